@@ -0,0 +1,80 @@
+// A $group gives the same answers when the part of the pipeline up to it runs on several threads
+// and their partial results are merged.
+
+var t = db.jstests_aggregation_parallel_group;
+t.drop();
+
+var pad = new Array( 200 ).join( "x" );
+for( var i = 0; i < 5000; ++i ) {
+    t.save( { a: i, b: i % 10, c: [ i % 3, i % 5 ], pad: pad } );
+}
+assert.eq( null, db.getLastError() );
+
+function sortIds( x, y ) {
+    return x._id < y._id ? -1 : ( x._id > y._id ? 1 : 0 );
+}
+
+function numbers( x, y ) {
+    return x - y;
+}
+
+function run( pipeline, options ) {
+    var res = t.aggregate( pipeline, options ).toArray().sort( sortIds );
+    res.forEach( function( doc ) {
+        if ( doc.set ) {
+            doc.set.sort( numbers );
+        }
+        if ( doc.pushed ) {
+            doc.pushed.sort( numbers );
+        }
+    } );
+    return res;
+}
+
+function results() {
+    return {
+        plain: run( [ { $group: { _id: "$b", n: { $sum: 1 }, total: { $sum: "$a" },
+                                  avg: { $avg: "$a" }, min: { $min: "$a" }, max: { $max: "$a" },
+                                  set: { $addToSet: { $mod: [ "$a", 7 ] } } } } ] ),
+        matched: run( [ { $match: { b: { $in: [ 1, 2, 3 ] } } },
+                        { $project: { b: 1, a2: { $multiply: [ "$a", 2 ] } } },
+                        { $group: { _id: "$b", total: { $sum: "$a2" },
+                                    pushed: { $push: "$a2" } } } ] ),
+        unwound: run( [ { $unwind: "$c" },
+                        { $group: { _id: "$c", n: { $sum: 1 }, avg: { $avg: "$a" } } },
+                        { $match: { n: { $gt: 1000 } } } ] ),
+        onDisk: run( [ { $group: { _id: "$a", n: { $sum: 1 } } },
+                       { $group: { _id: "$n", count: { $sum: 1 } } } ],
+                     { allowDiskUse: true } ),
+        sorted: t.aggregate( [ { $sort: { a: 1 } },
+                               { $group: { _id: "$b", first: { $first: "$a" },
+                                           last: { $last: "$a" } } },
+                               { $sort: { _id: 1 } } ] ).toArray()
+    };
+}
+
+t.ensureIndex( { a: 1 } );
+var serial = results();
+assert.eq( 10, serial.plain.length );
+assert.eq( 5, serial.unwound.length );
+
+var old = db.adminCommand( { getParameter: 1, internalPipelineParallelThreads: 1,
+                             internalPipelineParallelMinMB: 1 } );
+assert.commandWorked( old );
+assert.commandWorked( db.adminCommand( { setParameter: 1, internalPipelineParallelThreads: 4,
+                                         internalPipelineParallelMinMB: 0 } ) );
+
+assert.eq( serial, results() );
+
+// Errors in a worker reach the client.
+assert.throws( function() {
+    t.aggregate( [ { $group: { _id: "$b", n: { $sum: { $divide: [ "$a", "$pad" ] } } } } ] );
+} );
+
+assert.commandWorked( db.adminCommand( { setParameter: 1,
+                                         internalPipelineParallelThreads:
+                                             old.internalPipelineParallelThreads,
+                                         internalPipelineParallelMinMB:
+                                             old.internalPipelineParallelMinMB } ) );
+
+t.drop();
@@ -0,0 +1,63 @@
+// A leading $sort with a $limit runs in the query, which can then pick a plan that filters on one
+// index and keeps the top documents, and it returns the same answers as the pipeline's sort.
+
+var t = db.jstests_aggregation_sort_limit_pushdown;
+t.drop();
+
+for( var i = 0; i < 3000; ++i ) {
+    t.save( { user: "u" + ( i % 30 ), ts: ( i * 7919 ) % 3000, v: i } );
+}
+assert.eq( null, db.getLastError() );
+
+function cursorStage( pipeline ) {
+    var explained = t.runCommand( "aggregate", { pipeline: pipeline, explain: true } );
+    assert.commandWorked( explained );
+    return explained.stages[ 0 ].$cursor;
+}
+
+var pipelines = {
+    latest: [ { $match: { user: "u7" } }, { $sort: { ts: -1 } }, { $limit: 5 } ],
+    earliest: [ { $match: { user: { $in: [ "u1", "u2" ] } } }, { $sort: { ts: 1 } },
+                { $limit: 10 }, { $project: { _id: 0, ts: 1, v: 1 } } ],
+    twoKeys: [ { $match: { ts: { $lt: 1000 } } }, { $sort: { user: 1, ts: -1 } },
+               { $limit: 20 } ]
+};
+
+// Without indexes the pipeline sorts.
+var expected = {};
+for( var name in pipelines ) {
+    assert.eq( undefined, cursorStage( pipelines[ name ] ).sort, name );
+    expected[ name ] = t.aggregate( pipelines[ name ] ).toArray();
+}
+assert.eq( 5, expected.latest.length );
+assert.eq( 20, expected.twoKeys.length );
+
+// With no index proving 'ts' never holds an array the sort stays in the pipeline.
+t.ensureIndex( { user: 1 } );
+assert.eq( undefined, cursorStage( pipelines.latest ).sort );
+assert.eq( expected.latest, t.aggregate( pipelines.latest ).toArray() );
+
+t.ensureIndex( { ts: 1 } );
+for( var name in pipelines ) {
+    var cursor = cursorStage( pipelines[ name ] );
+    assert.eq( pipelines[ name ][ 1 ].$sort, cursor.sort, name );
+    assert.eq( pipelines[ name ][ 2 ].$limit, cursor.limit, name );
+    assert.eq( expected[ name ], t.aggregate( pipelines[ name ] ).toArray(), name );
+}
+
+// A 2d index isn't multikey over the [x, y] arrays it indexes, so it proves nothing.
+var g = db.jstests_aggregation_sort_limit_pushdown_2d;
+g.drop();
+for( var i = 0; i < 100; ++i ) {
+    g.save( { user: "u" + ( i % 10 ), loc: [ i % 7, i % 11 ] } );
+}
+g.ensureIndex( { user: 1 } );
+g.ensureIndex( { loc: "2d" } );
+var byLoc = [ { $match: { user: "u3" } }, { $sort: { loc: 1 } }, { $limit: 3 } ];
+var explained = g.runCommand( "aggregate", { pipeline: byLoc, explain: true } );
+assert.commandWorked( explained );
+assert.eq( undefined, explained.stages[ 0 ].$cursor.sort );
+assert.eq( 3, g.aggregate( byLoc ).toArray().length );
+g.drop();
+
+t.drop();
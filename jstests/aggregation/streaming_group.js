@@ -0,0 +1,90 @@
+// A $group on a field that an index scan already returns in order streams its groups, and gives
+// the same answers as when it has to hold every group until the end.
+
+var t = db.jstests_aggregation_streaming_group;
+t.drop();
+
+for( var i = 0; i < 2000; ++i ) {
+    var doc = { b: i };
+    if ( i % 100 != 0 ) { // some documents have no 'a', which groups with null
+        doc.a = ( i * 7 ) % 50;
+    }
+    t.save( doc );
+}
+t.save( { a: null, b: -1 } );
+assert.eq( null, db.getLastError() );
+
+function numbers( x, y ) {
+    return x - y;
+}
+
+function run( pipeline ) {
+    var res = t.aggregate( pipeline.concat( [ { $sort: { _id: 1 } } ] ) ).toArray();
+    res.forEach( function( doc ) {
+        doc.pushed.sort( numbers );
+    } );
+    return res;
+}
+
+function cursorSort( pipeline ) {
+    var explained = t.runCommand( "aggregate", { pipeline: pipeline, explain: true } );
+    assert.commandWorked( explained );
+    return explained.stages[ 0 ].$cursor.sort;
+}
+
+var group = { $group: { _id: "$a", n: { $sum: 1 }, total: { $sum: "$b" }, first: { $first: "$b" },
+                        pushed: { $push: "$b" } } };
+var pipelines = {
+    range: [ { $match: { a: { $gte: 10 } } }, group ],
+    withNull: [ { $match: { a: { $in: [ null, 1, 2, 3 ] } } }, group ],
+    all: [ group ]
+};
+
+// Without an index every group is held until the end.
+var expected = {};
+for( var name in pipelines ) {
+    assert.eq( undefined, cursorSort( pipelines[ name ] ), name );
+    expected[ name ] = run( pipelines[ name ] );
+}
+assert.eq( 40, expected.range.length );
+assert.eq( 4, expected.withNull.length );
+assert.eq( 51, expected.all.length );
+
+t.ensureIndex( { a: 1 } );
+
+// The index scans deliver the documents ordered on 'a', so the groups stream. Without a $match
+// there is no index plan to take the order from.
+assert.eq( { a: 1 }, cursorSort( pipelines.range ) );
+assert.eq( { a: 1 }, cursorSort( pipelines.withNull ) );
+assert.eq( undefined, cursorSort( pipelines.all ) );
+
+// $first still sees the documents in index order, which may differ from the unindexed one.
+for( var name in pipelines ) {
+    var actual = run( pipelines[ name ] );
+    assert.eq( expected[ name ].length, actual.length, name );
+    for( var j = 0; j < actual.length; ++j ) {
+        delete actual[ j ].first;
+        delete expected[ name ][ j ].first;
+    }
+    assert.eq( expected[ name ], actual, name );
+}
+
+// Holding one group at a time doesn't lift the memory limit, and there is nothing to spill.
+var limitParam = "internalDocumentSourceGroupMaxMemoryBytes";
+var oldLimit = db.adminCommand( { getParameter: 1, internalDocumentSourceGroupMaxMemoryBytes: 1 } );
+assert.commandWorked( oldLimit );
+var setLimit = { setParameter: 1 };
+setLimit[ limitParam ] = 100;
+assert.commandWorked( db.adminCommand( setLimit ) );
+var res = t.runCommand( "aggregate", { pipeline: pipelines.range, allowDiskUse: true } );
+setLimit[ limitParam ] = oldLimit[ limitParam ];
+assert.commandWorked( db.adminCommand( setLimit ) );
+assert.commandFailed( res );
+assert.eq( 17422, res.code );
+
+// A multikey index orders array elements rather than documents, so it can't be used.
+t.save( { a: [ 30, 10 ], b: 5000 } );
+assert.eq( undefined, cursorSort( pipelines.range ) );
+assert.eq( 41, run( pipelines.range ).length );
+
+t.drop();
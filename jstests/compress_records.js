@@ -0,0 +1,73 @@
+// Tests collections created with the compressRecords option.
+
+var t = db.compress_records;
+t.drop();
+
+assert.commandWorked( db.createCollection( t.getName(), { compressRecords: true } ) );
+assert.eq( 3, t.stats().userFlags, "compressRecords should set userFlags bit 2" );
+
+assert.commandFailed( db.createCollection( "compress_records_capped",
+                                           { capped: true, size: 100000, compressRecords: true } ) );
+
+var line = "GET /index.html HTTP/1.1 200 host=www.example.com agent=Mozilla/5.0 ";
+var logLine = "";
+while ( logLine.length < 2000 )
+    logLine += line;
+
+for ( var i = 0; i < 1000; i++ ) {
+    // small documents don't compress and are stored as they are
+    t.insert( { _id: i, line: ( i % 10 == 0 ? "x" : logLine ), n: i } );
+}
+assert.eq( null, db.getLastError() );
+t.ensureIndex( { n: 1 } );
+
+var stats = t.stats();
+assert.lt( stats.size, 1000 * logLine.length / 3, "documents weren't compressed: " + tojson( stats ) );
+
+assert.eq( 1000, t.find().itcount() );
+assert.eq( logLine, t.findOne( { _id: 5 } ).line );
+assert.eq( "x", t.findOne( { _id: 10 } ).line );
+assert.eq( 100, t.find( { line: "x" } ).count() );
+assert.eq( 10, t.find( { n: { $lt: 10 } } ).itcount() );
+assert.eq( logLine, t.find( { n: 7 } ).hint( { n: 1 } ).next().line );
+
+// updates that could be applied in place are applied to the compressed document
+t.update( { _id: 5 }, { $inc: { n: 1000 } } );
+assert.eq( null, db.getLastError() );
+assert.eq( 1005, t.findOne( { _id: 5 } ).n );
+assert.eq( 1, t.find( { n: 1005 } ).hint( { n: 1 } ).itcount() );
+
+// updates that grow the document
+t.update( { _id: 6 }, { $set: { more: logLine } } );
+t.update( { _id: 20 }, { $set: { line: logLine } } );
+assert.eq( null, db.getLastError() );
+assert.eq( logLine, t.findOne( { _id: 6 } ).more );
+assert.eq( logLine, t.findOne( { _id: 20 } ).line );
+
+t.remove( { _id: { $lt: 100 } } );
+assert.eq( 900, t.count() );
+assert( t.validate( true ).valid );
+
+// turning compression off leaves existing documents readable
+var res = db.runCommand( { collMod: t.getName(), compressRecords: false } );
+assert.commandWorked( res );
+assert.eq( true, res.compressRecords_old );
+assert.eq( 1, t.stats().userFlags );
+t.insert( { _id: "plain", line: logLine } );
+assert.eq( logLine, t.findOne( { _id: "plain" } ).line );
+assert.eq( logLine, t.findOne( { _id: 500 } ).line );
+
+// and compact rewrites them in the collection's current form
+var before = t.stats().size;
+assert.commandWorked( db.runCommand( { compact: t.getName() } ) );
+assert.gt( t.stats().size, before );
+assert.eq( 901, t.find().itcount() );
+assert.eq( logLine, t.findOne( { _id: 500 } ).line );
+
+assert.commandWorked( db.runCommand( { collMod: t.getName(), compressRecords: true } ) );
+assert.commandWorked( db.runCommand( { compact: t.getName() } ) );
+assert.lt( t.stats().size, before );
+assert.eq( 901, t.find().itcount() );
+assert( t.validate( true ).valid );
+
+t.drop();
@@ -0,0 +1,41 @@
+// Counts whose predicates are all answered by an index, over several intervals or with predicates
+// the bounds can't express, count from the index keys without fetching documents.
+
+t = db.jstests_count_covered;
+t.drop();
+
+var statuses = [ "new", "open", "closed", "failed" ];
+for( i = 0; i < 2000; ++i ) {
+    t.save( { status: statuses[ i % 4 ], ts: i, tags: [ i % 3, i % 5 ] } );
+}
+t.ensureIndex( { status: 1, ts: 1 } );
+t.ensureIndex( { tags: 1 } );
+
+function check( query ) {
+    assert.eq( t.find( query ).itcount(), t.count( query ), tojson( query ) );
+}
+
+// several intervals
+check( { status: { $in: [ "open", "failed" ] }, ts: { $gt: 1500 } } );
+check( { status: { $in: [ "open", "failed" ] }, ts: { $gt: 100, $lte: 1900 } } );
+check( { status: "new", ts: { $in: [ 4, 8, 9, 400, 1999, 2000 ] } } );
+check( { $or: [ { status: "new" }, { status: "closed" } ], ts: { $lt: 10 } } );
+
+// a predicate tested against the key
+check( { status: { $in: [ "open", "failed" ] }, ts: { $mod: [ 7, 0 ] } } );
+check( { status: { $gt: "a" }, ts: { $mod: [ 3, 1 ] } } );
+
+// multikey index, each document is counted once
+check( { tags: { $in: [ 0, 1 ] } } );
+check( { tags: { $in: [ 2, 4 ] } } );
+
+// two indexes can count, so the plans are ranked, and counted again once the choice is cached
+t.ensureIndex( { ts: 1, status: 1 } );
+check( { status: { $in: [ "open", "failed" ] }, ts: { $gt: 1500 } } );
+check( { status: { $in: [ "open", "failed" ] }, ts: { $gt: 1500 } } );
+check( { status: { $in: [ "new", "closed" ] }, ts: { $in: [ 4, 8, 9, 400 ] } } );
+
+assert.eq( 500, t.count( { status: { $in: [ "open", "failed" ] }, ts: { $gte: 1000 } } ) );
+assert.eq( 4, t.count( { status: "new", ts: { $in: [ 4, 8, 9, 400, 1999, 2000 ] } } ) );
+
+t.drop();
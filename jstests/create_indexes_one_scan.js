@@ -0,0 +1,62 @@
+// createIndexes builds foreground indexes from one scan of the collection, on several threads
+// when the collection is big enough.
+
+var t = db.create_indexes_one_scan;
+t.drop();
+
+var old = db.adminCommand( { getParameter: 1, indexBuildThreads: 1 } ).indexBuildThreads;
+assert.commandWorked( db.adminCommand( { setParameter: 1, indexBuildThreads: 4 } ) );
+
+var n = 60000;
+for ( var i = 0; i < n; i++ ) {
+    t.insert( { _id: i, a: i % 1000, b: "b" + ( n - i ), c: [ i, i + 1 ], u: i } );
+}
+assert.eq( null, db.getLastError() );
+
+var res = t.runCommand( "createIndexes", { indexes: [ { key: { a: 1 }, name: "a_1" },
+                                                      { key: { b: -1, a: 1 }, name: "b_-1_a_1" },
+                                                      { key: { c: 1 }, name: "c_1" },
+                                                      { key: { u: 1 }, name: "u_1", unique: true },
+                                                      { key: { a: "hashed" }, name: "a_hashed" } ] } );
+assert.commandWorked( res );
+assert.eq( 6, res.numIndexesAfter );
+
+assert.eq( n, t.find().hint( { a: 1 } ).itcount() );
+assert.eq( n, t.find().hint( { b: -1, a: 1 } ).itcount() );
+assert.eq( n, t.find().hint( { u: 1 } ).itcount() );
+assert.eq( 60, t.find( { a: 7 } ).hint( { a: "hashed" } ).itcount() );
+assert.eq( 2, t.find( { c: 10 } ).itcount() );
+assert( t.find( { c: 10 } ).explain().isMultiKey );
+assert( !t.find( { a: 7 } ).hint( { a: 1 } ).explain().isMultiKey );
+
+var prev = null;
+t.find( {}, { b: 1, a: 1, _id: 0 } ).hint( { b: -1, a: 1 } ).forEach( function( doc ) {
+    if ( prev )
+        assert.lte( doc.b, prev.b, "index out of order" );
+    prev = doc;
+} );
+assert( t.validate( true ).valid );
+
+// a failed build removes all the indexes it was building
+t.update( { _id: 5 }, { $set: { v: 1 } } );
+t.update( { _id: 6 }, { $set: { v: 1 } } );
+res = t.runCommand( "createIndexes", { indexes: [ { key: { a: 1, b: 1 }, name: "a_1_b_1" },
+                                                  { key: { v: 1 }, name: "v_1", unique: true } ] } );
+assert.commandFailed( res );
+assert.eq( 6, t.getIndexes().length );
+
+// dropDups deletes the duplicates, from every index
+res = t.runCommand( "createIndexes", { indexes: [ { key: { a: 1, b: 1 }, name: "a_1_b_1" },
+                                                  { key: { a: 1, u: -1 }, name: "a_1_u_-1" },
+                                                  { key: { a: 1, missing: 1 }, name: "a_1_missing_1",
+                                                    unique: true, dropDups: true } ] } );
+assert.commandWorked( res );
+assert.eq( 9, t.getIndexes().length );
+assert.eq( 1000, t.count() );
+assert.eq( 1000, t.find().hint( { a: 1, b: 1 } ).itcount() );
+assert.eq( 1000, t.find().hint( { a: 1, u: -1 } ).itcount() );
+assert.eq( 1000, t.find().hint( { u: 1 } ).itcount() );
+assert( t.validate( true ).valid );
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, indexBuildThreads: old } ) );
+t.drop();
@@ -0,0 +1,76 @@
+// A distinct over the first field of a compound index can skip through that field's values even
+// when the query is over the other fields of the index.
+
+t = db.jstests_distinct_skip_scan;
+t.drop();
+
+function d( k , q ){
+    return t.runCommand( "distinct" , { key : k , query : q || {} } );
+}
+
+// The distinct values of 'key' over the documents matching 'query', found without an index.
+function expected( key , query ) {
+    var seen = {};
+    var out = [];
+    t.find( query ).hint( { $natural : 1 } ).forEach( function( doc ) {
+        if ( !( tojson( doc[ key ] ) in seen ) ) {
+            seen[ tojson( doc[ key ] ) ] = true;
+            out.push( doc[ key ] );
+        }
+    } );
+    return out.sort();
+}
+
+function check( key , query ) {
+    var x = d( key , query );
+    assert.commandWorked( x );
+    assert.eq( expected( key , query ) , x.values.sort() , tojson( query ) );
+    return x;
+}
+
+for( c = 0; c < 10; ++c ) {
+    for( ts = 0; ts < 100; ++ts ) {
+        t.save( { customerId : c , ts : ts , s : "s" + ( ts % 7 ) } );
+    }
+}
+t.ensureIndex( { customerId : 1 , ts : 1 , s : 1 } );
+
+// Bounds on a later field are used under each value of the first field.
+x = check( "customerId" , { ts : { $gt : 90 } } );
+assert.eq( 10 , x.values.length );
+assert.eq( 0 , x.stats.nscannedObjects );
+assert.lt( x.stats.nscanned , 50 );
+
+x = check( "customerId" , { ts : { $gte : 50 , $lt : 52 } , s : { $in : [ "s2" , "s3" ] } } );
+assert.eq( 0 , x.stats.nscannedObjects );
+
+// No document has ts 200.
+x = check( "customerId" , { ts : 200 } );
+assert.eq( 0 , x.values.length );
+assert.eq( 0 , x.stats.nscannedObjects );
+
+// Predicates the bounds can't express are tested against the keys.
+x = check( "customerId" , { ts : { $mod : [ 10 , 3 ] } } );
+assert.eq( 10 , x.values.length );
+assert.eq( 0 , x.stats.nscannedObjects );
+
+x = check( "customerId" , { ts : { $gt : 95 } , s : /^s[12]$/ } );
+assert.eq( 0 , x.stats.nscannedObjects );
+
+// Predicates on the distinct field combine with those on later fields.
+x = check( "customerId" , { customerId : { $gte : 5 } , ts : { $mod : [ 50 , 49 ] } } );
+assert.eq( [ 5 , 6 , 7 , 8 , 9 ] , x.values.sort() );
+assert.eq( 0 , x.stats.nscannedObjects );
+
+// A predicate on a field outside the index needs the documents.
+check( "customerId" , { ts : { $gt : 90 } , other : null } );
+
+// $exists can't be answered from the keys.
+check( "customerId" , { s : { $exists : true } } );
+
+// Once the index is multikey the keys don't tell us what the documents hold.
+t.save( { customerId : 3 , ts : [ 1 , 200 ] , s : "s1" } );
+check( "customerId" , { ts : { $gt : 150 , $lt : 250 } } );
+check( "customerId" , { ts : { $mod : [ 1000 , 200 ] } } );
+
+t.drop();
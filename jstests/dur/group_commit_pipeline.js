@@ -0,0 +1,52 @@
+/* test the pipelined group commit
+   several clients do j:true writes with a short commit interval, so commits overlap in the
+   pipeline.  then kill -9 and check every acknowledged write was recovered.
+*/
+
+var testname = "group_commit_pipeline";
+var path = MongoRunner.dataPath + testname + "dur";
+var nShells = 4;
+var nPerShell = 500;
+
+function log(str) {
+    print("\n" + testname + " " + str);
+}
+
+log("run mongod --journal --journalCommitInterval 2");
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--journal", "--smallfiles",
+                            "--journalCommitInterval", 2, "--durOptions", /*DurParanoid*/8);
+var d = conn.getDB("test");
+d.foo.insert({ _id: "start" });
+assert.eq(null, d.getLastError());
+
+log("j:true writes from " + nShells + " shells");
+var shells = [];
+for (var i = 0; i < nShells; i++) {
+    shells.push(startParallelShell("var x = 'x'; while (x.length < 4096) x += x;" +
+                                   "for (var j = 0; j < " + nPerShell + "; j++) {" +
+                                   "    db.foo.insert({ _id: " + i + " * 100000 + j, x: x });" +
+                                   "    assert.eq(null, db.getLastError(1, 0, true));" +
+                                   "}", 30001));
+}
+shells.forEach(function(join) { join(); });
+assert.eq(nShells * nPerShell + 1, d.foo.count());
+
+var dur = d.serverStatus().dur;
+printjson(dur);
+assert(dur.timeMs.journalQueue !== undefined, "no journalQueue time");
+assert(dur.timeMs.dataFilesQueue !== undefined, "no dataFilesQueue time");
+assert(dur.maxMs !== undefined, "no per stage max times");
+assert(dur.maxMs.commit !== undefined, "no commit latency");
+
+log("kill -9");
+stopMongod(30001, /*signal*/9);
+
+log("restart and recover");
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--journal", "--smallfiles",
+                          "--durOptions", /*DurParanoid*/8);
+d = conn.getDB("test");
+assert.eq(nShells * nPerShell + 1, d.foo.count(), "acknowledged j:true writes were lost");
+assert(d.foo.validate().valid);
+stopMongod(30002);
+
+print(testname + " SUCCESS");
@@ -0,0 +1,49 @@
+/* test durability of writes that don't compress
+   such journal sections are stored uncompressed; kill -9 and check recovery applies them
+*/
+
+var testname = "incompressible";
+var path = MongoRunner.dataPath + testname + "dur";
+
+function log(str) {
+    print("\n" + testname + " " + str);
+}
+
+function randomString(len) {
+    var s = "";
+    while (s.length < len)
+        s += Math.random().toString(36).substring(2);
+    return s.substring(0, len);
+}
+
+log("run mongod --journal");
+var conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--journal", "--smallfiles",
+                            "--durOptions", /*DurParanoid*/8);
+var d = conn.getDB("test");
+
+var docs = [];
+for (var i = 0; i < 200; i++) {
+    var doc = { _id: i, r: randomString(16 * 1024) };
+    d.foo.insert(doc);
+    // alternate single documents with a compressible one now and then so the journal has both
+    if (i % 10 == 0)
+        d.foo.insert({ _id: "c" + i, x: new Array(4096).join("x") });
+    assert.eq(null, d.getLastError(1, 0, true));
+    docs.push(doc);
+}
+
+log("kill -9");
+stopMongod(30001, /*signal*/9);
+
+log("restart and recover");
+conn = startMongodNoReset("--port", 30002, "--dbpath", path, "--journal", "--smallfiles",
+                          "--durOptions", /*DurParanoid*/8);
+d = conn.getDB("test");
+assert.eq(220, d.foo.count());
+docs.forEach(function(doc) {
+    assert.eq(doc.r, d.foo.findOne({ _id: doc._id }).r, "document " + doc._id + " differs");
+});
+assert(d.foo.validate().valid);
+stopMongod(30002);
+
+print(testname + " SUCCESS");
@@ -0,0 +1,63 @@
+// Unindexed find, count and aggregation scans give the same answers when split among worker
+// threads.
+
+t = db.jstests_parallel_collscan;
+t.drop();
+
+var pad = new Array( 500 ).join( "x" );
+for( i = 0; i < 5000; ++i ) {
+    t.save( { a: i, b: i % 10, pad: pad } );
+}
+assert.eq( null, db.getLastError() );
+
+function results() {
+    return {
+        count: t.count( { b: { $lt: 3 } } ),
+        find: t.find( { b: 7 }, { _id: 0, a: 1 } ).toArray().map( function( o ) { return o.a; } )
+              .sort( function( x, y ) { return x - y; } ),
+        agg: t.aggregate( [ { $match: { b: { $in: [ 1, 2 ] } } },
+                            { $group: { _id: "$b", n: { $sum: 1 }, total: { $sum: "$a" } } },
+                            { $sort: { _id: 1 } } ] ).toArray(),
+        sorted: t.find( { a: { $gte: 4990 } }, { _id: 0, a: 1 } ).sort( { a: -1 } ).toArray()
+    };
+}
+
+var serial = results();
+
+var old = db.adminCommand( { getParameter: 1, internalQueryParallelScanThreads: 1,
+                             internalQueryParallelScanMinMB: 1 } );
+assert.commandWorked( old );
+assert.commandWorked( db.adminCommand( { setParameter: 1, internalQueryParallelScanThreads: 4,
+                                         internalQueryParallelScanMinMB: 0 } ) );
+
+var parallel = results();
+assert.eq( 1500, parallel.count );
+assert.eq( serial, parallel );
+
+// Documents deleted while a getMore is pending aren't returned.
+var cursor = t.find( { b: 3 } ).batchSize( 10 );
+var seen = {};
+var n = 0;
+for( i = 0; i < 10; ++i ) {
+    seen[ cursor.next().a ] = true;
+    ++n;
+}
+t.remove( { b: 3, a: { $gte: 2500 } } );
+assert.eq( null, db.getLastError() );
+while( cursor.hasNext() ) {
+    var a = cursor.next().a;
+    assert.lt( a, 2500 );
+    assert( !( a in seen ), "returned twice: " + a );
+    seen[ a ] = true;
+    ++n;
+}
+assert.lte( n, 260 );
+assert.eq( 250, t.count( { b: 3 } ) );
+
+assert.commandWorked( db.adminCommand( { setParameter: 1,
+                                         internalQueryParallelScanThreads:
+                                             old.internalQueryParallelScanThreads,
+                                         internalQueryParallelScanMinMB:
+                                             old.internalQueryParallelScanMinMB } ) );
+
+t.drop();
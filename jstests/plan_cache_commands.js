@@ -47,8 +47,15 @@ assert.commandFailed(missingCollection.runCommand('planCacheListQueryShapes'));
 // Number of shapes should match queries executed by multi-plan runner.
 var shapes = getShapes();
 assert.eq(1, shapes.length, 'unexpected number of shapes in planCacheListQueryShapes result');
-assert.eq({query: queryA1, sort: sortA1, projection: projectionA1}, shapes[0],
-          'unexpected query shape returned from planCacheListQueryShapes');
+assert.eq({query: queryA1, sort: sortA1, projection: projectionA1, hits: 0, misses: 1,
+           evictions: 0, replans: 0},
+          shapes[0], 'unexpected query shape returned from planCacheListQueryShapes');
+
+// Running the query again uses the cached plan.
+assert.eq(1, t.find(queryA1, projectionA1).sort(sortA1).itcount(), 'unexpected document count');
+shapes = getShapes();
+assert.eq(1, shapes[0].hits, 'cached plan lookup not counted as a hit');
+assert.eq(1, shapes[0].misses, 'cached plan lookup counted as a miss');
 
 
 
@@ -0,0 +1,59 @@
+// A cached plan that does far more work than when it was chosen is replaced part way through
+// the query that notices.
+
+var t = db.jstests_plan_cache_replan;
+t.drop();
+
+function getShapes() {
+    var res = t.runCommand('planCacheListQueryShapes');
+    assert.commandWorked(res, 'planCacheListQueryShapes failed');
+    return res.shapes;
+}
+
+function getCachedPlans(query) {
+    var res = t.runCommand('planCacheListPlans', {query: query});
+    assert.commandWorked(res, 'planCacheListPlans failed');
+    return res.plans;
+}
+
+var old = db.adminCommand({getParameter: 1, internalQueryCacheReplanFactor: 1});
+assert.commandWorked(old);
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryCacheReplanFactor: 1}));
+
+t.ensureIndex({a: 1});
+t.ensureIndex({b: 1});
+
+// Nothing has a == 1, so the {a: 1} index finds out straight away that nothing matches.
+for (var i = 0; i < 50; i++) {
+    t.insert({a: 2, b: 1});
+}
+
+var query = {a: 1, b: 1};
+assert.eq(0, t.find(query).itcount());
+var shapes = getShapes();
+assert.eq(1, shapes.length, 'query not cached');
+assert.eq(0, shapes[0].replans);
+assert.eq('{ a: 1 }', getCachedPlans(query)[0].reason.stats.children[0].keyPattern,
+          'expected the {a: 1} index to be cached');
+
+// Now the {a: 1} index has to get through 500 keys first.  Stay under the 1000 writes that
+// would flush the cache.
+for (var i = 0; i < 500; i++) {
+    t.insert({a: 1, b: 2});
+}
+t.insert({a: 1, b: 1});
+
+assert.eq(1, t.find(query).itcount(), 'replanned query returned the wrong results');
+shapes = getShapes();
+assert.eq(1, shapes.length, 'replanned query not cached again');
+assert.eq(1, shapes[0].replans, 'replan not counted');
+assert.eq('{ b: 1 }', getCachedPlans(query)[0].reason.stats.children[0].keyPattern,
+          'expected the {b: 1} index to be cached after replanning');
+
+// Each result is still returned once with the cache out of the way.
+assert.eq(1, t.find(query).itcount());
+assert.eq(1, getShapes()[0].replans);
+
+assert.commandWorked(db.adminCommand({setParameter: 1,
+                                      internalQueryCacheReplanFactor:
+                                          old.internalQueryCacheReplanFactor}));
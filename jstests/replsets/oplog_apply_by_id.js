@@ -0,0 +1,66 @@
+/**
+ * Secondaries split the ops on one collection between writers by _id.  Check the result matches
+ * the primary, including for capped collections and collections with unique indexes, which are
+ * still applied in order, and that serverStatus reports how busy each writer was.
+ */
+var rt = new ReplSetTest( { name : "oplog_apply_by_id" , nodes: 2, oplogSize: 100 } );
+rt.startSet();
+rt.initiate();
+rt.awaitSecondaryNodes();
+
+var primary = rt.getPrimary();
+var secondary = rt.getSecondary();
+var testDB = primary.getDB("test");
+var secondaryDB = secondary.getDB("test");
+
+function checkSame(collName) {
+    var onPrimary = testDB[collName].find().sort({_id: 1}).toArray();
+    var onSecondary = secondaryDB[collName].find().sort({_id: 1}).toArray();
+    assert.eq(onPrimary.length, onSecondary.length, collName + " has different counts");
+    for (var i = 0; i < onPrimary.length; i++) {
+        assert.eq(tojson(onPrimary[i]), tojson(onSecondary[i]), collName + " differs");
+    }
+}
+
+// inserts, updates and deletes of the same documents in one batch
+for (var i = 0; i < 5000; i++) {
+    testDB.a.insert({_id: i, n: 0});
+    testDB.a.update({_id: i % 100}, {$inc: {n: 1}, $push: {seen: i}});
+    if (i % 7 == 0) {
+        testDB.a.remove({_id: i - 3});
+    }
+}
+testDB.getLastError(2);
+checkSame("a");
+
+// a unique index lets a document take a key another one gave up earlier in the batch
+testDB.u.ensureIndex({k: 1}, {unique: true});
+testDB.getLastError(2);
+testDB.u.insert({_id: 0, k: 0});
+for (var i = 1; i < 2000; i++) {
+    testDB.u.update({_id: i - 1}, {$set: {k: -i}});
+    testDB.u.insert({_id: i, k: 0});
+}
+testDB.getLastError(2);
+checkSame("u");
+
+// capped collections keep insertion order
+testDB.createCollection("c", {capped: true, size: 100000});
+for (var i = 0; i < 2000; i++) {
+    testDB.c.insert({_id: 2000 - i, x: i});
+}
+testDB.getLastError(2);
+assert.eq(testDB.c.find().toArray(), secondaryDB.c.find().toArray());
+
+var writers = secondaryDB.serverStatus().repl.writers;
+printjson(writers);
+assert(writers.applyMillis >= 0, "applyMillis missing");
+var busy = 0;
+writers.threads.forEach(function(w) {
+    assert(w.utilization >= 0, "utilization missing");
+    if (w.ops > 0)
+        busy++;
+});
+assert.gt(busy, 1, "ops on one collection were applied by a single writer");
+
+rt.stopSet();
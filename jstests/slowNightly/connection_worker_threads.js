@@ -0,0 +1,56 @@
+// Tests serving connections from a fixed pool of worker threads (connectionWorkerThreads)
+
+var numConns = 50;
+var numWorkers = 4;
+
+var mongo = MongoRunner.runMongod({setParameter: "connectionWorkerThreads=" + numWorkers});
+var db = mongo.getDB("test");
+var coll = db.connection_worker_threads;
+coll.drop();
+
+jsTestLog("Opening more connections than there are workers");
+var conns = [];
+for (var i = 0; i < numConns; i++) {
+    conns.push(new Mongo(db.getMongo().host));
+}
+
+// each connection keeps its own last error state while sharing the workers
+for (var i = 0; i < numConns; i++) {
+    var c = conns[i].getDB("test").connection_worker_threads;
+    c.insert({_id: i});
+    assert.eq(null, conns[i].getDB("test").getLastError());
+}
+conns[0].getDB("test").connection_worker_threads.insert({_id: 0});
+assert.neq(null, conns[0].getDB("test").getLastError());
+assert.eq(null, conns[1].getDB("test").getLastError());
+assert.eq(numConns, coll.count());
+
+jsTestLog("Running requests from parallel shells");
+var shells = [];
+for (var i = 0; i < 5; i++) {
+    shells.push(startParallelShell("for (var j = 0; j < 200; j++) {" +
+                                   "    db.connection_worker_threads.insert({shell: " + i + "});" +
+                                   "    assert.eq(null, db.getLastError());" +
+                                   "}", mongo.port));
+}
+shells.forEach(function(join) { join(); });
+assert.eq(numConns + 1000, coll.count());
+
+jsTestLog("Unlocking fsync while every worker is blocked behind the lock");
+assert.commandWorked(db.fsyncLock());
+var numBlocked = numWorkers + 2;
+var blocked = [];
+for (var i = 0; i < numBlocked; i++) {
+    blocked.push(startParallelShell("db.connection_worker_threads.insert({blocked: 1});" +
+                                    "assert.eq(null, db.getLastError());", mongo.port));
+}
+// the pool grows, so currentOp and the unlock still get a worker
+assert.soon(function() {
+    return db.currentOp().inprog.filter(function(op) { return op.waitingForLock; }).length >=
+           numBlocked;
+});
+db.fsyncUnlock();
+blocked.forEach(function(join) { join(); });
+assert.eq(numConns + 1000 + numBlocked, coll.count());
+
+MongoRunner.stopMongod(mongo.port);
@@ -0,0 +1,62 @@
+// Unindexed sorts of more data than the sort stage may buffer write sorted runs to disk and merge
+// them, while sorts with a limit keep their top results in memory.
+
+t = db.jstests_sort_spill;
+t.drop();
+
+big = new Array( 100000 ).toString();
+
+// About 40MB, more than the 32MB a sort may buffer.
+var n = 400;
+for( i = 0; i < n; ++i ) {
+    t.save( { _id: i, a: ( i * 37 ) % 100, x: big } );
+}
+assert.eq( null, db.getLastError() );
+
+function checkSorted( cursor, dir ) {
+    var count = 0;
+    var prev = null;
+    cursor.forEach( function( doc ) {
+        if ( prev ) {
+            if ( dir > 0 )
+                assert.lte( prev.a, doc.a );
+            else
+                assert.gte( prev.a, doc.a );
+            // documents with the same key come back in DiskLoc order, as from an index
+            if ( prev.a == doc.a )
+                assert.lt( prev._id, doc._id );
+        }
+        prev = { _id: doc._id, a: doc.a };
+        count++;
+    } );
+    return count;
+}
+
+assert.eq( n, checkSorted( t.find().sort( { a: 1 } ).batchSize( 1000 ), 1 ) );
+assert.eq( n, checkSorted( t.find().sort( { a: -1 } ).batchSize( 1000 ), -1 ) );
+assert.eq( n, checkSorted( t.find( {}, { x: 0 } ).sort( { a: 1 } ), 1 ) );
+
+var sortStage = function( stats ) {
+    while ( stats.type != "SORT" ) {
+        stats = stats.children[ 0 ];
+    }
+    return stats;
+};
+
+var explain = t.find().sort( { a: 1 } ).batchSize( 1000 ).explain( true );
+var sortStats = sortStage( explain.stats );
+assert.gt( sortStats.spills, 1, tojson( sortStats ) );
+assert.gt( sortStats.spilledBytes, 32 * 1024 * 1024, tojson( sortStats ) );
+
+// a limit keeps the top results in memory, it doesn't spill
+explain = t.find().sort( { a: 1 } ).limit( 10 ).explain( true );
+sortStats = sortStage( explain.stats );
+assert.eq( 0, sortStats.spills, tojson( sortStats ) );
+assert.eq( 10, t.find().sort( { a: 1 } ).limit( 10 ).itcount() );
+
+// turned off, the sort fails once it passes the limit
+assert.commandWorked( db.adminCommand( { setParameter: 1, sortSpillToDisk: false } ) );
+assert.throws( function() { t.find().sort( { a: 1 } ).batchSize( 1000 ).itcount(); } );
+assert.commandWorked( db.adminCommand( { setParameter: 1, sortSpillToDisk: true } ) );
+
+t.drop();
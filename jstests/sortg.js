@@ -1,8 +1,12 @@
 // Test that a memory exception is triggered for in memory sorts, but not for indexed sorts.
+// Sorts that don't fit in memory spill to disk unless sortSpillToDisk is off, see sort_spill.js.
 
 t = db.jstests_sortg;
 t.drop();
 
+var oldSpill = db.adminCommand( { getParameter: 1, sortSpillToDisk: 1 } ).sortSpillToDisk;
+assert.commandWorked( db.adminCommand( { setParameter: 1, sortSpillToDisk: false } ) );
+
 big = new Array( 1000000 ).toString()
 
 for( i = 0; i < 100; ++i ) {
@@ -62,3 +66,5 @@ noMemoryException( {_id:1}, {b:null} );
 // retried when the unindexed plan exhausts its memory limit.
 noMemoryException( {_id:1}, {b:null} );
 t.drop();
+
+assert.commandWorked( db.adminCommand( { setParameter: 1, sortSpillToDisk: oldSpill } ) );
@@ -16,7 +16,7 @@
  */
 
 #include <cstring>
-#include <deque>
+#include <vector>
 
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
@@ -155,6 +155,42 @@ namespace mongo {
             int _startPosition;
         };
 
+        /**
+         * The stack of objects being validated.  Most documents nest only a few levels, so the
+         * first frames live inline and validating a document doesn't allocate.  Pointers from
+         * back() are invalidated by push() and pop().
+         */
+        class ValidationFrameStack {
+        public:
+            ValidationFrameStack() : _size(0) {}
+
+            bool empty() const { return _size == 0; }
+            size_t size() const { return _size; }
+
+            ValidationObjectFrame& push() {
+                if (_size >= InlineFrames)
+                    _overflow.push_back(ValidationObjectFrame());
+                _size++;
+                return back();
+            }
+
+            void pop() {
+                if (_size > InlineFrames)
+                    _overflow.pop_back();
+                _size--;
+            }
+
+            ValidationObjectFrame& back() {
+                return _size > InlineFrames ? _overflow.back() : _inline[_size - 1];
+            }
+
+        private:
+            enum { InlineFrames = 32 };
+            ValidationObjectFrame _inline[InlineFrames];
+            std::vector<ValidationObjectFrame> _overflow;
+            size_t _size;
+        };
+
         /**
          * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
          */
@@ -255,7 +291,7 @@ namespace mongo {
         }
 
         Status validateBSONIterative(Buffer* buffer) {
-            std::deque<ValidationObjectFrame> frames;
+            ValidationFrameStack frames;
             ValidationObjectFrame* curr = NULL;
             ValidationState::State state = ValidationState::BeginObj;
 
@@ -265,8 +301,7 @@ namespace mongo {
             while (state != ValidationState::Done) {
                 switch (state) {
                 case ValidationState::BeginObj:
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = &frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(false);
                     if (!buffer->readNumber<int>(&curr->expectedSize)) {
@@ -305,7 +340,7 @@ namespace mongo {
                     if ( actualLength != curr->expectedSize ) {
                         return makeError("bson length doesn't match what we found", idElem);
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty()) {
                         state = ValidationState::Done;
                     }
@@ -319,8 +354,7 @@ namespace mongo {
                     break;
                 }
                 case ValidationState::BeginCodeWScope: {
-                    frames.push_back(ValidationObjectFrame());
-                    curr = &frames.back();
+                    curr = &frames.push();
                     curr->setStartPosition(buffer->position());
                     curr->setIsCodeWithScope(true);
                     if ( !buffer->readNumber<int>( &curr->expectedSize ) )
@@ -337,7 +371,7 @@ namespace mongo {
                         return makeError("bson length for CodeWScope doesn't match what we found",
                                          idElem);
                     }
-                    frames.pop_back();
+                    frames.pop();
                     if (frames.empty())
                         return makeError("unnested CodeWScope", idElem);
                     curr = &frames.back();
@@ -221,6 +221,20 @@ namespace {
         ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
     }
 
+    TEST(BSONValidateFast, DeeplyNestedObject) {
+        // deeper than the 32 frames the validator keeps inline, alternating objects and arrays
+        BSONObj x = BSON("x" << 1);
+        for (int i = 0; i < 100; i++) {
+            if (i % 2)
+                x = BSON("a" << i << "b" << x);
+            else
+                x = BSON("a" << i << "c" << BSON_ARRAY("d" << x));
+        }
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+        ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() - 1));
+        ASSERT_NOT_OK(validateBSON(x.objdata(), x.objsize() / 2));
+    }
+
     TEST(BSONValidateFast, ErrorWithId) {
         BufBuilder bb;
         BSONObjBuilder ob(bb);
@@ -42,6 +42,7 @@
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/db/structure/collection_iterator.h"
 
 #include "mongo/db/pdfile.h" // XXX-ERH
@@ -157,6 +158,15 @@ namespace mongo {
         return BSONObj::make( rec->accessed() );
     }
 
+    bool Collection::isDocumentCompressed( const DiskLoc& loc ) const {
+        const Record* rec = getExtentManager()->recordFor( loc );
+        return RecordCompression::isCompressed( rec->data() );
+    }
+
+    bool Collection::_compressRecords() const {
+        return _details->isUserFlagSet( NamespaceDetails::Flag_CompressRecords );
+    }
+
     StatusWith<DiskLoc> Collection::insertDocument( const DocWriter* doc, bool enforceQuota ) {
         verify( _indexCatalog.numIndexesTotal() == 0 ); // eventually can implement, just not done
 
@@ -194,8 +204,9 @@ namespace mongo {
 
     StatusWith<DiskLoc> Collection::insertDocument( const BSONObj& doc,
                                                     MultiIndexBlock& indexBlock ) {
-        StatusWith<DiskLoc> loc = _recordStore->insertRecord( doc.objdata(),
-                                                              doc.objsize(),
+        RecordData stored( doc, _compressRecords() );
+        StatusWith<DiskLoc> loc = _recordStore->insertRecord( stored.data(),
+                                                              stored.size(),
                                                               0 );
 
         if ( !loc.isOK() )
@@ -220,8 +231,9 @@ namespace mongo {
         //       under the RecordStore, this feels broken since that should be a
         //       collection access method probably
 
-        StatusWith<DiskLoc> loc = _recordStore->insertRecord( docToInsert.objdata(),
-                                                              docToInsert.objsize(),
+        RecordData stored( docToInsert, _compressRecords() );
+        StatusWith<DiskLoc> loc = _recordStore->insertRecord( stored.data(),
+                                                              stored.size(),
                                                               enforceQuota ? largestFileNumberInQuota() : 0 );
         if ( !loc.isOK() )
             return loc;
@@ -325,7 +337,9 @@ namespace mongo {
             }
         }
 
-        if ( oldRecord->netLength() < objNew.objsize() ) {
+        RecordData stored( objNew, _compressRecords() );
+
+        if ( oldRecord->netLength() < stored.size() ) {
             // doesn't fit, have to move to new location
 
             if ( _details->isCapped() )
@@ -386,8 +400,8 @@ namespace mongo {
         _cursorCache.invalidateDocument(oldLocation, INVALIDATION_MUTATION);
 
         //  update in place
-        int sz = objNew.objsize();
-        memcpy(getDur().writingPtr(oldRecord->data(), sz), objNew.objdata(), sz);
+        int sz = stored.size();
+        memcpy(getDur().writingPtr(oldRecord->data(), sz), stored.data(), sz);
 
         return StatusWith<DiskLoc>( oldLocation );
     }
@@ -132,6 +132,12 @@ namespace mongo {
 
         BSONObj docFor( const DiskLoc& loc );
 
+        /**
+         * @return true if the document at 'loc' is stored compressed, in which case docFor()
+         *         returns a copy and the document can't be modified in place
+         */
+        bool isDocumentCompressed( const DiskLoc& loc ) const;
+
         // ---- things that should move to a CollectionAccessMethod like thing
         /**
          * canonical to get all would be
@@ -222,6 +228,9 @@ namespace mongo {
         // @return 0 for inf., otherwise a number of files
         int largestFileNumberInQuota() const;
 
+        // new documents should be stored compressed
+        bool _compressRecords() const;
+
         ExtentManager* getExtentManager();
         const ExtentManager* getExtentManager() const;
 
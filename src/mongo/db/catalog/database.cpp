@@ -107,11 +107,18 @@ namespace mongo {
                 flags = e.numberInt();
                 flagsSet = true;
             }
+            else if ( fieldName == "compressRecords" ) {
+                compressRecords = e.trueValue();
+            }
             else if ( fieldName == "temp" ) {
                 temp = e.trueValue();
             }
         }
 
+        if ( compressRecords && capped )
+            return Status( ErrorCodes::BadValue,
+                           "compressRecords is not supported for capped collections" );
+
         return Status::OK();
     }
 
@@ -136,6 +143,9 @@ namespace mongo {
         if ( flagsSet )
             b.append( "flags", flags );
 
+        if ( compressRecords )
+            b.appendBool( "compressRecords", true );
+
         if ( temp )
             b.appendBool( "temp", true );
 
@@ -370,6 +380,8 @@ namespace mongo {
         LOG(1) << "dropCollection: " << fullns << endl;
         massertNamespaceNotIndex( fullns, "dropCollection" );
 
+        Lock::assertWriteLocked( _name );
+
         Collection* collection = getCollection( fullns );
         if ( !collection ) {
             // collection doesn't exist
@@ -494,6 +506,8 @@ namespace mongo {
     Status Database::renameCollection( const StringData& fromNS, const StringData& toNS,
                                        bool stayTemp ) {
 
+        Lock::assertWriteLocked( _name );
+
         // move data namespace
         Status s = _renameSingleNamespace( fromNS, toNS, stayTemp );
         if ( !s.isOK() )
@@ -646,6 +660,7 @@ namespace mongo {
                                             const CollectionOptions& options,
                                             bool allocateDefaultSpace,
                                             bool createIdIndex ) {
+        Lock::assertWriteLocked( _name );
         massert( 17399, "collection already exists", _namespaceIndex.details( ns ) == NULL );
         massertNamespaceNotIndex( ns, "createCollection" );
         _namespaceIndex.init();
@@ -687,6 +702,9 @@ namespace mongo {
             nsd->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
         }
 
+        if ( options.compressRecords )
+            nsd->setUserFlag( NamespaceDetails::Flag_CompressRecords );
+
         if ( options.cappedMaxDocs > 0 )
             nsd->setMaxCappedDocs( options.cappedMaxDocs );
 
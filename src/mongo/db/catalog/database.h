@@ -58,6 +58,7 @@ namespace mongo {
             autoIndexId = DEFAULT;
             flags = 0;
             flagsSet = false;
+            compressRecords = false;
             temp = false;
         }
 
@@ -86,6 +87,9 @@ namespace mongo {
         int flags;
         bool flagsSet;
 
+        // store documents snappy compressed, see RecordCompression
+        bool compressRecords;
+
         bool temp;
     };
 
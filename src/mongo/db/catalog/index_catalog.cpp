@@ -55,6 +55,7 @@
 #include "mongo/db/jsobjmanipulator.h"
 #include "mongo/db/keypattern.h"
 #include "mongo/db/ops/delete.h"
+#include "mongo/db/pdfile_private.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/repl/rs.h" // this is ugly
 #include "mongo/db/catalog/collection.h"
@@ -338,6 +339,117 @@ namespace mongo {
         }
     }
 
+    Status IndexCatalog::createIndexes( const std::vector<BSONObj>& specs,
+                                        bool mayInterrupt,
+                                        ShutdownBehavior shutdownBehavior ) {
+        Lock::assertWriteLocked( _collection->_database->name() );
+        _checkMagic();
+        Status status = _checkUnfinished();
+        if ( !status.isOK() )
+            return status;
+
+        // a scan is only worth sharing between foreground builds of non empty collections
+        bool oneScan = _collection->numRecords() > 0;
+        std::vector<BSONObj> toBuild;
+        for ( size_t i = 0; i < specs.size() && oneScan; i++ ) {
+            BSONObj spec = specs[i];
+            if ( spec["background"].trueValue() && !inDBRepair ) {
+                oneScan = false;
+                break;
+            }
+
+            status = okToAddIndex( spec );
+            if ( status.isOK() ) {
+                spec = fixIndexSpec( spec );
+                status = okToAddIndex( spec );
+            }
+            if ( status.code() == ErrorCodes::IndexAlreadyExists )
+                continue;
+            if ( !status.isOK() )
+                return status;
+
+            for ( size_t j = 0; j < toBuild.size(); j++ ) {
+                if ( toBuild[j]["name"].valuestrsafe() == spec["name"].String() ||
+                     toBuild[j]["key"].Obj().woCompare( spec["key"].Obj() ) == 0 ) {
+                    // the same index twice; createIndex says what's wrong with that
+                    oneScan = false;
+                }
+            }
+
+            string pluginName = IndexNames::findPluginName( spec["key"].Obj() );
+            if ( pluginName.size() ) {
+                Status s = _upgradeDatabaseMinorVersionIfNeeded( pluginName );
+                if ( !s.isOK() )
+                    return s;
+            }
+
+            toBuild.push_back( spec );
+        }
+
+        if ( !oneScan || toBuild.size() <= 1 ) {
+            const std::vector<BSONObj>& one = oneScan ? toBuild : specs;
+            for ( size_t i = 0; i < one.size(); i++ ) {
+                status = createIndex( one[i], mayInterrupt, shutdownBehavior );
+                if ( status.code() == ErrorCodes::IndexAlreadyExists )
+                    continue;
+                if ( !status.isOK() )
+                    return status;
+            }
+            return Status::OK();
+        }
+
+        const string ns = _collection->ns().ns(); // our copy
+        MultiIndexBlock indexer( _collection );
+        status = indexer.init( toBuild );
+        if ( !status.isOK() )
+            return status;
+
+        try {
+            // see createIndex
+            if ( mayInterrupt ) {
+                cc().curop()->setQuery( BSON( "indexes" << toBuild ) );
+            }
+
+            for ( size_t i = 0; i < toBuild.size(); i++ ) {
+                IndexDescriptor* descriptor = findIndexByName( toBuild[i]["name"].String(), true );
+                invariant( descriptor );
+                MONGO_TLOG(0) << "build index on: " << ns
+                              << " properties: " << descriptor->toString() << endl;
+                audit::logCreateIndex( currentClient.get(),
+                                       &descriptor->infoObj(),
+                                       descriptor->indexName(),
+                                       ns );
+            }
+
+            Timer t;
+            _collection->infoCache()->addedIndex();
+
+            uassertStatusOK( indexer.insertAllDocumentsInCollection( mayInterrupt ) );
+            uassertStatusOK( indexer.commit( mayInterrupt, true ) );
+
+            MONGO_TLOG(0) << "build indexes done.  built " << toBuild.size() << " indexes in "
+                          << t.millis() / 1000.0 << " secs" << endl;
+            _collection->infoCache()->addedIndex();
+            return Status::OK();
+        }
+        catch ( const AssertionException& exc ) {
+            log() << "index build failed."
+                  << " specs: " << BSON( "indexes" << toBuild )
+                  << " error: " << exc;
+
+            if ( shutdownBehavior == SHUTDOWN_LEAVE_DIRTY &&
+                 exc.getCode() == InterruptedAtShutdown ) {
+                indexer.abort();
+            }
+            // otherwise the indexer cleans up the unfinished indexes
+
+            ErrorCodes::Error codeToUse = ErrorCodes::fromInt( exc.getCode() );
+            if ( codeToUse == ErrorCodes::UnknownError )
+                return Status( ErrorCodes::InternalError, exc.what(), exc.getCode() );
+            return Status( codeToUse, exc.what() );
+        }
+    }
+
     IndexCatalog::IndexBuildBlock::IndexBuildBlock( Collection* collection,
                                                     const BSONObj& spec )
         : _collection( collection ),
@@ -367,6 +479,7 @@ namespace mongo {
         /// ----------   setup on disk structures ----------------
 
         Database* db = _collection->_database;
+        Lock::assertWriteLocked( db->name() );
 
         // 1) insert into system.indexes
 
@@ -773,6 +886,8 @@ namespace mongo {
         if ( !status.isOK() )
             return status;
 
+        Lock::assertWriteLocked( _collection->_database->name() );
+
         // there may be pointers pointing at keys in the btree(s).  kill them.
         // TODO: can this can only clear cursors on this index?
         _collection->cursorCache()->invalidateAll( false );
@@ -1051,6 +1166,18 @@ namespace mongo {
         return entry->accessMethod();
     }
 
+    IndexCatalogEntry* IndexCatalog::getEntry( const IndexDescriptor* desc ) {
+        IndexCatalogEntry* entry = _entries.find( desc );
+        massert( 17416, "cannot find index entry", entry );
+        return entry;
+    }
+
+    const IndexCatalogEntry* IndexCatalog::getEntry( const IndexDescriptor* desc ) const {
+        const IndexCatalogEntry* entry = _entries.find( desc );
+        massert( 17417, "cannot find index entry", entry );
+        return entry;
+    }
+
     IndexAccessMethod* IndexCatalog::_createAccessMethod( const IndexDescriptor* desc,
                                                           IndexCatalogEntry* entry ) {
         const string& type = desc->getAccessMethodName();
@@ -104,6 +104,10 @@ namespace mongo {
         IndexAccessMethod* getIndex( const IndexDescriptor* desc );
         const IndexAccessMethod* getIndex( const IndexDescriptor* desc ) const;
 
+        // never returns NULL
+        IndexCatalogEntry* getEntry( const IndexDescriptor* desc );
+        const IndexCatalogEntry* getEntry( const IndexDescriptor* desc ) const;
+
         class IndexIterator {
         public:
             bool more();
@@ -145,6 +149,14 @@ namespace mongo {
                             bool mayInterrupt,
                             ShutdownBehavior shutdownBehavior = SHUTDOWN_CLEANUP );
 
+        /**
+         * Like calling createIndex for each spec, but foreground builds share one scan of the
+         * collection (see MultiIndexBlock).  Specs for indexes that already exist are skipped.
+         */
+        Status createIndexes( const std::vector<BSONObj>& specs,
+                              bool mayInterrupt,
+                              ShutdownBehavior shutdownBehavior = SHUTDOWN_CLEANUP );
+
         Status okToAddIndex( const BSONObj& spec ) const;
 
         Status dropAllIndexes( bool includingIdIndex );
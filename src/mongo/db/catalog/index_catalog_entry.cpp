@@ -44,7 +44,8 @@ namespace mongo {
           _accessMethod( NULL ),
           _forcedBtreeIndex( NULL ),
           _ordering( Ordering::make( descriptor->keyPattern() ) ),
-          _isReady( false ) {
+          _isReady( false ),
+          _statsMutex( "IndexCatalogEntry::_statsMutex" ) {
         _descriptor->_cachedEntry = this;
     }
 
@@ -78,6 +79,16 @@ namespace mongo {
         return _isReady;
     }
 
+    boost::shared_ptr<const IndexStats> IndexCatalogEntry::getStats() const {
+        SimpleMutex::scoped_lock lk( _statsMutex );
+        return _stats;
+    }
+
+    void IndexCatalogEntry::setStats( const boost::shared_ptr<const IndexStats>& stats ) {
+        SimpleMutex::scoped_lock lk( _statsMutex );
+        _stats = stats;
+    }
+
     bool IndexCatalogEntry::isMultikey() const {
         DEV verify( _isMultikey == _catalogIsMultikey() );
         return _isMultikey;
@@ -30,11 +30,13 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <string>
 
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/ordering.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -42,6 +44,7 @@ namespace mongo {
     class IndexDescriptor;
     class RecordStore;
     class IndexAccessMethod;
+    struct IndexStats;
 
     class IndexCatalogEntry {
         MONGO_DISALLOW_COPYING( IndexCatalogEntry );
@@ -88,6 +91,14 @@ namespace mongo {
         // if this ready is ready for queries
         bool isReady() const;
 
+        // -- statistics for the query planner, gathered in the background
+
+        // NULL if they haven't been gathered yet
+        boost::shared_ptr<const IndexStats> getStats() const;
+
+        // callers only need a read lock
+        void setStats( const boost::shared_ptr<const IndexStats>& stats );
+
     private:
 
         int _indexNo() const;
@@ -113,6 +124,9 @@ namespace mongo {
         bool _isReady; // cache of NamespaceDetails info
         DiskLoc _head; // cache of IndexDetails
         bool _isMultikey; // cache of NamespaceDetails info
+
+        mutable SimpleMutex _statsMutex; // protects _stats
+        boost::shared_ptr<const IndexStats> _stats;
     };
 
     class IndexCatalogEntryContainer {
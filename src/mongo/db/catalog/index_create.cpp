@@ -30,6 +30,9 @@
 
 #include "mongo/db/catalog/index_create.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/background.h"
@@ -47,8 +50,13 @@
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/repl/rs.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/processinfo.h"
 #include "mongo/util/progress_meter.h"
+#include "mongo/util/queue.h"
 
 namespace mongo {
 
@@ -185,6 +193,35 @@ namespace mongo {
         return n;
     }
 
+    /**
+     * Deletes the documents a bulk build found to be duplicates in a dropDups index.
+     */
+    static void deleteDups( Collection* collection,
+                            const std::set<DiskLoc>& dupsToDrop,
+                            bool mayInterrupt ) {
+        string ns = collection->ns().ns(); // our copy
+
+        if ( dupsToDrop.size() )
+            log() << "\t bulk dropping " << dupsToDrop.size() << " dups";
+
+        for( set<DiskLoc>::const_iterator i = dupsToDrop.begin(); i != dupsToDrop.end(); ++i ) {
+            BSONObj toDelete;
+            collection->deleteDocument( *i,
+                                        false /* cappedOk */,
+                                        true /* noWarn */,
+                                        &toDelete );
+            if ( isMaster( ns.c_str() ) ) {
+                logOp( "d", ns.c_str(), toDelete );
+            }
+
+            getDur().commitIfNeeded();
+
+            RARELY if ( mayInterrupt ) {
+                killCurrentOp.checkForInterrupt();
+            }
+        }
+    }
+
     // ---------------------------
 
     // throws DBException
@@ -257,25 +294,7 @@ namespace mongo {
                      str::stream() << "commitBulk failed: " << status.toString(),
                      status.isOK() );
 
-            if ( dupsToDrop.size() )
-                log() << "\t bulk dropping " << dupsToDrop.size() << " dups";
-
-            for( set<DiskLoc>::const_iterator i = dupsToDrop.begin(); i != dupsToDrop.end(); ++i ) {
-                BSONObj toDelete;
-                collection->deleteDocument( *i,
-                                            false /* cappedOk */,
-                                            true /* noWarn */,
-                                            &toDelete );
-                if ( isMaster( ns.c_str() ) ) {
-                    logOp( "d", ns.c_str(), toDelete );
-                }
-                
-                getDur().commitIfNeeded();
-
-                RARELY if ( mayInterrupt ) {
-                    killCurrentOp.checkForInterrupt();
-                }
-            }
+            deleteDups( collection, dupsToDrop, mayInterrupt );
         }
 
         verify( !btreeState->head().isNull() );
@@ -288,6 +307,137 @@ namespace mongo {
 
     // ----------------------------
 
+    // 0 means one per core, up to 8.  1 builds on the thread that runs the command.
+    MONGO_EXPORT_SERVER_PARAMETER(indexBuildThreads, int, 0);
+
+    static int numIndexBuildThreads() {
+        int n = indexBuildThreads;
+        if ( n <= 0 )
+            n = std::min( 8, static_cast<int>( ProcessInfo().getNumCores() ) );
+        return std::max( n, 1 );
+    }
+
+    typedef std::vector<std::pair<BSONObj, DiskLoc> > DocumentBatch;
+
+    /**
+     * Threads that add documents to bulk index builds.  Each thread has its own fork of every
+     * bulk builder (see IndexAccessMethod::forkBulk), so generating and sorting keys needs no
+     * locking.  The workers only look at the documents they are given and don't touch the
+     * catalog or the data files, so they don't need a Client or a lock of their own.
+     */
+    class IndexBuildWorkers {
+        MONGO_DISALLOW_COPYING( IndexBuildWorkers );
+    public:
+        IndexBuildWorkers( const std::vector<IndexAccessMethod*>& bulks, int numThreads )
+            : _queue( 2 * numThreads ),
+              _numThreads( numThreads ),
+              _mutex( "IndexBuildWorkers" ),
+              _status( Status::OK() ) {
+
+            _forks.resize( numThreads );
+            for ( int i = 0; i < numThreads; i++ ) {
+                for ( size_t j = 0; j < bulks.size(); j++ ) {
+                    IndexAccessMethod* fork = bulks[j]->forkBulk();
+                    invariant( fork );
+                    _forks[i].push_back( fork );
+                }
+            }
+
+            for ( int i = 0; i < numThreads; i++ ) {
+                _threads.create_thread( boost::bind( &IndexBuildWorkers::_run, this, i ) );
+            }
+        }
+
+        ~IndexBuildWorkers() {
+            if ( _numThreads ) {
+                // we're unwinding, e.g. the build was interrupted
+                _stop.store( 1 );
+                _join();
+            }
+        }
+
+        /**
+         * Hands 'batch' to a worker, which deletes it.
+         * @return false if a worker has failed, in which case the build should stop
+         */
+        bool add( DocumentBatch* batch ) {
+            _queue.push( batch );
+            return _stop.load() == 0;
+        }
+
+        /**
+         * Waits until all the batches have been added to the builders.
+         * @return the first error a worker hit
+         */
+        Status finish() {
+            _join();
+            mongo::mutex::scoped_lock lk( _mutex );
+            return _status;
+        }
+
+    private:
+        void _join() {
+            for ( int i = 0; i < _numThreads; i++ )
+                _queue.push( NULL );
+            _threads.join_all();
+            _numThreads = 0;
+        }
+
+        void _run( int n ) {
+            const std::string name = str::stream() << "indexBuildWorker" << n;
+            setThreadName( name.c_str() );
+
+            InsertDeleteOptions options;
+            options.logIfError = false;
+            options.dupsAllowed = true;
+
+            const std::vector<IndexAccessMethod*>& forks = _forks[n];
+            while ( DocumentBatch* batch = _queue.blockingPop() ) {
+                // after a failure keep taking batches, so add() doesn't block
+                for ( size_t i = 0; i < batch->size() && _stop.load() == 0; i++ ) {
+                    const BSONObj& obj = (*batch)[i].first;
+                    const DiskLoc& loc = (*batch)[i].second;
+                    for ( size_t j = 0; j < forks.size(); j++ ) {
+                        Status status = Status::OK();
+                        try {
+                            status = forks[j]->insert( obj, loc, options, NULL );
+                        }
+                        catch ( const DBException& e ) {
+                            status = e.toStatus();
+                        }
+                        catch ( const std::exception& e ) {
+                            status = Status( ErrorCodes::InternalError, e.what() );
+                        }
+
+                        if ( !status.isOK() ) {
+                            _fail( status );
+                            break;
+                        }
+                    }
+                }
+                delete batch;
+            }
+        }
+
+        void _fail( const Status& status ) {
+            mongo::mutex::scoped_lock lk( _mutex );
+            if ( _status.isOK() )
+                _status = status;
+            _stop.store( 1 );
+        }
+
+        std::vector< std::vector<IndexAccessMethod*> > _forks; // [thread][index], not owned
+        BlockingQueue<DocumentBatch*> _queue; // NULL tells a worker to exit
+        boost::thread_group _threads;
+        int _numThreads;
+        AtomicUInt32 _stop;
+
+        mongo::mutex _mutex; // protects _status
+        Status _status;
+    };
+
+    // ----------------------------
+
     MultiIndexBlock::MultiIndexBlock( Collection* collection )
         : _collection( collection ) {
     }
@@ -331,17 +481,109 @@ namespace mongo {
         return Status::OK();
     }
 
-    Status MultiIndexBlock::commit() {
+    InsertDeleteOptions MultiIndexBlock::_insertOptions( const IndexState& state ) {
+        InsertDeleteOptions options;
+        options.logIfError = false;
+        options.dupsAllowed = true;
+
+        // bulk builds check uniqueness when they are committed
+        const IndexDescriptor* descriptor = state.block->getEntry()->descriptor();
+        if ( !state.bulk && ( descriptor->isIdIndex() || descriptor->unique() ) ) {
+            if ( !ignoreUniqueIndex( descriptor ) ) {
+                options.dupsAllowed = false;
+            }
+        }
+        return options;
+    }
+
+    Status MultiIndexBlock::insertAllDocumentsInCollection( bool mayInterrupt ) {
+        const string ns = _collection->ns().ns(); // our copy
+
+        ProgressMeter& progress = cc().curop()->setMessage( "Index Build",
+                                                            "Index Build",
+                                                            _collection->numRecords() );
+
+        std::vector<IndexAccessMethod*> bulks;
+        for ( size_t i = 0; i < _states.size(); i++ ) {
+            if ( _states[i].bulk )
+                bulks.push_back( _states[i].bulk );
+        }
+
+        int threads = 1;
+        if ( bulks.size() == _states.size() ) {
+            uint64_t enough = _collection->numRecords() / MinDocumentsPerThread;
+            threads = static_cast<int>( std::min( static_cast<uint64_t>( numIndexBuildThreads() ),
+                                                  enough ) );
+        }
+
+        auto_ptr<Runner> runner( InternalPlanner::collectionScan( ns ) );
+        BSONObj obj;
+        DiskLoc loc;
+
+        if ( threads <= 1 ) {
+            while ( Runner::RUNNER_ADVANCED == runner->getNext( &obj, &loc ) ) {
+                for ( size_t i = 0; i < _states.size(); i++ ) {
+                    Status status = _states[i].forInsert()->insert( obj,
+                                                                    loc,
+                                                                    _insertOptions( _states[i] ),
+                                                                    NULL );
+                    if ( !status.isOK() )
+                        return status;
+                }
+
+                progress.hit();
+                getDur().commitIfNeeded();
+                RARELY if ( mayInterrupt ) {
+                    killCurrentOp.checkForInterrupt();
+                }
+            }
+            progress.finished();
+            return Status::OK();
+        }
+
+        log() << "\t building " << _states.size() << " indexes with " << threads << " threads";
+
+        // the documents point into the data files, which can't be remapped while the workers
+        // have them: there are no writes, and so no commitIfNeeded, until finish()
+        IndexBuildWorkers workers( bulks, threads );
+        auto_ptr<DocumentBatch> batch( new DocumentBatch() );
+        while ( Runner::RUNNER_ADVANCED == runner->getNext( &obj, &loc ) ) {
+            batch->push_back( std::make_pair( obj, loc ) );
+            if ( batch->size() == static_cast<size_t>( DocumentsPerBatch ) ) {
+                if ( !workers.add( batch.release() ) )
+                    break;
+                batch.reset( new DocumentBatch() );
+            }
+
+            progress.hit();
+            RARELY if ( mayInterrupt ) {
+                killCurrentOp.checkForInterrupt();
+            }
+        }
+        if ( !batch->empty() )
+            workers.add( batch.release() );
+
+        Status status = workers.finish();
+        if ( status.isOK() )
+            progress.finished();
+        return status;
+    }
+
+    Status MultiIndexBlock::commit( bool mayInterrupt, bool dropDups ) {
+        std::set<DiskLoc> dupsToDrop;
+
         for ( size_t i = 0; i < _states.size(); i++ ) {
             if ( _states[i].bulk == NULL )
                 continue;
             Status status = _states[i].real->commitBulk( _states[i].bulk,
-                                                         false,
-                                                         NULL );
+                                                         mayInterrupt,
+                                                         dropDups ? &dupsToDrop : NULL );
             if ( !status.isOK() )
                 return status;
         }
 
+        deleteDups( _collection, dupsToDrop, mayInterrupt );
+
         for ( size_t i = 0; i < _states.size(); i++ ) {
             _states[i].block->success();
         }
@@ -349,5 +591,11 @@ namespace mongo {
         return Status::OK();
     }
 
+    void MultiIndexBlock::abort() {
+        for ( size_t i = 0; i < _states.size(); i++ ) {
+            _states[i].block->abort();
+        }
+    }
+
 }  // namespace mongo
 
@@ -62,11 +62,28 @@ namespace mongo {
                        const DiskLoc& loc,
                        const InsertDeleteOptions& options );
 
-        Status commit();
+        /**
+         * Adds every document in the collection to all the indexes, with one collection scan.
+         * If all the indexes are built in bulk, keys are generated and sorted by a pool of
+         * indexBuildThreads threads.  The documents are still read on this thread, which has
+         * the collection locked.
+         */
+        Status insertAllDocumentsInCollection( bool mayInterrupt );
+
+        /**
+         * Finishes the bulk builds and marks the indexes ready.
+         * @param dropDups if true, documents that are duplicates in a dropDups index are
+         *                 deleted from the collection
+         */
+        Status commit( bool mayInterrupt = false, bool dropDups = false );
+
+        /**
+         * Gives up on the builds but leaves their metadata, for when we are shutting down
+         * and the builds should be restarted when the server comes back.
+         */
+        void abort();
 
     private:
-        Collection* _collection;
-
         struct IndexState {
             IndexState()
                 : real( NULL ), bulk( NULL ) {
@@ -79,7 +96,18 @@ namespace mongo {
             IndexAccessMethod* bulk;
         };
 
+        // the options addKeysToIndex uses, for an index that isn't built in bulk
+        static InsertDeleteOptions _insertOptions( const IndexState& state );
+
+        Collection* _collection;
+
         std::vector<IndexState> _states;
+
+        // documents are handed to the index build threads in batches of this many
+        static const int DocumentsPerBatch = 512;
+
+        // smaller collections are indexed on one thread
+        static const int MinDocumentsPerThread = 10000;
     };
 
 } // namespace mongo
@@ -161,6 +161,16 @@ namespace mongo {
         return *c;
     }
 
+    Client* Client::detachFromThread() {
+        return currentClient.release();
+    }
+
+    void Client::attachToThread( Client* c ) {
+        verify( currentClient.get() == 0 );
+        currentClient.reset( c );
+        setThreadName( c->_desc.c_str() );
+    }
+
     Client::Client(const string& desc, AbstractMessagingPort *p) :
         ClientBasic(p),
         _context(0),
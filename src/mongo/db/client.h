@@ -86,6 +86,14 @@ namespace mongo {
             initThread(desc);
         }
 
+        /** detaches this thread's Client without destroying it, so that the connection it
+         *  belongs to can be served by another thread.  see attachToThread.
+         */
+        static Client* detachFromThread();
+
+        /** makes c, from detachFromThread, this thread's Client. the thread must have none. */
+        static void attachToThread( Client* c );
+
         /** this has to be called as the client goes away, but before thread termination
          *  @return true if anything was done
          */
@@ -308,17 +308,19 @@ namespace mongo {
                                 bool mayYield, bool mayBeInterrupted, bool copyIndexes,
                                 bool logForRepl) {
 
-        Client::WriteContext ctx(ns);
+        // creates the collection and its indexes, which needs the whole database
+        Lock::DBWrite lk( nsToDatabaseSubstring( ns ) );
+        Client::Context ctx( ns );
 
         // config
-        string temp = ctx.ctx().db()->name() + ".system.namespaces";
+        string temp = ctx.db()->name() + ".system.namespaces";
         BSONObj config = _conn->findOne(temp , BSON("name" << ns));
         if (config["options"].isABSONObj())
             if (!userCreateNS(ns.c_str(), config["options"].Obj(), errmsg, logForRepl, 0))
                 return false;
 
         // main data
-        copy(ctx.ctx(),
+        copy(ctx,
              ns.c_str(), ns.c_str(), false, logForRepl, false, true, mayYield, mayBeInterrupted,
              Query(query).snapshot());
 
@@ -328,8 +330,8 @@ namespace mongo {
         }
 
         // indexes
-        temp = ctx.ctx().db()->name() + ".system.indexes";
-        copy(ctx.ctx(), temp.c_str(), temp.c_str(), true, logForRepl, false, true, mayYield,
+        temp = ctx.db()->name() + ".system.indexes";
+        copy(ctx, temp.c_str(), temp.c_str(), true, logForRepl, false, true, mayYield,
              mayBeInterrupted, BSON( "ns" << ns ));
 
         getDur().commitIfNeeded();
@@ -666,6 +668,15 @@ namespace mongo {
 
     // SERVER-4328 todo review for concurrency
     thread_specific_ptr< DBClientConnection > authConn_;
+
+    DBClientConnection* detachCopyDbAuthConnection() {
+        return authConn_.release();
+    }
+
+    void attachCopyDbAuthConnection( DBClientConnection* conn ) {
+        authConn_.reset( conn );
+    }
+
     /* Usage:
      admindb.$cmd.findOne( { copydbgetnonce: 1, fromhost: <hostname> } );
      */
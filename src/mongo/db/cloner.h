@@ -125,4 +125,11 @@ namespace mongo {
         bool syncIndexes;
     };
 
+    /**
+     * The connection copydbgetnonce opens for the copydb that follows it on the same client
+     * connection.  Kept per thread; these move it when the client connection changes threads.
+     */
+    DBClientConnection* detachCopyDbAuthConnection();
+    void attachCopyDbAuthConnection( DBClientConnection* conn );
+
 } // namespace mongo
@@ -142,7 +142,7 @@ namespace mongo {
                 compactOptions.validateDocuments = cmdObj["validate"].trueValue();
 
 
-            Lock::DBWrite lk(ns.ns());
+            Lock::DBWrite lk(ns.db()); // the indexes are rebuilt
             BackgroundOperation::assertNoBgOpInProgForNs(ns.ns());
             Client::Context ctx(ns);
 
@@ -156,9 +156,11 @@ namespace mongo {
                 }
             }
 
-            // now we know we have to create index(es)
-            Client::WriteContext writeContext( ns.ns() );
-            Database* db = writeContext.ctx().db();
+            // now we know we have to create index(es).  that changes the catalog, so we need
+            // the whole database even where a write to the collection would lock only it.
+            Lock::DBWrite lk( ns.db() );
+            Client::Context ctx( ns.ns() );
+            Database* db = ctx.db();
 
             Collection* collection = db->getCollection( ns.ns() );
             result.appendBool( "createdCollectionAutomatically", collection == NULL );
@@ -169,20 +171,21 @@ namespace mongo {
 
             result.append( "numIndexesBefore", collection->getIndexCatalog()->numIndexesTotal() );
 
+            // may have been created since we checked
             for ( size_t i = 0; i < specs.size(); i++ ) {
-                BSONObj spec = specs[i];
-
-                status = collection->getIndexCatalog()->createIndex( spec, true );
+                status = collection->getIndexCatalog()->okToAddIndex( specs[i] );
                 if ( status.code() == ErrorCodes::IndexAlreadyExists ) {
                     if ( !result.hasField( "note" ) )
                         result.append( "note", "index already exists" );
-                    continue;
+                    specs.erase( specs.begin() + i );
+                    i--;
                 }
+            }
 
-                if ( !status.isOK() ) {
-                    appendCommandStatus( result, status );
-                    return false;
-                }
+            status = collection->getIndexCatalog()->createIndexes( specs, true );
+            if ( !status.isOK() ) {
+                appendCommandStatus( result, status );
+                return false;
             }
 
             result.append( "numIndexesAfter", collection->getIndexCatalog()->numIndexesTotal() );
@@ -232,6 +232,12 @@ namespace mongo {
             shapeBuilder.append("query", entry->query);
             shapeBuilder.append("sort", entry->sort);
             shapeBuilder.append("projection", entry->projection);
+            if (entry->shapeStats) {
+                shapeBuilder.appendNumber("hits", entry->shapeStats->hits.load());
+                shapeBuilder.appendNumber("misses", entry->shapeStats->misses.load());
+                shapeBuilder.appendNumber("evictions", entry->shapeStats->evictions.load());
+                shapeBuilder.appendNumber("replans", entry->shapeStats->replans.load());
+            }
             shapeBuilder.doneFast();
 
             // Release resources for cached solution after extracting query shape.
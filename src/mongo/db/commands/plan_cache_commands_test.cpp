@@ -138,6 +138,39 @@ namespace {
         ASSERT_EQUALS(shapes[0].getObjectField("query"), cq->getQueryObj());
         ASSERT_EQUALS(shapes[0].getObjectField("sort"), cq->getParsed().getSort());
         ASSERT_EQUALS(shapes[0].getObjectField("projection"), cq->getParsed().getProj());
+        ASSERT_EQUALS(shapes[0].getIntField("hits"), 0);
+    }
+
+    TEST(PlanCacheCommandsTest, planCacheListQueryShapesCounters) {
+        CanonicalQuery* cqRaw;
+        ASSERT_OK(CanonicalQuery::canonicalize(ns, fromjson("{a: 1}"), &cqRaw));
+        auto_ptr<CanonicalQuery> cq(cqRaw);
+
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(createSolutionCacheData());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        // A lookup before the shape is cached is a miss.
+        CachedSolution* rawCS;
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCS));
+        planCache.add(*cq, solns, createDecision(1U));
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_OK(planCache.get(*cq, &rawCS));
+            delete rawCS;
+        }
+
+        // The counters survive the entry being dropped and added again.
+        ASSERT_OK(planCache.remove(*cq));
+        ASSERT_NOT_OK(planCache.get(*cq, &rawCS));
+        planCache.add(*cq, solns, createDecision(1U));
+
+        vector<BSONObj> shapes = getShapes(planCache);
+        ASSERT_EQUALS(shapes.size(), 1U);
+        ASSERT_EQUALS(shapes[0].getIntField("hits"), 3);
+        ASSERT_EQUALS(shapes[0].getIntField("misses"), 2);
+        ASSERT_EQUALS(shapes[0].getIntField("evictions"), 0);
     }
 
     /**
@@ -251,9 +284,11 @@ namespace {
         vector<BSONObj> shapesBefore = getShapes(planCache);
         ASSERT_EQUALS(shapesBefore.size(), 2U);
         BSONObj shapeA = BSON("query" << cqA->getQueryObj() << "sort" << cqA->getParsed().getSort()
-                           << "projection" << cqA->getParsed().getProj());
+                           << "projection" << cqA->getParsed().getProj()
+                           << "hits" << 0 << "misses" << 0 << "evictions" << 0);
         BSONObj shapeB = BSON("query" << cqB->getQueryObj() << "sort" << cqB->getParsed().getSort()
-                           << "projection" << cqB->getParsed().getProj());
+                           << "projection" << cqB->getParsed().getProj()
+                           << "hits" << 0 << "misses" << 0 << "evictions" << 0);
         ASSERT_TRUE(std::find(shapesBefore.begin(), shapesBefore.end(), shapeA) != shapesBefore.end());
         ASSERT_TRUE(std::find(shapesBefore.begin(), shapesBefore.end(), shapeB) != shapesBefore.end());
 
@@ -32,6 +32,8 @@
 
 #include "mongo/db/d_concurrency.h"
 
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/client.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/curop.h"
@@ -56,6 +58,7 @@
 
 #define MONGOD_CONCURRENCY_LEVEL_GLOBAL 0
 #define MONGOD_CONCURRENCY_LEVEL_DB 1
+#define MONGOD_CONCURRENCY_LEVEL_COLLECTION 2
 
 #ifndef MONGOD_CONCURRENCY_LEVEL
 #define MONGOD_CONCURRENCY_LEVEL MONGOD_CONCURRENCY_LEVEL_DB
@@ -64,6 +67,7 @@
 namespace mongo { 
 
     static const bool DB_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_DB );
+    static const bool COLLECTION_LEVEL_LOCKING_ENABLED = ( ( MONGOD_CONCURRENCY_LEVEL ) >= MONGOD_CONCURRENCY_LEVEL_COLLECTION );
 
     inline LockState& lockState() { 
         return cc().lockState();
@@ -95,6 +99,16 @@ namespace mongo {
     typedef mapsf< StringMap<WrapperForRWLock*> > DBLocksMap;
     static DBLocksMap dblocks;
 
+    /* full ns->lock, only used with collection level concurrency.
+       The hierarchy is global -> database -> collection: a DBWrite/DBRead on a normal collection
+       takes the global lock in 'w'/'r' mode, the database lock in intent mode (shared, since
+       writers of different collections are compatible) and then the collection lock itself.
+       Anything touching the database as a whole takes the database lock exclusively, which
+       excludes all intent holders.  Like dblocks, entries are never deleted.
+    */
+    typedef mapsf< StringMap<WrapperForRWLock*> > CollectionLocksMap;
+    static CollectionLocksMap collectionlocks;
+
     /* we don't want to touch dblocks too much as a mutex is involved.  thus party for that, 
        this is here...
     */
@@ -270,6 +284,9 @@ namespace mongo {
     bool Lock::dbLevelLockingEnabled() {
         return DB_LEVEL_LOCKING_ENABLED;
     }
+    bool Lock::collectionLevelLockingEnabled() {
+        return COLLECTION_LEVEL_LOCKING_ENABLED;
+    }
 
     RWLockRecursive &Lock::ParallelBatchWriterMode::_batchLock = *(new RWLockRecursive("special"));
     void Lock::ParallelBatchWriterMode::iAmABatchParticipant() {
@@ -294,7 +311,7 @@ namespace mongo {
 
 
     Lock::ScopedLock::ScopedLock( char type ) 
-        : _type(type), _stat(0) {
+        : _type(type), _stat(0), _collectionStat(0) {
         LockState& ls = lockState();
         ls.enterScopedLock( this );
     }
@@ -326,6 +343,8 @@ namespace mongo {
     void Lock::ScopedLock::_recordTime( long long micros ) {
         if ( _stat )
             _stat->recordLockTimeMicros( _type , micros );
+        if ( _collectionStat ) // the collection itself is held exclusive ('W') or shared ('R')
+            _collectionStat->recordLockTimeMicros( _type == 'w' ? 'W' : 'R' , micros );
         cc().curop()->lockStat().recordLockTimeMicros( _type , micros );
     }
 
@@ -518,15 +537,55 @@ namespace mongo {
         }
     }
 
-    void Lock::DBWrite::lockOther(const StringData& db) {
+    /** nested locking under a collection lock: the outer lock only covers its own collection */
+    static void assertNestedCollectionLock(LockState& ls, const StringData& ns, bool intent) {
+        if( !ls.collectionCount() )
+            return;
+        massert(17407, str::stream() << "can't lock database " << nsToDatabaseSubstring(ns) << " while only collection " << ls.collectionName() << " is locked", intent);
+        massert(17408, str::stream() << "internal error tried to lock two collections at the same time. old:" << ls.collectionName() << " new:" << ns, ns == ls.collectionName());
+    }
+
+    static WrapperForRWLock* getCollectionLock(LockState& ls, const StringData& ns) {
+        if( ns == ls.collectionName() ) {
+            DEV OCCASIONALLY { dassert( collectionlocks.get(ns) == ls.collectionLock() ); }
+            return ls.collectionLock();
+        }
+        CollectionLocksMap::ref r(collectionlocks);
+        WrapperForRWLock*& lock = r[ns];
+        if( lock == 0 )
+            lock = new WrapperForRWLock(ns);
+        return lock;
+    }
+
+    /** only meaningful with 'ns' locked; it can then only be created under the whole db lock */
+    static bool collectionExists(const StringData& ns) {
+        Database* db = dbHolder().get(ns.toString(), storageGlobalParams.dbpath);
+        return db && db->getCollection(ns);
+    }
+
+    void Lock::DBWrite::lockCollection(const StringData& ns) {
+        LockState& ls = lockState();
+        WrapperForRWLock* lock = getCollectionLock(ls, ns);
+        ls.lockedCollection(ns, 1, lock);
+        fassert(17409,_weLockedCollection==0);
+        Timer t;
+        lock->lock();
+        lock->stats.recordAcquireTimeMicros('W', t.micros());
+        _weLockedCollection = lock;
+        setCollectionStat(&lock->stats);
+    }
+
+    void Lock::DBWrite::lockOther(const StringData& db, const StringData& ns) {
         fassert( 16252, !db.empty() );
         LockState& ls = lockState();
+        const bool intent = isCollectionLockable(ns);
 
         // we do checks first, as on assert destructor won't be called so don't want to be half finished with our work.
         if( ls.otherCount() ) { 
             // nested. if/when we do temprelease with DBWrite we will need to increment here
             // (so we can not release or assert if nested).
             massert(16106, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db , db == ls.otherName() );
+            assertNestedCollectionLock(ls, ns, intent);
             return;
         }
 
@@ -547,8 +606,35 @@ namespace mongo {
         }
         
         fassert(16134,_weLocked==0);
-        ls.otherLock()->lock();
-        _weLocked = ls.otherLock();
+        if( intent ) {
+            // other writers of this database only need to be excluded from our collection
+            ls.otherLock()->lock_shared();
+            _weLocked = ls.otherLock();
+            lockCollection(ns);
+            if( !collectionExists(ns) ) {
+                // creating it (or opening the database) writes the catalog: take the whole db
+                ls.unlockedCollection();
+                _weLockedCollection->unlock();
+                setCollectionStat(0);
+                _weLockedCollection = 0;
+                _weLocked->unlock_shared();
+                _weLocked->lock();
+            }
+        }
+        else {
+            ls.otherLock()->lock();
+            _weLocked = ls.otherLock();
+        }
+    }
+
+    bool Lock::isIntentLocked(const StringData& db) {
+        LockState& ls = lockState();
+        return ls.collectionCount() != 0 && db == ls.otherName();
+    }
+
+    bool Lock::isIntentWriteLocked(const StringData& db) {
+        LockState& ls = lockState();
+        return ls.collectionCount() > 0 && db == ls.otherName();
     }
 
     static Lock::Nestable n(const StringData& db) { 
@@ -559,6 +645,16 @@ namespace mongo {
         return Lock::notnestable;
     }
 
+    bool Lock::isCollectionLockable(const StringData& ns) {
+        if( !COLLECTION_LEVEL_LOCKING_ENABLED )
+            return false;
+        NamespaceString nss(ns);
+        // system collections hold the catalog (and profile data) for the whole database, so
+        // they are only ever touched with the database locked exclusively.
+        return !nss.coll().empty() && nss.isNormal() && !nss.isSystem() &&
+            n(nss.db()) == Lock::notnestable;
+    }
+
     void Lock::DBWrite::lockDB(const string& ns) {
         fassert( 16253, !ns.empty() );
         LockState& ls = lockState();
@@ -567,6 +663,7 @@ namespace mongo {
         _locked_W=false;
         _locked_w=false; 
         _weLocked=0;
+        _weLockedCollection=0;
 
 
         massert( 16186 , "can't get a DBWrite while having a read lock" , ! ls.hasAnyReadLock() );
@@ -583,7 +680,7 @@ namespace mongo {
                 return;
             } 
             if( !nested )
-                lockOther(db);
+                lockOther(db, ns);
             lockTop(ls);
             if( nested )
                 lockNestable(nested);
@@ -601,6 +698,7 @@ namespace mongo {
         Acquiring a(this,ls);
         _locked_r=false; 
         _weLocked=0; 
+        _weLockedCollection=0;
 
         if ( ls.isRW() )
             return;
@@ -608,7 +706,7 @@ namespace mongo {
             StringData db = nsToDatabaseSubstring(ns);
             Nestable nested = n(db);
             if( !nested )
-                lockOther(db);
+                lockOther(db, ns);
             lockTop(ls);
             if( nested )
                 lockNestable(nested);
@@ -640,12 +738,21 @@ namespace mongo {
         if( _weLocked ) {
             recordTime();  // for lock stats
         
+            if( _weLockedCollection ) {
+                lockState().unlockedCollection();
+                _weLockedCollection->unlock();
+                setCollectionStat(0);
+            }
+
             if ( _nested )
                 lockState().unlockedNestable();
             else
                 lockState().unlockedOther();
     
-            _weLocked->unlock();
+            if( _weLockedCollection )
+                _weLocked->unlock_shared(); // intent
+            else
+                _weLocked->unlock();
         }
 
         if( _locked_w ) {
@@ -659,18 +766,28 @@ namespace mongo {
             qlk.unlock_W();
         }
         _weLocked = 0;
+        _weLockedCollection = 0;
         _locked_W = _locked_w = false;
     }
     void Lock::DBRead::unlockDB() {
         if( _weLocked ) {
             recordTime();  // for lock stats
         
+            if( _weLockedCollection ) {
+                lockState().unlockedCollection();
+                _weLockedCollection->unlock_shared();
+                setCollectionStat(0);
+            }
+
             if( _nested )
                 lockState().unlockedNestable();
             else
                 lockState().unlockedOther();
 
-            _weLocked->unlock_shared();
+            if( COLLECTION_LEVEL_LOCKING_ENABLED && !_nested && !_weLockedCollection )
+                _weLocked->unlock(); // see lockOther
+            else
+                _weLocked->unlock_shared();
         }
 
         if( _locked_r ) {
@@ -681,6 +798,7 @@ namespace mongo {
             }
         }
         _weLocked = 0;
+        _weLockedCollection = 0;
         _locked_r = false;
     }
 
@@ -708,15 +826,29 @@ namespace mongo {
         }
     }
 
-    void Lock::DBRead::lockOther(const StringData& db) {
+    void Lock::DBRead::lockCollection(const StringData& ns) {
+        LockState& ls = lockState();
+        WrapperForRWLock* lock = getCollectionLock(ls, ns);
+        ls.lockedCollection(ns, -1, lock);
+        fassert(17410,_weLockedCollection==0);
+        Timer t;
+        lock->lock_shared();
+        lock->stats.recordAcquireTimeMicros('R', t.micros());
+        _weLockedCollection = lock;
+        setCollectionStat(&lock->stats);
+    }
+
+    void Lock::DBRead::lockOther(const StringData& db, const StringData& ns) {
         fassert( 16255, !db.empty() );
         LockState& ls = lockState();
+        const bool intent = isCollectionLockable(ns);
 
         // we do checks first, as on assert destructor won't be called so don't want to be half finished with our work.
         if( ls.otherCount() ) { 
             // nested. prev could be read or write. if/when we do temprelease with DBRead/DBWrite we will need to increment/decrement here
             // (so we can not release or assert if nested).  temprelease we should avoid if we can though, it's a bit of an anti-pattern.
             massert(16099, str::stream() << "internal error tried to lock two databases at the same time. old:" << ls.otherName() << " new:" << db, db == ls.otherName() );
+            assertNestedCollectionLock(ls, ns, intent);
             return;
         }
 
@@ -736,8 +868,21 @@ namespace mongo {
             ls.lockedOther(-1);
         }
         fassert(16135,_weLocked==0);
-        ls.otherLock()->lock_shared();
-        _weLocked = ls.otherLock();
+        if( intent ) {
+            ls.otherLock()->lock_shared();
+            _weLocked = ls.otherLock();
+            lockCollection(ns);
+        }
+        else if( COLLECTION_LEVEL_LOCKING_ENABLED ) {
+            // a read of the whole database (or its catalog) must exclude the intent writers,
+            // which also hold this lock shared
+            ls.otherLock()->lock();
+            _weLocked = ls.otherLock();
+        }
+        else {
+            ls.otherLock()->lock_shared();
+            _weLocked = ls.otherLock();
+        }
     }
 
     Lock::DBWrite::UpgradeToExclusive::UpgradeToExclusive() {
@@ -861,10 +1006,37 @@ namespace mongo {
             b.append(".", qlk.stats.report());
             b.append("admin", nestableLocks[Lock::admin]->stats.report());
             b.append("local", nestableLocks[Lock::local]->stats.report());
+
+            // per collection stats when collection locking is on, listed under their database
+            // since a full ns isn't a usable field name
+            map<string, vector<WrapperForRWLock*> > collectionsByDb;
+            {
+                CollectionLocksMap::ref r(collectionlocks);
+                for( CollectionLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
+                    collectionsByDb[nsToDatabase(i->first)].push_back(i->second);
+                }
+            }
+
             {
                 DBLocksMap::ref r(dblocks);
                 for( DBLocksMap::const_iterator i = r.r.begin(); i != r.r.end(); ++i ) {
-                    b.append(i->first, i->second->stats.report());
+                    const vector<WrapperForRWLock*>& collections = collectionsByDb[i->first];
+                    if( collections.empty() ) {
+                        b.append(i->first, i->second->stats.report());
+                        continue;
+                    }
+
+                    BSONObjBuilder db( b.subobjStart(i->first) );
+                    db.appendElements(i->second->stats.report());
+                    BSONArrayBuilder arr( db.subarrayStart("collections") );
+                    for( size_t j = 0; j < collections.size(); j++ ) {
+                        BSONObjBuilder coll( arr.subobjStart() );
+                        coll.append("name", nsToCollectionSubstring(collections[j]->name()));
+                        coll.appendElements(collections[j]->stats.report());
+                        coll.done();
+                    }
+                    arr.done();
+                    db.done();
                 }
             }
             return b.obj();
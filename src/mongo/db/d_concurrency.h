@@ -61,6 +61,20 @@ namespace mongo {
         static void assertWriteLocked(const StringData& ns);
 
         static bool dbLevelLockingEnabled(); 
+        static bool collectionLevelLockingEnabled();
+
+        /**
+         * @return true if DBWrite/DBRead on 'ns' lock only that collection, holding the
+         * database in intent mode.  Always false unless built with collection level concurrency.
+         */
+        static bool isCollectionLockable(const StringData& ns);
+
+        /**
+         * @return true if we hold 'db' only in intent mode, beneath a lock on one of its
+         * collections.  Such a holder may reach the database's files, but not its catalog.
+         */
+        static bool isIntentLocked(const StringData& db);
+        static bool isIntentWriteLocked(const StringData& db);
         
         static LockStat* globalLockStat();
         static LockStat* nestableLockStat( Nestable db );
@@ -117,6 +131,9 @@ namespace mongo {
         protected:
             explicit ScopedLock( char type ); 
 
+            // Lock time is also accrued to the collection's stat when one is set
+            void setCollectionStat( LockStat* stat ) { _collectionStat = stat; }
+
         private:
             friend struct TempRelease;
             void tempRelease(); // TempRelease class calls these
@@ -133,6 +150,7 @@ namespace mongo {
             Timer _timer;
             char _type;      // 'r','w','R','W'
             LockStat* _stat; // the stat for the relevant lock to increment when we're done
+            LockStat* _collectionStat; // set when only a single collection is locked
         };
 
         // note that for these classes recursive locking is ok if the recursive locking "makes sense"
@@ -164,18 +182,22 @@ namespace mongo {
         };
 
         // lock this database. do not shared_lock globally first, that is handledin herein. 
+        // with collection level concurrency, a collection ns locks the database in intent mode
+        // and then the collection itself exclusively.
         class DBWrite : public ScopedLock {
             /**
              * flow
              *   1) lockDB
              *      a) lockTop
              *      b) lockNestable or lockOther
+             *         lockOther -> lockCollection (collection level concurrency only)
              *   2) unlockDB
              */
 
             void lockTop(LockState&);
             void lockNestable(Nestable db);
-            void lockOther(const StringData& db);
+            void lockOther(const StringData& db, const StringData& ns);
+            void lockCollection(const StringData& ns);
             void lockDB(const string& ns);
             void unlockDB();
 
@@ -201,6 +223,7 @@ namespace mongo {
             bool _locked_w;
             bool _locked_W;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_weLockedCollection;
             const string _what;
             bool _nested;
         };
@@ -209,7 +232,8 @@ namespace mongo {
         class DBRead : public ScopedLock {
             void lockTop(LockState&);
             void lockNestable(Nestable db);
-            void lockOther(const StringData& db);
+            void lockOther(const StringData& db, const StringData& ns);
+            void lockCollection(const StringData& ns);
             void lockDB(const string& ns);
             void unlockDB();
 
@@ -224,6 +248,7 @@ namespace mongo {
         private:
             bool _locked_r;
             WrapperForRWLock *_weLocked;
+            WrapperForRWLock *_weLockedCollection;
             string _what;
             bool _nested;
             
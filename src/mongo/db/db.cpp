@@ -45,6 +45,7 @@
 #include "mongo/db/catalog/index_key_validate.h"
 #include "mongo/db/client.h"
 #include "mongo/db/clientcursor.h"
+#include "mongo/db/cloner.h"
 #include "mongo/db/commands/server_status.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/db/d_globals.h"
@@ -54,6 +55,7 @@
 #include "mongo/db/dur.h"
 #include "mongo/db/index_names.h"
 #include "mongo/db/index_rebuilder.h"
+#include "mongo/db/index_stats_monitor.h"
 #include "mongo/db/initialize_server_global_state.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/introspect.h"
@@ -74,6 +76,7 @@
 #include "mongo/db/storage_options.h"
 #include "mongo/db/ttl.h"
 #include "mongo/platform/process_id.h"
+#include "mongo/s/d_logic.h"
 #include "mongo/s/d_writeback.h"
 #include "mongo/scripting/engine.h"
 #include "mongo/util/background.h"
@@ -184,6 +187,16 @@ namespace mongo {
         sleepmicros( Client::recommendedYieldMicros() );
     }
 
+    /**
+     * Per connection state kept in thread locals, detached while a connection served by the
+     * ConnectionReactor waits between requests.  LastError is moved by the reactor itself.
+     */
+    struct ConnectionSession {
+        Client* client;
+        ShardedConnectionInfo* shardedInfo;
+        DBClientConnection* copyDbAuthConn;
+    };
+
     class MyMessageHandler : public MessageHandler {
     public:
         virtual void connected( AbstractMessagingPort* p ) {
@@ -244,6 +257,30 @@ namespace mongo {
             if( c ) c->shutdown();
         }
 
+        virtual bool supportsSessionHandoff() const { return true; }
+
+        virtual void* detachSession() {
+            ConnectionSession* s = new ConnectionSession();
+            s->client = Client::detachFromThread();
+            s->shardedInfo = ShardedConnectionInfo::detach();
+            s->copyDbAuthConn = detachCopyDbAuthConnection();
+            return s;
+        }
+
+        virtual void attachSession( void* session ) {
+            scoped_ptr<ConnectionSession> s( static_cast<ConnectionSession*>( session ) );
+            Client::attachToThread( s->client );
+            ShardedConnectionInfo::attach( s->shardedInfo );
+            attachCopyDbAuthConnection( s->copyDbAuthConn );
+        }
+
+        virtual void destroySession( void* session ) {
+            scoped_ptr<ConnectionSession> s( static_cast<ConnectionSession*>( session ) );
+            delete s->client;
+            delete s->shardedInfo;
+            delete s->copyDbAuthConn;
+        }
+
     };
 
     void logStartup() {
@@ -746,6 +783,7 @@ namespace mongo {
         else {
             startTTLBackgroundJob();
         }
+        startIndexStatsBackgroundJob();
 
 #ifndef _WIN32
         mongo::signalForkSuccess();
@@ -1080,6 +1080,7 @@ namespace mongo {
             help << 
                 "Sets collection options.\n"
                 "Example: { collMod: 'foo', usePowerOf2Sizes:true }\n"
+                "Example: { collMod: 'foo', compressRecords:true }\n"
                 "Example: { collMod: 'foo', index: {keyPattern: {a: 1}, expireAfterSeconds: 600} }";
         }
         virtual void addRequiredPrivileges(const std::string& dbname,
@@ -1125,6 +1126,25 @@ namespace mongo {
                         result.appendBool( "usePowerOf2Sizes_new", newPowerOf2 );
                     }
                 }
+                else if ( str::equals( "compressRecords", e.fieldName() ) ) {
+                    // documents already stored keep their form until they are rewritten
+                    bool oldCompress = nsd->isUserFlagSet(NamespaceDetails::Flag_CompressRecords);
+                    bool newCompress = e.trueValue();
+
+                    if ( newCompress && nsd->isCapped() ) {
+                        errmsg = "compressRecords is not supported for capped collections";
+                        ok = false;
+                    }
+                    else if ( oldCompress != newCompress ) {
+                        result.appendBool( "compressRecords_old", oldCompress );
+
+                        newCompress ? nsd->setUserFlag( NamespaceDetails::Flag_CompressRecords ) :
+                                      nsd->clearUserFlag( NamespaceDetails::Flag_CompressRecords );
+                        nsd->syncUserFlags( ns ); // must keep system.namespaces up-to-date
+
+                        result.appendBool( "compressRecords_new", newCompress );
+                    }
+                }
                 else if ( str::equals( "index", e.fieldName() ) ) {
                     BSONObj indexObj = e.Obj();
                     BSONObj keyPattern = indexObj.getObjectField( "keyPattern" );
@@ -55,22 +55,29 @@
      READLOCK dbMutex (big 'R')
      LOCK groupCommitMutex
        PREPLOGBUFFER()
-     READLOCK mmmutex
        commitJob.reset()
-     UNLOCK dbMutex                      // now other threads can write
-       WRITETOJOURNAL()
-       WRITETODATAFILES()
-     UNLOCK mmmutex
+       hand off to the commit pipeline
      UNLOCK groupCommitMutex
+     UNLOCK dbMutex                      // now other threads can write
+
+   pipeline:
 
-   every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. because of
-   that we are in W lock for that groupCommit, which is nonideal of course.
+     WRITETOJOURNAL() and WRITETODATAFILES() each run on their own thread, taking commits in the
+     order they were prepared, so with a slow disk commit N+1 is prepared while N is fsync'd to
+     the journal and N-1 is applied to the data files.  getlasterror j:true is acknowledged as
+     soon as the journal write is done.  WRITETODATAFILES takes the mmmutex (shared); closing a
+     file waits for the pipeline to empty first.
+
+   every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. that needs
+   every earlier commit in the data files, so we wait for the pipeline to empty (in R) and then
+   upgrade to W for the remap itself.
 
    @see https://docs.google.com/drawings/edit?id=1TklsmZzm7ohIZkwgeK6rMvsdaR13KjtJYMsfLr175Zc
 */
 
 #include "mongo/pch.h"
 
+#include <boost/bind.hpp>
 #include <boost/thread/thread.hpp>
 
 #include "mongo/db/client.h"
@@ -86,6 +93,7 @@
 #include "mongo/util/concurrency/race.h"
 #include "mongo/util/mongoutils/hash.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/queue.h"
 #include "mongo/util/stacktrace.h"
 #include "mongo/util/timer.h"
 
@@ -128,7 +136,7 @@ namespace mongo {
         string _CSVHeader();
 
         string Stats::S::_CSVHeader() { 
-            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tprpLgB  wrToJ\twrToDF\trmpPrVw";
+            return "cmts  jrnMB\twrDFMB\tcIWLk\tearly\tprpLgB  wrToJ\twrToDF\trmpPrVw\tjQueue\tdfQueue";
         }
 
         string Stats::S::_asCSV() { 
@@ -143,7 +151,9 @@ namespace mongo {
                 (unsigned) (_prepLogBufferMicros/1000) << '\t' << 
                 (unsigned) (_writeToJournalMicros/1000) << '\t' << 
                 (unsigned) (_writeToDataFilesMicros/1000) << '\t' << 
-                (unsigned) (_remapPrivateViewMicros/1000);
+                (unsigned) (_remapPrivateViewMicros/1000) << '\t' << 
+                (unsigned) (_journalQueueMicros/1000) << '\t' << 
+                (unsigned) (_dataFilesQueueMicros/1000);
             return ss.str();
         }
 
@@ -162,8 +172,18 @@ namespace mongo {
                              "prepLogBuffer" << (unsigned) (_prepLogBufferMicros/1000) <<
                              "writeToJournal" << (unsigned) (_writeToJournalMicros/1000) <<
                              "writeToDataFiles" << (unsigned) (_writeToDataFilesMicros/1000) <<
-                             "remapPrivateView" << (unsigned) (_remapPrivateViewMicros/1000)
-                           );
+                             "remapPrivateView" << (unsigned) (_remapPrivateViewMicros/1000) <<
+                             "journalQueue" << (unsigned) (_journalQueueMicros/1000) <<
+                             "dataFilesQueue" << (unsigned) (_dataFilesQueueMicros/1000)
+                           ) <<
+                       "maxMs" <<
+                       BSON( "prepLogBuffer" << (unsigned) (_prepLogBufferMaxMicros/1000) <<
+                             "writeToJournal" << (unsigned) (_writeToJournalMaxMicros/1000) <<
+                             "writeToDataFiles" << (unsigned) (_writeToDataFilesMaxMicros/1000) <<
+                             "remapPrivateView" << (unsigned) (_remapPrivateViewMaxMicros/1000) <<
+                             "commit" << (unsigned) (_commitLatencyMaxMicros/1000)
+                           ) <<
+                       "pipelineDrains" << _pipelineDrains;
             if (storageGlobalParams.journalCommitInterval != 0)
                 b << "journalCommitIntervalMs" << storageGlobalParams.journalCommitInterval;
             return b.obj();
@@ -567,68 +587,204 @@ namespace mongo {
         void REMAPPRIVATEVIEW() {
             Timer t;
             _REMAPPRIVATEVIEW();
-            stats.curr->_remapPrivateViewMicros += t.micros();
+            unsigned long long m = t.micros();
+            stats.curr->_remapPrivateViewMicros += m;
+            Stats::noteMax(stats.curr->_remapPrivateViewMaxMicros, m);
         }
 
-        // this is a pseudo-local variable in the groupcommit functions 
-        // below.  however we don't truly do that so that we don't have to 
-        // reallocate, and more importantly regrow it, on every single commit.
-        static AlignedBuilder __theBuilder(4 * 1024 * 1024);
+        /** a group commit on its way through the commit pipeline.  see top of file. */
+        struct CommitBatch : boost::noncopyable {
+            // 4MB to start so that we don't have to regrow it on every single commit
+            CommitBatch() : ab(4 * 1024 * 1024) { clear(); }
+            void clear() {
+                empty = true;
+                commitNumber = 0;
+                preparedAt = 0;
+                queuedAt = 0;
+            }
+
+            JSectHeader h;
+            AlignedBuilder ab;
+            bool empty;                     // nothing was written; only acknowledge commitNumber
+            NotifyAll::When commitNumber;   // for getlasterror j:true
+            unsigned long long preparedAt;  // curTimeMicros64() when PREPLOGBUFFER began
+            unsigned long long queuedAt;    // when handed to the current stage
+        };
+
+        /** runs WRITETOJOURNAL and WRITETODATAFILES for prepared commits on their own threads, one
+            commit per stage at a time and in commit order.  the commit thread can thus prepare
+            commit N+1 while N is being written to the journal and N-1 to the data files.  there
+            are only as many buffers as stages, so if the disk falls behind, preparing waits for a
+            buffer rather than using more and more ram.
+        */
+        class CommitPipeline : boost::noncopyable {
+        public:
+            CommitPipeline() : _m("commitPipeline"), _inFlight(0) {
+                for( int i = 0; i < NumBuffers; i++ )
+                    _free.push(&_buffers[i]);
+            }
+
+            void start() {
+                boost::thread journalWriter(boost::bind(&CommitPipeline::journalWriterThread, this));
+                boost::thread dataFileWriter(boost::bind(&CommitPipeline::dataFileWriterThread, this));
+            }
+
+            /** blocks until a buffer is free.  don't hold the db lock while calling if avoidable */
+            CommitBatch* getBuffer() {
+                return _free.blockingPop();
+            }
+
+            /** for a buffer from getBuffer() that won't be submitted after all */
+            void giveBack(CommitBatch* b) {
+                _free.push(b);
+            }
+
+            /** call in groupCommitMutex so that commits are journaled in the order they began */
+            void submit(CommitBatch* b) {
+                commitJob.groupCommitMutex.dassertLocked();
+                {
+                    scoped_lock lk(_m);
+                    _inFlight++;
+                }
+                b->queuedAt = curTimeMicros64();
+                _toJournal.push(b);
+            }
+
+            /** waits until every commit submitted so far is in the data files */
+            void drain() {
+                scoped_lock lk(_m);
+                if( _inFlight == 0 )
+                    return;
+                stats.curr->_pipelineDrains++;
+                while( _inFlight > 0 )
+                    _drained.wait(lk.boost());
+            }
+
+        private:
+            void journalWriterThread() {
+                Client::initThread("journalWriter");
+                try {
+                    while( 1 ) {
+                        CommitBatch* b = _toJournal.blockingPop();
+                        if( !b->empty ) {
+                            stats.curr->_journalQueueMicros += curTimeMicros64() - b->queuedAt;
+                            WRITETOJOURNAL(b->h, b->ab);
+                        }
+
+                        // data is now in the journal, which is sufficient for acknowledging
+                        // getLastError.  (ok to crash after that)
+                        commitJob.committingNotifyCommitted(b->commitNumber);
+
+                        unsigned long long now = curTimeMicros64();
+                        if( !b->empty )
+                            Stats::noteMax(stats.curr->_commitLatencyMaxMicros, now - b->preparedAt);
+                        b->queuedAt = now;
+                        _toDataFiles.push(b);
+                    }
+                }
+                catch(std::exception& e) {
+                    log() << "exception in journal writer causing immediate shutdown: " << e.what() << endl;
+                    mongoAbort("dur5");
+                }
+            }
+
+            void dataFileWriterThread() {
+                Client::initThread("journalDataFiles");
+                try {
+                    while( 1 ) {
+                        CommitBatch* b = _toDataFiles.blockingPop();
+                        if( !b->empty ) {
+                            stats.curr->_dataFilesQueueMicros += curTimeMicros64() - b->queuedAt;
+                            // files can't close under us: closing one drains the pipeline first
+                            // (closingFileNotification), and processSection holds the files lock.
+                            // private view readers won't see anything as we do this, but external
+                            // viewers of the datafiles will see them mutating.
+                            WRITETODATAFILES(b->h, b->ab);
+                        }
+                        b->ab.reset();
+                        b->clear();
+
+                        {
+                            scoped_lock lk(_m);
+                            if( --_inFlight == 0 )
+                                _drained.notify_all();
+                        }
+                        _free.push(b);
+                    }
+                }
+                catch(std::exception& e) {
+                    log() << "exception in journal data file writer causing immediate shutdown: " << e.what() << endl;
+                    mongoAbort("dur6");
+                }
+            }
+
+            enum { NumBuffers = 3 }; // preparing, journaling, writing to the data files
+            CommitBatch _buffers[NumBuffers];
+            BlockingQueue<CommitBatch*> _free;
+            BlockingQueue<CommitBatch*> _toJournal;
+            BlockingQueue<CommitBatch*> _toDataFiles;
+
+            mongo::mutex _m;
+            boost::condition _drained;
+            unsigned _inFlight; // submitted but not yet through WRITETODATAFILES
+        };
+
+        static CommitPipeline& commitPipeline = *(new CommitPipeline()); // don't destroy
+
+        /** starts a group commit in 'b': PREPLOGBUFFER, and reset the commit job so that others
+            may write again.  in groupCommitMutex, and in a lock that excludes writes (as write
+            intent structures point into the private mmap for their actual data).
+        */
+        static void prepareCommit(CommitBatch* b) {
+            commitJob.commitingBegin(); // increments the commit epoch for getlasterror j:true
+            b->commitNumber = commitJob.commitNumber();
+            b->preparedAt = curTimeMicros64();
+
+            if( !commitJob.hasWritten() ) {
+                // getlasterror request could have came after the data was already committed.
+                // we still go through the pipeline so it is acknowledged after earlier commits
+                return;
+            }
+
+            b->empty = false;
+            PREPLOGBUFFER(b->h, b->ab);
+            commitJob.committingReset(); // must be reset before allowing anyone to write
+            DEV verify( !commitJob.hasWritten() );
+        }
 
         static bool _groupCommitWithLimitedLocks() {
             unspoolWriteIntents(); // in case we were doing some writing ourself (likely impossible with limitedlocks version)
-            AlignedBuilder &ab = __theBuilder;
 
             verify( ! Lock::isLocked() );
 
+            // get a buffer before locking; if the journal or data files are behind this is where
+            // we wait
+            CommitBatch* b = commitPipeline.getBuffer();
+
             // do we need this to be greedy, so that it can start working fairly soon?
             // probably: as this is a read lock, it wouldn't change anything if only reads anyway.
             // also needs to stop greed. our time to work before clearing lk1 is not too bad, so 
             // not super critical, but likely 'correct'.  todo.
-            scoped_ptr<Lock::GlobalRead> lk1( new Lock::GlobalRead() );
+            Lock::GlobalRead lk1;
 
             SimpleMutex::scoped_lock lk2(commitJob.groupCommitMutex);
 
-            commitJob.commitingBegin(); // increments the commit epoch for getlasterror j:true
-
-            if( !commitJob.hasWritten() ) {
-                // getlasterror request could have came after the data was already committed
-                commitJob.committingNotifyCommitted();
+            if( inShutdown() ) {
+                // the final commit at shutdown does the rest.  checked in groupCommitMutex so that
+                // we can't submit after that commit has drained the pipeline and files are closing
+                commitPipeline.giveBack(b);
                 return true;
             }
 
-            JSectHeader h;
             // need to be in readlock (writes excluded) for this as write intent stuctures point into 
             // the private mmap for their actual data.  i suppose we could lock individual databases 
             // and do them one at a time or in parallel (surely the latter would make sense if one went 
             // that route...)
-            PREPLOGBUFFER(h,ab); 
-
-            LockMongoFilesShared lk3;
-
-            unsigned abLen = ab.len();
-            commitJob.committingReset(); // must be reset before allowing anyone to write
-            DEV verify( !commitJob.hasWritten() );
+            prepareCommit(b);
 
-            // release the readlock -- allowing others to now write while we are writing to the journal (etc.)
-            lk1.reset();
-
-            // ****** now other threads can do writes ******
-
-            WRITETOJOURNAL(h, ab);
-            verify( abLen == ab.len() ); // a check that no one touched the builder while we were doing work. if so, our locking is wrong.
-
-            // data is now in the journal, which is sufficient for acknowledging getLastError.
-            // (ok to crash after that)
-            commitJob.committingNotifyCommitted();
-
-            // note the higher-up-the-chain locking of filesLockedFsync is important here, 
-            // as we are not in Lock::GlobalRead anymore. private view readers won't see 
-            // anything as we do this, but external viewers of the datafiles will see them 
-            // mutating.
-            WRITETODATAFILES(h, ab);
-            verify( abLen == ab.len() ); // check again wasn't modded
-            ab.reset();
+            // journaling and writing to the data files happen on the pipeline threads; once we
+            // release the readlock others can write while that work is done
+            commitPipeline.submit(b);
 
             // can't : d.dbMutex._remapPrivateViewRequested = true;
             // (writes have happened we released)
@@ -669,40 +825,29 @@ namespace mongo {
             unspoolWriteIntents(); // in case we were doing some writing ourself
 
             {
-                AlignedBuilder &ab = __theBuilder;
+                CommitBatch* b = commitPipeline.getBuffer();
 
-                // we need to make sure two group commits aren't running at the same time
+                // we need to make sure two group commits aren't prepared at the same time
                 // (and we are only read locked in the dbMutex, so it could happen -- while 
                 // there is only one dur thread, "early commits" can be done by other threads)
                 SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
 
-                commitJob.commitingBegin();
-
-                if( !commitJob.hasWritten() ) {
-                    // getlasterror request could have came after the data was already committed
-                    commitJob.committingNotifyCommitted();
+                if( lgw && inShutdown() ) {
+                    // durThread: the final commit at shutdown does the rest (see above)
+                    commitPipeline.giveBack(b);
+                    return;
                 }
-                else {
-                    JSectHeader h;
-                    PREPLOGBUFFER(h,ab);
-
-                    // todo : write to the journal outside locks, as this write can be slow.
-                    //        however, be careful then about remapprivateview as that cannot be done 
-                    //        if new writes are then pending in the private maps.
-                    WRITETOJOURNAL(h, ab);
-
-                    // data is now in the journal, which is sufficient for acknowledging getLastError.
-                    // (ok to crash after that)
-                    commitJob.committingNotifyCommitted();
 
-                    WRITETODATAFILES(h, ab);
-                    debugValidateAllMapsMatch();
-
-                    commitJob.committingReset();
-                    ab.reset();
-                }
+                prepareCommit(b);
+                commitPipeline.submit(b);
             }
 
+            // our callers need everything in the data files before we return: the remap below,
+            // a file that is about to close, fsync+lock.  earlier commits still in the pipeline
+            // are finished by the time ours is.
+            commitPipeline.drain();
+            debugValidateAllMapsMatch();
+
             // REMAPPRIVATEVIEW
             //
             // remapping private views must occur after WRITETODATAFILES otherwise
@@ -801,6 +946,9 @@ namespace mongo {
 
             if( Lock::isLocked() ) {
                 getDur().commitIfNeeded(true);
+                // commitIfNeeded can't always commit from our lock state; either way, writes to
+                // this file from earlier commits must land before it goes away
+                commitPipeline.drain();
             }
             else {
                 verify( inShutdown() );
@@ -908,6 +1056,7 @@ namespace mongo {
 
             preallocateFiles();
 
+            commitPipeline.start();
             boost::thread t(durThread);
         }
 
@@ -915,12 +1064,8 @@ namespace mongo {
             verify( Lock::isW() );
 
             // a commit from the commit thread won't begin while we are in the write lock,
-            // but it may already be in progress and the end of that work is done outside 
-            // (dbMutex) locks. This line waits for that to complete if already underway.
-            {
-                SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
-            }
-
+            // but earlier ones may still be in the commit pipeline, which works outside
+            // (dbMutex) locks.  commitNow() waits for those to complete.
             commitNow();
             MongoFile::flushAll(true);
             journalCleanup();
@@ -167,10 +167,15 @@ namespace mongo {
         public:
             /** these called by the groupCommit code as it goes along */
             void commitingBegin();
-            /** the commit code calls this when data reaches the journal (on disk) */
-            void committingNotifyCommitted() { 
+            /** the number to acknowledge once the commit started by commitingBegin() is on disk */
+            NotifyAll::When commitNumber() const {
                 groupCommitMutex.dassertLocked();
-                _notify.notifyAll(_commitNumber); 
+                return _commitNumber;
+            }
+            /** the commit pipeline calls this when data reaches the journal (on disk).  commits reach
+                the journal in the order they began, so this acknowledges everything up to 'n' */
+            void committingNotifyCommitted(NotifyAll::When n) {
+                _notify.notifyAll(n);
             }
             /** we use the commitjob object over and over, calling reset() rather than reconstructing */
             void committingReset() {
@@ -160,6 +160,17 @@ namespace mongo {
             }
         }
 
+        /** journal sections are padded so that each append is whole pages, as the journal is
+            written with O_DIRECT.  that used to be Alignment (8KB) always; a page is usually 4KB,
+            and with frequent small commits (j:true, a short journalCommitInterval) the padding is
+            most of what we write.
+        */
+        static unsigned journalSectionAlignment() {
+            static const unsigned a = std::max<unsigned>(4096, g_minOSPageSizeBytes);
+            dassert( Alignment % a == 0 ); // sections start right after the Alignment sized JHeader
+            return a;
+        }
+
         JHeader::JHeader(string fname) {
             magic[0] = 'j'; magic[1] = '\n';
             _version = CurrentVersion;
@@ -172,6 +183,7 @@ namespace mongo {
                 fileId = t&0xffffffff;
                 fileId |= static_cast<unsigned long long>( getMySecureRandomNumber() ) << 32;
             }
+            sectionAlignment = journalSectionAlignment();
             memset(reserved3, 0, sizeof(reserved3));
             txt2[0] = txt2[1] = '\n';
             n1 = n2 = n3 = n4 = '\n';
@@ -725,7 +737,9 @@ namespace mongo {
         void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed) {
             Timer t;
             j.journal(h, uncompressed);
-            stats.curr->_writeToJournalMicros += t.micros();
+            unsigned long long m = t.micros();
+            stats.curr->_writeToJournalMicros += m;
+            Stats::noteMax(stats.curr->_writeToJournalMaxMicros, m);
         }
         void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             RACECHECK
@@ -740,33 +754,51 @@ namespace mongo {
             b.reset(max);
 
             {
-                dassert( h.sectionLen() == (unsigned) 0xffffffff ); // we will backfill later
-                b.appendStruct(h);
+                dassert( h.sectionLen() == (unsigned) 0x7fffffff ); // we will backfill later
+                JSectHeader hdr = h;
+                {
+                    // the section may have been prepared while the previous one was still being
+                    // written (and rotated us to a new file), so stamp the id of the file it will
+                    // actually go in.  only the journal writer thread rotates, so this can't change
+                    // before we append.
+                    SimpleMutex::scoped_lock lk(_curLogFileMutex);
+                    hdr.fileId = _curFileId;
+                }
+                b.appendStruct(hdr);
             }
 
             size_t compressedLength = 0;
             rawCompress(uncompressed.buf(), uncompressed.len(), b.cur(), &compressedLength);
             verify( compressedLength < 0xffffffff );
             verify( compressedLength < max );
-            b.skip(compressedLength);
+            // data that doesn't compress (binary, already compressed by the app) is stored as is;
+            // the section is no bigger than the raw data and recovery skips the uncompress
+            const bool compressed = compressedLength < uncompressed.len();
+            if( compressed ) {
+                b.skip(compressedLength);
+            }
+            else {
+                memcpy(b.cur(), uncompressed.buf(), uncompressed.len());
+                b.skip(uncompressed.len());
+            }
 
             // footer
             unsigned L = 0xffffffff;
             {
                 // pad to alignment, and set the total section length in the JSectHeader
-                verify( 0xffffe000 == (~(Alignment-1)) );
+                const unsigned alignment = journalSectionAlignment();
                 unsigned lenUnpadded = b.len() + sizeof(JSectFooter);
-                L = (lenUnpadded + Alignment-1) & (~(Alignment-1));
+                L = (lenUnpadded + alignment-1) & (~(alignment-1));
                 dassert( L >= lenUnpadded );
 
-                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded);
+                ((JSectHeader*)b.atOfs(0))->setSectionLen(lenUnpadded, compressed);
 
                 JSectFooter f(b.buf(), b.len()); // computes checksum
                 b.appendStruct(f);
                 dassert( b.len() == lenUnpadded );
 
                 b.skip(L - lenUnpadded);
-                dassert( b.len() % Alignment == 0 );
+                dassert( b.len() % alignment == 0 );
             }
 
             try {
@@ -51,8 +51,11 @@ namespace mongo {
 #if defined(_NOCOMPRESS)
             enum { CurrentVersion = 0x4148 };
 #else
-            enum { CurrentVersion = 0x4149 };
+            enum { CurrentVersion = 0x414a };
 #endif
+            // files from before sectionAlignment and uncompressed sections.  we can still recover
+            // from them, as they are the same format with every section compressed and 8KB aligned
+            enum { PreviousVersion = 0x4149 };
             unsigned short _version;
 
             // these are just for diagnostic ease (make header more useful as plain text)
@@ -64,10 +67,13 @@ namespace mongo {
 
             unsigned long long fileId; // unique identifier that will be in each JSectHeader. important as we recycle prealloced files
 
-            char reserved3[8026]; // 8KB total for the file header
+            unsigned sectionAlignment; // sections in this file are padded to this. 0 (older files) means Alignment
+
+            char reserved3[8022]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
-            bool versionOk() const { return _version == CurrentVersion; }
+            bool versionOk() const { return _version == CurrentVersion || _version == PreviousVersion; }
+            unsigned alignment() const { return sectionAlignment ? sectionAlignment : Alignment; }
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
@@ -77,19 +83,26 @@ namespace mongo {
         */
         struct JSectHeader {
         private:
-            unsigned _sectionLen;          // unpadded length in bytes of the whole section
+            // unpadded length in bytes of the whole section.  the high bit is set if the operations
+            // were stored uncompressed, which we do when compressing wouldn't make them smaller
+            unsigned _sectionLen;
+            enum { Uncompressed = 0x80000000 };
         public:
             unsigned long long seqNumber;  // sequence number that can be used on recovery to not do too much work
             unsigned long long fileId;     // matches JHeader::fileId
-            unsigned sectionLen() const { return _sectionLen; }
+            unsigned sectionLen() const { return _sectionLen & ~Uncompressed; }
+            bool compressed() const { return !(_sectionLen & Uncompressed); }
 
             // we store the unpadded length so we can use that when we uncompress. to 
-            // get the true total size this must be rounded up to the Alignment.
-            void setSectionLen(unsigned lenUnpadded) { _sectionLen = lenUnpadded; }
+            // get the true total size this must be rounded up to the file's alignment.
+            void setSectionLen(unsigned lenUnpadded, bool compressed = true) {
+                _sectionLen = lenUnpadded | (compressed ? 0 : Uncompressed);
+            }
 
-            unsigned sectionLenWithPadding() const { 
-                unsigned x = (sectionLen() + (Alignment-1)) & (~(Alignment-1));
-                dassert( x % Alignment == 0 );
+            /** @param alignment JHeader::alignment() of the file the section is in */
+            unsigned sectionLenWithPadding(unsigned alignment) const { 
+                unsigned x = (sectionLen() + (alignment-1)) & (~(alignment-1));
+                dassert( x % alignment == 0 );
                 return x;
             }
         };
@@ -121,6 +121,12 @@ namespace mongo {
                 , _doDurOps(doDurOpsRecovering)
             {
                 verify( doDurOpsRecovering );
+                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
+                if( !_h.compressed() ) {
+                    // stored as is as it didn't compress
+                    _entries = auto_ptr<BufReader>( new BufReader(compressed, compressedLen) );
+                    return;
+                }
                 bool ok = uncompress((const char *)compressed, compressedLen, &_uncompressed);
                 if( !ok ) { 
                     // it should always be ok (i think?) as there is a previous check to see that the JSectFooter is ok
@@ -128,7 +134,6 @@ namespace mongo {
                     msgasserted(15874, "couldn't uncompress journal section");
                 }
                 const char *p = _uncompressed.c_str();
-                verify( compressedLen == _h.sectionLen() - sizeof(JSectFooter) - sizeof(JSectHeader) );
                 _entries = auto_ptr<BufReader>( new BufReader(p, _uncompressed.size()) );
             }
 
@@ -436,6 +441,7 @@ namespace mongo {
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
             try {
                 unsigned long long fileId;
+                unsigned alignment;
                 BufReader br(p,len);
 
                 {
@@ -460,9 +466,10 @@ namespace mongo {
                         uasserted(13536, str::stream() << "journal version number mismatch " << h._version);
                     }
                     fileId = h.fileId;
+                    alignment = h.alignment();
                     if (storageGlobalParams.durOptions &
                         StorageGlobalParams::DurDumpJournal) {
-                        log() << "JHeader::fileId=" << fileId << endl;
+                        log() << "JHeader::fileId=" << fileId << " alignment=" << alignment << endl;
                     }
                 }
 
@@ -480,7 +487,7 @@ namespace mongo {
                     }
                     unsigned slen = h.sectionLen();
                     unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
-                    const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
+                    const char *hdr = (const char *) br.skip(h.sectionLenWithPadding(alignment));
                     const char *data = hdr + sizeof(JSectHeader);
                     const char *footer = data + dataLen;
                     processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
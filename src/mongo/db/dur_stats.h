@@ -31,8 +31,10 @@
 namespace mongo {
     namespace dur {
 
-        /** journaling stats.  the model here is that the commit thread is the only writer, and that reads are
-            uncommon (from a serverStatus command and such).  Thus, there should not be multicore chatter overhead.
+        /** journaling stats.  the model here is that the commit pipeline threads are the only writers, and that
+            reads are uncommon (from a serverStatus command and such).  Thus, there should not be multicore chatter
+            overhead.  each field is written by a single stage's thread; a stage finishing just as the commit thread
+            rotates may be counted in either interval.
         */
         struct Stats {
             Stats();
@@ -56,6 +58,25 @@ namespace mongo {
                 unsigned long long _writeToDataFilesMicros;
                 unsigned long long _remapPrivateViewMicros;
 
+                // slowest single commit for each stage this interval
+                unsigned long long _prepLogBufferMaxMicros;
+                unsigned long long _writeToJournalMaxMicros;
+                unsigned long long _writeToDataFilesMaxMicros;
+                unsigned long long _remapPrivateViewMaxMicros;
+
+                // time prepared commits waited for the journal writer / journaled commits waited to be
+                // written to the data files.  large values mean that stage is the bottleneck
+                unsigned long long _journalQueueMicros;
+                unsigned long long _dataFilesQueueMicros;
+
+                // from the start of PREPLOGBUFFER until the commit is on disk in the journal, which is
+                // what a getlasterror j:true waits for (beyond waiting for the commit to start)
+                unsigned long long _commitLatencyMaxMicros;
+
+                // commits that had to wait for all earlier commits to reach the data files, for
+                // remapping or because a file is closing
+                unsigned _pipelineDrains;
+
                 // undesirable to be in write lock for the group commit (it can be done in a read lock), so good if we
                 // have visibility when this happens.  can happen for a couple reasons
                 // - read lock starvation
@@ -66,6 +87,12 @@ namespace mongo {
                 unsigned _dtMillis;
             };
             S *curr;
+
+            /** note 'micros' as the time of one commit in a stage, keeping the largest */
+            static void noteMax(unsigned long long& max, unsigned long long micros) {
+                if( micros > max )
+                    max = micros;
+            }
         private:
             S _a,_b;
             unsigned long long _lastRotate;
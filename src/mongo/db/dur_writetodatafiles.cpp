@@ -106,6 +106,7 @@ namespace mongo {
             WRITETODATAFILES_Impl1(h, uncompressed);
             unsigned long long m = t.micros();
             stats.curr->_writeToDataFilesMicros += m;
+            Stats::noteMax(stats.curr->_writeToDataFilesMaxMicros, m);
             LOG(2) << "journal WRITETODATAFILES " << m / 1000.0 << "ms" << endl;
         }
 
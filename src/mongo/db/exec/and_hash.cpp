@@ -30,29 +30,71 @@
 
 #include "mongo/db/exec/and_common-inl.h"
 #include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/storage/record_compression.h"
+
+namespace {
+
+    using namespace mongo;
+
+    // What a buffered WSM costs us.  Index keys are owned copies; an unowned obj is in the
+    // mapped file and doesn't count.
+    size_t getMemUsage(const WorkingSetMember* member) {
+        size_t memUsage = sizeof(WorkingSetMember);
+        for (size_t i = 0; i < member->keyData.size(); ++i) {
+            memUsage += member->keyData[i].keyData.objsize();
+        }
+        if (member->obj.isOwned()) {
+            memUsage += member->obj.objsize();
+        }
+        return memUsage;
+    }
+
+}  // namespace
 
 namespace mongo {
 
     const size_t AndHashStage::kLookAheadWorks = 10;
 
-    AndHashStage::AndHashStage(WorkingSet* ws, const MatchExpression* filter)
+    const size_t AndHashStage::kDefaultMaxMemUsage = 32 * 1024 * 1024;
+
+    AndHashStage::AndHashStage(WorkingSet* ws, const MatchExpression* filter, size_t maxMemUsage)
         : _ws(ws),
           _filter(filter),
+          _memUsage(0),
+          _maxMemUsage(maxMemUsage),
+          _locsOnly(false),
+          _idBeingPagedIn(WorkingSet::INVALID_ID),
           _hashingChildren(true),
-          _currentChild(0) {}
+          _currentChild(0) {
+
+        _specificStats.memLimit = _maxMemUsage;
+    }
 
     AndHashStage::~AndHashStage() {
         for (size_t i = 0; i < _children.size(); ++i) { delete _children[i]; }
     }
 
-    void AndHashStage::addChild(PlanStage* child) { _children.push_back(child); }
+    void AndHashStage::addChild(PlanStage* child) {
+        _children.push_back(child);
+        _scans.push_back(NULL);
+    }
+
+    void AndHashStage::addIndexScanChild(IndexScan* child) {
+        _children.push_back(child);
+        _scans.push_back(child);
+    }
 
     bool AndHashStage::isEOF() {
         // This is empty before calling work() and not-empty after.
         if (_lookAheadResults.empty()) { return false; }
 
+        // We still owe our parent the result it's paging in.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) { return false; }
+
         // Either we're busy hashing children, in which case we're not done yet.
         if (_hashingChildren) { return false; }
 
@@ -72,6 +114,17 @@ namespace mongo {
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
+        // If we asked our parent for a page-in last time, the document is there now.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            WorkingSetID id = _idBeingPagedIn;
+            _idBeingPagedIn = WorkingSet::INVALID_ID;
+            WorkingSetMember* member = _ws->get(id);
+            member->obj = member->loc.obj();
+            member->keyData.clear();
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            return returnIfMatches(member, id, out);
+        }
+
         // Fast-path for one of our children being EOF immediately.  We work each child a few times.
         // If it hits EOF, the AND cannot output anything.  If it produces a result, we stash that
         // result in _lookAheadResults.
@@ -97,7 +150,7 @@ namespace mongo {
 
                         // A child went right to EOF.  Bail out.
                         _hashingChildren = false;
-                        _dataMap.clear();
+                        _dataMap = DataMap();
                         return PlanStage::IS_EOF;
                     }
                     else if (PlanStage::ADVANCED == childStatus) {
@@ -110,7 +163,7 @@ namespace mongo {
                         *out = _lookAheadResults[i];
 
                         _hashingChildren = false;
-                        _dataMap.clear();
+                        _dataMap = DataMap();
                         return PlanStage::FAILURE;
                     }
                     // We ignore NEED_TIME.  TODO: What do we want to do if the child provides
@@ -167,7 +220,7 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
-        DataMap::iterator it = _dataMap.find(member->loc);
+        DataMap::const_iterator it = _dataMap.find(member->loc);
         if (_dataMap.end() == it) {
             // Child's output wasn't in every previous child.  Throw it out.
             _ws->free(*out);
@@ -180,23 +233,120 @@ namespace mongo {
             WorkingSetID hashID = it->second;
             _dataMap.erase(it);
 
+            if (WorkingSet::INVALID_ID == hashID) {
+                // We only kept the DiskLoc, so the key data from the other children is gone.
+                return fetchProbeResult(*out, out);
+            }
+
             WorkingSetMember* olderMember = _ws->get(hashID);
+            _memUsage -= getMemUsage(olderMember);
             AndCommon::mergeFrom(olderMember, *member);
             _ws->free(*out);
 
             // We should check for matching at the end so the matcher can use information in the
             // indices of all our children.
-            if (Filter::passes(olderMember, _filter)) {
-                *out = hashID;
-                ++_commonStats.advanced;
-                return PlanStage::ADVANCED;
+            return returnIfMatches(olderMember, hashID, out);
+        }
+    }
+
+    PlanStage::StageState AndHashStage::fetchProbeResult(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+        ++_specificStats.fetchedResults;
+
+        // Our last child may have fetched it already.
+        if (member->hasObj()) {
+            return returnIfMatches(member, id, out);
+        }
+
+        verify(WorkingSetMember::LOC_AND_IDX == member->state);
+        const char* data = member->loc.rec()->dataNoThrowing();
+        if (!Record::likelyInPhysicalMemory(data)) {
+            verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+            _idBeingPagedIn = id;
+            *out = id;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+
+        // The filter may be over fields we no longer have keys for, so test the whole document.
+        member->obj = RecordCompression::document(data);
+        member->keyData.clear();
+        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        return returnIfMatches(member, id, out);
+    }
+
+    PlanStage::StageState AndHashStage::returnIfMatches(WorkingSetMember* member,
+                                                        WorkingSetID id,
+                                                        WorkingSetID* out) {
+        if (Filter::passes(member, _filter)) {
+            *out = id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+        else {
+            _ws->free(id);
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+    }
+
+    size_t AndHashStage::memUsage() const {
+        return _memUsage
+               + _dataMap.capacity() * DataMap::slotBytes()
+               + _seenMap.capacity() * SeenMap::slotBytes()
+               + (NULL == _locFilter.get() ? 0 : _locFilter->memUsage());
+    }
+
+    bool AndHashStage::checkMemUsage(WorkingSetID* out) {
+        const size_t usage = memUsage();
+        if (usage > _specificStats.memUsage) {
+            _specificStats.memUsage = usage;
+        }
+        if (usage <= _maxMemUsage) {
+            return true;
+        }
+
+        if (!_locsOnly) {
+            // Keep the DiskLocs and let go of everything else.
+            for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+                _ws->free(it->second);
+                _dataMap[it->first] = WorkingSet::INVALID_ID;
             }
-            else {
-                _ws->free(hashID);
-                ++_commonStats.needTime;
-                return PlanStage::NEED_TIME;
+            _memUsage = 0;
+            _locsOnly = true;
+            _specificStats.locsOnly = true;
+
+            if (memUsage() <= _maxMemUsage) {
+                return true;
             }
         }
+
+        mongoutils::str::stream ss;
+        ss << "hashed AND stage buffered data usage of " << memUsage()
+           << " bytes exceeds internal limit of " << _maxMemUsage << " bytes";
+        Status status(ErrorCodes::Overflow, ss);
+        *out = WorkingSetCommon::allocateStatusMember(_ws, status);
+        return false;
+    }
+
+    void AndHashStage::pushLocFilter() {
+        // Whatever the previous child was given describes a bigger table than we have now.
+        if (NULL != _locFilter.get()) {
+            for (size_t i = 0; i < _scans.size(); ++i) {
+                if (NULL != _scans[i]) { _scans[i]->setLocFilter(NULL); }
+            }
+            _locFilter.reset();
+        }
+
+        if (_currentChild >= _scans.size() || NULL == _scans[_currentChild]) {
+            return;
+        }
+
+        _locFilter.reset(new DiskLocBloomFilter(_dataMap.size()));
+        for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
+            _locFilter->insert(it->first);
+        }
+        _scans[_currentChild]->setLocFilter(_locFilter.get());
     }
 
     PlanStage::StageState AndHashStage::workChild(size_t childNo, WorkingSetID* out) {
@@ -229,7 +379,19 @@ namespace mongo {
             verify(member->hasLoc());
             verify(_dataMap.end() == _dataMap.find(member->loc));
 
-            _dataMap[member->loc] = id;
+            if (_locsOnly) {
+                _dataMap[member->loc] = WorkingSet::INVALID_ID;
+                _ws->free(id);
+            }
+            else {
+                _dataMap[member->loc] = id;
+                _memUsage += getMemUsage(member);
+            }
+
+            if (!checkMemUsage(out)) {
+                return PlanStage::FAILURE;
+            }
+
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
         }
@@ -245,6 +407,7 @@ namespace mongo {
 
             ++_commonStats.needTime;
             _specificStats.mapAfterChild.push_back(_dataMap.size());
+            pushLocFilter();
 
             return PlanStage::NEED_TIME;
         }
@@ -282,16 +445,26 @@ namespace mongo {
             }
 
             verify(member->hasLoc());
-            if (_dataMap.end() == _dataMap.find(member->loc)) {
+            DataMap::const_iterator it = _dataMap.find(member->loc);
+            if (_dataMap.end() == it) {
                 // Ignore.  It's not in any previous child.
             }
             else {
-                // We have a hit.  Copy data into the WSM we already have.
-                _seenMap.insert(member->loc);
-                WorkingSetMember* olderMember = _ws->get(_dataMap[member->loc]);
-                AndCommon::mergeFrom(olderMember, *member);
+                // We have a hit.  Copy data into the WSM we already have, if we still have it.
+                _seenMap[member->loc] = true;
+                if (WorkingSet::INVALID_ID != it->second) {
+                    WorkingSetMember* olderMember = _ws->get(it->second);
+                    _memUsage -= getMemUsage(olderMember);
+                    AndCommon::mergeFrom(olderMember, *member);
+                    _memUsage += getMemUsage(olderMember);
+                }
             }
             _ws->free(id);
+
+            if (!checkMemUsage(out)) {
+                return PlanStage::FAILURE;
+            }
+
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
         }
@@ -299,21 +472,21 @@ namespace mongo {
             // Finished with a child.
             ++_currentChild;
 
-            // Keep elements of _dataMap that are in _seenMap.
-            DataMap::iterator it = _dataMap.begin();
-            while (it != _dataMap.end()) {
+            // Keep elements of _dataMap that are in _seenMap.  Erasing only marks the slot free,
+            // so the iterator stays good.
+            for (DataMap::const_iterator it = _dataMap.begin(); it != _dataMap.end(); ++it) {
                 if (_seenMap.end() == _seenMap.find(it->first)) {
-                    DataMap::iterator toErase = it;
-                    ++it;
-                    _ws->free(toErase->second);
-                    _dataMap.erase(toErase);
+                    if (WorkingSet::INVALID_ID != it->second) {
+                        _memUsage -= getMemUsage(_ws->get(it->second));
+                        _ws->free(it->second);
+                    }
+                    _dataMap.erase(it);
                 }
-                else { ++it; }
             }
 
             _specificStats.mapAfterChild.push_back(_dataMap.size());
 
-            _seenMap.clear();
+            _seenMap = SeenMap();
 
             // _dataMap is now the intersection of the first _currentChild nodes.
 
@@ -327,6 +500,7 @@ namespace mongo {
             if (_currentChild == _children.size()) {
                 _hashingChildren = false;
             }
+            pushLocFilter();
 
             ++_commonStats.needTime;
             return PlanStage::NEED_TIME;
@@ -386,16 +560,39 @@ namespace mongo {
             }
         }
 
+        // A result we're waiting on a page-in for is flagged the same way as the ones still in
+        // _dataMap below.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn) {
+            WorkingSetMember* member = _ws->get(_idBeingPagedIn);
+            if (member->hasLoc() && member->loc == dl) {
+                ++_specificStats.flaggedButPassed;
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+                _ws->flagForReview(_idBeingPagedIn);
+                _idBeingPagedIn = WorkingSet::INVALID_ID;
+            }
+        }
+
         // If it's a deletion, we have to forget about the DiskLoc, and since the AND-ing is by
         // DiskLoc we can't continue processing it even with the object.
         //
         // If it's a mutation the predicates implied by the AND-ing may no longer be true.
         //
         // So, we flag and try to pick it up later.
-        DataMap::iterator it = _dataMap.find(dl);
+        DataMap::const_iterator it = _dataMap.find(dl);
         if (_dataMap.end() != it) {
             WorkingSetID id = it->second;
-            WorkingSetMember* member = _ws->get(id);
+            WorkingSetMember* member;
+            if (WorkingSet::INVALID_ID == id) {
+                // We only kept the DiskLoc.  Make a WSM to hold the document.
+                id = _ws->allocate();
+                member = _ws->get(id);
+                member->loc = dl;
+                member->state = WorkingSetMember::LOC_AND_IDX;
+            }
+            else {
+                member = _ws->get(id);
+                _memUsage -= getMemUsage(member);
+            }
             verify(member->loc == dl);
 
             if (_hashingChildren) {
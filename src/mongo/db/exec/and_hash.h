@@ -33,12 +33,14 @@
 
 #include "mongo/db/diskloc.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/exec/diskloc_map.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
-#include "mongo/platform/unordered_set.h"
 
 namespace mongo {
 
+    class IndexScan;
+
     /**
      * Reads from N children, each of which must have a valid DiskLoc.  Uses a hash table to
      * intersect the outputs of the N children, and outputs the intersection.
@@ -49,14 +51,29 @@ namespace mongo {
      * is fetched and added to the WorkingSet as "flagged for further review."  Because this stage
      * operates with DiskLocs, we are unable to evaluate the AND for the invalidated DiskLoc, and it
      * must be fully matched later.
+     *
+     * The hash table is held to 'maxMemUsage' bytes.  Past that we free the WSMs we're buffering
+     * and keep only their DiskLocs, fetching the document for each result instead.  If the
+     * DiskLocs alone don't fit either, we fail.
+     *
+     * Children are best added smallest first: the first child fills the table, and the table can
+     * only shrink after that.
      */
     class AndHashStage : public PlanStage {
     public:
-        AndHashStage(WorkingSet* ws, const MatchExpression* filter);
+        AndHashStage(WorkingSet* ws,
+                     const MatchExpression* filter,
+                     size_t maxMemUsage = kDefaultMaxMemUsage);
         virtual ~AndHashStage();
 
         void addChild(PlanStage* child);
 
+        /**
+         * Like addChild, but once we know which DiskLocs can possibly intersect we hand the scan a
+         * bloom filter of them, so it can skip the rest without allocating WSMs.
+         */
+        void addIndexScanChild(IndexScan* child);
+
         virtual StageState work(WorkingSetID* out);
         virtual bool isEOF();
 
@@ -66,6 +83,8 @@ namespace mongo {
 
         virtual PlanStageStats* getStats();
 
+        static const size_t kDefaultMaxMemUsage;
+
     private:
         static const size_t kLookAheadWorks;
 
@@ -73,6 +92,30 @@ namespace mongo {
         StageState hashOtherChildren(WorkingSetID* out);
         StageState workChild(size_t childNo, WorkingSetID* out);
 
+        /**
+         * The last child's output 'id' is in every other child but we dropped our copy of it.
+         * Fetch it and test it against _filter, or ask for a page-in.
+         */
+        StageState fetchProbeResult(WorkingSetID id, WorkingSetID* out);
+        StageState returnIfMatches(WorkingSetMember* member, WorkingSetID id, WorkingSetID* out);
+
+        /**
+         * Makes sure we're within _maxMemUsage, dropping the buffered WSMs if need be.  Returns
+         * false, with a status member in 'out', if even the DiskLocs are too many.
+         */
+        bool checkMemUsage(WorkingSetID* out);
+
+        /**
+         * How much we're holding: the buffered WSMs plus the hash tables.
+         */
+        size_t memUsage() const;
+
+        /**
+         * Builds a bloom filter over _dataMap for the child we're about to start on, if it's an
+         * index scan.
+         */
+        void pushLocFilter();
+
         // Not owned by us.
         WorkingSet* _ws;
 
@@ -87,16 +130,36 @@ namespace mongo {
         // we place that result here.
         std::vector<WorkingSetID> _lookAheadResults;
 
+        // _scans[i] is _children[i] if that child is an index scan we can push a filter into,
+        // NULL otherwise.
+        std::vector<IndexScan*> _scans;
+
         // _dataMap is filled out by the first child and probed by subsequent children.  This is the
         // hash table that we create by intersecting _children and probe with the last child.
-        typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
+        // Once _locsOnly is set the values are all WorkingSet::INVALID_ID.
+        typedef DiskLocMap<WorkingSetID> DataMap;
         DataMap _dataMap;
 
         // Keeps track of what elements from _dataMap subsequent children have seen.
         // Only used while _hashingChildren.
-        typedef unordered_set<DiskLoc, DiskLoc::Hasher> SeenMap;
+        typedef DiskLocMap<bool> SeenMap;
         SeenMap _seenMap;
 
+        // What's in _dataMap, as of the start of the current child.  Not owned by the scan it's
+        // pushed into.
+        boost::scoped_ptr<DiskLocBloomFilter> _locFilter;
+
+        // Bytes of WSMs we're buffering in _dataMap.
+        size_t _memUsage;
+
+        size_t _maxMemUsage;
+
+        // True once we've freed the WSMs in _dataMap to save memory.
+        bool _locsOnly;
+
+        // A result we've asked our parent to page in.
+        WorkingSetID _idBeingPagedIn;
+
         // True if we're still intersecting _children[0..._children.size()-1].
         bool _hashingChildren;
 
@@ -107,6 +107,42 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState CollectionScan::workBatch(size_t maxWorks,
+                                                    std::vector<WorkingSetID>* results,
+                                                    WorkingSetID* out) {
+        // Opening the iterator, tailing and maxScan are handled one document at a time.
+        if (NULL == _iter || _nsDropped || _params.tailable || 0 != _params.maxScan) {
+            return PlanStage::workBatch(maxWorks, results, out);
+        }
+
+        // Read a run of documents, then filter them all at once.
+        const size_t first = results->size();
+        size_t scanned = 0;
+        while (scanned < maxWorks && !_iter->isEOF()) {
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->loc = _iter->getNext();
+            member->obj = member->loc.obj();
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            results->push_back(id);
+            ++scanned;
+        }
+
+        const size_t passed = Filter::filterBatch(_workingSet, _filter, results, first);
+
+        _commonStats.works += scanned;
+        _commonStats.advanced += passed;
+        _commonStats.needTime += scanned - passed;
+        _specificStats.docsTested += scanned;
+
+        if (scanned < maxWorks) {
+            // What the next call to work() would have found.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
     bool CollectionScan::isEOF() {
         if ((0 != _params.maxScan) && (_specificStats.docsTested >= _params.maxScan)) {
             return true;
@@ -51,6 +51,9 @@ namespace mongo {
                        const MatchExpression* filter);
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
         virtual bool isEOF();
 
         virtual void invalidate(const DiskLoc& dl, InvalidationType type);
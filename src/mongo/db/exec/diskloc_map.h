@@ -0,0 +1,138 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/util/unordered_fast_key_table.h"
+
+namespace mongo {
+
+    /**
+     * DiskLoc::Hasher xors the file number and offset, which leaves offsets that are multiples of
+     * the record alignment clustered together.  Open addressing needs the bits mixed, so we run
+     * them through a 64 bit finalizer.
+     */
+    struct DiskLocMixHash {
+        static unsigned long long mix(const DiskLoc& loc) {
+            unsigned long long h = (static_cast<unsigned long long>(
+                                        static_cast<unsigned int>(loc.a())) << 32)
+                                   | static_cast<unsigned int>(loc.getOfs());
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        size_t operator()(const DiskLoc& loc) const {
+            return static_cast<size_t>(mix(loc));
+        }
+    };
+
+    struct DiskLocMapEqual {
+        bool operator()(const DiskLoc& a, const DiskLoc& b) const { return a == b; }
+    };
+
+    struct DiskLocMapConvertor {
+        const DiskLoc& operator()(const DiskLoc& loc) const { return loc; }
+    };
+
+    /**
+     * An open addressed DiskLoc -> V table.  Entries are kept inline so there's no allocation
+     * per key, unlike unordered_map.
+     */
+    template <typename V>
+    class DiskLocMap : public UnorderedFastKeyTable<DiskLoc, // K_L
+                                                    DiskLoc, // K_S
+                                                    V,
+                                                    DiskLocMixHash,
+                                                    DiskLocMapEqual,
+                                                    DiskLocMapConvertor> {
+    public:
+        /**
+         * Rough size of one slot, for callers that account for their memory.  Multiply by
+         * capacity() rather than size(): free slots cost the same.
+         */
+        static size_t slotBytes() { return 2 * sizeof(bool) + sizeof(size_t) + sizeof(DiskLoc)
+                                           + sizeof(V); }
+    };
+
+    /**
+     * A bloom filter over DiskLocs.  mayContain() never says no to a DiskLoc that was inserted;
+     * it says yes to about 1% of the others.
+     */
+    class DiskLocBloomFilter {
+    public:
+        /**
+         * Sized for 'expected' insertions.
+         */
+        explicit DiskLocBloomFilter(size_t expected)
+            : _numBits(std::max(static_cast<unsigned long long>(expected) * kBitsPerEntry,
+                                static_cast<unsigned long long>(64))),
+              _bits((_numBits + 63) / 64, 0) { }
+
+        void insert(const DiskLoc& loc) {
+            unsigned long long h = DiskLocMixHash::mix(loc);
+            const unsigned long long step = (h >> 32) | 1;
+            for (int i = 0; i < kNumProbes; ++i) {
+                const unsigned long long bit = h % _numBits;
+                _bits[bit / 64] |= 1ULL << (bit % 64);
+                h += step;
+            }
+        }
+
+        bool mayContain(const DiskLoc& loc) const {
+            unsigned long long h = DiskLocMixHash::mix(loc);
+            const unsigned long long step = (h >> 32) | 1;
+            for (int i = 0; i < kNumProbes; ++i) {
+                const unsigned long long bit = h % _numBits;
+                if (0 == (_bits[bit / 64] & (1ULL << (bit % 64)))) {
+                    return false;
+                }
+                h += step;
+            }
+            return true;
+        }
+
+        size_t memUsage() const { return _bits.size() * sizeof(unsigned long long); }
+
+    private:
+        // 10 bits and 7 probes per entry gives about a 1% false positive rate.
+        static const unsigned long long kBitsPerEntry = 10;
+        static const int kNumProbes = 7;
+
+        unsigned long long _numBits;
+        std::vector<unsigned long long> _bits;
+    };
+
+}  // namespace mongo
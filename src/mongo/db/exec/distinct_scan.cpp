@@ -100,6 +100,25 @@ namespace mongo {
         BSONObj ownedKeyObj = _btreeCursor->getKey().getOwned();
         DiskLoc loc = _btreeCursor->getValue();
 
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = loc;
+        member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(), ownedKeyObj));
+        member->state = WorkingSetMember::LOC_AND_IDX;
+
+        if (!Filter::passes(member, _params.filter)) {
+            // Another key with the same value may still pass, so we can't skip ahead yet.
+            _workingSet->free(id);
+            _btreeCursor->next();
+            checkEnd();
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        if (NULL != _params.filter) {
+            ++_specificStats.matchTested;
+        }
+
         // The underlying IndexCursor points at the *next* thing we want to return.  We do this so
         // that if we're scanning an index looking for docs to delete we don't continually clobber
         // the thing we're pointing at.
@@ -115,13 +134,6 @@ namespace mongo {
         // And make sure we're within the bounds.
         checkEnd();
 
-        // Package up the result for the caller.
-        WorkingSetID id = _workingSet->allocate();
-        WorkingSetMember* member = _workingSet->get(id);
-        member->loc = loc;
-        member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(), ownedKeyObj));
-        member->state = WorkingSetMember::LOC_AND_IDX;
-
         *out = id;
         ++_commonStats.advanced;
         return PlanStage::ADVANCED;
@@ -49,7 +49,8 @@ namespace mongo {
     struct DistinctParams {
         DistinctParams() : descriptor(NULL),
                            direction(1),
-                           fieldNo(0) { }
+                           fieldNo(0),
+                           filter(NULL) { }
 
         // What index are we traversing?
         const IndexDescriptor* descriptor;
@@ -66,6 +67,10 @@ namespace mongo {
         // If we distinct over 'a' the position is 0.
         // If we distinct over 'b' the position is 1.
         int fieldNo;
+
+        // Predicates the bounds can't express, tested against the key data.  Only set when the
+        // index isn't multikey.  Not owned by us.
+        const MatchExpression* filter;
     };
 
     /**
@@ -75,6 +80,9 @@ namespace mongo {
      * for that field, so there is no point in examining all keys with the same value for that
      * field.
      *
+     * If there is a filter, keys are examined one at a time until one passes it.  Once we've found
+     * a key for a value we skip the rest of that value's keys as usual.
+     *
      * Only created through the getDistinctRunner path.  See db/query/get_runner.cpp
      */
     class DistinctScan : public PlanStage {
@@ -31,6 +31,7 @@
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/util/fail_point_service.h"
 
 namespace mongo {
@@ -40,7 +41,12 @@ namespace mongo {
     MONGO_FP_DECLARE(fetchInMemorySucceed);
 
     FetchStage::FetchStage(WorkingSet* ws, PlanStage* child, const MatchExpression* filter)
-        : _ws(ws), _child(child), _filter(filter), _idBeingPagedIn(WorkingSet::INVALID_ID) { }
+        : _ws(ws),
+          _child(child),
+          _filter(filter),
+          _idBeingPagedIn(WorkingSet::INVALID_ID),
+          _pendingState(PlanStage::NEED_TIME),
+          _pendingOut(WorkingSet::INVALID_ID) { }
 
     FetchStage::~FetchStage() { }
 
@@ -51,6 +57,11 @@ namespace mongo {
             return false;
         }
 
+        if (!_pending.empty() || PlanStage::NEED_TIME != _pendingState) {
+            // Left over from a batch.
+            return false;
+        }
+
         return _child->isEOF();
     }
 
@@ -76,42 +87,30 @@ namespace mongo {
             return fetchCompleted(out);
         }
 
+        // Hand on what's left over from the last batch before asking our child for more.
+        if (!_pending.empty()) {
+            WorkingSetID id = _pending.front();
+            _pending.pop_front();
+            return fetchChildResult(id, out);
+        }
+        if (PlanStage::NEED_TIME != _pendingState) {
+            StageState status = _pendingState;
+            *out = _pendingOut;
+            _pendingState = PlanStage::NEED_TIME;
+            _pendingOut = WorkingSet::INVALID_ID;
+            if (PlanStage::NEED_FETCH == status) {
+                ++_commonStats.needFetch;
+            }
+            return status;
+        }
+
         // If we're here, we're not waiting for a DiskLoc to be fetched.  Get another to-be-fetched
         // result from our child.
         WorkingSetID id = WorkingSet::INVALID_ID;
         StageState status = _child->work(&id);
 
         if (PlanStage::ADVANCED == status) {
-            WorkingSetMember* member = _ws->get(id);
-
-            // If there's an obj there, there is no fetching to perform.
-            if (member->hasObj()) {
-                ++_specificStats.alreadyHasObj;
-                return returnIfMatches(member, id, out);
-            }
-
-            // We need a valid loc to fetch from and this is the only state that has one.
-            verify(WorkingSetMember::LOC_AND_IDX == member->state);
-            verify(member->hasLoc());
-
-            Record* record = member->loc.rec();
-            const char* data = record->dataNoThrowing();
-
-            if (!recordInMemory(data)) {
-                // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
-                verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
-                _idBeingPagedIn = id;
-                *out = id;
-                ++_commonStats.needFetch;
-                return PlanStage::NEED_FETCH;
-            }
-            else {
-                // Don't need index data anymore as we have an obj.
-                member->keyData.clear();
-                member->obj = BSONObj(data);
-                member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-                return returnIfMatches(member, id, out);
-            }
+            return fetchChildResult(id, out);
         }
         else if (PlanStage::FAILURE == status) {
             *out = id;
@@ -129,6 +128,109 @@ namespace mongo {
         }
     }
 
+    PlanStage::StageState FetchStage::fetchChildResult(WorkingSetID id, WorkingSetID* out) {
+        WorkingSetMember* member = _ws->get(id);
+
+        // If there's an obj there, there is no fetching to perform.
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+            return returnIfMatches(member, id, out);
+        }
+
+        // We need a valid loc to fetch from and this is the only state that has one.
+        verify(WorkingSetMember::LOC_AND_IDX == member->state);
+        verify(member->hasLoc());
+
+        Record* record = member->loc.rec();
+        const char* data = record->dataNoThrowing();
+
+        if (!recordInMemory(data)) {
+            // member->loc points to a record that's NOT in memory.  Pass a fetch request up.
+            verify(WorkingSet::INVALID_ID == _idBeingPagedIn);
+            _idBeingPagedIn = id;
+            *out = id;
+            ++_commonStats.needFetch;
+            return PlanStage::NEED_FETCH;
+        }
+        else {
+            // Don't need index data anymore as we have an obj.
+            member->keyData.clear();
+            member->obj = RecordCompression::document(data);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            return returnIfMatches(member, id, out);
+        }
+    }
+
+    PlanStage::StageState FetchStage::workBatch(size_t maxWorks,
+                                                std::vector<WorkingSetID>* results,
+                                                WorkingSetID* out) {
+        // Anything left over from an earlier batch goes out one result at a time.
+        if (WorkingSet::INVALID_ID != _idBeingPagedIn || !_pending.empty()
+            || PlanStage::NEED_TIME != _pendingState) {
+            return PlanStage::workBatch(maxWorks, results, out);
+        }
+
+        const size_t first = results->size();
+        WorkingSetID childOut = WorkingSet::INVALID_ID;
+        StageState childStatus = _child->workBatch(maxWorks, results, &childOut);
+        ++_commonStats.works;
+
+        // Fetch the batch in place, then filter it all at once.
+        size_t fetched = first;
+        for (size_t i = first; i < results->size(); ++i) {
+            WorkingSetID id = (*results)[i];
+            WorkingSetMember* member = _ws->get(id);
+
+            if (member->hasObj()) {
+                ++_specificStats.alreadyHasObj;
+                (*results)[fetched++] = id;
+                continue;
+            }
+
+            verify(WorkingSetMember::LOC_AND_IDX == member->state);
+            verify(member->hasLoc());
+
+            const char* data = member->loc.rec()->dataNoThrowing();
+            if (!recordInMemory(data)) {
+                // Ask for this one to be paged in and hold the rest of the batch until then.
+                _idBeingPagedIn = id;
+                _pending.assign(results->begin() + i + 1, results->end());
+                if (PlanStage::FAILURE == childStatus || PlanStage::DEAD == childStatus
+                    || PlanStage::NEED_FETCH == childStatus) {
+                    _pendingState = childStatus;
+                    _pendingOut = childOut;
+                }
+                results->resize(fetched);
+                childStatus = PlanStage::NEED_FETCH;
+                childOut = id;
+                break;
+            }
+
+            member->keyData.clear();
+            member->obj = RecordCompression::document(data);
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+            (*results)[fetched++] = id;
+        }
+        results->resize(fetched);
+
+        const size_t tested = fetched - first;
+        const size_t passed = Filter::filterBatch(_ws, _filter, results, first);
+        if (NULL != _filter) {
+            _specificStats.matchTested += passed;
+        }
+        _commonStats.works += tested;
+        _commonStats.advanced += passed;
+        _commonStats.needTime += tested - passed;
+
+        if (PlanStage::NEED_FETCH == childStatus || PlanStage::FAILURE == childStatus) {
+            *out = childOut;
+        }
+        if (PlanStage::NEED_FETCH == childStatus) {
+            ++_commonStats.needFetch;
+        }
+        return childStatus;
+    }
+
     void FetchStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
@@ -153,6 +255,15 @@ namespace mongo {
                 WorkingSetCommon::fetchAndInvalidateLoc(member);
             }
         }
+
+        // The same goes for results left over from a batch.
+        for (std::deque<WorkingSetID>::const_iterator it = _pending.begin();
+             it != _pending.end(); ++it) {
+            WorkingSetMember* member = _ws->get(*it);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     PlanStage::StageState FetchStage::fetchCompleted(WorkingSetID* out) {
@@ -172,15 +283,14 @@ namespace mongo {
         verify(member->hasLoc());
         verify(!member->hasObj());
 
-        // Make the (unowned) object.
+        // Make the object.  It is unowned unless the record was compressed.
         Record* record = member->loc.rec();
         const char* data = record->dataNoThrowing();
-        member->obj = BSONObj(data);
+        member->obj = RecordCompression::document(data);
 
         // Don't need index data anymore as we have an obj.
         member->keyData.clear();
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
-        verify(!member->obj.isOwned());
 
         // Return the obj if it passes our filter.
         WorkingSetID memberID = _idBeingPagedIn;
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <deque>
+
 #include "mongo/db/diskloc.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/jsobj.h"
@@ -50,6 +52,9 @@ namespace mongo {
 
         virtual bool isEOF();
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
 
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -70,6 +75,11 @@ namespace mongo {
          */
         StageState fetchCompleted(WorkingSetID* out);
 
+        /**
+         * Fetches the result 'id' our child produced, or asks for it to be paged in.
+         */
+        StageState fetchChildResult(WorkingSetID id, WorkingSetID* out);
+
         // _ws is not owned by us.
         WorkingSet* _ws;
         scoped_ptr<PlanStage> _child;
@@ -81,6 +91,13 @@ namespace mongo {
         // a "please page this in" result and hold on to the WSID until the next call to work(...).
         WorkingSetID _idBeingPagedIn;
 
+        // When a record in the middle of a batch from our child isn't in memory, the results
+        // after it wait here, and how the child's batch ended waits in _pendingState (NEED_TIME
+        // if there's nothing to pass on) and _pendingOut.  work(...) hands them on in order.
+        std::deque<WorkingSetID> _pending;
+        StageState _pendingState;
+        WorkingSetID _pendingOut;
+
         // Stats
         CommonStats _commonStats;
         FetchStats _specificStats;
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/matcher/matchable.h"
 
@@ -40,9 +42,17 @@ namespace mongo {
      */
     class WorkingSetMatchableDocument : public MatchableDocument {
     public:
-        WorkingSetMatchableDocument(WorkingSetMember* wsm) : _wsm(wsm) { }
+        WorkingSetMatchableDocument(WorkingSetMember* wsm) : _wsm(wsm), _iteratorUsed(false) { }
         virtual ~WorkingSetMatchableDocument() { }
 
+        /**
+         * Points this document at 'wsm' so one instance can be used for a run of members.
+         */
+        void reset(WorkingSetMember* wsm) {
+            verify(!_iteratorUsed);
+            _wsm = wsm;
+        }
+
         // This is only called by a $where query.  The query system must be smart enough to realize
         // that it should do a fetch beforehand.
         BSONObj toBSON() const {
@@ -54,7 +64,14 @@ namespace mongo {
             // BSONElementIterator does some interesting things with arrays that I don't think
             // SimpleArrayElementIterator does.
             if (_wsm->hasObj()) {
-                return new BSONElementIterator(path, _wsm->obj);
+                // Most leaves are evaluated one after another, so hand out our own iterator
+                // rather than allocating one per leaf per document.
+                if (_iteratorUsed) {
+                    return new BSONElementIterator(path, _wsm->obj);
+                }
+                _iteratorUsed = true;
+                _iterator.reset(path, _wsm->obj);
+                return &_iterator;
             }
 
             // NOTE: This (kind of) duplicates code in WorkingSetMember::getFieldDotted.
@@ -89,11 +106,18 @@ namespace mongo {
         }
 
         virtual void releaseIterator( ElementIterator* iterator ) const {
-            delete iterator;
+            if (iterator == &_iterator) {
+                _iteratorUsed = false;
+            }
+            else {
+                delete iterator;
+            }
         }
 
     private:
         WorkingSetMember* _wsm;
+        mutable BSONElementIterator _iterator;
+        mutable bool _iteratorUsed;
     };
 
     /**
@@ -110,6 +134,33 @@ namespace mongo {
             WorkingSetMatchableDocument doc(wsm);
             return filter->matches(&doc, NULL);
         }
+
+        /**
+         * Tests the members ids[first], ids[first + 1], ... against 'filter' in one pass.  Those
+         * that pass are kept in order, those that don't are freed from 'ws' and removed from
+         * 'ids'.  Returns how many passed.
+         */
+        static size_t filterBatch(WorkingSet* ws,
+                                  const MatchExpression* filter,
+                                  std::vector<WorkingSetID>* ids,
+                                  size_t first) {
+            if (NULL == filter) { return ids->size() - first; }
+
+            size_t kept = first;
+            WorkingSetMatchableDocument doc(NULL);
+            for (size_t i = first; i < ids->size(); ++i) {
+                WorkingSetID id = (*ids)[i];
+                doc.reset(ws->get(id));
+                if (filter->matches(&doc, NULL)) {
+                    (*ids)[kept++] = id;
+                }
+                else {
+                    ws->free(id);
+                }
+            }
+            ids->resize(kept);
+            return kept - first;
+        }
     };
 
 }  // namespace mongo
@@ -28,6 +28,7 @@
 
 #include "mongo/db/exec/index_scan.h"
 
+#include "mongo/db/exec/diskloc_map.h"
 #include "mongo/db/exec/filter.h"
 #include "mongo/db/exec/working_set_computed_data.h"
 #include "mongo/db/index/index_access_method.h"
@@ -54,6 +55,7 @@ namespace mongo {
           _hitEnd(false),
           _filter(filter), 
           _shouldDedup(params.descriptor->isMultikey()),
+          _locFilter(NULL),
           _yieldMovedCursor(false),
           _params(params),
           _btreeCursor(NULL) {
@@ -64,6 +66,11 @@ namespace mongo {
             _shouldDedup = false;
         }
 
+        if (_params.countOnly) {
+            _countMember.state = WorkingSetMember::LOC_AND_IDX;
+            _countMember.keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(), BSONObj()));
+        }
+
         _specificStats.indexType = "BtreeCursor"; // TODO amName;
         _specificStats.indexName = _descriptor->infoObj()["name"].String();
         _specificStats.indexBounds = _params.bounds.toBSON();
@@ -139,9 +146,20 @@ namespace mongo {
 
         if (isEOF()) { return PlanStage::IS_EOF; }
 
+        if (_params.countOnly) {
+            return countKey(out);
+        }
+
         // Grab the next (key, value) from the index.
-        BSONObj ownedKeyObj = _indexCursor->getKey().getOwned();
         DiskLoc loc = _indexCursor->getValue();
+        if (NULL != _locFilter && !_locFilter->mayContain(loc)) {
+            ++_specificStats.locsFiltered;
+            _indexCursor->next();
+            checkEnd();
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+        BSONObj ownedKeyObj = _indexCursor->getKey().getOwned();
 
         // Move to the next result.
         // The underlying IndexCursor points at the *next* thing we want to return.  We do this so
@@ -187,6 +205,105 @@ namespace mongo {
         return PlanStage::NEED_TIME;
     }
 
+    PlanStage::StageState IndexScan::workBatch(size_t maxWorks,
+                                               std::vector<WorkingSetID>* results,
+                                               WorkingSetID* out) {
+        // Opening the cursor, picking up after a yield and counting are handled one key at a
+        // time.
+        if (NULL == _indexCursor.get() || _yieldMovedCursor || _params.countOnly) {
+            return PlanStage::workBatch(maxWorks, results, out);
+        }
+
+        // Read a run of keys, then filter them all at once.
+        const size_t first = results->size();
+        size_t scanned = 0;
+        while (scanned < maxWorks && !isEOF()) {
+            DiskLoc loc = _indexCursor->getValue();
+            if (NULL != _locFilter && !_locFilter->mayContain(loc)) {
+                ++_specificStats.locsFiltered;
+                _indexCursor->next();
+                checkEnd();
+                ++scanned;
+                continue;
+            }
+            BSONObj ownedKeyObj = _indexCursor->getKey().getOwned();
+            _indexCursor->next();
+            checkEnd();
+            ++scanned;
+
+            if (_shouldDedup) {
+                ++_specificStats.dupsTested;
+                if (!_returned.insert(loc).second) {
+                    ++_specificStats.dupsDropped;
+                    continue;
+                }
+            }
+
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->loc = loc;
+            member->keyData.push_back(IndexKeyDatum(_descriptor->keyPattern(), ownedKeyObj));
+            member->state = WorkingSetMember::LOC_AND_IDX;
+            results->push_back(id);
+        }
+
+        const size_t passed = Filter::filterBatch(_workingSet, _filter, results, first);
+        if (NULL != _filter) {
+            _specificStats.matchTested += passed;
+        }
+        if (_params.addKeyMetadata) {
+            for (size_t i = first; i < results->size(); ++i) {
+                WorkingSetMember* member = _workingSet->get((*results)[i]);
+                BSONObjBuilder bob;
+                bob.appendKeys(_descriptor->keyPattern(), member->keyData[0].keyData);
+                member->addComputed(new IndexKeyComputedData(bob.obj()));
+            }
+        }
+
+        _commonStats.works += scanned;
+        _commonStats.advanced += passed;
+        _commonStats.needTime += scanned - passed;
+
+        if (scanned < maxWorks) {
+            // What the next call to work() would have found.
+            ++_commonStats.works;
+            return PlanStage::IS_EOF;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    PlanStage::StageState IndexScan::countKey(WorkingSetID* out) {
+        DiskLoc loc = _indexCursor->getValue();
+
+        if (NULL != _filter) {
+            // Test the key where it is, before we move the cursor off of it.
+            _countMember.keyData[0].keyData = _indexCursor->getKey();
+            if (!Filter::passes(&_countMember, _filter)) {
+                _indexCursor->next();
+                checkEnd();
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+            ++_specificStats.matchTested;
+        }
+
+        _indexCursor->next();
+        checkEnd();
+
+        if (_shouldDedup) {
+            ++_specificStats.dupsTested;
+            if (!_returned.insert(loc).second) {
+                ++_specificStats.dupsDropped;
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+
+        *out = WorkingSet::INVALID_ID;
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
     bool IndexScan::isEOF() {
         if (NULL == _indexCursor.get()) {
             // Have to call work() at least once.
@@ -39,6 +39,7 @@
 
 namespace mongo {
 
+    class DiskLocBloomFilter;
     class IndexAccessMethod;
     class IndexCursor;
     class IndexDescriptor;
@@ -49,7 +50,8 @@ namespace mongo {
                             direction(1),
                             doNotDedup(false),
                             maxScan(0),
-                            addKeyMetadata(false) { }
+                            addKeyMetadata(false),
+                            countOnly(false) { }
 
         const IndexDescriptor* descriptor;
 
@@ -64,6 +66,11 @@ namespace mongo {
 
         // Do we want to add the key as metadata?
         bool addKeyMetadata;
+
+        // Does the caller only want to know how many keys pass the filter?  If so we test each
+        // key in place and return ADVANCED with an invalid WSID for each one that passes, as the
+        // Count stage does.
+        bool countOnly;
     };
 
     /**
@@ -86,6 +93,9 @@ namespace mongo {
         virtual ~IndexScan() { }
 
         virtual StageState work(WorkingSetID* out);
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out);
         virtual bool isEOF();
         virtual void prepareToYield();
         virtual void recoverFromYield();
@@ -93,6 +103,13 @@ namespace mongo {
 
         virtual PlanStageStats* getStats();
 
+        /**
+         * Skip any key whose DiskLoc isn't in 'filter', before allocating a WSM for it.  An AND
+         * above us uses this to tell us which DiskLocs it could still use.  Not owned.  NULL
+         * turns it off.
+         */
+        void setLocFilter(const DiskLocBloomFilter* filter) { _locFilter = filter; }
+
     private:
         /**
          * Initialize the underlying IndexCursor
@@ -102,6 +119,9 @@ namespace mongo {
         /** See if the cursor is pointing at or past _endKey, if _endKey is non-empty. */
         void checkEnd();
 
+        /** work(...) for countOnly scans. */
+        StageState countKey(WorkingSetID* out);
+
         // The WorkingSet we annotate with results.  Not owned by us.
         WorkingSet* _workingSet;
 
@@ -122,6 +142,13 @@ namespace mongo {
         bool _shouldDedup;
         unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
 
+        // See setLocFilter.
+        const DiskLocBloomFilter* _locFilter;
+
+        // With countOnly, the filter is tested against this member, which holds the current key
+        // unowned.
+        WorkingSetMember _countMember;
+
         // For yielding.
         BSONObj _savedKey;
         DiskLoc _savedLoc;
@@ -0,0 +1,412 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/parallel_collscan.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/pdfile.h"
+#include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage/record.h"
+#include "mongo/db/storage/record_compression.h"
+
+namespace mongo {
+
+    const size_t ParallelCollectionScan::kRecordsPerBatch = 128;
+    const size_t ParallelCollectionScan::kQueuedBatchesPerWorker = 4;
+    const int ParallelCollectionScan::kWaitMillis = 10;
+
+    ParallelCollectionScan::ParallelCollectionScan(const CollectionScanParams& params,
+                                                   size_t numWorkers,
+                                                   WorkingSet* workingSet,
+                                                   const MatchExpression* filter)
+        : _workingSet(workingSet),
+          _filter(filter),
+          _params(params),
+          _numWorkers(numWorkers),
+          _collection(NULL),
+          _started(false),
+          _nsDropped(false),
+          _paused(false),
+          _shuttingDown(false),
+          _scanning(0),
+          _finished(0),
+          _recheck(0) {
+        invariant(_numWorkers > 0);
+        invariant(!_params.tailable);
+        invariant(0 == _params.maxScan);
+    }
+
+    ParallelCollectionScan::~ParallelCollectionScan() {
+        shutdown();
+    }
+
+    void ParallelCollectionScan::start(Collection* collection) {
+        _collection = collection;
+
+        // Deal the extents out the way the parallelCollectionScan command does.
+        const ExtentManager* extentManager = &cc().database()->getExtentManager();
+        DiskLoc extentLoc = collection->details()->firstExtent();
+        size_t extentNumber = 0;
+        while (!extentLoc.isNull()) {
+            if (_workers.size() < _numWorkers) {
+                _workers.push_back(Worker());
+            }
+            _workers[extentNumber % _workers.size()].extents.push_back(extentLoc);
+            extentLoc = extentManager->getExtent(extentLoc)->xnext;
+            ++extentNumber;
+        }
+
+        // A small collection may not have an extent for each worker.
+        _numWorkers = _workers.size();
+
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            Worker* worker = &_workers[i];
+            mapExtents(worker);
+            Extent* first = reinterpret_cast<Extent*>(worker->fileBases[0] +
+                                                      worker->extents[0].getOfs());
+            worker->next = first->firstRecord;
+            if (worker->next.isNull()) {
+                // The first extent is empty.  advance() needs a record to start from.
+                while (++worker->currentExtent < worker->extents.size()) {
+                    Extent* e = reinterpret_cast<Extent*>(
+                        worker->fileBases[worker->currentExtent] +
+                        worker->extents[worker->currentExtent].getOfs());
+                    worker->next = e->firstRecord;
+                    if (!worker->next.isNull()) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        _started = true;
+
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            _threads.push_back(boost::shared_ptr<boost::thread>(
+                new boost::thread(boost::bind(&ParallelCollectionScan::runWorker,
+                                              this,
+                                              &_workers[i]))));
+        }
+    }
+
+    void ParallelCollectionScan::mapExtents(Worker* worker) {
+        const ExtentManager* extentManager = &cc().database()->getExtentManager();
+        worker->fileBases.resize(worker->extents.size());
+        for (size_t i = worker->currentExtent; i < worker->extents.size(); ++i) {
+            const DiskLoc& extentLoc = worker->extents[i];
+            Extent* e = extentManager->getExtent(extentLoc);
+            worker->fileBases[i] = reinterpret_cast<char*>(e) - extentLoc.getOfs();
+        }
+    }
+
+    // static
+    void ParallelCollectionScan::advance(Worker* worker) {
+        Record* record = reinterpret_cast<Record*>(worker->fileBases[worker->currentExtent] +
+                                                   worker->next.getOfs());
+        // np() rather than nextOfs(), which may want to throw a PageFaultException on behalf of
+        // the current Client.  Workers don't have one.
+        int nextOfs = record->np()->nextOfs;
+        if (DiskLoc::NullOfs != nextOfs) {
+            worker->next = DiskLoc(worker->next.a(), nextOfs);
+            return;
+        }
+
+        while (++worker->currentExtent < worker->extents.size()) {
+            Extent* e = reinterpret_cast<Extent*>(worker->fileBases[worker->currentExtent] +
+                                                  worker->extents[worker->currentExtent].getOfs());
+            worker->next = e->firstRecord;
+            if (!worker->next.isNull()) {
+                return;
+            }
+        }
+
+        worker->next = DiskLoc();
+    }
+
+    void ParallelCollectionScan::runWorker(Worker* worker) {
+        std::vector<DiskLoc> matches;
+        boost::unique_lock<boost::mutex> lk(_mutex);
+
+        for (;;) {
+            while (!_shuttingDown &&
+                   (_paused || _queue.size() >= _numWorkers * kQueuedBatchesPerWorker)) {
+                _workersCond.wait(lk);
+            }
+            if (_shuttingDown) {
+                return;
+            }
+
+            ++_scanning;
+            lk.unlock();
+
+            // Test a batch of records without the mutex.
+            std::string error;
+            size_t tested = 0;
+            try {
+                while (tested < kRecordsPerBatch && !worker->next.isNull()
+                       && 0 == _interrupted.load()) {
+                    Record* record = reinterpret_cast<Record*>(
+                        worker->fileBases[worker->currentExtent] + worker->next.getOfs());
+                    BSONObj obj = RecordCompression::document(record->dataNoThrowing());
+                    ++tested;
+                    if (NULL == _filter || _filter->matchesBSON(obj)) {
+                        matches.push_back(worker->next);
+                    }
+                    advance(worker);
+                }
+            }
+            catch (const DBException& e) {
+                error = e.toString();
+            }
+            catch (const std::exception& e) {
+                error = e.what();
+            }
+
+            lk.lock();
+            --_scanning;
+            worker->docsTested += tested;
+            if (!matches.empty()) {
+                _queue.push_back(std::vector<DiskLoc>());
+                _queue.back().swap(matches);
+            }
+
+            const bool done = worker->next.isNull() || !error.empty();
+            if (!error.empty() && _error.empty()) {
+                _error = error;
+            }
+            if (done) {
+                ++_finished;
+            }
+
+            _resultsCond.notify_all();
+            if (done) {
+                return;
+            }
+        }
+    }
+
+    void ParallelCollectionScan::pauseWorkers() {
+        _interrupted.store(1);
+
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        _paused = true;
+        while (_scanning > 0) {
+            _resultsCond.wait(lk);
+        }
+
+        for (; !_queue.empty(); _queue.pop_front()) {
+            _buffer.insert(_buffer.end(), _queue.front().begin(), _queue.front().end());
+        }
+
+        // Any of these may have changed or gone away while we're paused.
+        _recheck = _buffer.size();
+    }
+
+    void ParallelCollectionScan::resumeWorkers() {
+        // The files may have been remapped while the workers were paused.
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            if (!_workers[i].next.isNull()) {
+                mapExtents(&_workers[i]);
+            }
+        }
+
+        _interrupted.store(0);
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        _paused = false;
+        _workersCond.notify_all();
+    }
+
+    void ParallelCollectionScan::shutdown() {
+        _interrupted.store(1);
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _shuttingDown = true;
+            _workersCond.notify_all();
+        }
+
+        for (size_t i = 0; i < _threads.size(); ++i) {
+            _threads[i]->join();
+        }
+        _threads.clear();
+    }
+
+    PlanStage::StageState ParallelCollectionScan::work(WorkingSetID* out) {
+        ++_commonStats.works;
+        if (_nsDropped) { return PlanStage::DEAD; }
+
+        if (!_started) {
+            Collection* collection = cc().database()->getCollection(_params.ns);
+            if (NULL == collection) {
+                _nsDropped = true;
+                return PlanStage::DEAD;
+            }
+
+            start(collection);
+
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        // Only we set _paused, so we can look at it without the mutex.  recoverFromYield()
+        // resumes the workers; this covers an invalidate() outside of a yield.
+        if (_paused) {
+            resumeWorkers();
+        }
+
+        if (_buffer.empty()) {
+            boost::unique_lock<boost::mutex> lk(_mutex);
+            if (_queue.empty() && _finished < _numWorkers && _error.empty()) {
+                // Wait a little for a batch, but don't sit on the caller's lock until one comes:
+                // a scan that matches little would never yield or notice it was killed.
+                _resultsCond.timed_wait(lk, boost::posix_time::milliseconds(kWaitMillis));
+                if (_queue.empty() && _finished < _numWorkers && _error.empty()) {
+                    ++_commonStats.needTime;
+                    return PlanStage::NEED_TIME;
+                }
+            }
+
+            if (!_error.empty()) {
+                *out = WorkingSetCommon::allocateStatusMember(
+                    _workingSet,
+                    Status(ErrorCodes::InternalError,
+                           "parallel collection scan worker failed: " + _error));
+                return PlanStage::FAILURE;
+            }
+
+            if (_queue.empty()) {
+                return PlanStage::IS_EOF;
+            }
+
+            _buffer.assign(_queue.front().begin(), _queue.front().end());
+            _queue.pop_front();
+            _workersCond.notify_all();
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->loc = _buffer.front();
+        member->obj = member->loc.obj();
+        member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        _buffer.pop_front();
+
+        if (_recheck > 0) {
+            --_recheck;
+            if (!Filter::passes(member, _filter)) {
+                _workingSet->free(id);
+                ++_commonStats.needTime;
+                return PlanStage::NEED_TIME;
+            }
+        }
+
+        *out = id;
+        ++_commonStats.advanced;
+        return PlanStage::ADVANCED;
+    }
+
+    bool ParallelCollectionScan::isEOF() {
+        if (_nsDropped) { return true; }
+        if (!_started) { return false; }
+        if (!_buffer.empty()) { return false; }
+
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        return _queue.empty() && _finished == _numWorkers && _error.empty();
+    }
+
+    void ParallelCollectionScan::invalidate(const DiskLoc& dl, InvalidationType type) {
+        ++_commonStats.invalidates;
+        if (!_started || _nsDropped) { return; }
+
+        // We're normally paused already, since the caller yielded.
+        pauseWorkers();
+
+        // We test results against the filter again before returning them, so we don't care about
+        // mutations.
+        if (INVALIDATION_DELETION != type) { return; }
+
+        for (size_t i = 0; i < _workers.size(); ++i) {
+            Worker* worker = &_workers[i];
+            if (worker->next == dl) {
+                mapExtents(worker);
+                advance(worker);
+            }
+        }
+
+        _buffer.erase(std::remove(_buffer.begin(), _buffer.end(), dl), _buffer.end());
+        _recheck = _buffer.size();
+    }
+
+    void ParallelCollectionScan::prepareToYield() {
+        ++_commonStats.yields;
+        if (!_started || _nsDropped) { return; }
+        pauseWorkers();
+    }
+
+    void ParallelCollectionScan::recoverFromYield() {
+        ++_commonStats.unyields;
+        if (!_started || _nsDropped) { return; }
+
+        _collection = cc().database()->getCollection(_params.ns);
+        if (NULL == _collection) {
+            warning() << "collection dropped during yield of parallel collscan";
+            _nsDropped = true;
+            return;
+        }
+
+        if (_paused) {
+            resumeWorkers();
+        }
+    }
+
+    PlanStageStats* ParallelCollectionScan::getStats() {
+        _commonStats.isEOF = isEOF();
+
+        _specificStats.workers = _numWorkers;
+        _specificStats.docsTested = 0;
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            for (size_t i = 0; i < _workers.size(); ++i) {
+                _specificStats.docsTested += _workers[i].docsTested;
+            }
+        }
+
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COLLSCAN));
+        ret->specific.reset(new CollectionScanStats(_specificStats));
+        return ret.release();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,197 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <vector>
+
+#include "mongo/db/diskloc.h"
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/platform/atomic_word.h"
+
+namespace mongo {
+
+    class Collection;
+    class WorkingSet;
+
+    /**
+     * Scans a collection with several threads.  The collection's extents are dealt round-robin to
+     * 'numWorkers' worker threads, as the parallelCollectionScan command does for its cursors.
+     * Each worker walks its own extents, tests the filter against every record and passes the
+     * DiskLocs that match to this stage through a bounded exchange queue.  Results come out in no
+     * particular order.
+     *
+     * The workers only read the collection, and only while the caller holds its lock:
+     * prepareToYield() and invalidate() pause them and recoverFromYield() resumes them.  work()
+     * returns NEED_TIME when no batch comes within kWaitMillis, so the caller still yields and
+     * checks for interrupts during a scan that matches little.  Results that were queued
+     * before a yield are tested against the filter again before they are returned.  The caller
+     * must not modify the collection between calls to work() without yielding.
+     *
+     * Not for capped collections, tailable cursors or maxScan.
+     */
+    class ParallelCollectionScan : public PlanStage {
+    public:
+        ParallelCollectionScan(const CollectionScanParams& params,
+                               size_t numWorkers,
+                               WorkingSet* workingSet,
+                               const MatchExpression* filter);
+
+        virtual ~ParallelCollectionScan();
+
+        virtual StageState work(WorkingSetID* out);
+        virtual bool isEOF();
+
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+
+        virtual PlanStageStats* getStats();
+
+        // How many records a worker tests before it hands its matches to the queue.
+        static const size_t kRecordsPerBatch;
+
+        // How many batches may wait in the queue for each worker.
+        static const size_t kQueuedBatchesPerWorker;
+
+        // How long work() waits for a batch before returning NEED_TIME, so the caller can yield
+        // and check for interrupts.
+        static const int kWaitMillis;
+
+    private:
+        // One worker's share of the collection.  Only touched by the worker thread while it is
+        // scanning, and only by us while every worker is paused.
+        struct Worker {
+            Worker() : currentExtent(0), docsTested(0) { }
+
+            std::vector<DiskLoc> extents;
+
+            // Start of the mapped file holding each extent.  Records are in their extent's file,
+            // so the worker can find them without the ExtentManager, which wants the calling
+            // thread to hold the lock.  Recomputed whenever the workers resume.
+            std::vector<char*> fileBases;
+
+            size_t currentExtent;
+
+            // The next record to test.  Null once the worker is done.
+            DiskLoc next;
+
+            size_t docsTested;
+        };
+
+        /** Deals out the extents and starts the workers. */
+        void start(Collection* collection);
+
+        /** Body of a worker thread. */
+        void runWorker(Worker* worker);
+
+        /** Moves 'worker' to its next record, crossing into its following extents as needed. */
+        static void advance(Worker* worker);
+
+        /** Looks up where the files holding the rest of 'worker's extents are mapped. */
+        void mapExtents(Worker* worker);
+
+        /**
+         * Waits until no worker is scanning, then moves everything they queued into _buffer.
+         * Everything in _buffer is tested again before it's returned.
+         */
+        void pauseWorkers();
+
+        /** Lets the workers scan again. */
+        void resumeWorkers();
+
+        /** Stops and joins the worker threads. */
+        void shutdown();
+
+        // WorkingSet is not owned by us.
+        WorkingSet* _workingSet;
+
+        // The filter is not owned by us.
+        const MatchExpression* _filter;
+
+        CollectionScanParams _params;
+
+        size_t _numWorkers;
+
+        // Set on the first call to work().
+        Collection* _collection;
+        bool _started;
+
+        // True if the collection was gone on our first call to work() or after a yield.
+        bool _nsDropped;
+
+        std::vector<Worker> _workers;
+        std::vector<boost::shared_ptr<boost::thread> > _threads;
+
+        // Everything below up to _buffer is protected by _mutex.
+        boost::mutex _mutex;
+
+        // Workers wait here while paused or while the queue is full.
+        boost::condition_variable _workersCond;
+
+        // We wait here for results, or for the workers to pause.
+        boost::condition_variable _resultsCond;
+
+        // The exchange.  Each entry is one worker's matches from one batch of records.
+        std::deque<std::vector<DiskLoc> > _queue;
+
+        bool _paused;
+        bool _shuttingDown;
+
+        // Set when the workers should stop before the end of their current batch.  Read without
+        // the mutex, once per record.
+        AtomicUInt32 _interrupted;
+
+        // Workers in the middle of a batch.
+        size_t _scanning;
+
+        // Workers that reached the end of their extents.
+        size_t _finished;
+
+        // Set if a worker failed.
+        std::string _error;
+
+        // Results taken off the queue, handed out one per call to work().  Only touched by us.
+        std::deque<DiskLoc> _buffer;
+
+        // How many results at the front of _buffer must pass the filter again.
+        size_t _recheck;
+
+        // Stats
+        CommonStats _commonStats;
+        CollectionScanStats _specificStats;
+    };
+
+}  // namespace mongo
@@ -28,6 +28,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/invalidation_type.h"
@@ -171,6 +173,36 @@ namespace mongo {
          */
         virtual StageState work(WorkingSetID* out) = 0;
 
+        /**
+         * Perform up to 'maxWorks' units of work at once, appending every result produced to
+         * 'results' in order.  The caller owns those results exactly as if work(...) had returned
+         * them one at a time.  No yield may happen in between, so the caller must consume or take
+         * responsibility (e.g. for invalidations) for them before the next yield.
+         *
+         * Returns NEED_TIME if all 'maxWorks' units were done.  Otherwise returns the state
+         * (other than ADVANCED and NEED_TIME) that ended the batch early, with *out set as
+         * work(...) would set it.  The caller handles that state after 'results'.
+         *
+         * Stages that can process a batch faster than one result at a time, such as scans that
+         * filter a run of documents in one pass, override this.
+         */
+        virtual StageState workBatch(size_t maxWorks,
+                                     std::vector<WorkingSetID>* results,
+                                     WorkingSetID* out) {
+            for (size_t i = 0; i < maxWorks; ++i) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                StageState state = work(&id);
+                if (ADVANCED == state) {
+                    results->push_back(id);
+                }
+                else if (NEED_TIME != state) {
+                    *out = id;
+                    return state;
+                }
+            }
+            return NEED_TIME;
+        }
+
         /**
          * Returns true if no more work can be done on the query / out of results.
          */
@@ -128,7 +128,11 @@ namespace mongo {
 
     struct AndHashStats : public SpecificStats {
         AndHashStats() : flaggedButPassed(0),
-                         flaggedInProgress(0) { }
+                         flaggedInProgress(0),
+                         memUsage(0),
+                         memLimit(0),
+                         locsOnly(false),
+                         fetchedResults(0) { }
 
         virtual ~AndHashStats() { }
 
@@ -151,6 +155,16 @@ namespace mongo {
 
         // mapAfterChild[mapAfterChild.size() - 1] WSMswere match tested.
         // commonstats.advanced is how many passed.
+
+        // The most bytes the hash table and the WSMs in it used, and how many they may use.
+        size_t memUsage;
+        size_t memLimit;
+
+        // Did we go over memLimit and drop everything but the DiskLocs?
+        bool locsOnly;
+
+        // If so, how many results did we fetch because we no longer had their index keys?
+        size_t fetchedResults;
     };
 
     struct AndSortedStats : public SpecificStats {
@@ -175,7 +189,7 @@ namespace mongo {
     };
 
     struct CollectionScanStats : public SpecificStats {
-        CollectionScanStats() : docsTested(0) { }
+        CollectionScanStats() : docsTested(0), workers(0) { }
 
         virtual SpecificStats* clone() const {
             CollectionScanStats* specific = new CollectionScanStats(*this);
@@ -184,10 +198,13 @@ namespace mongo {
 
         // How many documents did we check against our filter?
         size_t docsTested;
+
+        // How many threads scanned the collection, if it was split among several.  0 otherwise.
+        size_t workers;
     };
 
     struct DistinctScanStats : public SpecificStats {
-        DistinctScanStats() : keysExamined(0) { }
+        DistinctScanStats() : keysExamined(0), matchTested(0) { }
 
         virtual SpecificStats* clone() const {
             return new DistinctScanStats(*this);
@@ -195,6 +212,9 @@ namespace mongo {
 
         // How many keys did we look at while distinct-ing?
         size_t keysExamined;
+
+        // Number of keys that passed the filter.
+        size_t matchTested;
     };
 
     struct FetchStats : public SpecificStats {
@@ -230,7 +250,8 @@ namespace mongo {
                            dupsDropped(0),
                            seenInvalidated(0),
                            matchTested(0),
-                           keysExamined(0) { }
+                           keysExamined(0),
+                           locsFiltered(0) { }
 
         virtual ~IndexScanStats() { }
 
@@ -277,6 +298,8 @@ namespace mongo {
         // Number of entries retrieved from the index during the scan.
         size_t keysExamined;
 
+        // Number of entries skipped because their DiskLoc can't be in the AND we're under.
+        size_t locsFiltered;
     };
 
     struct OrStats : public SpecificStats {
@@ -302,7 +325,7 @@ namespace mongo {
     };
 
     struct SortStats : public SpecificStats {
-        SortStats() : forcedFetches(0) { }
+        SortStats() : forcedFetches(0), spills(0), spilledBytes(0) { }
 
         virtual ~SortStats() { }
 
@@ -313,6 +336,11 @@ namespace mongo {
 
         // How many records were we forced to fetch as the result of an invalidation?
         size_t forcedFetches;
+
+        // How many sorted runs did we write to disk, and how many bytes of keys and documents
+        // did they hold?
+        size_t spills;
+        long long spilledBytes;
     };
 
     struct MergeSortStats : public SpecificStats {
@@ -81,6 +81,36 @@ namespace mongo {
         return status;
     }
 
+    PlanStage::StageState ProjectionStage::workBatch(size_t maxWorks,
+                                                     std::vector<WorkingSetID>* results,
+                                                     WorkingSetID* out) {
+        const size_t first = results->size();
+        StageState status = _child->workBatch(maxWorks, results, out);
+        ++_commonStats.works;
+
+        for (size_t i = first; i < results->size(); ++i) {
+            Status projStatus = _exec->transform(_ws->get((*results)[i]));
+            if (!projStatus.isOK()) {
+                warning() << "Couldn't execute projection, status = "
+                          << projStatus.toString() << endl;
+                // Nobody will see the rest of the batch.
+                for (size_t j = i; j < results->size(); ++j) {
+                    _ws->free((*results)[j]);
+                }
+                results->resize(i);
+                *out = WorkingSetCommon::allocateStatusMember(_ws, projStatus);
+                return PlanStage::FAILURE;
+            }
+        }
+
+        _commonStats.works += results->size() - first;
+        _commonStats.advanced += results->size() - first;
+        if (PlanStage::NEED_FETCH == status) {
+            ++_commonStats.needFetch;
+        }
+        return status;
+    }
+
     void ProjectionStage::prepareToYield() {
         ++_commonStats.yields;
         _child->prepareToYield();
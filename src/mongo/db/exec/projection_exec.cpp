@@ -46,7 +46,8 @@ namespace mongo {
           _hasNonSimple(false),
           _hasDottedField(false),
           _queryExpression(NULL),
-          _hasReturnKey(false) { }
+          _hasReturnKey(false),
+          _topLevelInclusion(false) { }
 
 
     ProjectionExec::ProjectionExec(const BSONObj& spec, const MatchExpression* queryExpression)
@@ -60,7 +61,8 @@ namespace mongo {
           _hasNonSimple(false),
           _hasDottedField(false),
           _queryExpression(queryExpression),
-          _hasReturnKey(false) {
+          _hasReturnKey(false),
+          _topLevelInclusion(false) {
 
         // Are we including or excluding fields?
         // -1 when we haven't initialized it.
@@ -172,6 +174,30 @@ namespace mongo {
                 _arrayOpType = ARRAY_OP_POSITIONAL;
             }
         }
+
+        // A plain inclusion of top-level fields is the most common projection by far.  Remember
+        // where each field goes in the output so that we can project a document in one pass.
+        _topLevelInclusion = !_include && !_hasNonSimple && !_hasDottedField;
+        if (_topLevelInclusion) {
+            if (_includeID) {
+                _topLevelSlots["_id"] = _topLevelFields.size();
+                _topLevelFields.push_back("_id");
+            }
+            BSONObjIterator specIt(_source);
+            while (specIt.more()) {
+                BSONElement specElt = specIt.next();
+                if (mongoutils::str::equals("_id", specElt.fieldName())) {
+                    continue;
+                }
+                if (_topLevelSlots.end() != _topLevelSlots.find(specElt.fieldName())) {
+                    // A repeated field is output twice; leave that to the general case.
+                    _topLevelInclusion = false;
+                    break;
+                }
+                _topLevelSlots[specElt.fieldName()] = _topLevelFields.size();
+                _topLevelFields.push_back(specElt.fieldName());
+            }
+        }
     }
 
     ProjectionExec::~ProjectionExec() {
@@ -248,6 +274,16 @@ namespace mongo {
             return Status::OK();
         }
 
+        if (_topLevelInclusion && member->hasObj()) {
+            BSONObj newObj;
+            transformTopLevel(member->obj, &newObj);
+            member->state = WorkingSetMember::OWNED_OBJ;
+            member->obj = newObj;
+            member->keyData.clear();
+            member->loc = DiskLoc();
+            return Status::OK();
+        }
+
         BSONObjBuilder bob;
         if (!requiresDocument()) {
             // Go field by field.
@@ -348,6 +384,59 @@ namespace mongo {
         return Status::OK();
     }
 
+    void ProjectionExec::transformTopLevel(const BSONObj& in, BSONObj* out) const {
+        // Find the first occurrence of every projected field in one pass over 'in'.
+        const size_t numFields = _topLevelFields.size();
+        vector<BSONElement> found(numFields);
+        size_t numFound = 0;
+        int outSize = 0;
+
+        BSONObjIterator it(in);
+        while (numFound < numFields && it.more()) {
+            BSONElement elt = it.next();
+            StringMap<size_t>::const_iterator slot = _topLevelSlots.find(elt.fieldName());
+            if (_topLevelSlots.end() == slot || !found[slot->second].eoo()) {
+                continue;
+            }
+            found[slot->second] = elt;
+            outSize += elt.size();
+            ++numFound;
+        }
+
+        // If every field of an owned 'in' is kept in place there is nothing to copy.
+        if (in.isOwned() && outSize + 5 == in.objsize()) {
+            const char* next = in.objdata() + 4;
+            size_t i = 0;
+            for (; i < numFields; ++i) {
+                if (found[i].eoo()) { continue; }
+                if (found[i].rawdata() != next) { break; }
+                next += found[i].size();
+            }
+            if (numFields == i) {
+                *out = in;
+                return;
+            }
+        }
+
+        // Copy the fields in output order, merging runs that are adjacent in 'in' into a
+        // single copy.  The buffer is sized so that it never has to grow.
+        BSONObjBuilder bob(outSize + 1);
+        size_t i = 0;
+        while (i < numFields) {
+            if (found[i].eoo()) {
+                ++i;
+                continue;
+            }
+            const char* start = found[i].rawdata();
+            const char* end = start + found[i].size();
+            for (++i; i < numFields && !found[i].eoo() && found[i].rawdata() == end; ++i) {
+                end += found[i].size();
+            }
+            bob.bb().appendBuf(start, end - start);
+        }
+        *out = bob.obj();
+    }
+
     Status ProjectionExec::transform(const BSONObj& in, BSONObj* out) const {
         BSONObjBuilder bob;
         Status s = transform(in, &bob, NULL);
@@ -131,6 +131,13 @@ namespace mongo {
             return _include || _hasNonSimple || _hasDottedField;
         }
 
+        /**
+         * Computes a projection that only includes top-level fields by copying the matching
+         * elements of 'in' into a buffer sized up front.  The output is the same as projecting
+         * field by field: _id first, then the remaining fields in the order of the spec.
+         */
+        void transformTopLevel(const BSONObj& in, BSONObj* out) const;
+
         /**
          * Appends the element 'e' to the builder 'bob', possibly descending into sub-fields of 'e'
          * if needed.
@@ -193,6 +200,15 @@ namespace mongo {
         // Do we have a returnKey projection?  If so we *only* output the index key metadata.  If
         // it's not found we output nothing.
         bool _hasReturnKey;
+
+        // Set if the projection only includes top-level fields, e.g. {a: 1, b: 1}.  Such
+        // projections of a full document go through transformTopLevel(...).
+        bool _topLevelInclusion;
+
+        // The fields output by transformTopLevel(...), in output order, and the position of each
+        // in that order.
+        vector<string> _topLevelFields;
+        StringMap<size_t> _topLevelSlots;
     };
 
 }  // namespace mongo
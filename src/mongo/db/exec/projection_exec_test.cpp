@@ -200,6 +200,47 @@ namespace {
         testTransform("{a: {$slice: [10, 10]}}", "{}", "{a: [4, 6, 8]}", true, "{a: []}");
     }
 
+    //
+    // Inclusion of top-level fields
+    //
+
+    TEST(ProjectionExecTest, TransformTopLevelInclusion) {
+        // _id first, then fields in spec order.
+        testTransform("{a: 1, b: 1}", "{}", "{b: 2, x: 0, a: 1, _id: 9}", true,
+                      "{_id: 9, a: 1, b: 2}");
+        testTransform("{b: 1, a: 1}", "{}", "{_id: 9, a: 1, b: 2, c: 3}", true,
+                      "{_id: 9, b: 2, a: 1}");
+        testTransform("{a: 1, _id: 0}", "{}", "{_id: 9, a: 1, b: 2}", true, "{a: 1}");
+        testTransform("{_id: 1, a: 1}", "{}", "{_id: 9, a: 1, b: 2}", true, "{_id: 9, a: 1}");
+
+        // Missing fields are skipped and only the first of a repeated field is kept.
+        testTransform("{a: 1, z: 1}", "{}", "{b: 2}", true, "{}");
+        testTransform("{a: 1}", "{}", "{a: 1, a: 2}", true, "{a: 1}");
+
+        // Every field kept in place.
+        testTransform("{a: 1, b: 1}", "{}", "{_id: 9, a: 1, b: 2}", true, "{_id: 9, a: 1, b: 2}");
+        testTransform("{a: 1, b: 1}", "{}", "{_id: 9, b: 2, a: 1}", true, "{_id: 9, a: 1, b: 2}");
+
+        // Values that are themselves documents are copied whole.
+        testTransform("{a: 1}", "{}", "{a: {x: [1, {y: 2}]}, b: 1}", true, "{a: {x: [1, {y: 2}]}}");
+    }
+
+    TEST(ProjectionExecTest, TransformTopLevelInclusionUnowned) {
+        BSONObj spec = fromjson("{c: 1, a: 1}");
+        ProjectionExec exec(spec, NULL);
+
+        BSONObj backing = fromjson("{_id: 1, a: 'x', b: 'y', c: 'z'}");
+        WorkingSetMember wsm;
+        wsm.state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+        wsm.obj = BSONObj(backing.objdata());
+        ASSERT_FALSE(wsm.obj.isOwned());
+
+        ASSERT_OK(exec.transform(&wsm));
+        ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, wsm.state);
+        ASSERT_TRUE(wsm.obj.isOwned());
+        ASSERT_EQUALS(fromjson("{_id: 1, c: 'z', a: 'x'}"), wsm.obj);
+    }
+
     //
     // $meta
     // $meta projections add computed values to the projected object.
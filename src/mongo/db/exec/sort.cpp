@@ -36,6 +36,7 @@
 #include "mongo/db/index/btree_key_generator.h"
 #include "mongo/db/query/lite_parsed_query.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/sorter/sorter.h"
 
 namespace {
 
@@ -53,13 +54,66 @@ namespace {
         return memUsage;
     }
 
+    bool hasComputedData(const WorkingSetMember& member) {
+        for (int i = 0; i < mongo::WSM_COMPUTED_NUM_TYPES; ++i) {
+            if (member.hasComputed(static_cast<mongo::WorkingSetComputedDataType>(i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
 } // namespace
 
 namespace mongo {
 
     using std::vector;
 
-    const size_t kMaxBytes = 32 * 1024 * 1024;
+    const size_t SortStageParams::kMaxBytes = 32 * 1024 * 1024;
+
+    namespace {
+        /**
+         * Orders spilled runs the way WorkingSetComparator orders the buffer: by sort key, then
+         * by DiskLoc.
+         */
+        class SpillComparator {
+        public:
+            typedef std::pair<BSONObj, SortStage::SpilledDocument> Data;
+
+            explicit SpillComparator(const BSONObj& pattern) : _pattern(pattern) { }
+
+            int operator()(const Data& lhs, const Data& rhs) const {
+                int result = lhs.first.woCompare(rhs.first, _pattern, false);
+                if (0 != result) {
+                    return result;
+                }
+                return lhs.second.loc.compare(rhs.second.loc);
+            }
+
+        private:
+            BSONObj _pattern;
+        };
+    } // namespace
+
+    void SortStage::SpilledDocument::serializeForSorter(BufBuilder& buf) const {
+        loc.serializeForSorter(buf);
+        obj.serializeForSorter(buf);
+    }
+
+    SortStage::SpilledDocument SortStage::SpilledDocument::deserializeForSorter(
+            BufReader& buf, const SorterDeserializeSettings&) {
+        SpilledDocument doc;
+        doc.loc = DiskLoc::deserializeForSorter(buf, DiskLoc::SorterDeserializeSettings());
+        doc.obj = BSONObj::deserializeForSorter(buf, BSONObj::SorterDeserializeSettings());
+        return doc;
+    }
+
+    SortStage::SpilledDocument SortStage::SpilledDocument::getOwned() const {
+        SpilledDocument doc;
+        doc.loc = loc;
+        doc.obj = obj.getOwned();
+        return doc;
+    }
 
     SortStageKeyGenerator::SortStageKeyGenerator(const BSONObj& sortSpec, const BSONObj& queryObj) {
         _hasBounds = false;
@@ -277,8 +331,11 @@ namespace mongo {
           _pattern(params.pattern),
           _query(params.query),
           _limit(params.limit),
+          _maxMemoryUsageBytes(params.maxMemoryUsageBytes),
+          _tempDir(params.tempDir),
           _sorted(false),
           _resultIterator(_data.end()),
+          _hasComputedData(false),
           _memUsage(0) {
         dassert(_limit >= 0);
     }
@@ -288,7 +345,8 @@ namespace mongo {
     bool SortStage::isEOF() {
         // We're done when our child has no more results, we've sorted the child's results, and
         // we've returned all sorted results.
-        return _child->isEOF() && _sorted && (_data.end() == _resultIterator);
+        return _child->isEOF() && _sorted && (_data.end() == _resultIterator)
+            && (NULL == _spilledOutput || !_spilledOutput->more());
     }
 
     PlanStage::StageState SortStage::work(WorkingSetID* out) {
@@ -307,10 +365,10 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
-        if (_memUsage > kMaxBytes) {
+        if (_memUsage > _maxMemoryUsageBytes) {
             mongoutils::str::stream ss;
             ss << "sort stage buffered data usage of " << _memUsage
-               << " bytes exceeds internal limit of " << kMaxBytes << " bytes";
+               << " bytes exceeds internal limit of " << _maxMemoryUsageBytes << " bytes";
             Status status(ErrorCodes::Overflow, ss);
             *out = WorkingSetCommon::allocateStatusMember( _ws, status);
             return PlanStage::FAILURE;
@@ -346,15 +404,37 @@ namespace mongo {
                     item.loc = member->loc;
                 }
 
+                if (hasComputedData(*member)) {
+                    _hasComputedData = true;
+                }
+
                 addToBuffer(item);
 
+                // Only an unlimited sort can outgrow memory without bound; a top-K sort holds
+                // at most K results and those stay in memory.
+                if (0 == _limit && _memUsage > _maxMemoryUsageBytes && !_tempDir.empty()
+                    && !_hasComputedData) {
+                    spillBuffer();
+                }
+
                 ++_commonStats.needTime;
                 return PlanStage::NEED_TIME;
             }
             else if (PlanStage::IS_EOF == code) {
                 // TODO: We don't need the lock for this.  We could ask for a yield and do this work
                 // unlocked.  Also, this is performing a lot of work for one call to work(...)
-                sortBuffer();
+                if (_spilledRuns.empty()) {
+                    sortBuffer();
+                }
+                else {
+                    // Write what's left as one more run and merge them all.
+                    if (!_data.empty()) {
+                        spillBuffer();
+                    }
+                    SpillComparator cmp(_sortKeyGen->getSortComparator());
+                    _spilledOutput.reset(SpilledIterator::merge(_spilledRuns, SortOptions(), cmp));
+                    _spilledRuns.clear();
+                }
                 _resultIterator = _data.begin();
                 _sorted = true;
                 ++_commonStats.needTime;
@@ -377,8 +457,20 @@ namespace mongo {
         }
 
         // Returning results.
-        verify(_resultIterator != _data.end());
         verify(_sorted);
+        if (NULL != _spilledOutput) {
+            // The document may have changed or gone away since we wrote it out.  As with an
+            // invalidation, we return the copy we sorted, without its DiskLoc.
+            SpilledDocument doc = _spilledOutput->next().second;
+            *out = _ws->allocate();
+            WorkingSetMember* member = _ws->get(*out);
+            member->obj = doc.obj.getOwned();
+            member->state = WorkingSetMember::OWNED_OBJ;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        verify(_resultIterator != _data.end());
         *out = _resultIterator->wsid;
         _resultIterator++;
 
@@ -521,6 +613,30 @@ namespace mongo {
         }
     }
 
+    void SortStage::spillBuffer() {
+        sortBuffer();
+
+        SortedFileWriter<BSONObj, SpilledDocument> writer(SortOptions().TempDir(_tempDir));
+        for (size_t i = 0; i < _data.size(); ++i) {
+            WorkingSetMember* member = _ws->get(_data[i].wsid);
+            SpilledDocument doc;
+            doc.loc = _data[i].loc;
+            doc.obj = member->obj;
+            writer.addAlreadySorted(_data[i].sortKey, doc);
+            _specificStats.spilledBytes += _data[i].sortKey.objsize() + doc.obj.objsize();
+
+            if (member->hasLoc()) {
+                _wsidByDiskLoc.erase(member->loc);
+            }
+            _ws->free(_data[i].wsid);
+        }
+        _spilledRuns.push_back(boost::shared_ptr<SpilledIterator>(writer.done()));
+        ++_specificStats.spills;
+
+        _data.clear();
+        _memUsage = 0;
+    }
+
     void SortStage::sortBuffer() {
         if (_limit == 0) {
             const WorkingSetComparator& cmp = *_sortKeyComparator;
@@ -541,3 +657,6 @@ namespace mongo {
     }
 
 }  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+MONGO_CREATE_SORTER(mongo::BSONObj, mongo::SortStage::SpilledDocument, mongo::SpillComparator);
@@ -29,6 +29,8 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
 #include <vector>
 #include <set>
 
@@ -38,6 +40,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/index_bounds.h"
+#include "mongo/db/sorter/sorter.h"
 #include "mongo/platform/unordered_map.h"
 
 namespace mongo {
@@ -47,7 +50,10 @@ namespace mongo {
     // Parameters that must be provided to a SortStage
     class SortStageParams {
     public:
-        SortStageParams() : limit(0) { }
+        SortStageParams() : limit(0), maxMemoryUsageBytes(kMaxBytes) { }
+
+        // How much data we buffer before spilling it to disk or, when we can't, failing.
+        static const size_t kMaxBytes;
 
         // How we're sorting.
         BSONObj pattern;
@@ -57,6 +63,13 @@ namespace mongo {
 
         // Must be >= 0.  Equal to 0 for no limit.
         int limit;
+
+        size_t maxMemoryUsageBytes;
+
+        // Where sorted runs are written once the buffered data passes maxMemoryUsageBytes.
+        // Empty means the sort fails instead.  Only sorts without a limit spill, a top-K sort
+        // keeps its K results in memory.
+        std::string tempDir;
     };
 
     /**
@@ -145,6 +158,22 @@ namespace mongo {
 
         PlanStageStats* getStats();
 
+        // A buffered document written out with a sorted run.
+        struct SpilledDocument {
+            DiskLoc loc;
+            BSONObj obj;
+
+            // members for Sorter
+            struct SorterDeserializeSettings {}; // unused
+            void serializeForSorter(BufBuilder& buf) const;
+            static SpilledDocument deserializeForSorter(BufReader& buf,
+                                                        const SorterDeserializeSettings&);
+            int memUsageForSorter() const { return sizeof(SpilledDocument) + obj.objsize(); }
+            SpilledDocument getOwned() const;
+        };
+
+        typedef SortIteratorInterface<BSONObj, SpilledDocument> SpilledIterator;
+
     private:
         void getBoundsForSort(const BSONObj& queryObj, const BSONObj& sortObj);
 
@@ -167,6 +196,11 @@ namespace mongo {
         // Must be >= 0.  Equal to 0 for no limit.
         int _limit;
 
+        size_t _maxMemoryUsageBytes;
+
+        // Empty if we can't spill.
+        std::string _tempDir;
+
         //
         // Sort key generation
         //
@@ -216,6 +250,11 @@ namespace mongo {
          */
         void sortBuffer();
 
+        /**
+         * Sorts _data and writes it out as a run on disk, freeing its working set members.
+         */
+        void spillBuffer();
+
         // Comparator for data buffer
         // Initialization follows sort key generator
         scoped_ptr<WorkingSetComparator> _sortKeyComparator;
@@ -238,6 +277,21 @@ namespace mongo {
         typedef unordered_map<DiskLoc, WorkingSetID, DiskLoc::Hasher> DataMap;
         DataMap _wsidByDiskLoc;
 
+        //
+        // External sort
+        //
+
+        // Set when a buffered member carries computed data (e.g. a text score), which a run on
+        // disk doesn't keep.
+        bool _hasComputedData;
+
+        // The runs written so far.
+        std::vector<boost::shared_ptr<SpilledIterator> > _spilledRuns;
+
+        // Merges _spilledRuns once the child is exhausted.  We return results from here rather
+        // than from _data if we spilled.
+        boost::scoped_ptr<SpilledIterator> _spilledOutput;
+
         //
         // Stats
         //
@@ -34,6 +34,8 @@
 
 #include "mongo/db/json.h"
 #include "mongo/db/exec/mock_stage.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
 
 using namespace mongo;
@@ -238,4 +240,94 @@ namespace {
                  "{output: [{a: 3}]}");
     }
 
+    //
+    // Sorting more than fits in memory
+    //
+
+    /**
+     * Feeds 'numDocs' documents {a: <scrambled>, i: <input position>} through a sort on 'a' that
+     * may buffer 'maxBytes' and spills to 'tempDir', checking the output is in order.
+     */
+    void testSpill(int numDocs, size_t maxBytes, const std::string& tempDir, int limit,
+                   SortStats* statsOut) {
+        WorkingSet ws;
+        MockStage* ms = new MockStage(&ws);
+        for (int i = 0; i < numDocs; ++i) {
+            WorkingSetMember wsm;
+            wsm.state = WorkingSetMember::OWNED_OBJ;
+            // Repeats every 100 documents so there are ties on 'a'.
+            wsm.obj = BSON("a" << (i * 37) % 100 << "i" << i);
+            ms->pushBack(wsm);
+        }
+
+        SortStageParams params;
+        params.pattern = BSON("a" << 1);
+        params.limit = limit;
+        params.maxMemoryUsageBytes = maxBytes;
+        params.tempDir = tempDir;
+        SortStage sort(params, &ws, ms);
+
+        int count = 0;
+        BSONObj last;
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            state = sort.work(&id);
+            ASSERT_NOT_EQUALS(state, PlanStage::FAILURE);
+            if (PlanStage::ADVANCED != state) {
+                continue;
+            }
+            BSONObj obj = ws.get(id)->obj;
+            if (!last.isEmpty()) {
+                ASSERT_LESS_THAN_OR_EQUALS(last["a"].numberInt(), obj["a"].numberInt());
+            }
+            last = obj.getOwned();
+            ws.free(id);
+            ++count;
+        }
+
+        ASSERT_EQUALS(limit ? limit : numDocs, count);
+        scoped_ptr<PlanStageStats> stats(sort.getStats());
+        *statsOut = *static_cast<SortStats*>(stats->specific.get());
+    }
+
+    TEST(SortStageTest, SpillsToDisk) {
+        unittest::TempDir tempDir("sort_stage_test");
+        SortStats stats;
+        testSpill(5000, 16 * 1024, tempDir.path(), 0, &stats);
+        ASSERT_GREATER_THAN(stats.spills, 1U);
+        ASSERT_GREATER_THAN(stats.spilledBytes, 5000 * 16);
+    }
+
+    TEST(SortStageTest, TopKDoesNotSpill) {
+        unittest::TempDir tempDir("sort_stage_test");
+        SortStats stats;
+        testSpill(5000, 16 * 1024, tempDir.path(), 10, &stats);
+        ASSERT_EQUALS(stats.spills, 0U);
+        ASSERT_EQUALS(stats.spilledBytes, 0);
+    }
+
+    TEST(SortStageTest, FailsWithoutTempDir) {
+        WorkingSet ws;
+        MockStage* ms = new MockStage(&ws);
+        for (int i = 0; i < 1000; ++i) {
+            WorkingSetMember wsm;
+            wsm.state = WorkingSetMember::OWNED_OBJ;
+            wsm.obj = BSON("a" << i);
+            ms->pushBack(wsm);
+        }
+
+        SortStageParams params;
+        params.pattern = BSON("a" << 1);
+        params.maxMemoryUsageBytes = 1024;
+        SortStage sort(params, &ws, ms);
+
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::NEED_TIME == state) {
+            state = sort.work(&id);
+        }
+        ASSERT_EQUALS(state, PlanStage::FAILURE);
+    }
+
 }  // namespace
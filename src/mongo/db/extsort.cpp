@@ -71,6 +71,15 @@ namespace mongo {
                                  .MaxMemoryUsageBytes(maxFileSize),
                     ComparatorWithInterruptCheck(comp, _mayInterrupt)))
     {}
+
+    BSONObjExternalSorter::Iterator* BSONObjExternalSorter::merge(
+            const std::vector<boost::shared_ptr<Iterator> >& iters,
+            const ExternalSortComparison* comp) {
+        return Iterator::merge(iters,
+                               SortOptions(),
+                               ComparatorWithInterruptCheck(comp,
+                                                            boost::make_shared<bool>(false)));
+    }
 }
 
 #include "mongo/db/sorter/sorter.cpp"
@@ -63,6 +63,10 @@ namespace mongo {
 
         auto_ptr<Iterator> iterator() { return auto_ptr<Iterator>(_sorter->done()); }
 
+        /** @return an iterator over the contents of 'iters', which were all sorted by 'comp' */
+        static Iterator* merge(const std::vector<boost::shared_ptr<Iterator> >& iters,
+                               const ExternalSortComparison* comp);
+
         void sort( bool mayInterrupt ) { *_mayInterrupt = mayInterrupt; }
         int numFiles() { return _sorter->numFiles(); }
         long getCurSizeSoFar() { return _sorter->memUsed(); }
@@ -30,6 +30,7 @@
 
 #include <vector>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/status.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/extsort.h"
@@ -366,6 +367,15 @@ namespace mongo {
             return Status::OK();
         }
 
+        virtual IndexAccessMethod* forkBulk() {
+            BtreeBulk* fork = new BtreeBulk( _real );
+            fork->_phase1.sortCmp = _phase1.sortCmp;
+            fork->_phase1.sorter.reset( new BSONObjExternalSorter( _phase1.sortCmp.get(),
+                                                                   ForkSortMemoryBytes ) );
+            _forks.mutableVector().push_back( fork );
+            return fork;
+        }
+
         virtual Status touch(const BSONObj& obj) {
             return _notAllowed();
         }
@@ -376,6 +386,40 @@ namespace mongo {
 
         // -------
 
+        // forks each get a smaller sorter, as there is one per thread per index
+        enum { ForkSortMemoryBytes = 16 * 1024 * 1024 };
+
+        unsigned long long numKeys() const {
+            unsigned long long n = _phase1.nkeys;
+            for ( size_t i = 0; i < _forks.size(); i++ )
+                n += _forks.vector()[i]->numKeys();
+            return n;
+        }
+
+        bool isMultikey() const {
+            bool multi = _phase1.multi;
+            for ( size_t i = 0; i < _forks.size(); i++ )
+                multi = multi || _forks.vector()[i]->isMultikey();
+            return multi;
+        }
+
+        /** @return all the keys inserted into this and its forks, in order */
+        BSONObjExternalSorter::Iterator* sortedKeys() {
+            if ( _forks.empty() )
+                return _phase1.sorter->iterator().release();
+
+            std::vector<boost::shared_ptr<BSONObjExternalSorter::Iterator> > iters;
+            _addIterators( &iters );
+            return BSONObjExternalSorter::merge( iters, _phase1.sortCmp.get() );
+        }
+
+        void _addIterators( std::vector<boost::shared_ptr<BSONObjExternalSorter::Iterator> >* iters ) {
+            iters->push_back( boost::shared_ptr<BSONObjExternalSorter::Iterator>(
+                                  _phase1.sorter->iterator().release() ) );
+            for ( size_t i = 0; i < _forks.size(); i++ )
+                _forks.vector()[i]->_addIterators( iters );
+        }
+
         template< class V >
         void commit( set<DiskLoc>* dupsToDrop,
                      CurOp* op,
@@ -392,12 +436,13 @@ namespace mongo {
             BtreeBuilder<V> btBuilder(dupsAllowed, entry);
 
             BSONObj keyLast;
-            scoped_ptr<BSONObjExternalSorter::Iterator> i( _phase1.sorter->iterator() );
+            const unsigned long long nkeys = numKeys();
+            scoped_ptr<BSONObjExternalSorter::Iterator> i( sortedKeys() );
 
             // verifies that pm and op refer to the same ProgressMeter
             ProgressMeter& pm = op->setMessage("Index Bulk Build: (2/3) btree bottom up",
                                                "Index: (2/3) BTree Bottom Up Progress",
-                                               _phase1.nkeys,
+                                               nkeys,
                                                10);
 
             while( i->more() ) {
@@ -443,7 +488,7 @@ namespace mongo {
                            "Index: (3/3) BTree Middle Progress");
             LOG(timer.seconds() > 10 ? 0 : 1 ) << "\t done building bottom layer, going to commit";
             btBuilder.commit( mayInterrupt );
-            if ( btBuilder.getn() != _phase1.nkeys && ! dropDups ) {
+            if ( btBuilder.getn() != nkeys && ! dropDups ) {
                 warning() << "not all entries were added to the index, probably some "
                           << "keys were too large" << endl;
             }
@@ -457,6 +502,7 @@ namespace mongo {
 
         BtreeBasedAccessMethod* _real; // now owned here
         SortPhaseOne _phase1;
+        OwnedPointerVector<BtreeBulk> _forks;
     };
 
     int oldCompare(const BSONObj& l,const BSONObj& r, const Ordering &o); // key.cpp
@@ -542,7 +588,7 @@ namespace mongo {
         string ns = _btreeState->collection()->ns().ns();
 
         BtreeBulk* bulk = static_cast<BtreeBulk*>( bulkRaw );
-        if ( bulk->_phase1.multi )
+        if ( bulk->isMultikey() )
             _btreeState->setMultikey();
 
         bulk->_phase1.sorter->sort( false );
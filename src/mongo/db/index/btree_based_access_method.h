@@ -89,6 +89,8 @@ namespace mongo {
                                    bool mayInterrupt,
                                    std::set<DiskLoc>* dups );
 
+        virtual IndexAccessMethod* forkBulk() { return NULL; }
+
         virtual Status touch(const BSONObj& obj);
 
         virtual Status validate(int64_t* numKeys);
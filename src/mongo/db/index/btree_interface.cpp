@@ -29,6 +29,7 @@
 #include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/index/btree_interface.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/platform/random.h"
 #include "mongo/db/structure/btree/btree.h"
 #include "mongo/db/structure/record_store.h"
 
@@ -217,6 +218,58 @@ namespace mongo {
                                        const BSONObj& keyPattern) {
             return getBucket( btreeState, thisLoc )->fullValidate(thisLoc, keyPattern);
         }
+
+        virtual double randomKey(const IndexCatalogEntry* btreeState,
+                                 PseudoRandom* random,
+                                 BSONObj* keyOut) const {
+            *keyOut = BSONObj();
+
+            // The buckets on the way down, and how many keys each level of the tree is estimated
+            // to hold: a bucket's keys times how many buckets at its depth it stands for.
+            vector<DiskLoc> path;
+            vector<double> levelKeys;
+            double estimate = 0;
+            double weight = 1;
+            DiskLoc loc = btreeState->head();
+            while ( !loc.isNull() ) {
+                const BtreeBucket<Version> *b = getBucket( btreeState, loc );
+                int n = b->getN();
+                if ( n == b->INVALID_N_SENTINEL ) {
+                    throw UserException(deletedBucketCode, "randomKey bucket deleted");
+                }
+                path.push_back( loc );
+                levelKeys.push_back( weight * n );
+                estimate += weight * n;
+
+                // Children are either all null (a leaf) or all set.
+                int child = static_cast<uint32_t>( random->nextInt32() ) % ( n + 1 );
+                loc = ( child == n ) ? b->getNextChild() : DiskLoc( b->k( child ).prevChildBucket );
+                weight *= n + 1;
+            }
+
+            if ( estimate <= 0 )
+                return estimate;
+
+            // Take the key from a level in proportion to its share of the keys.  We reached the
+            // bucket at a level with probability 1 / its weight, so each key, internal or leaf,
+            // is about as likely as any other.
+            double r = static_cast<uint32_t>( random->nextInt32() ) / 4294967296.0 * estimate;
+            size_t level = 0;
+            while ( level + 1 < path.size() && r >= levelKeys[level] ) {
+                r -= levelKeys[level];
+                level++;
+            }
+
+            const BtreeBucket<Version> *b = getBucket( btreeState, path[level] );
+            int n = b->getN();
+            if ( n > 0 ) {
+                int pos = static_cast<uint32_t>( random->nextInt32() ) % n;
+                if ( b->k( pos ).isUsed() ) {
+                    *keyOut = b->keyNode( pos ).key.toBson();
+                }
+            }
+            return estimate;
+        }
     };
 
     BtreeInterfaceImpl<V0> interface_v0;
@@ -34,6 +34,7 @@
 namespace mongo {
 
     class IndexCatalogEntry;
+    class PseudoRandom;
 
     /**
      * We have two Btree on-disk formats which support identical operations.  We hide this as much
@@ -147,6 +148,19 @@ namespace mongo {
         virtual void keyAndRecordAt(const IndexCatalogEntry* btreeState,
                                     DiskLoc bucket, int keyOffset, BSONObj* keyOut,
                                     DiskLoc* recordOut) const = 0;
+
+        /**
+         * Walks down from the head to a leaf, taking one of each bucket's children at random,
+         * and puts a random key of one of the buckets on the way in 'keyOut' (empty if it has
+         * none).  The bucket is picked by its level's estimated share of the keys, so internal
+         * keys are sampled as often as leaf keys.  'keyOut' points into the bucket.
+         *
+         * Returns an estimate of the number of keys in the index from the keys and children of
+         * the buckets on the way down.  The average over many walks is unbiased.
+         */
+        virtual double randomKey(const IndexCatalogEntry* btreeState,
+                                 PseudoRandom* random,
+                                 BSONObj* keyOut) const = 0;
     };
 
 }  // namespace mongo
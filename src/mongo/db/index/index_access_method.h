@@ -169,6 +169,15 @@ namespace mongo {
         virtual Status commitBulk( IndexAccessMethod* bulk,
                                    bool mayInterrupt,
                                    std::set<DiskLoc>* dups ) = 0;
+
+        /**
+         * Call this on an IndexAccessMethod gotten from initiateBulk to get another one that
+         * can be inserted into from a different thread, at the same time as this one and its
+         * other forks.  The keys of all of them are merged when this one is committed.
+         * The returned IndexAccessMethod is owned by this one.
+         * Returns NULL if this isn't a bulk IndexAccessMethod.
+         */
+        virtual IndexAccessMethod* forkBulk() = 0;
     };
 
     /**
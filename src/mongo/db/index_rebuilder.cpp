@@ -86,9 +86,10 @@ namespace mongo {
             LOG(3) << "IndexRebuilder::checkNS: " << ns;
 
             // This write lock is held throughout the index building process
-            // for this namespace.
-            Client::WriteContext ctx(ns);
-            Collection* collection = ctx.ctx().db()->getCollection( ns );
+            // for this namespace.  Building an index needs the whole database.
+            Lock::DBWrite lk( nsToDatabaseSubstring( ns ) );
+            Client::Context ctx( ns );
+            Collection* collection = ctx.db()->getCollection( ns );
             if ( collection == NULL )
                 continue;
 
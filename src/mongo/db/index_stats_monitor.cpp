@@ -0,0 +1,265 @@
+// index_stats_monitor.cpp
+
+/**
+*    Copyright (C) 2013 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/index_stats_monitor.h"
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/index/btree_interface.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_cursor.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/instance.h"
+#include "mongo/db/query/index_stats.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/background.h"
+
+namespace mongo {
+
+    Counter64 indexStatsPasses;
+    Counter64 indexStatsRefreshed;
+
+    ServerStatusMetricField<Counter64> indexStatsPassesDisplay("indexStats.passes",
+                                                                &indexStatsPasses);
+    ServerStatusMetricField<Counter64> indexStatsRefreshedDisplay("indexStats.refreshed",
+                                                                   &indexStatsRefreshed);
+
+    MONGO_EXPORT_SERVER_PARAMETER( indexStatsMonitorEnabled, bool, true );
+    MONGO_EXPORT_SERVER_PARAMETER( indexStatsMonitorSleepSecs, int, 60 );
+
+    class IndexStatsMonitor : public BackgroundJob {
+    public:
+        IndexStatsMonitor() : _random( static_cast<int64_t>( curTimeMicros64() ) ) {}
+        virtual ~IndexStatsMonitor(){}
+
+        virtual string name() const { return "IndexStatsMonitor"; }
+
+        // How many leading values we keep per index, give or take a factor of two.
+        static const size_t kMaxSamples = 100;
+
+        // How many random keys we read per index.
+        static const int kSampleKeys = 1000;
+
+        // Indexes with up to about this many keys are read whole instead, which is no slower
+        // and gives exact stats.
+        static const long long kMaxWalkKeys = 10000;
+
+        /**
+         * Stats are out of date once the collection has grown or shrunk by a tenth.
+         */
+        static bool isStale( const IndexStats& stats, long long records ) {
+            long long change = records - stats.collectionRecords;
+            if ( change < 0 )
+                change = -change;
+            return change * 10 > stats.collectionRecords;
+        }
+
+        static bool leadingValueLessThan( const BSONObj& a, const BSONObj& b ) {
+            return a.firstElement().woCompare( b.firstElement(), false ) < 0;
+        }
+
+        /**
+         * Reads up to 'maxKeys' keys of the index in order.  Returns NULL if there were more.
+         */
+        static IndexStats* walkIndex( IndexAccessMethod* iam, const IndexDescriptor* desc,
+                                      long long maxKeys, long long records ) {
+            IndexCursor* rawCursor;
+            Status status = iam->newCursor( &rawCursor );
+            if ( !status.isOK() )
+                return NULL;
+            scoped_ptr<IndexCursor> cursor( rawCursor );
+
+            CursorOptions options;
+            options.direction = CursorOptions::INCREASING;
+            options.numWanted = 0;
+            cursor->setOptions( options );
+
+            // Seek to the very first key in index order.
+            BSONObjBuilder start;
+            BSONObjIterator it( desc->keyPattern() );
+            while ( it.more() ) {
+                if ( it.next().number() >= 0 )
+                    start.appendMinKey( "" );
+                else
+                    start.appendMaxKey( "" );
+            }
+            cursor->seek( start.obj() );
+
+            int direction = desc->keyPattern().firstElement().number() >= 0 ? 1 : -1;
+            IndexStatsBuilder builder( kMaxSamples, direction );
+            for ( long long i = 0; i < maxKeys && !cursor->isEOF(); ++i ) {
+                builder.addKey( cursor->getKey() );
+                cursor->next();
+            }
+            if ( !cursor->isEOF() )
+                return NULL;
+            return builder.done( records );
+        }
+
+        /**
+         * Samples kSampleKeys random keys of the index named 'indexName' on 'ns', or reads it
+         * whole if it's small, and hangs the result off its IndexCatalogEntry.
+         */
+        void refreshIndex( const string& ns, const string& indexName ) {
+            Client::ReadContext ctx( ns );
+            Collection* collection = ctx.ctx().db()->getCollection( ns );
+            if ( !collection )
+                return;
+
+            IndexCatalog* catalog = collection->getIndexCatalog();
+            IndexDescriptor* desc = catalog->findIndexByName( indexName );
+            if ( !desc || IndexNames::BTREE != desc->getAccessMethodName() )
+                return;
+
+            IndexCatalogEntry* entry = catalog->getEntry( desc );
+            long long records = collection->numRecords();
+
+            boost::shared_ptr<const IndexStats> current = entry->getStats();
+            if ( current && !isStale( *current, records ) )
+                return;
+
+            BtreeInterface* interface = BtreeInterface::interfaces[desc->version()];
+            double numKeys = 0;
+            vector<BSONObj> sample;
+            for ( int i = 0; i < kSampleKeys; ++i ) {
+                BSONObj key;
+                numKeys += interface->randomKey( entry, &_random, &key );
+                if ( !key.isEmpty() )
+                    sample.push_back( key.getOwned() );
+            }
+            numKeys /= kSampleKeys;
+
+            boost::shared_ptr<const IndexStats> stats;
+            if ( numKeys <= kMaxWalkKeys ) {
+                // The estimate can be off, so don't read much more than we meant to.
+                stats.reset( walkIndex( catalog->getIndex( desc ), desc, 2 * kMaxWalkKeys,
+                                        records ) );
+            }
+            if ( !stats ) {
+                std::sort( sample.begin(), sample.end(), leadingValueLessThan );
+                IndexStatsBuilder builder( kMaxSamples, 1 );
+                for ( size_t i = 0; i < sample.size(); ++i ) {
+                    builder.addKey( sample[i] );
+                }
+                stats.reset( builder.doneSampled( static_cast<long long>( numKeys ), records ) );
+            }
+
+            entry->setStats( stats );
+            indexStatsRefreshed.increment();
+            LOG(1) << "index stats for " << ns << " " << indexName << ": "
+                   << stats->numKeys << " keys, " << stats->distinctLeadingValues
+                   << " leading values" << endl;
+        }
+
+        void doIndexStatsForDB( const string& dbName ) {
+            vector<BSONObj> indexes;
+            {
+                auto_ptr<DBClientCursor> cursor =
+                                db.query( dbName + ".system.indexes" ,
+                                          BSONObj() ,
+                                          0 , /* default nToReturn */
+                                          0 , /* default nToSkip */
+                                          0 , /* default fieldsToReturn */
+                                          QueryOption_SlaveOk ); /* perform on secondaries too */
+                if ( cursor.get() ) {
+                    while ( cursor->more() ) {
+                        indexes.push_back( cursor->next().getOwned() );
+                    }
+                }
+            }
+
+            for ( unsigned i=0; i<indexes.size() && !inShutdown(); i++ ) {
+                BSONObj idx = indexes[i];
+                if ( idx["ns"].type() != String || idx["name"].type() != String )
+                    continue;
+                refreshIndex( idx["ns"].String(), idx["name"].String() );
+            }
+        }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+            cc().getAuthorizationSession()->grantInternalAuthorization();
+
+            while ( ! inShutdown() ) {
+                sleepsecs( std::max( indexStatsMonitorSleepSecs, 1 ) );
+
+                LOG(3) << "IndexStatsMonitor thread awake" << endl;
+
+                if ( !indexStatsMonitorEnabled ) {
+                   LOG(1) << "IndexStatsMonitor is disabled" << endl;
+                   continue;
+                }
+
+                set<string> dbs;
+                {
+                    Lock::DBRead lk( "local" );
+                    dbHolder().getAllShortNames( dbs );
+                }
+
+                indexStatsPasses.increment();
+
+                for ( set<string>::const_iterator i=dbs.begin(); i!=dbs.end(); ++i ) {
+                    string db = *i;
+                    try {
+                        doIndexStatsForDB( db );
+                    }
+                    catch ( DBException& e ) {
+                        error() << "error gathering index stats for db: " << db << " " << e << endl;
+                    }
+                }
+            }
+        }
+
+        DBDirectClient db;
+
+    private:
+        PseudoRandom _random;
+    };
+
+    void startIndexStatsBackgroundJob() {
+        IndexStatsMonitor* monitor = new IndexStatsMonitor();
+        monitor->go();
+    }
+
+}
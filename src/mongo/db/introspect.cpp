@@ -132,7 +132,8 @@ namespace {
         BufBuilder profileBufBuilder(1024);
 
         try {
-            Lock::DBWrite lk( currentOp.getNS() );
+            // system.profile is shared by the whole database, lock it as such
+            Lock::DBWrite lk( nsToDatabaseSubstring( currentOp.getNS() ) );
             if (dbHolder()._isLoaded(nsToDatabase(currentOp.getNS()), storageGlobalParams.dbpath)) {
                 Client::Context cx(currentOp.getNS(), storageGlobalParams.dbpath);
                 _profile(c, currentOp, profileBufBuilder);
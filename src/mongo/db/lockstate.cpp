@@ -48,6 +48,8 @@ namespace mongo {
           _nestableCount(0), 
           _otherCount(0), 
           _otherLock(NULL),
+          _collectionCount(0),
+          _collectionLock(NULL),
           _scopedLk(NULL),
           _lockPending(false),
           _lockPendingParallelWriter(false)
@@ -76,7 +78,7 @@ namespace mongo {
         
         DEV verify( _otherName.find( '.' ) == string::npos ); // XXX this shouldn't be here, but somewhere
         if ( _otherCount && db == _otherName )
-            return true;
+            return !_collectionCount || coveredByCollectionLock( ns );
 
         if ( _nestableCount ) {
             if ( mongoutils::str::equals( db , "local" ) )
@@ -88,6 +90,14 @@ namespace mongo {
         return false;
     }
 
+    bool LockState::coveredByCollectionLock( const StringData& ns ) const {
+        // Only our collection or one of its indexes.  The bare database name and the system
+        // collections stand for state of the whole database, which needs the database lock.
+        const StringData coll( _collectionName );
+        return ns == coll
+            || ( ns.startsWith( coll ) && ns.substr( coll.size() ).startsWith( ".$" ) );
+    }
+
     void LockState::lockedStart( char newState ) {
         _threadState = newState;
     }
@@ -108,6 +118,15 @@ namespace mongo {
         return "?";
     }
 
+    // a db locked in intent mode reports like the global lock does: lowercase
+    static string intentKind(int n) { 
+        if( n > 0 )
+            return "w";
+        if( n < 0 ) 
+            return "r";
+        return "?";
+    }
+
     BSONObj LockState::reportState() {
         BSONObjBuilder b;
         reportState( b );
@@ -136,10 +155,22 @@ namespace mongo {
         }
         if( _otherCount ) { 
             WrapperForRWLock *k = _otherLock;
+            WrapperForRWLock *c = _collectionLock;
             if( k ) {
                 string s = "^";
                 s += k->name();
-                b.append(s, kind(_otherCount));
+                if( _collectionCount && c ) {
+                    // the collection goes under its database: a full ns isn't a usable field name
+                    BSONObjBuilder db( b.subobjStart(s) );
+                    db.append("^", intentKind(_otherCount));
+                    db.append("collection",
+                              BSON("name" << nsToCollectionSubstring(c->name())
+                                   << "mode" << kind(_collectionCount)));
+                    db.done();
+                }
+                else {
+                    b.append(s, kind(_otherCount));
+                }
             }
         }
         BSONObj o = b.obj();
@@ -167,6 +198,10 @@ namespace mongo {
             if( _otherCount ) {
                 ss << " otherdb:" << _otherName;
             }
+            if( _collectionCount ) {
+                ss << " collectionCount:" << _collectionCount;
+                ss << " collection:" << _collectionName;
+            }
             if( _nestableCount ) {
                 ss << " nestableCount:" << _nestableCount << " which:";
                 if( _whichNestable == Lock::local ) 
@@ -230,6 +265,18 @@ namespace mongo {
         _otherCount = 0;
     }
 
+    void LockState::lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock ) {
+        fassert( 17406 , _collectionCount == 0 );
+        _collectionName = ns.toString();
+        _collectionCount = type;
+        _collectionLock = lock;
+    }
+
+    void LockState::unlockedCollection() {
+        // as with _otherLock, _collectionName and _collectionLock are left set
+        _collectionCount = 0;
+    }
+
     LockStat* LockState::getRelevantLockStat() {
         if ( _whichNestable )
             return Lock::nestableLockStat( _whichNestable );
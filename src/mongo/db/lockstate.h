@@ -91,6 +91,13 @@ namespace mongo {
         void lockedOther( const StringData& db , int type , WrapperForRWLock* lock );
         void lockedOther( int type );  // "same lock as last time" case 
         void unlockedOther();
+
+        // collection level concurrency: the db ("other") lock is then held in intent mode
+        int collectionCount() const { return _collectionCount; }
+        const string& collectionName() const { return _collectionName; }
+        WrapperForRWLock* collectionLock() const { return _collectionLock; }
+        void lockedCollection( const StringData& ns , int type , WrapperForRWLock* lock );
+        void unlockedCollection();
         bool _batchWriter;
 
         LockStat* getRelevantLockStat();
@@ -98,6 +105,9 @@ namespace mongo {
         void resetLockTime() { _scopedLk->resetTime(); }
         
     private:
+        /** with a collection locked under an intent lock on its db: whether that covers 'ns' */
+        bool coveredByCollectionLock( const StringData& ns ) const;
+
         unsigned _recursive;           // we allow recursively asking for a lock; we track that here
 
         // global lock related
@@ -111,6 +121,10 @@ namespace mongo {
         string _otherName;             // which database are we locking and working with (besides local/admin) 
         WrapperForRWLock* _otherLock;  // so we don't have to check the map too often (the map has a mutex)
 
+        int _collectionCount;          // >0 write lock, <0 read lock on _collectionName only
+        string _collectionName;        // full ns of the collection locked under an intent db lock
+        WrapperForRWLock* _collectionLock;
+
         // for temprelease
         // for the nonrecursive case. otherwise there would be many
         // the first lock goes here, which is ok since we can't yield recursive locks
@@ -38,9 +38,28 @@ namespace mongo {
     Status ElementPath::init( const StringData& path ) {
         _shouldTraverseLeafArray = true;
         _fieldRef.parse( path );
+
+        _tail.reset();
+        if ( _fieldRef.numParts() > 1 ) {
+            _tail.reset( new ElementPath() );
+            _tail->init( _fieldRef.dottedField( 1 ) );
+        }
         return Status::OK();
     }
 
+    void ElementPath::setTraverseLeafArray( bool b ) {
+        _shouldTraverseLeafArray = b;
+        if ( _tail )
+            _tail->setTraverseLeafArray( b );
+    }
+
+    const ElementPath* ElementPath::suffix( size_t offset ) const {
+        const ElementPath* path = this;
+        for ( size_t i = 0; path && i < offset; ++i )
+            path = path->_tail.get();
+        return path;
+    }
+
     // -----
 
     ElementIterator::~ElementIterator(){
@@ -105,13 +124,14 @@ namespace mongo {
         _next.reset();
 
         _subCursor.reset();
-        _subCursorPath.reset();
     }
 
 
-    void BSONElementIterator::ArrayIterationState::reset( const FieldRef& ref, int start ) {
-        restOfPath = ref.dottedField( start ).toString();
+    void BSONElementIterator::ArrayIterationState::reset( const ElementPath* path, size_t start ) {
+        const FieldRef& ref = path->fieldRef();
+        restOfPath = ref.dottedField( start );
         hasMore = restOfPath.size() > 0;
+        restPath = hasMore ? path->suffix( start ) : NULL;
         if ( hasMore ) {
             nextPieceOfPath = ref.getPart( start );
             nextPieceOfPathIsNumber = isAllDigits( nextPieceOfPath );
@@ -158,10 +178,8 @@ namespace mongo {
                     return true;
                 }
 
-                _subCursorPath.reset( new ElementPath() );
-                _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
-                _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-                _subCursor.reset( new BSONElementIterator( _subCursorPath.get(), _arrayIterationState._current.Obj() ) );
+                _subCursor.reset( new BSONElementIterator( _arrayIterationState.restPath->suffix( 1 ),
+                                                           _arrayIterationState._current.Obj() ) );
                 _arrayIterationState._current = BSONElement();
                 return more();
             }
@@ -187,7 +205,7 @@ namespace mongo {
 
             // its an array
 
-            _arrayIterationState.reset( _path->fieldRef(), idxPath + 1 );
+            _arrayIterationState.reset( _path, idxPath + 1 );
 
             if ( !_arrayIterationState.hasMore && !_path->shouldTraverseLeafArray() ) {
                 _next.reset( e, BSONElement(), true );
@@ -213,11 +231,8 @@ namespace mongo {
                 // i have deeper to go
 
                 if ( x.type() == Object ) {
-                    _subCursorPath.reset( new ElementPath() );
-                    _subCursorPath->init( _arrayIterationState.restOfPath );
-                    _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-
-                    _subCursor.reset( new BSONElementIterator( _subCursorPath.get(), x.Obj() ) );
+                    _subCursor.reset( new BSONElementIterator( _arrayIterationState.restPath,
+                                                               x.Obj() ) );
                     return more();
                 }
 
@@ -230,12 +245,10 @@ namespace mongo {
                     }
 
                     if ( x.isABSONObj() ) {
-                        _subCursorPath.reset( new ElementPath() );
-                        _subCursorPath->init( _arrayIterationState.restOfPath.substr( _arrayIterationState.nextPieceOfPath.size() + 1 ) );
-                        _subCursorPath->setTraverseLeafArray( _path->shouldTraverseLeafArray() );
-                        BSONElementIterator* real = new BSONElementIterator( _subCursorPath.get(), _arrayIterationState._current.Obj() );
+                        const ElementPath* subPath = _arrayIterationState.restPath->suffix( 1 );
+                        BSONElementIterator* real = new BSONElementIterator( subPath, _arrayIterationState._current.Obj() );
                         _subCursor.reset( real );
-                        real->_arrayIterationState.reset( _subCursorPath->fieldRef(), 0 );
+                        real->_arrayIterationState.reset( subPath, 0 );
                         real->_arrayIterationState.startIterator( x );
                         real->_state = IN_ARRAY;
                         _arrayIterationState._current = BSONElement();
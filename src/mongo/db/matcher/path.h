@@ -44,14 +44,25 @@ namespace mongo {
     public:
         Status init( const StringData& path );
 
-        void setTraverseLeafArray( bool b ) { _shouldTraverseLeafArray = b; }
+        void setTraverseLeafArray( bool b );
 
         const FieldRef& fieldRef() const { return _fieldRef; }
         bool shouldTraverseLeafArray() const { return _shouldTraverseLeafArray; }
 
+        /**
+         * Returns the path made of this path's parts from 'offset' on, e.g. suffix(1) of
+         * "a.b.c" is "b.c".  Suffixes are split once in init() so that descending into
+         * arrays while matching doesn't re-parse the rest of the path for every element.
+         * Returns NULL if 'offset' is past the last part.
+         */
+        const ElementPath* suffix( size_t offset ) const;
+
     private:
         FieldRef _fieldRef;
         bool _shouldTraverseLeafArray;
+
+        // Everything after our first part, or NULL if there is only one part.
+        boost::scoped_ptr<ElementPath> _tail;
     };
 
     class ElementIterator {
@@ -134,7 +145,7 @@ namespace mongo {
 
         struct ArrayIterationState {
 
-            void reset( const FieldRef& ref, int start );
+            void reset( const ElementPath* path, size_t start );
             void startIterator( BSONElement theArray );
 
             bool more();
@@ -143,7 +154,9 @@ namespace mongo {
             bool isArrayOffsetMatch( const StringData& fieldName ) const;
             bool nextEntireRest() const { return nextPieceOfPath.size() == restOfPath.size(); }
 
-            string restOfPath;
+            // Points into the owning ElementPath, which outlives the iterator.
+            StringData restOfPath;
+            const ElementPath* restPath;
             bool hasMore;
             StringData nextPieceOfPath;
             bool nextPieceOfPathIsNumber;
@@ -156,7 +169,6 @@ namespace mongo {
         ArrayIterationState _arrayIterationState;
 
         boost::scoped_ptr<ElementIterator> _subCursor;
-        boost::scoped_ptr<ElementPath> _subCursorPath;
     };
 
 }
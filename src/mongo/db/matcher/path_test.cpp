@@ -311,6 +311,41 @@ namespace mongo {
         ASSERT( !cursor.more() );
     }
 
+    TEST( Path, Suffix1 ) {
+        ElementPath p;
+        ASSERT( p.init( "a.b.c" ).isOK() );
+        p.setTraverseLeafArray( false );
+
+        ASSERT_EQUALS( &p, p.suffix( 0 ) );
+        ASSERT_EQUALS( "b.c", p.suffix( 1 )->fieldRef().dottedField() );
+        ASSERT_EQUALS( "c", p.suffix( 2 )->fieldRef().dottedField() );
+        ASSERT( NULL == p.suffix( 3 ) );
+
+        ASSERT( !p.suffix( 1 )->shouldTraverseLeafArray() );
+        ASSERT( !p.suffix( 2 )->shouldTraverseLeafArray() );
+    }
+
+    TEST( Path, NestedArraySuffixReuse ) {
+        ElementPath p;
+        ASSERT( p.init( "a.b.c" ).isOK() );
+
+        BSONObj doc = BSON( "a" << BSON_ARRAY( BSON( "b" << BSON_ARRAY( BSON( "c" << 1 ) <<
+                                                                        BSON( "c" << 2 ) ) ) <<
+                                               BSON( "b" << BSON( "c" << 3 ) ) ) );
+
+        // Walk the same document twice with one iterator to check that sub cursors
+        // built from the shared suffixes leave nothing behind.
+        BSONElementIterator cursor;
+        for ( int pass = 0; pass < 2; ++pass ) {
+            cursor.reset( &p, doc );
+            int sum = 0;
+            while ( cursor.more() ) {
+                sum += cursor.next().element().numberInt();
+            }
+            ASSERT_EQUALS( 6, sum );
+        }
+    }
+
     TEST( SimpleArrayElementIterator, SimpleNoArrayLast1 ) {
         BSONObj obj = BSON( "a" << BSON_ARRAY( 5 << BSON( "x" << 6 ) << BSON_ARRAY( 7 << 9 ) << 11 ) );
         SimpleArrayElementIterator i( obj["a"], false );
@@ -688,6 +688,11 @@ namespace mongo {
             // Save state before making changes
             runner->saveState();
 
+            // A compressed document was handed to us as an uncompressed copy, so changing it
+            // in place would change only the copy.
+            if (inPlace && !damages.empty() && collection->isDocumentCompressed(loc))
+                inPlace = false;
+
             if (inPlace && !driver->modsAffectIndices()) {
 
                 // If a set of modifiers were all no-ops, we are still 'in place', but there is
@@ -43,6 +43,7 @@
 #include "mongo/db/storage/data_file.h"
 #include "mongo/db/storage/durable_mapped_file.h"
 #include "mongo/db/storage/extent.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/db/structure/catalog/namespace_details-inl.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/pdfile_version.h"
@@ -87,7 +88,10 @@ namespace mongo {
     BOOST_STATIC_ASSERT( 16 == sizeof(DeletedRecord) );
 
     inline BSONObj BSONObj::make(const Record* r ) {
-        return BSONObj( r->data() );
+        const char* data = r->data();
+        if ( RecordCompression::isCompressed( data ) )
+            return RecordCompression::uncompress( data );
+        return BSONObj( data );
     }
 
 } // namespace mongo
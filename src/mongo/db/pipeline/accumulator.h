@@ -120,6 +120,22 @@ namespace mongo {
     };
 
 
+    /**
+     * The running total of a $sum.  Kept apart from AccumulatorSum so that $group can store one
+     * per group in a plain array.
+     */
+    struct SumTotals {
+        SumTotals() : totalType(NumberInt), longTotal(0), doubleTotal(0) {}
+
+        void add(const Value& input);
+        Value getValue() const;
+
+        BSONType totalType;
+        long long longTotal;
+        double doubleTotal;
+    };
+
+
     class AccumulatorSum : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
@@ -132,9 +148,7 @@ namespace mongo {
     private:
         AccumulatorSum();
 
-        BSONType totalType;
-        long long longTotal;
-        double doubleTotal;
+        SumTotals _totals;
     };
 
 
@@ -148,6 +162,18 @@ namespace mongo {
         static intrusive_ptr<Accumulator> createMin();
         static intrusive_ptr<Accumulator> createMax();
 
+        /**
+         * True if 'input' should replace 'current' as the min (sense 1) or max (sense -1).
+         */
+        static bool replaces(const Value& current, const Value& input, int sense) {
+            // nullish values should have no impact on result
+            if (input.nullish())
+                return false;
+
+            // missing is lower than all other values
+            return current.missing() || Value::compare(current, input) * sense > 0;
+        }
+
     private:
         AccumulatorMinMax(int theSense);
 
@@ -172,6 +198,20 @@ namespace mongo {
     };
 
 
+    /**
+     * The running total and count of an $avg, for the same reason as SumTotals.
+     */
+    struct AvgTotals {
+        AvgTotals() : total(0), count(0) {}
+
+        void add(const Value& input, bool merging);
+        Value getValue(bool toBeMerged) const;
+
+        double total;
+        long long count;
+    };
+
+
     class AccumulatorAvg : public Accumulator {
     public:
         virtual void processInternal(const Value& input, bool merging);
@@ -184,7 +224,6 @@ namespace mongo {
     private:
         AccumulatorAvg();
 
-        double _total;
-        long long _count;
+        AvgTotals _totals;
     };
 }
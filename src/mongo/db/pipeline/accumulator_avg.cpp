@@ -40,52 +40,56 @@ namespace {
     const char countName[] = "count";
 }
 
-    void AccumulatorAvg::processInternal(const Value& input, bool merging) {
+    void AvgTotals::add(const Value& input, bool merging) {
         if (!merging) {
             // non numeric types have no impact on average
             if (!input.numeric())
                 return;
 
-            _total += input.getDouble();
-            _count += 1;
+            total += input.getDouble();
+            count += 1;
         }
         else {
             // We expect an object that contains both a subtotal and a count.
             // This is what getValue(true) produced below.
             verify(input.getType() == Object);
-            _total += input[subTotalName].getDouble();
-            _count += input[countName].getLong();
+            total += input[subTotalName].getDouble();
+            count += input[countName].getLong();
         }
     }
 
-    intrusive_ptr<Accumulator> AccumulatorAvg::create() {
-        return new AccumulatorAvg();
-    }
-
-    Value AccumulatorAvg::getValue(bool toBeMerged) const {
+    Value AvgTotals::getValue(bool toBeMerged) const {
         if (!toBeMerged) {
-            if (_count == 0)
+            if (count == 0)
                 return Value(0.0);
 
-            return Value(_total / static_cast<double>(_count));
+            return Value(total / static_cast<double>(count));
         }
         else {
-            return Value(DOC(subTotalName << _total
-                          << countName << _count));
+            return Value(DOC(subTotalName << total
+                          << countName << count));
         }
     }
 
-    AccumulatorAvg::AccumulatorAvg()
-        : _total(0)
-        , _count(0)
-    {
+    void AccumulatorAvg::processInternal(const Value& input, bool merging) {
+        _totals.add(input, merging);
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorAvg::create() {
+        return new AccumulatorAvg();
+    }
+
+    Value AccumulatorAvg::getValue(bool toBeMerged) const {
+        return _totals.getValue(toBeMerged);
+    }
+
+    AccumulatorAvg::AccumulatorAvg() {
         // This is a fixed size Accumulator so we never need to update this
         _memUsageBytes = sizeof(*this);
     }
 
     void AccumulatorAvg::reset() {
-        _total = 0;
-        _count = 0;
+        _totals = AvgTotals();
     }
 
     const char *AccumulatorAvg::getOpName() const {
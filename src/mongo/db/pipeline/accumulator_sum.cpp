@@ -33,7 +33,7 @@
 
 namespace mongo {
 
-    void AccumulatorSum::processInternal(const Value& input, bool merging) {
+    void SumTotals::add(const Value& input) {
         // do nothing with non numeric types
         if (!input.numeric())
             return;
@@ -56,11 +56,7 @@ namespace mongo {
         }
     }
 
-    intrusive_ptr<Accumulator> AccumulatorSum::create() {
-        return new AccumulatorSum();
-    }
-
-    Value AccumulatorSum::getValue(bool toBeMerged) const {
+    Value SumTotals::getValue() const {
         if (totalType == NumberLong) {
             return Value(longTotal);
         }
@@ -75,19 +71,25 @@ namespace mongo {
         }
     }
 
-    AccumulatorSum::AccumulatorSum()
-        : totalType(NumberInt)
-        , longTotal(0)
-        , doubleTotal(0)
-    {
+    void AccumulatorSum::processInternal(const Value& input, bool merging) {
+        _totals.add(input);
+    }
+
+    intrusive_ptr<Accumulator> AccumulatorSum::create() {
+        return new AccumulatorSum();
+    }
+
+    Value AccumulatorSum::getValue(bool toBeMerged) const {
+        return _totals.getValue();
+    }
+
+    AccumulatorSum::AccumulatorSum() {
         // This is a fixed size Accumulator so we never need to update this
         _memUsageBytes = sizeof(*this);
     }
 
     void AccumulatorSum::reset() {
-        totalType = NumberInt;
-        longTotal = 0;
-        doubleTotal = 0;
+        _totals = SumTotals();
     }
 
     const char *AccumulatorSum::getOpName() const {
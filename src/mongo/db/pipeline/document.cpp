@@ -39,6 +39,49 @@
 namespace mongo {
     using namespace mongoutils;
 
+    DocumentStorage::DocumentStorage(const BSONObj& bson, const BSONObj& holder)
+        : _buffer(NULL)
+        , _bufferEnd(NULL)
+        , _usedBytes(0)
+        , _numFields(0)
+        , _hashTabMask(0)
+        , _hasTextScore(false)
+        , _textScore(0)
+        , _bson(bson)
+        , _bsonHolder(holder)
+        , _bsonNext(bson.isEmpty() ? NULL : bson.objdata() + sizeof(int))
+        , _matchesBson(true) {
+        dassert(_bson.isOwned() || _bsonHolder.isOwned());
+    }
+
+    Value DocumentStorage::lazyValue(const BSONElement& elt, const BSONObj& holder) {
+        if (elt.type() == Object) {
+            return Value(Document(new DocumentStorage(elt.embeddedObject(), holder)));
+        }
+
+        if (elt.type() == Array) {
+            vector<Value> values;
+            BSONForEach(sub, elt.embeddedObject()) {
+                values.push_back(lazyValue(sub, holder));
+            }
+            return Value::consume(values);
+        }
+
+        return Value(elt);
+    }
+
+    Position DocumentStorage::loadNextField() {
+        const BSONElement elt(_bsonNext);
+        _bsonNext += elt.size();
+        if (*_bsonNext == EOO)
+            _bsonNext = NULL;
+
+        const Position pos(_usedBytes);
+        Value val = lazyValue(elt, _bson.isOwned() ? _bson : _bsonHolder);
+        appendFieldNoLoad(elt.fieldNameStringData()) = val;
+        return pos;
+    }
+
     Position DocumentStorage::findField(StringData requested) const {
         int reqSize = requested.size(); // get size calculation out of the way if needed
 
@@ -58,7 +101,7 @@ namespace mongo {
             }
         }
         else { // linear scan
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+            for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
                 if (it->nameLen == reqSize
                     && memcmp(requested.rawData(), it->_name, reqSize) == 0) {
                     return it.position();
@@ -66,12 +109,27 @@ namespace mongo {
             }
         }
 
+        // Not loaded yet, so load fields from the BSON until we get to it.
+        while (_bsonNext) {
+            const Position pos = const_cast<DocumentStorage*>(this)->loadNextField();
+            const ValueElement& elem = getField(pos);
+            if (elem.nameLen == reqSize
+                && memcmp(requested.rawData(), elem._name, reqSize) == 0) {
+                return pos;
+            }
+        }
+
         // if we got here, there's no such field
         return Position();
     }
 
     Value& DocumentStorage::appendField(StringData name) {
-        Position pos = getNextPosition();
+        materialize();
+        return appendFieldNoLoad(name);
+    }
+
+    Value& DocumentStorage::appendFieldNoLoad(StringData name) {
+        Position pos(_usedBytes);
         const int nameSize = name.size();
 
         // these are the same for everyone
@@ -182,14 +240,19 @@ namespace mongo {
     }
 
     intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
+        // Clones are made to be modified, so there is no point keeping them lazy.
+        loadLazyFields();
+
         intrusive_ptr<DocumentStorage> out (new DocumentStorage());
 
         // Make a copy of the buffer.
         // It is very important that the positions of each field are the same after cloning.
-        const size_t bufferBytes = (_bufferEnd + hashTabBytes()) - _buffer;
-        out->_buffer = new char[bufferBytes];
-        out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
-        memcpy(out->_buffer, _buffer, bufferBytes);
+        if (_buffer) {
+            const size_t bufferBytes = (_bufferEnd + hashTabBytes()) - _buffer;
+            out->_buffer = new char[bufferBytes];
+            out->_bufferEnd = out->_buffer + (_bufferEnd - _buffer);
+            memcpy(out->_buffer, _buffer, bufferBytes);
+        }
 
         // Copy remaining fields
         out->_usedBytes = _usedBytes;
@@ -197,9 +260,12 @@ namespace mongo {
         out->_hashTabMask = _hashTabMask;
         out->_hasTextScore = _hasTextScore;
         out->_textScore = _textScore;
+        out->_bson = _bson;
+        out->_bsonHolder = _bsonHolder;
+        out->_matchesBson = _matchesBson;
 
         // Tell values that they have been memcpyed (updates ref counts)
-        for (DocumentStorageIterator it = out->iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = out->loadedIteratorAll(); !it.atEnd(); it.advance()) {
             it->val.memcpyed();
         }
 
@@ -209,22 +275,14 @@ namespace mongo {
     DocumentStorage::~DocumentStorage() {
         boost::scoped_array<char> deleteBufferAtScopeEnd (_buffer);
 
-        for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance()) {
+        for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance()) {
             it->val.~Value(); // explicit destructor call
         }
     }
 
-    Document::Document(const BSONObj& bson) {
-        MutableDocument md(bson.nFields());
-
-        BSONObjIterator it(bson);
-        while(it.more()) {
-            BSONElement bsonElement(it.next());
-            md.addField(bsonElement.fieldNameStringData(), Value(bsonElement));
-        }
-
-        *this = md.freeze();
-    }
+    Document::Document(const BSONObj& bson)
+        : _storage(new DocumentStorage(bson.getOwned(), BSONObj()))
+    {}
 
     BSONObjBuilder& operator << (BSONObjBuilderValueStream& builder, const Document& doc) {
         BSONObjBuilder subobj(builder.subobjStart());
@@ -234,12 +292,20 @@ namespace mongo {
     }
 
     void Document::toBson(BSONObjBuilder* pBuilder) const {
+        if (storage().matchesBson()) {
+            pBuilder->appendElements(storage().bson());
+            return;
+        }
+
         for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
             *pBuilder << it->nameSD() << it->val;
         }
     }
 
     BSONObj Document::toBson() const {
+        if (storage().matchesBson() && storage().bson().isOwned())
+            return storage().bson();
+
         BSONObjBuilder bb;
         toBson(&bb);
         return bb.obj();
@@ -256,6 +322,17 @@ namespace mongo {
     }
 
     Document Document::fromBsonWithMetaData(const BSONObj& bson) {
+        // Metadata fields are rare.  Without any, the document can stay lazy.
+        bool hasMetaData = false;
+        BSONForEach(elem, bson) {
+            if (elem.fieldName()[0] == '$' && elem.fieldNameStringData() == metaFieldTextScore) {
+                hasMetaData = true;
+                break;
+            }
+        }
+        if (!hasMetaData)
+            return Document(bson);
+
         MutableDocument md;
 
         BSONObjIterator it(bson);
@@ -353,7 +430,8 @@ namespace mongo {
         size_t size = sizeof(DocumentStorage);
         size += storage().allocatedBytes();
 
-        for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
+        // Fields that are still lazy are covered by the BSON counted in allocatedBytes().
+        for (DocumentStorageIterator it = storage().loadedIterator(); !it.atEnd(); it.advance()) {
             size += it->val.getApproximateSize();
             size -= sizeof(Value); // already accounted for above
         }
@@ -188,6 +188,7 @@ namespace mongo {
         const void* getPtr() const { return _storage.get(); }
 
     private:
+        friend class DocumentStorage;
         friend class FieldIterator;
         friend class ValueStorage;
         friend class MutableDocument;
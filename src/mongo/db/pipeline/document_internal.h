@@ -157,7 +157,14 @@ namespace mongo {
         bool _includeMissing;
     };
 
-    /// Storage class used by both Document and MutableDocument
+    /** Storage class used by both Document and MutableDocument
+     *
+     *  A DocumentStorage can be backed by a BSONObj, in which case its fields are converted to
+     *  Values lazily, in order, as lookups need them.  Sub-documents of the BSON are themselves
+     *  lazy DocumentStorages sharing the same buffer.  Anything that iterates the fields, and any
+     *  modification, loads all remaining fields first.  Lazy loading changes the storage from
+     *  const methods, so a lazily backed Document must not be read from several threads at once.
+     */
     class DocumentStorage :  public RefCountable {
     public:
         // Note: default constructor should zero-init to support emptyDoc()
@@ -168,7 +175,16 @@ namespace mongo {
                           , _hashTabMask(0)
                           , _hasTextScore(false)
                           , _textScore(0)
+                          , _bsonNext(NULL)
+                          , _matchesBson(false)
         {}
+
+        /**
+         * Storage whose fields are those of 'bson', loaded on demand.  Either 'bson' is owned,
+         * or 'holder' is an owned object that contains it and keeps its buffer alive.
+         */
+        DocumentStorage(const BSONObj& bson, const BSONObj& holder);
+
         ~DocumentStorage();
 
         static const DocumentStorage& emptyDoc() {
@@ -185,7 +201,10 @@ namespace mongo {
         }
 
         /// Returns the position of the next field to be inserted
-        Position getNextPosition() const { return Position(_usedBytes); }
+        Position getNextPosition() const {
+            loadLazyFields();
+            return Position(_usedBytes);
+        }
 
         /// Returns the position of the named field (may be missing) or Position()
         Position findField(StringData name) const;
@@ -205,9 +224,11 @@ namespace mongo {
         // MutableDocument uses these
         ValueElement& getField(Position pos) {
             verify(pos.found());
+            materialize();
             return *(_firstElement->plusBytes(pos.index));
         }
         Value& getField(StringData name) {
+            materialize();
             Position pos = findField(name);
             if (!pos.found())
                 return appendField(name); // TODO: find a way to avoid hashing name twice
@@ -224,21 +245,39 @@ namespace mongo {
 
         /// This skips missing values
         DocumentStorageIterator iterator() const {
+            loadLazyFields();
             return DocumentStorageIterator(_firstElement, end(), false);
         }
 
         /// This includes missing values
         DocumentStorageIterator iteratorAll() const {
+            loadLazyFields();
             return DocumentStorageIterator(_firstElement, end(), true);
         }
 
+        /// Like iterator() but only over the fields loaded so far.  Never loads anything.
+        DocumentStorageIterator loadedIterator() const {
+            return DocumentStorageIterator(_firstElement, end(), false);
+        }
+
         /// Shallow copy of this. Caller owns memory.
         intrusive_ptr<DocumentStorage> clone() const;
 
+        /// Includes the BSON backing this storage, unless it is shared with a parent document.
         size_t allocatedBytes() const {
-            return !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
+            size_t bytes = !_buffer ? 0 : (_bufferEnd - _buffer + hashTabBytes());
+            if (_bson.isOwned())
+                bytes += _bson.objsize();
+            return bytes;
         }
 
+        /**
+         * True if the fields are exactly those of bson(): nothing has been changed since this
+         * storage was built from it.
+         */
+        bool matchesBson() const { return _matchesBson; }
+        const BSONObj& bson() const { return _bson; }
+
         /**
          * Copies all metadata from source if it has any.
          * Note: does not clear metadata from this.
@@ -258,6 +297,30 @@ namespace mongo {
 
     private:
 
+        /// Loads all fields of _bson that haven't been loaded yet.
+        void loadLazyFields() const {
+            while (_bsonNext)
+                const_cast<DocumentStorage*>(this)->loadNextField();
+        }
+
+        /// Converts the next unloaded field of _bson and appends it.  Returns its Position.
+        Position loadNextField();
+
+        /// Loads everything and forgets the BSON. Call before handing out anything mutable.
+        void materialize() {
+            loadLazyFields();
+            _matchesBson = false;
+        }
+
+        /// Appends a field without loading lazy fields first.
+        Value& appendFieldNoLoad(StringData name);
+
+        /**
+         * Converts 'elt', which is inside 'holder', leaving any sub-documents lazy and sharing
+         * holder's buffer.
+         */
+        static Value lazyValue(const BSONElement& elt, const BSONObj& holder);
+
         /// Same as lastElement->next() or firstElement() if empty.
         const ValueElement* end() const { return _firstElement->plusBytes(_usedBytes); }
 
@@ -288,10 +351,15 @@ namespace mongo {
             return hashKey(name) & _hashTabMask;
         }
 
+        /// Iterates over the fields loaded so far, including missing values.
+        DocumentStorageIterator loadedIteratorAll() const {
+            return DocumentStorageIterator(_firstElement, end(), true);
+        }
+
         /// Adds all fields to the hash table
         void rehash() {
             hashTabInit();
-            for (DocumentStorageIterator it = iteratorAll(); !it.atEnd(); it.advance())
+            for (DocumentStorageIterator it = loadedIteratorAll(); !it.atEnd(); it.advance())
                 addFieldToHashTable(it.position());
         }
 
@@ -327,6 +395,17 @@ namespace mongo {
 
         bool _hasTextScore; // When adding more metadata fields, this should become a bitvector
         double _textScore;
+
+        // The object this storage was built from, if any.  Owned unless it is a sub-object of
+        // _bsonHolder.
+        BSONObj _bson;
+        BSONObj _bsonHolder;
+
+        // Next element of _bson to be loaded, or NULL once all have been.
+        const char* _bsonNext;
+
+        // See matchesBson().
+        bool _matchesBson;
         // When adding a field, make sure to update clone() method
     };
 }
@@ -31,12 +31,17 @@
 #include "mongo/pch.h"
 
 #include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/unordered_map.hpp>
 #include <deque>
 
 #include "mongo/db/clientcursor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher.h"
+#include "mongo/db/pipeline/accumulator.h"
 #include "mongo/db/pipeline/document.h"
 #include "mongo/db/pipeline/dependencies.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -44,6 +49,7 @@
 #include "mongo/db/pipeline/value.h"
 #include "mongo/db/projection.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/s/shard.h"
 #include "mongo/s/strategy.h"
 #include "mongo/util/intrusive_counter.h"
@@ -55,6 +61,7 @@ namespace mongo {
     class ExpressionFieldPath;
     class ExpressionObject;
     class DocumentSourceLimit;
+    class Pipeline;
     class Runner;
 
     class DocumentSource : public IntrusiveCounterUnsigned {
@@ -418,6 +425,125 @@ namespace mongo {
     };
 
 
+    /**
+     * Runs copies of the shard half of a pipeline (see Pipeline::splitForSharded()) on worker
+     * threads and returns everything they output, for the merge half to combine.
+     *
+     * The documents come from a DocumentSourceCursor on the calling thread, which still does all
+     * of the locking and yielding.  They are handed out in batches to whichever worker is free.
+     * The workers never lock anything or touch the Client, so their halves may only contain
+     * stages that look at one document at a time, followed by a $group.
+     *
+     * All of the work happens in the first call to getNext(), so no worker is running between
+     * calls.
+     */
+    class DocumentSourceParallelPartials :
+        public DocumentSource {
+    public:
+        // virtuals from DocumentSource
+        virtual ~DocumentSourceParallelPartials();
+        virtual boost::optional<Document> getNext();
+        virtual const char *getSourceName() const;
+        virtual Value serialize(bool explain = false) const;
+        virtual void setSource(DocumentSource *pSource);
+        virtual bool isValidInitialSource() const { return true; }
+        virtual void dispose();
+
+        /**
+         * Create a source that feeds 'cursor's documents to 'numWorkers' copies of the shard half
+         * of 'partialCmd'.
+         *
+         * @param cursor the input.  Nothing else may use it.
+         * @param partialCmd an aggregate command whose pipeline is the part of this pipeline that
+         *                   follows 'cursor', as produced by Pipeline::serialize().  Each worker
+         *                   parses its own copy.
+         * @param numWorkers how many threads to use
+         * @param pExpCtx the expression context for the pipeline
+         */
+        static intrusive_ptr<DocumentSourceParallelPartials> create(
+            const intrusive_ptr<DocumentSourceCursor>& cursor,
+            const BSONObj& partialCmd,
+            size_t numWorkers,
+            const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        // How many documents are handed to a worker at a time.
+        static const size_t kDocsPerBatch;
+
+        // How many batches may wait to be picked up for each worker.
+        static const size_t kQueuedBatchesPerWorker;
+
+    private:
+        class WorkerInterruptStatus;
+        class Exchange;
+
+        DocumentSourceParallelPartials(const intrusive_ptr<DocumentSourceCursor>& cursor,
+                                       const BSONObj& partialCmd,
+                                       size_t numWorkers,
+                                       const intrusive_ptr<ExpressionContext> &pExpCtx);
+
+        /** Runs the whole input through the workers and collects their output in _results. */
+        void populate();
+
+        /** Body of a worker thread. */
+        void runWorker(size_t worker);
+
+        /** Waits for room in the queue and moves 'batch' onto it. False if a worker failed. */
+        bool deal(std::deque<Document>* batch);
+
+        /** Called by workers.  Waits for the next batch, false once there are no more. */
+        bool takeBatch(std::deque<Document>* batch);
+
+        /** Called by workers.  Records the first failure and stops everyone else. */
+        void fail(int code, const std::string& error);
+
+        /** Tells the workers the input is over and joins them. */
+        void finish();
+
+        /** Stops the workers without waiting for them to use up the queue, and joins them. */
+        void abort();
+
+        intrusive_ptr<DocumentSourceCursor> _cursor;
+
+        // Workers' ExpressionContexts refer to this, so it must outlive _partials.
+        scoped_ptr<WorkerInterruptStatus> _interruptStatus;
+
+        // One shard half per worker, each with an Exchange as its first source.
+        vector<intrusive_ptr<Pipeline> > _partials;
+
+        // What each worker's half produced.  Only touched by that worker until it is joined.
+        vector<vector<Document> > _outputs;
+
+        vector<boost::shared_ptr<boost::thread> > _threads;
+
+        // Everything below up to _results is protected by _mutex.
+        boost::mutex _mutex;
+
+        // Workers wait here for batches.
+        boost::condition_variable _batchesCond;
+
+        // We wait here for room in the queue.
+        boost::condition_variable _spaceCond;
+
+        // Batches nobody has picked up yet.  A Document is only used by one thread at a time: its
+        // batch belongs to us until it is queued and to one worker after it is taken.
+        std::deque<std::deque<Document> > _queue;
+
+        // Set once no more batches will be queued.
+        bool _inputDone;
+
+        // Set to make the workers stop early.  Also read without the mutex by their
+        // ExpressionContexts' interrupt checks.
+        AtomicUInt32 _aborted;
+
+        // The first failure in a worker.
+        int _errorCode;
+        std::string _error;
+
+        bool _populated;
+        std::deque<Document> _results;
+    };
+
+
     class DocumentSourceGroup : public DocumentSource
                               , public SplittableDocumentSource {
     public:
@@ -457,6 +583,19 @@ namespace mongo {
         /// Tell this source if it is doing a merge from shards. Defaults to false.
         void setDoingMerge(bool doingMerge) { _doingMerge = doingMerge; }
 
+        /**
+         * Returns the path of the field this groups on, without the "$" prefix, if the _id is a
+         * plain field path like "$a.b".  Otherwise returns an empty string.
+         */
+        std::string getIdFieldPath() const;
+
+        /**
+         * Tell this source its input arrives ordered on the _id, so that equal ids are adjacent.
+         * It then returns each group as soon as the next one starts, holding only one group at a
+         * time.  Defaults to false.
+         */
+        void setStreaming(bool streaming) { _streaming = streaming; }
+
         /**
           Create a grouping DocumentSource from BSON.
 
@@ -481,11 +620,11 @@ namespace mongo {
     private:
         DocumentSourceGroup(const intrusive_ptr<ExpressionContext> &pExpCtx);
 
-        /// Spill groups map to disk and returns an iterator to the file.
+        /// Spill groups to disk and returns an iterator to the file.
         shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
         // Only used by spill. Would be function-local if that were legal in C++03.
-        class SpillSTLComparator;
+        class SpillComparator;
 
         /*
           Before returning anything, this source must fetch everything from
@@ -496,6 +635,9 @@ namespace mongo {
         void populate();
         bool populated;
 
+        /// getNext() when _streaming.
+        boost::optional<Document> getNextStreaming();
+
         /**
          * Parses the raw id expression into _idExpressions and possibly _idFieldNames.
          */
@@ -514,8 +656,62 @@ namespace mongo {
 
 
         typedef vector<intrusive_ptr<Accumulator> > Accumulators;
-        typedef boost::unordered_map<Value, Accumulators, Value::Hash> GroupsMap;
-        GroupsMap groups;
+
+        /**
+         * One accumulator's state for every group, indexed by group number.  $sum, $avg, $min and
+         * $max keep theirs in plain arrays, so adding a group allocates nothing and processing a
+         * value makes no virtual call.  Other accumulators get an Accumulator object per group.
+         */
+        class AccumulatorColumn {
+        public:
+            explicit AccumulatorColumn(intrusive_ptr<Accumulator> (*factory)());
+
+            /// Adds the state for a new group. Returns how many bytes that used.
+            int addGroup();
+
+            /// Returns the change in bytes used.
+            int process(size_t group, const Value& input, bool merging);
+
+            Value getValue(size_t group, bool toBeMerged) const;
+
+            /// Forgets all groups. Keeps the arrays' memory unless releaseMemory is true.
+            void clear(bool releaseMemory);
+
+        private:
+            enum Kind { SUM, AVG, MIN, MAX, OTHER };
+
+            Kind _kind;
+            intrusive_ptr<Accumulator> (*_factory)();
+
+            // Only the array for _kind is used.
+            vector<SumTotals> _sums;
+            vector<AvgTotals> _avgs;
+            vector<Value> _values; // MIN and MAX
+            Accumulators _others;
+        };
+
+        /**
+         * Returns the number of the group for 'id', adding a group with fresh accumulators if
+         * there isn't one.  Sets *newGroupBytes to how many bytes the new group takes, or to 0 if
+         * the group was already there.
+         */
+        size_t findOrAddGroup(const Value& id, int* newGroupBytes);
+
+        /// Doubles the size of _groupIndex and rehashes every group into it.
+        void growGroupIndex();
+
+        /// Forgets all groups. Keeps the memory for the next ones unless releaseMemory is true.
+        void clearGroups(bool releaseMemory);
+
+        /*
+          The group table.  Groups are numbered in the order they were first seen, and every
+          array below is indexed by that number.  _groupIndex is an open addressing hash table
+          of group numbers plus one, with 0 for an empty slot.
+        */
+        vector<Value> _groupIds;
+        vector<size_t> _groupHashes;
+        vector<uint32_t> _groupIndex;
+        vector<AccumulatorColumn> _columns; // parallels vFieldName
 
         /*
           The field names for the result documents and the accumulator
@@ -535,8 +731,10 @@ namespace mongo {
 
 
         Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
+        Document makeDocument(size_t group, bool mergeableOutput);
 
         bool _doingMerge;
+        bool _streaming;
         bool _spilled;
         const bool _extSortAllowed;
         const int _maxMemoryUsageBytes;
@@ -544,14 +742,19 @@ namespace mongo {
         std::vector<std::string> _idFieldNames; // used when id is a document
         std::vector<intrusive_ptr<Expression> > _idExpressions;
 
-        // only used when !_spilled
-        GroupsMap::iterator groupsIterator;
+        // only used when !_spilled: the next group to return
+        size_t _nextGroup;
 
         // only used when _spilled
         scoped_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
         pair<Value, Value> _firstPartOfNextGroup;
+
+        // used when _spilled or _streaming: the group being accumulated
         Value _currentId;
         Accumulators _currentAccumulators;
+
+        // only used when _streaming: whether _currentId holds a group not yet returned
+        bool _haveCurrentGroup;
     };
 
 
@@ -36,8 +36,13 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/value.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
+    // How much a $group may hold in memory before it spills to disk, or fails if it can't.
+    MONGO_EXPORT_SERVER_PARAMETER(internalDocumentSourceGroupMaxMemoryBytes, int,
+                                  100 * 1024 * 1024);
+
     const char DocumentSourceGroup::groupName[] = "$group";
 
     const char *DocumentSourceGroup::getSourceName() const {
@@ -47,6 +52,9 @@ namespace mongo {
     boost::optional<Document> DocumentSourceGroup::getNext() {
         pExpCtx->checkForInterrupt();
 
+        if (_streaming)
+            return getNextStreaming();
+
         if (!populated)
             populate();
 
@@ -95,27 +103,86 @@ namespace mongo {
             return makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
 
         } else {
-            if (groups.empty())
+            if (_nextGroup == _groupIds.size())
                 return boost::none;
 
-            Document out = makeDocument(groupsIterator->first,
-                                        groupsIterator->second,
-                                        pExpCtx->inShard);
+            Document out = makeDocument(_nextGroup, pExpCtx->inShard);
 
-            if (++groupsIterator == groups.end())
+            if (++_nextGroup == _groupIds.size())
                 dispose();
 
             return out;
         }
     }
 
+    boost::optional<Document> DocumentSourceGroup::getNextStreaming() {
+        const size_t numAccumulators = vpAccumulatorFactory.size();
+        dassert(numAccumulators == vpExpression.size());
+
+        if (!populated) {
+            _currentAccumulators.reserve(numAccumulators);
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators.push_back(vpAccumulatorFactory[i]());
+            }
+            populated = true;
+        }
+
+        while (boost::optional<Document> input = pSource->getNext()) {
+            _variables->setRoot(*input);
+
+            Value id = computeId(_variables.get());
+
+            // treat missing values the same as NULL SERVER-4674
+            if (id.missing())
+                id = Value(BSONNULL);
+
+            // The input is ordered on the id, so a new id means the current group is complete.
+            boost::optional<Document> out;
+            if (_haveCurrentGroup && id != _currentId) {
+                out = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+                for (size_t i = 0; i < numAccumulators; i++) {
+                    _currentAccumulators[i]->reset();
+                }
+            }
+
+            if (!_haveCurrentGroup || out) {
+                _currentId = id;
+                _haveCurrentGroup = true;
+            }
+
+            // Only one group is held, so there is nothing to spill.
+            int memoryUsageBytes = _currentId.getApproximateSize();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                _currentAccumulators[i]->process(vpExpression[i]->evaluate(_variables.get()),
+                                                 _doingMerge);
+                memoryUsageBytes += _currentAccumulators[i]->memUsageForSorter();
+            }
+            uassert(17422, "Exceeded memory limit for a single group in $group",
+                    memoryUsageBytes <= _maxMemoryUsageBytes);
+
+            // We are done with the ROOT document so release it.
+            _variables->clearRoot();
+
+            if (out)
+                return out;
+        }
+
+        if (!_haveCurrentGroup)
+            return boost::none;
+
+        Document out = makeDocument(_currentId, _currentAccumulators, pExpCtx->inShard);
+        dispose();
+        return out;
+    }
+
     void DocumentSourceGroup::dispose() {
         // free our resources
-        GroupsMap().swap(groups);
+        clearGroups(/*releaseMemory=*/true);
         _sorterIterator.reset();
+        _haveCurrentGroup = false;
 
         // make us look done
-        groupsIterator = groups.end();
+        _nextGroup = 0;
 
         // free our source's resources
         pSource->dispose();
@@ -196,11 +263,33 @@ namespace mongo {
         : DocumentSource(pExpCtx)
         , populated(false)
         , _doingMerge(false)
+        , _streaming(false)
         , _spilled(false)
         , _extSortAllowed(pExpCtx->extSortAllowed && !pExpCtx->inRouter)
-        , _maxMemoryUsageBytes(100*1024*1024)
+        , _maxMemoryUsageBytes(internalDocumentSourceGroupMaxMemoryBytes)
+        , _nextGroup(0)
+        , _haveCurrentGroup(false)
     {}
 
+    string DocumentSourceGroup::getIdFieldPath() const {
+        if (!_idFieldNames.empty() || _idExpressions.size() != 1)
+            return "";
+
+        const ExpressionFieldPath* efp =
+            dynamic_cast<const ExpressionFieldPath*>(_idExpressions[0].get());
+        if (!efp)
+            return "";
+
+        // $group's _id can't bind variables, so CURRENT is ROOT here.
+        const FieldPath& withVariable = efp->getFieldPath();
+        if (withVariable.getPathLength() < 2
+                || (withVariable.getFieldName(0) != "ROOT"
+                    && withVariable.getFieldName(0) != "CURRENT"))
+            return "";
+
+        return withVariable.tail().getPath(false);
+    }
+
     void DocumentSourceGroup::addAccumulator(
             const std::string& fieldName,
             intrusive_ptr<Accumulator> (*pAccumulatorFactory)(),
@@ -351,6 +440,12 @@ namespace mongo {
         const size_t numAccumulators = vpAccumulatorFactory.size();
         dassert(numAccumulators == vpExpression.size());
 
+        _columns.clear();
+        _columns.reserve(numAccumulators);
+        for (size_t i = 0; i < numAccumulators; i++) {
+            _columns.push_back(AccumulatorColumn(vpAccumulatorFactory[i]));
+        }
+
         // pushed to on spill()
         vector<shared_ptr<Sorter<Value, Value>::Iterator> > sortedFiles;
         int memoryUsageBytes = 0;
@@ -374,34 +469,15 @@ namespace mongo {
             if (id.missing())
                 id = Value(BSONNULL);
 
-            /*
-              Look for the _id value in the map; if it's not there, add a
-              new entry with a blank accumulator.
-            */
-            const size_t oldSize = groups.size();
-            vector<intrusive_ptr<Accumulator> >& group = groups[id];
-            const bool inserted = groups.size() != oldSize;
-
-            if (inserted) {
-                memoryUsageBytes += id.getApproximateSize();
-
-                // Add the accumulators
-                group.reserve(numAccumulators);
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    group.push_back(vpAccumulatorFactory[i]());
-                }
-            } else {
-                for (size_t i = 0; i < numAccumulators; i++) {
-                    // subtract old mem usage. New usage added back after processing.
-                    memoryUsageBytes -= group[i]->memUsageForSorter();
-                }
-            }
+            int newGroupBytes;
+            const size_t group = findOrAddGroup(id, &newGroupBytes);
+            const bool inserted = newGroupBytes != 0;
+            memoryUsageBytes += newGroupBytes;
 
             /* tickle all the accumulators for the group we found */
-            dassert(numAccumulators == group.size());
             for (size_t i = 0; i < numAccumulators; i++) {
-                group[i]->process(vpExpression[i]->evaluate(_variables.get()), _doingMerge);
-                memoryUsageBytes += group[i]->memUsageForSorter();
+                memoryUsageBytes += _columns[i].process(
+                        group, vpExpression[i]->evaluate(_variables.get()), _doingMerge);
             }
 
             // We are done with the ROOT document so release it.
@@ -422,12 +498,12 @@ namespace mongo {
         // These blocks do any final steps necessary to prepare to output results.
         if (!sortedFiles.empty()) {
             _spilled = true;
-            if (!groups.empty()) {
+            if (!_groupIds.empty()) {
                 sortedFiles.push_back(spill());
             }
 
-            // We won't be using groups again so free its memory.
-            GroupsMap().swap(groups);
+            // We won't be using groups again so free their memory.
+            clearGroups(/*releaseMemory=*/true);
 
             _sorterIterator.reset(
                     Sorter<Value,Value>::Iterator::merge(
@@ -442,60 +518,224 @@ namespace mongo {
             verify(_sorterIterator->more()); // we put data in, we should get something out.
             _firstPartOfNextGroup = _sorterIterator->next();
         } else {
-            // start the group iterator
-            groupsIterator = groups.begin();
+            // start with the first group
+            _nextGroup = 0;
         }
 
         populated = true;
     }
 
-    class DocumentSourceGroup::SpillSTLComparator {
+    class DocumentSourceGroup::SpillComparator {
     public:
-        bool operator() (const GroupsMap::value_type* lhs, const GroupsMap::value_type* rhs) const {
-            return Value::compare(lhs->first, rhs->first) < 0;
+        explicit SpillComparator(const vector<Value>& ids) : _ids(ids) {}
+        bool operator() (uint32_t lhs, uint32_t rhs) const {
+            return Value::compare(_ids[lhs], _ids[rhs]) < 0;
         }
+    private:
+        const vector<Value>& _ids;
     };
 
     shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
-        vector<const GroupsMap::value_type*> ptrs; // using pointers to speed sorting
-        ptrs.reserve(groups.size());
-        for (GroupsMap::const_iterator it=groups.begin(), end=groups.end(); it != end; ++it) {
-            ptrs.push_back(&*it);
+        vector<uint32_t> order; // group numbers, to speed sorting
+        order.reserve(_groupIds.size());
+        for (size_t i = 0; i < _groupIds.size(); i++) {
+            order.push_back(i);
         }
 
-        stable_sort(ptrs.begin(), ptrs.end(), SpillSTLComparator());
+        std::sort(order.begin(), order.end(), SpillComparator(_groupIds));
 
         SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir));
-        switch (vpAccumulatorFactory.size()) { // same as ptrs[i]->second.size() for all i.
+        switch (_columns.size()) {
         case 0: // no values, essentially a distinct
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
+            for (size_t i=0; i < order.size(); i++) {
+                writer.addAlreadySorted(_groupIds[order[i]], Value());
             }
             break;
 
         case 1: // just one value, use optimized serialization as single Value
-            for (size_t i=0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            for (size_t i=0; i < order.size(); i++) {
+                writer.addAlreadySorted(_groupIds[order[i]],
+                                        _columns[0].getValue(order[i], /*toBeMerged=*/true));
             }
             break;
 
         default: // multiple values, serialize as array-typed Value
-            for (size_t i=0; i < ptrs.size(); i++) {
+            for (size_t i=0; i < order.size(); i++) {
                 vector<Value> accums;
-                for (size_t j=0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+                accums.reserve(_columns.size());
+                for (size_t j=0; j < _columns.size(); j++) {
+                    accums.push_back(_columns[j].getValue(order[i], /*toBeMerged=*/true));
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value::consume(accums));
+                writer.addAlreadySorted(_groupIds[order[i]], Value::consume(accums));
             }
             break;
         }
 
-        groups.clear();
+        clearGroups(/*releaseMemory=*/false);
 
         return shared_ptr<Sorter<Value, Value>::Iterator>(writer.done());
     }
 
+    namespace {
+        /** Where to start looking for a hash in a group index of size mask + 1. */
+        size_t groupSlot(size_t hash, size_t mask) {
+            // Value::Hash isn't well mixed in its low bits, so spread it before masking.
+            const unsigned long long mixed = hash * 0x9E3779B97F4A7C15ULL;
+            return static_cast<size_t>(mixed ^ (mixed >> 32)) & mask;
+        }
+    }
+
+    size_t DocumentSourceGroup::findOrAddGroup(const Value& id, int* newGroupBytes) {
+        *newGroupBytes = 0;
+        const size_t hash = Value::Hash()(id);
+
+        // Keep the index at most half full.
+        if ((_groupIds.size() + 1) * 2 > _groupIndex.size())
+            growGroupIndex();
+
+        const size_t mask = _groupIndex.size() - 1;
+        size_t slot = groupSlot(hash, mask);
+        while (_groupIndex[slot] != 0) {
+            const size_t group = _groupIndex[slot] - 1;
+            if (_groupHashes[group] == hash && Value::compare(_groupIds[group], id) == 0)
+                return group;
+            slot = (slot + 1) & mask;
+        }
+
+        const size_t group = _groupIds.size();
+        massert(17421, "too many groups for $group", group < 0xffffffffU);
+        _groupIndex[slot] = group + 1;
+        _groupIds.push_back(id);
+        _groupHashes.push_back(hash);
+
+        // The index is kept at least twice as big as the number of groups.
+        int bytes = id.getApproximateSize() + sizeof(size_t) + 2 * sizeof(uint32_t);
+        for (size_t i = 0; i < _columns.size(); i++) {
+            bytes += _columns[i].addGroup();
+        }
+        *newGroupBytes = bytes;
+        return group;
+    }
+
+    void DocumentSourceGroup::growGroupIndex() {
+        vector<uint32_t> index(std::max(_groupIndex.size() * 2, size_t(16)), 0);
+        const size_t mask = index.size() - 1;
+        for (size_t group = 0; group < _groupIds.size(); group++) {
+            size_t slot = groupSlot(_groupHashes[group], mask);
+            while (index[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            index[slot] = group + 1;
+        }
+        _groupIndex.swap(index);
+    }
+
+    void DocumentSourceGroup::clearGroups(bool releaseMemory) {
+        if (releaseMemory) {
+            vector<Value>().swap(_groupIds);
+            vector<size_t>().swap(_groupHashes);
+            vector<uint32_t>().swap(_groupIndex);
+        }
+        else {
+            _groupIds.clear();
+            _groupHashes.clear();
+            std::fill(_groupIndex.begin(), _groupIndex.end(), 0);
+        }
+
+        for (size_t i = 0; i < _columns.size(); i++) {
+            _columns[i].clear(releaseMemory);
+        }
+    }
+
+    DocumentSourceGroup::AccumulatorColumn::AccumulatorColumn(
+            intrusive_ptr<Accumulator> (*factory)())
+        : _kind(OTHER)
+        , _factory(factory)
+    {
+        if (factory == AccumulatorSum::create)
+            _kind = SUM;
+        else if (factory == AccumulatorAvg::create)
+            _kind = AVG;
+        else if (factory == AccumulatorMinMax::createMin)
+            _kind = MIN;
+        else if (factory == AccumulatorMinMax::createMax)
+            _kind = MAX;
+    }
+
+    int DocumentSourceGroup::AccumulatorColumn::addGroup() {
+        switch (_kind) {
+        case SUM:
+            _sums.push_back(SumTotals());
+            return sizeof(SumTotals);
+        case AVG:
+            _avgs.push_back(AvgTotals());
+            return sizeof(AvgTotals);
+        case MIN:
+        case MAX:
+            _values.push_back(Value());
+            return sizeof(Value);
+        case OTHER:
+            _others.push_back(_factory());
+            return sizeof(intrusive_ptr<Accumulator>) + _others.back()->memUsageForSorter();
+        }
+        verify(false);
+    }
+
+    int DocumentSourceGroup::AccumulatorColumn::process(size_t group,
+                                                        const Value& input,
+                                                        bool merging) {
+        switch (_kind) {
+        case SUM:
+            _sums[group].add(input);
+            return 0;
+        case AVG:
+            _avgs[group].add(input, merging);
+            return 0;
+        case MIN:
+        case MAX: {
+            Value& current = _values[group];
+            if (!AccumulatorMinMax::replaces(current, input, _kind == MIN ? 1 : -1))
+                return 0;
+            const int change = input.getApproximateSize() - current.getApproximateSize();
+            current = input;
+            return change;
+        }
+        case OTHER: {
+            Accumulator* accumulator = _others[group].get();
+            const int before = accumulator->memUsageForSorter();
+            accumulator->process(input, merging);
+            return accumulator->memUsageForSorter() - before;
+        }
+        }
+        verify(false);
+    }
+
+    Value DocumentSourceGroup::AccumulatorColumn::getValue(size_t group, bool toBeMerged) const {
+        switch (_kind) {
+        case SUM: return _sums[group].getValue();
+        case AVG: return _avgs[group].getValue(toBeMerged);
+        case MIN:
+        case MAX: return _values[group];
+        case OTHER: return _others[group]->getValue(toBeMerged);
+        }
+        verify(false);
+    }
+
+    void DocumentSourceGroup::AccumulatorColumn::clear(bool releaseMemory) {
+        if (releaseMemory) {
+            vector<SumTotals>().swap(_sums);
+            vector<AvgTotals>().swap(_avgs);
+            vector<Value>().swap(_values);
+            Accumulators().swap(_others);
+        }
+        else {
+            _sums.clear();
+            _avgs.clear();
+            _values.clear();
+            _others.clear();
+        }
+    }
+
     void DocumentSourceGroup::parseIdExpression(BSONElement groupField,
                                                 const VariablesParseState& vps) {
         if (groupField.type() == Object && !groupField.Obj().isEmpty()) {
@@ -587,6 +827,28 @@ namespace mongo {
         return out.freeze();
     }
 
+    Document DocumentSourceGroup::makeDocument(size_t group, bool mergeableOutput) {
+        const size_t n = vFieldName.size();
+        MutableDocument out (1 + n);
+
+        /* add the _id field */
+        out.addField("_id", expandId(_groupIds[group]));
+
+        /* add the rest of the fields */
+        for(size_t i = 0; i < n; ++i) {
+            Value val = _columns[i].getValue(group, mergeableOutput);
+            if (val.missing()) {
+                // we return null in this case so return objects are predictable
+                out.addField(vFieldName[i], Value(BSONNULL));
+            }
+            else {
+                out.addField(vFieldName[i], val);
+            }
+        }
+
+        return out.freeze();
+    }
+
     intrusive_ptr<DocumentSource> DocumentSourceGroup::getShardSource() {
         return this; // No modifications necessary when on shard
     }
@@ -0,0 +1,307 @@
+/**
+ * Copyright 2014 (c) MongoDB Inc.
+ *
+ * This program is free software: you can redistribute it and/or  modify
+ * it under the terms of the GNU Affero General Public License, version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * As a special exception, the copyright holders give permission to link the
+ * code of portions of this program with the OpenSSL library under certain
+ * conditions as described in each individual source file and distribute
+ * linked combinations including the program with the OpenSSL library. You
+ * must comply with the GNU Affero General Public License in all respects for
+ * all of the code used other than as permitted herein. If you modify file(s)
+ * with this exception, you may extend this exception to your version of the
+ * file(s), but you are not obligated to do so. If you do not wish to do so,
+ * delete this exception statement from your version. If you delete this
+ * exception statement from all source files in the program, then also delete
+ * it in the license file.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/db/pipeline/document_source.h"
+
+#include <boost/bind.hpp>
+
+#include "mongo/db/interrupt_status.h"
+#include "mongo/db/pipeline/document.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/pipeline.h"
+
+namespace mongo {
+
+    const size_t DocumentSourceParallelPartials::kDocsPerBatch = 256;
+    const size_t DocumentSourceParallelPartials::kQueuedBatchesPerWorker = 4;
+
+    /**
+     * What the workers' ExpressionContexts check instead of InterruptStatusMongod, which needs a
+     * Client.  The calling thread keeps checking for killOp through its own cursor and stops the
+     * workers if it sees one.
+     */
+    class DocumentSourceParallelPartials::WorkerInterruptStatus : public InterruptStatus {
+    public:
+        explicit WorkerInterruptStatus(const AtomicUInt32* aborted) : _aborted(aborted) {}
+        virtual ~WorkerInterruptStatus() {}
+
+        virtual void checkForInterrupt() const {
+            uassert(17418, "parallel aggregation stopped", 0 == _aborted->load());
+        }
+
+        virtual const char* checkForInterruptNoAssert() const {
+            return 0 == _aborted->load() ? "" : "parallel aggregation stopped";
+        }
+
+    private:
+        const AtomicUInt32* _aborted;
+    };
+
+    /**
+     * The first source of each worker's half: returns the documents in the batches the worker
+     * takes off the queue.
+     */
+    class DocumentSourceParallelPartials::Exchange : public DocumentSource {
+    public:
+        Exchange(DocumentSourceParallelPartials* owner,
+                 const intrusive_ptr<ExpressionContext>& pExpCtx)
+            : DocumentSource(pExpCtx)
+            , _owner(owner)
+        {}
+
+        virtual boost::optional<Document> getNext() {
+            pExpCtx->checkForInterrupt();
+
+            if (_batch.empty() && !_owner->takeBatch(&_batch))
+                return boost::none;
+
+            Document out = _batch.front();
+            _batch.pop_front();
+            return out;
+        }
+
+        virtual const char* getSourceName() const { return "$parallelPartialsExchange"; }
+        virtual Value serialize(bool explain = false) const { return Value(); }
+        virtual void setSource(DocumentSource* pSource) { verify(false); }
+        virtual bool isValidInitialSource() const { return true; }
+
+        virtual void dispose() { _batch.clear(); }
+
+    private:
+        DocumentSourceParallelPartials* const _owner;
+        std::deque<Document> _batch;
+    };
+
+    DocumentSourceParallelPartials::DocumentSourceParallelPartials(
+            const intrusive_ptr<DocumentSourceCursor>& cursor,
+            const BSONObj& partialCmd,
+            size_t numWorkers,
+            const intrusive_ptr<ExpressionContext> &pExpCtx)
+        : DocumentSource(pExpCtx)
+        , _cursor(cursor)
+        , _interruptStatus(new WorkerInterruptStatus(&_aborted))
+        , _outputs(numWorkers)
+        , _inputDone(false)
+        , _errorCode(0)
+        , _populated(false)
+    {
+        for (size_t i = 0; i < numWorkers; i++) {
+            intrusive_ptr<ExpressionContext> workerCtx =
+                new ExpressionContext(*_interruptStatus, pExpCtx->ns);
+            // The merge half expects what a shard would send it.
+            workerCtx->inShard = true;
+            workerCtx->tempDir = pExpCtx->tempDir;
+
+            string errmsg;
+            intrusive_ptr<Pipeline> merger = Pipeline::parseCommand(errmsg, partialCmd, workerCtx);
+            massert(17419, str::stream() << "can't parse partial pipeline: " << errmsg, merger);
+
+            intrusive_ptr<Pipeline> partial = merger->splitForSharded();
+            partial->addInitialSource(new Exchange(this, workerCtx));
+            partial->stitch();
+            _partials.push_back(partial);
+        }
+    }
+
+    intrusive_ptr<DocumentSourceParallelPartials> DocumentSourceParallelPartials::create(
+            const intrusive_ptr<DocumentSourceCursor>& cursor,
+            const BSONObj& partialCmd,
+            size_t numWorkers,
+            const intrusive_ptr<ExpressionContext> &pExpCtx) {
+        return new DocumentSourceParallelPartials(cursor, partialCmd, numWorkers, pExpCtx);
+    }
+
+    DocumentSourceParallelPartials::~DocumentSourceParallelPartials() {
+        // Only running while populate() is, but make sure nothing outlives us.
+        if (!_threads.empty())
+            abort();
+    }
+
+    const char *DocumentSourceParallelPartials::getSourceName() const {
+        return "$parallelPartials";
+    }
+
+    Value DocumentSourceParallelPartials::serialize(bool explain) const {
+        // we never parse this, and explain doesn't run in parallel
+        return explain ? _cursor->serialize(explain) : Value();
+    }
+
+    void DocumentSourceParallelPartials::setSource(DocumentSource *pSource) {
+        /* this doesn't take a source */
+        verify(false);
+    }
+
+    void DocumentSourceParallelPartials::dispose() {
+        _cursor->dispose();
+        _partials.clear();
+        _outputs.clear();
+        _results.clear();
+    }
+
+    boost::optional<Document> DocumentSourceParallelPartials::getNext() {
+        pExpCtx->checkForInterrupt();
+
+        if (!_populated)
+            populate();
+
+        if (_results.empty())
+            return boost::none;
+
+        Document out = _results.front();
+        _results.pop_front();
+        return out;
+    }
+
+    void DocumentSourceParallelPartials::populate() {
+        _populated = true;
+
+        try {
+            for (size_t i = 0; i < _partials.size(); i++) {
+                _threads.push_back(boost::shared_ptr<boost::thread>(
+                        new boost::thread(boost::bind(&DocumentSourceParallelPartials::runWorker,
+                                                      this,
+                                                      i))));
+            }
+
+            std::deque<Document> batch;
+            for (;;) {
+                {
+                    // Don't let 'next' hold a reference once the batch it's in has been queued.
+                    boost::optional<Document> next = _cursor->getNext();
+                    if (!next)
+                        break;
+                    batch.push_back(*next);
+                }
+
+                if (batch.size() == kDocsPerBatch && !deal(&batch))
+                    break;
+            }
+
+            if (!batch.empty())
+                deal(&batch);
+        }
+        catch (...) {
+            abort();
+            throw;
+        }
+
+        _cursor->dispose();
+        finish();
+
+        if (!_error.empty())
+            uasserted(_errorCode, _error);
+
+        for (size_t i = 0; i < _outputs.size(); i++) {
+            _results.insert(_results.end(), _outputs[i].begin(), _outputs[i].end());
+        }
+
+        // Release the workers' groups now rather than when the pipeline goes away.
+        _partials.clear();
+        _outputs.clear();
+    }
+
+    void DocumentSourceParallelPartials::runWorker(size_t worker) {
+        try {
+            DocumentSource* output = _partials[worker]->output();
+            while (boost::optional<Document> next = output->getNext()) {
+                _outputs[worker].push_back(*next);
+            }
+        }
+        catch (const DBException& e) {
+            fail(e.getCode(), e.what());
+        }
+        catch (const std::exception& e) {
+            fail(17420, str::stream() << "parallel aggregation worker failed: " << e.what());
+        }
+    }
+
+    bool DocumentSourceParallelPartials::deal(std::deque<Document>* batch) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_queue.size() >= _threads.size() * kQueuedBatchesPerWorker && 0 == _aborted.load()) {
+            _spaceCond.wait(lk);
+        }
+        if (0 != _aborted.load())
+            return false;
+
+        _queue.push_back(std::deque<Document>());
+        _queue.back().swap(*batch);
+        _batchesCond.notify_one();
+        return true;
+    }
+
+    bool DocumentSourceParallelPartials::takeBatch(std::deque<Document>* batch) {
+        boost::unique_lock<boost::mutex> lk(_mutex);
+        while (_queue.empty() && !_inputDone && 0 == _aborted.load()) {
+            _batchesCond.wait(lk);
+        }
+        if (_queue.empty() || 0 != _aborted.load())
+            return false;
+
+        batch->swap(_queue.front());
+        _queue.pop_front();
+        _spaceCond.notify_one();
+        return true;
+    }
+
+    void DocumentSourceParallelPartials::fail(int code, const std::string& error) {
+        boost::lock_guard<boost::mutex> lk(_mutex);
+        if (_error.empty()) {
+            _errorCode = code;
+            _error = error;
+        }
+        _aborted.store(1);
+        _batchesCond.notify_all();
+        _spaceCond.notify_all();
+    }
+
+    void DocumentSourceParallelPartials::finish() {
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _inputDone = true;
+            _batchesCond.notify_all();
+        }
+
+        for (size_t i = 0; i < _threads.size(); i++) {
+            _threads[i]->join();
+        }
+        _threads.clear();
+
+        // Anything still queued was never handed to a worker because we stopped early.
+        _queue.clear();
+    }
+
+    void DocumentSourceParallelPartials::abort() {
+        {
+            boost::lock_guard<boost::mutex> lk(_mutex);
+            _aborted.store(1);
+        }
+        finish();
+    }
+}
@@ -30,18 +30,32 @@
 
 #include "mongo/db/pipeline/pipeline_d.h"
 
+#include <limits>
+
 #include "mongo/client/dbclientinterface.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/exec/sort.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/pdfile.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/pipeline.h"
 #include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/query_planner.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/s/d_logic.h"
 
 namespace mongo {
 
+    // Pipelines that start with a $group, possibly after stages that only look at one document at
+    // a time, run that part on this many threads when the collection has at least
+    // internalPipelineParallelMinMB of data.  The $group's partial results are then merged as
+    // they would be from shards.  1 turns it off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalPipelineParallelThreads, int, 1);
+    MONGO_EXPORT_SERVER_PARAMETER(internalPipelineParallelMinMB, int, 64);
+
 namespace {
     class MongodImplementation : public DocumentSourceNeedsMongod::MongodInterface {
     public:
@@ -61,6 +75,97 @@ namespace {
     private:
         DBDirectClient _client;
     };
+
+    /**
+     * True if the pipeline has a $group and everything before it looks at one document at a time,
+     * so the part up to the $group gives the same merged result on any split of its input.
+     */
+    bool canRunPartialsInParallel(const std::deque<intrusive_ptr<DocumentSource> >& sources) {
+        for (size_t i = 0; i < sources.size(); i++) {
+            DocumentSource* source = sources[i].get();
+            if (dynamic_cast<DocumentSourceGroup*>(source))
+                return true;
+
+            if (!dynamic_cast<DocumentSourceMatch*>(source)
+                    && !dynamic_cast<DocumentSourceProject*>(source)
+                    && !dynamic_cast<DocumentSourceRedact*>(source)
+                    && !dynamic_cast<DocumentSourceUnwind*>(source)) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool isWorthRunningInParallel(const string& ns) {
+        const int minMB = internalPipelineParallelMinMB;
+        if (minMB <= 0)
+            return true;
+
+        Database* db = cc().database();
+        Collection* collection = db ? db->getCollection(ns) : NULL;
+        return collection && collection->dataSize() >= (static_cast<uint64_t>(minMB) << 20);
+    }
+
+    /**
+     * Returns true if the query layer can keep the first 'limit' documents in 'sortObj' order in
+     * place of the pipeline, for plans where no index provides that order.  The two sorts only
+     * agree when no document holds an array at a sort field, which a non-multikey btree index on
+     * the field proves.  Other index types don't: a 2d index isn't multikey over [x, y] pairs.  The query layer's sort also can't spill, so 'limit' average documents have
+     * to fit well within its memory.
+     */
+    bool canRunTopKInQuery(Collection* collection, const BSONObj& sortObj, long long limit) {
+        if (!collection || limit <= 0 || limit > std::numeric_limits<int>::max())
+            return false;
+
+        const long long bytesNeeded = limit * collection->averageObjectSize();
+        if (bytesNeeded > static_cast<long long>(SortStageParams::kMaxBytes / 2))
+            return false;
+
+        BSONForEach(sortField, sortObj) {
+            bool noArrays = false;
+            IndexCatalog::IndexIterator ii =
+                collection->getIndexCatalog()->getIndexIterator(false);
+            while (!noArrays && ii.more()) {
+                const IndexDescriptor* desc = ii.next();
+                const string& type = desc->getAccessMethodName();
+                noArrays = (IndexNames::BTREE == type || "btree" == type)
+                        && !desc->isMultikey()
+                        && desc->keyPattern().hasField(sortField.fieldName());
+            }
+            if (!noArrays)
+                return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Returns true if the plans for 'queryObj' already deliver documents ordered on what 'group'
+     * groups by, and fills out '*sortOut' with that order.
+     */
+    bool findStreamingGroupSort(const intrusive_ptr<ExpressionContext>& pExpCtx,
+                                const DocumentSourceGroup& group,
+                                const BSONObj& queryObj,
+                                const BSONObj& projectionForQuery,
+                                size_t runnerOptions,
+                                BSONObj* sortOut) {
+        const string field = group.getIdFieldPath();
+        if (field.empty())
+            return false;
+
+        CanonicalQuery* rawCq;
+        if (!CanonicalQuery::canonicalize(pExpCtx->ns,
+                                          queryObj,
+                                          BSONObj(),
+                                          projectionForQuery,
+                                          &rawCq).isOK())
+            return false;
+        const scoped_ptr<CanonicalQuery> cq(rawCq);
+
+        Database* db = cc().database();
+        Collection* collection = db ? db->getCollection(pExpCtx->ns.ns()) : NULL;
+        return getProvidedSortOnField(collection, *cq, field, runnerOptions, sortOut);
+    }
 }
 
     boost::shared_ptr<Runner> PipelineD::prepareCursorSource(
@@ -150,27 +255,65 @@ namespace {
                                    | QueryPlannerParams::INCLUDE_COLLSCAN
                                    | QueryPlannerParams::INCLUDE_SHARD_FILTER
                                    | QueryPlannerParams::NO_BLOCKING_SORT
+                                   | QueryPlannerParams::PARALLEL_COLLSCAN
                                    ;
+
+        // A $group whose input arrives ordered on its _id can return each group as soon as the
+        // next one starts, rather than holding every group until the input ends. If the plans we
+        // would get anyway already deliver that order, ask for it so the choice of plan keeps it.
+        intrusive_ptr<DocumentSourceGroup> groupStage;
+        if (!sortStage && !sources.empty()) {
+            groupStage = dynamic_cast<DocumentSourceGroup*>(sources.front().get());
+            if (groupStage && !findStreamingGroupSort(pExpCtx, *groupStage, queryObj,
+                                                      projectionForQuery, runnerOptions,
+                                                      &sortObj)) {
+                groupStage.reset();
+            }
+        }
+
         boost::shared_ptr<Runner> runner;
         bool sortInRunner = false;
-        if (sortStage) {
+        if (sortStage || groupStage) {
+            // A $limit coalesced into the $sort goes to the query as a hard limit. A plan whose
+            // index provides the order then stops after that many documents, and if the query
+            // layer can take over the top-K, plans that filter on another index and sort their
+            // results compete with it.
+            long long limit = 0;
+            size_t sortOptions = runnerOptions;
+            if (sortStage && sortStage->getLimitSrc()) {
+                Database* db = cc().database();
+                Collection* collection = db ? db->getCollection(fullName) : NULL;
+                if (canRunTopKInQuery(collection, sortObj,
+                                      sortStage->getLimitSrc()->getLimit())) {
+                    limit = sortStage->getLimitSrc()->getLimit();
+                    sortOptions &= ~QueryPlannerParams::NO_BLOCKING_SORT;
+                }
+            }
+
             CanonicalQuery* cq;
             Status status =
                 CanonicalQuery::canonicalize(pExpCtx->ns,
                                              queryObj,
                                              sortObj,
                                              projectionForQuery,
+                                             0, // skip
+                                             -limit, // negative for a hard limit
                                              &cq);
             Runner* rawRunner;
-            if (status.isOK() && getRunner(cq, &rawRunner, runnerOptions).isOK()) {
-                // success: The Runner will handle sorting for us using an index.
+            if (status.isOK() && getRunner(cq, &rawRunner, sortOptions).isOK()) {
+                // success: The Runner will handle sorting for us.
                 runner.reset(rawRunner);
                 sortInRunner = true;
 
-                sources.pop_front();
-                if (sortStage->getLimitSrc()) {
-                    // need to reinsert coalesced $limit after removing $sort
-                    sources.push_front(sortStage->getLimitSrc());
+                if (groupStage) {
+                    groupStage->setStreaming(true);
+                }
+                else {
+                    sources.pop_front();
+                    if (sortStage->getLimitSrc()) {
+                        // need to reinsert coalesced $limit after removing $sort
+                        sources.push_front(sortStage->getLimitSrc());
+                    }
                 }
             }
         }
@@ -204,12 +347,33 @@ namespace {
         if (sortInRunner)
             pSource->setSort(sortObj);
 
-        pSource->setProjection(deps.toProjection(), deps.toParsedDeps());
-
         while (!sources.empty() && pSource->coalesce(sources.front())) {
             sources.pop_front();
         }
 
+        const int threads = internalPipelineParallelThreads;
+        if (threads > 1
+                && !pPipeline->isExplain()
+                && !sortInRunner // $first and $last must see the sorted order
+                && pSource->getLimit() == -1
+                && canRunPartialsInParallel(sources)
+                && isWorthRunningInParallel(fullName)) {
+            // The workers parse their own copies of what follows the cursor and keep the shard
+            // half, while we keep the merge half.
+            const BSONObj partialCmd = pPipeline->serialize().toBson();
+            pPipeline->splitForSharded();
+
+            // Hand the workers unconverted documents, which they convert lazily. Extracting the
+            // fields here would keep that work on this thread.
+            pSource->setProjection(deps.toProjection(), boost::none);
+
+            pPipeline->addInitialSource(
+                DocumentSourceParallelPartials::create(pSource, partialCmd, threads, pExpCtx));
+            return runner;
+        }
+
+        pSource->setProjection(deps.toProjection(), deps.toParsedDeps());
+
         pPipeline->addInitialSource(pSource);
 
         return runner;
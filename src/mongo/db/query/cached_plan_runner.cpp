@@ -28,6 +28,8 @@
 
 #include "mongo/db/query/cached_plan_runner.h"
 
+#include <algorithm>
+
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
@@ -35,17 +37,29 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/eof_runner.h"
 #include "mongo/db/query/explain_plan.h"
+#include "mongo/db/query/get_runner.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/type_explain.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // A cached plan that is worked this many times more than it was during ranking, without
+    // producing a result, is evicted and the query planned again.  0 turns replanning off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryCacheReplanFactor, int, 10);
+
+    // Plans that were cheap to rank are budgeted as if they had taken this many works, so that
+    // replanning, which costs a trial period of its own, isn't triggered by small changes.
+    static const size_t kMinReplanDecisionWorks = 100;
+
     CachedPlanRunner::CachedPlanRunner(const Collection* collection,
                                        CanonicalQuery* canonicalQuery,
                                        QuerySolution* solution,
@@ -57,7 +71,11 @@ namespace mongo {
           _exec(new PlanExecutor(ws, root)),
           _alreadyProduced(false),
           _updatedCache(false),
-          _killed(false) { }
+          _killed(false),
+          _decisionWorks(0),
+          _plannerOptions(0),
+          _ns(canonicalQuery->getParsed().ns()),
+          _yieldPolicy(Runner::YIELD_MANUAL) { }
 
     CachedPlanRunner::~CachedPlanRunner() {
         // The runner may produce all necessary results without hitting EOF.  In this case, we still
@@ -68,11 +86,21 @@ namespace mongo {
     }
 
     Runner::RunnerState CachedPlanRunner::getNext(BSONObj* objOut, DiskLoc* dlOut) {
+        if (NULL != _replacement.get()) {
+            return _replacement->getNext(objOut, dlOut);
+        }
+
         Runner::RunnerState state = _exec->getNext(objOut, dlOut);
 
-        if (Runner::RUNNER_ADVANCED == state) {
-            // Indicate that the plan executor already produced results.
+        if (Runner::RUNNER_ADVANCED == state && !_alreadyProduced) {
+            // Indicate that the plan executor already produced results.  We can't switch plans
+            // after this without returning some results twice.
             _alreadyProduced = true;
+            _exec->setWorkBudget(0);
+        }
+
+        if (Runner::RUNNER_EOF == state && _exec->exceededWorkBudget()) {
+            return replan(objOut, dlOut);
         }
 
         // If the plan executor errors before producing any results,
@@ -92,10 +120,17 @@ namespace mongo {
     }
 
     bool CachedPlanRunner::isEOF() {
+        if (NULL != _replacement.get()) {
+            return _replacement->isEOF();
+        }
         return _exec->isEOF();
     }
 
     void CachedPlanRunner::saveState() {
+        if (NULL != _replacement.get()) {
+            _replacement->saveState();
+            return;
+        }
         _exec->saveState();
         if (NULL != _backupPlan.get()) {
             _backupPlan->saveState();
@@ -103,6 +138,9 @@ namespace mongo {
     }
 
     bool CachedPlanRunner::restoreState() {
+        if (NULL != _replacement.get()) {
+            return _replacement->restoreState();
+        }
         if (NULL != _backupPlan.get()) {
             _backupPlan->restoreState();
         }
@@ -110,6 +148,10 @@ namespace mongo {
     }
 
     void CachedPlanRunner::invalidate(const DiskLoc& dl, InvalidationType type) {
+        if (NULL != _replacement.get()) {
+            _replacement->invalidate(dl, type);
+            return;
+        }
         _exec->invalidate(dl, type);
         if (NULL != _backupPlan.get()) {
             _backupPlan->invalidate(dl, type);
@@ -117,6 +159,11 @@ namespace mongo {
     }
 
     void CachedPlanRunner::setYieldPolicy(Runner::YieldPolicy policy) {
+        _yieldPolicy = policy;
+        if (NULL != _replacement.get()) {
+            _replacement->setYieldPolicy(policy);
+            return;
+        }
         _exec->setYieldPolicy(policy);
         if (NULL != _backupPlan.get()) {
             _backupPlan->setYieldPolicy(policy);
@@ -124,12 +171,16 @@ namespace mongo {
     }
 
     const std::string& CachedPlanRunner::ns() {
-        return _canonicalQuery->getParsed().ns();
+        return _ns;
     }
 
     void CachedPlanRunner::kill() {
         _killed = true;
         _collection = NULL;
+        if (NULL != _replacement.get()) {
+            _replacement->kill();
+            return;
+        }
         _exec->kill();
         if (NULL != _backupPlan.get()) {
             _backupPlan->kill();
@@ -138,6 +189,10 @@ namespace mongo {
 
     Status CachedPlanRunner::getInfo(TypeExplain** explain,
                                      PlanInfo** planInfo) const {
+        if (NULL != _replacement.get()) {
+            return _replacement->getInfo(explain, planInfo);
+        }
+
         if (NULL != explain) {
             if (NULL == _exec.get()) {
                 return Status(ErrorCodes::InternalError, "No plan available to provide stats");
@@ -242,4 +297,57 @@ namespace mongo {
         _backupPlan.reset(new PlanExecutor(ws, root));
     }
 
+    void CachedPlanRunner::setReplanBudget(size_t decisionWorks, size_t plannerOptions) {
+        _decisionWorks = decisionWorks;
+        _plannerOptions = plannerOptions;
+
+        if (0 == _decisionWorks || internalQueryCacheReplanFactor <= 0) {
+            return;
+        }
+
+        _exec->setWorkBudget(static_cast<size_t>(internalQueryCacheReplanFactor)
+                             * std::max(_decisionWorks, kMinReplanDecisionWorks));
+    }
+
+    Runner::RunnerState CachedPlanRunner::replan(BSONObj* objOut, DiskLoc* dlOut) {
+        invariant(!_alreadyProduced);
+
+        Database* db = cc().database();
+        Collection* collection = (NULL == db) ? NULL : db->getCollection(_ns);
+        if (NULL == collection) {
+            return Runner::RUNNER_DEAD;
+        }
+
+        LOG(1) << _ns << ": replanning " << _canonicalQuery->toString()
+               << " - cached plan was worked " << _exec->worksSinceBudgetSet()
+               << " times without a result, " << _decisionWorks
+               << " when it was chosen" << endl;
+
+        collection->infoCache()->getPlanCache()->removeForReplan(*_canonicalQuery);
+
+        // The cached plan's numbers say nothing about the entry that replaces it.
+        _updatedCache = true;
+        _exec.reset();
+        _backupPlan.reset();
+        _backupSolution.reset();
+
+        Runner* rawRunner;
+        Status status = getRunner(collection, _canonicalQuery.release(), &rawRunner,
+                                  _plannerOptions);
+        if (!status.isOK()) {
+            if (NULL != objOut) {
+                WorkingSet ws;
+                WorkingSetID wsid = WorkingSetCommon::allocateStatusMember(&ws, status);
+                WorkingSetCommon::getStatusMemberObject(ws, wsid, objOut);
+            }
+            // The query went with the failed attempt, so there is nothing left to run.
+            _replacement.reset(new EOFRunner(NULL, _ns));
+            return Runner::RUNNER_ERROR;
+        }
+
+        _replacement.reset(rawRunner);
+        _replacement->setYieldPolicy(_yieldPolicy);
+        return _replacement->getNext(objOut, dlOut);
+    }
+
 } // namespace mongo
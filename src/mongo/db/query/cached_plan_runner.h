@@ -29,6 +29,7 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <memory>
 #include <string>
 
 #include "mongo/base/status.h"
@@ -52,6 +53,10 @@ namespace mongo {
      *
      * If we run a plan from the cache and behavior wildly deviates from expected behavior, we may
      * remove the plan from the cache.  See plan_cache.h.
+     *
+     * If the cached plan works far longer than it did when it was chosen without producing a
+     * result, the runner evicts it and hands the query to a freshly planned runner, which
+     * usually caches a better plan in its place.
      */
     class CachedPlanRunner : public Runner {
     public:
@@ -96,12 +101,26 @@ namespace mongo {
          */
         void setBackupPlan(QuerySolution* qs, PlanStage* root, WorkingSet* ws);
 
+        /**
+         * Allows replanning if the cached plan is worked more than a multiple of 'decisionWorks'
+         * times before its first result.  'plannerOptions' are what the runner was built with,
+         * and are used to plan again.
+         */
+        void setReplanBudget(size_t decisionWorks, size_t plannerOptions);
+
     private:
         void updateCache();
 
+        /**
+         * Evicts the cached plan and switches to a newly planned runner.  Returns the state of
+         * that runner's first getNext().
+         */
+        Runner::RunnerState replan(BSONObj* objOut, DiskLoc* dlOut);
+
         const Collection* _collection;
 
-        boost::scoped_ptr<CanonicalQuery> _canonicalQuery;
+        // An auto_ptr so that it can be handed to the replacement runner.
+        std::auto_ptr<CanonicalQuery> _canonicalQuery;
         boost::scoped_ptr<QuerySolution> _solution;
         boost::scoped_ptr<PlanExecutor> _exec;
 
@@ -121,6 +140,19 @@ namespace mongo {
 
         // Has the runner been killed?
         bool _killed;
+
+        // Works the cached plan needed when it was ranked, and the options to plan again with.
+        // Replanning is off while _decisionWorks is 0.
+        size_t _decisionWorks;
+        size_t _plannerOptions;
+
+        // Owned here.  Non-NULL once we've replanned, after which everything is passed to it.
+        boost::scoped_ptr<Runner> _replacement;
+
+        // Copied from _canonicalQuery, which the replacement takes.
+        std::string _ns;
+
+        Runner::YieldPolicy _yieldPolicy;
     };
 
 }  // namespace mongo
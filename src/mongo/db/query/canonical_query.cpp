@@ -28,10 +28,17 @@
 
 #include "mongo/db/query/canonical_query.h"
 
+#include "boost/functional/hash.hpp"
+#include "boost/shared_ptr.hpp"
+#include "boost/thread/locks.hpp"
+#include "boost/thread/mutex.hpp"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/matcher/expression_tree.h"
 #include "mongo/db/query/query_planner_common.h"
+#include "mongo/platform/unordered_map.h"
 
 namespace {
 
@@ -244,6 +251,283 @@ namespace {
         }
     }
 
+    //
+    // Filter shape cache.
+    //
+    // Most filters are nothing but top-level comparisons against literals, e.g.
+    // {a: 5, b: {$gt: 1, $lt: 10}}.  The canonical tree of such a filter depends only on its
+    // field names and operators, so after one filter of a given shape has gone through parse,
+    // normalize and sort we remember which raw comparison ended up where.  Later filters of the
+    // same shape build their leaves directly from their own literals.
+    //
+
+    // Filters with more comparisons than this aren't worth the bookkeeping.
+    const size_t kMaxShapeComparisons = 32;
+
+    // Each shard is emptied when it reaches this many shapes.
+    const size_t kMaxShapesPerShard = 512;
+
+    /**
+     * One comparison of a cacheable filter, in the order it appears in the raw query.
+     */
+    struct ShapeComparison {
+        // Both point into the raw filter.
+        StringData path;
+        BSONElement literal;
+        MatchExpression::MatchType type;
+    };
+
+    struct FilterShape {
+        std::string key;
+        std::vector<ShapeComparison> comparisons;
+    };
+
+    /**
+     * Literals that the comparison leaves treat the same way no matter the operator.  Arrays,
+     * objects and regexes all have operator-specific meanings in the parser.
+     */
+    bool isShapeLiteral(const BSONElement& elt) {
+        switch (elt.type()) {
+        case NumberDouble:
+        case String:
+        case BinData:
+        case jstOID:
+        case Bool:
+        case Date:
+        case jstNULL:
+        case NumberInt:
+        case Timestamp:
+        case NumberLong:
+        case MinKey:
+        case MaxKey:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool shapeOperatorType(const char* op, MatchExpression::MatchType* type) {
+        if (mongoutils::str::equals("$eq", op)) { *type = MatchExpression::EQ; }
+        else if (mongoutils::str::equals("$lt", op)) { *type = MatchExpression::LT; }
+        else if (mongoutils::str::equals("$lte", op)) { *type = MatchExpression::LTE; }
+        else if (mongoutils::str::equals("$gt", op)) { *type = MatchExpression::GT; }
+        else if (mongoutils::str::equals("$gte", op)) { *type = MatchExpression::GTE; }
+        else { return false; }
+        return true;
+    }
+
+    /**
+     * Fills out 'shape' and returns true if 'filter' only has top-level comparisons against
+     * literals, with no field or operator repeated.
+     */
+    bool getFilterShape(const BSONObj& filter, FilterShape* shape) {
+        BSONObjIterator it(filter);
+        while (it.more()) {
+            BSONElement elt = it.next();
+            StringData path(elt.fieldName(), elt.fieldNameSize() - 1);
+            if (path.empty() || '$' == path[0]) {
+                return false;
+            }
+            for (size_t i = 0; i < shape->comparisons.size(); ++i) {
+                if (shape->comparisons[i].path == path) {
+                    return false;
+                }
+            }
+
+            shape->key.append(path.rawData(), path.size());
+            shape->key.push_back('\0');
+
+            if (Object != elt.type()) {
+                if (!isShapeLiteral(elt)) {
+                    return false;
+                }
+                ShapeComparison cmp;
+                cmp.path = path;
+                cmp.literal = elt;
+                cmp.type = MatchExpression::EQ;
+                shape->comparisons.push_back(cmp);
+                shape->key.append(encodeMatchType(cmp.type));
+            }
+            else {
+                BSONObj ops = elt.embeddedObject();
+                if (ops.isEmpty()) {
+                    return false;
+                }
+                const size_t firstOp = shape->comparisons.size();
+                BSONObjIterator opIt(ops);
+                while (opIt.more()) {
+                    BSONElement opElt = opIt.next();
+                    ShapeComparison cmp;
+                    if (!shapeOperatorType(opElt.fieldName(), &cmp.type)
+                        || !isShapeLiteral(opElt)) {
+                        return false;
+                    }
+                    for (size_t i = firstOp; i < shape->comparisons.size(); ++i) {
+                        if (shape->comparisons[i].type == cmp.type) {
+                            return false;
+                        }
+                    }
+                    cmp.path = path;
+                    cmp.literal = opElt;
+                    shape->comparisons.push_back(cmp);
+                    shape->key.append(encodeMatchType(cmp.type));
+                }
+            }
+            shape->key.push_back('\0');
+
+            if (shape->comparisons.size() > kMaxShapeComparisons) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Where each comparison of a filter shape lands in the canonical tree, plus the part of the
+     * plan cache key the tree contributes.
+     */
+    class FilterShapeTemplate {
+    public:
+        /**
+         * Records the layout of 'root', the canonical tree built the slow way from a filter of
+         * shape 'shape'.  Returns NULL if the tree isn't what we expect from such a filter.
+         */
+        static FilterShapeTemplate* make(const MatchExpression* root, const FilterShape& shape) {
+            std::vector<const MatchExpression*> leaves;
+            bool andRoot = MatchExpression::AND == root->matchType();
+            if (andRoot) {
+                for (size_t i = 0; i < root->numChildren(); ++i) {
+                    leaves.push_back(root->getChild(i));
+                }
+            }
+            else {
+                leaves.push_back(root);
+            }
+            if (leaves.size() != shape.comparisons.size()) {
+                return NULL;
+            }
+
+            auto_ptr<FilterShapeTemplate> tmpl(new FilterShapeTemplate());
+            tmpl->_andRoot = andRoot;
+            std::vector<bool> used(shape.comparisons.size(), false);
+            for (size_t i = 0; i < leaves.size(); ++i) {
+                const MatchExpression* leaf = leaves[i];
+                if (NULL == newComparison(leaf->matchType())) {
+                    return NULL;
+                }
+                size_t ordinal = 0;
+                while (ordinal < shape.comparisons.size()
+                       && (used[ordinal]
+                           || shape.comparisons[ordinal].type != leaf->matchType()
+                           || shape.comparisons[ordinal].path != leaf->path())) {
+                    ++ordinal;
+                }
+                if (ordinal == shape.comparisons.size()) {
+                    return NULL;
+                }
+                used[ordinal] = true;
+                tmpl->_ordinals.push_back(ordinal);
+            }
+
+            mongoutils::str::stream ss;
+            encodePlanCacheKeyTree(root, &ss);
+            tmpl->_treeKey = ss;
+            return tmpl.release();
+        }
+
+        /**
+         * Builds the canonical tree for a filter of our shape out of its literals.  Returns NULL
+         * if any comparison refuses its literal, in which case the caller should parse.
+         */
+        MatchExpression* bind(const FilterShape& shape) const {
+            auto_ptr<AndMatchExpression> andRoot;
+            if (_andRoot) {
+                andRoot.reset(new AndMatchExpression());
+            }
+            for (size_t i = 0; i < _ordinals.size(); ++i) {
+                const ShapeComparison& cmp = shape.comparisons[_ordinals[i]];
+                auto_ptr<ComparisonMatchExpression> leaf(newComparison(cmp.type));
+                if (!leaf->init(cmp.path, cmp.literal).isOK()) {
+                    return NULL;
+                }
+                if (!_andRoot) {
+                    return leaf.release();
+                }
+                andRoot->add(leaf.release());
+            }
+            return andRoot.release();
+        }
+
+        const std::string& treeKey() const { return _treeKey; }
+
+    private:
+        FilterShapeTemplate() { }
+
+        static ComparisonMatchExpression* newComparison(MatchExpression::MatchType type) {
+            switch (type) {
+            case MatchExpression::EQ: return new EqualityMatchExpression();
+            case MatchExpression::LT: return new LTMatchExpression();
+            case MatchExpression::LTE: return new LTEMatchExpression();
+            case MatchExpression::GT: return new GTMatchExpression();
+            case MatchExpression::GTE: return new GTEMatchExpression();
+            default: return NULL;
+            }
+        }
+
+        bool _andRoot;
+
+        // _ordinals[i] is the index in the raw filter of the comparison that is leaf i.
+        std::vector<size_t> _ordinals;
+
+        std::string _treeKey;
+    };
+
+    typedef boost::shared_ptr<const FilterShapeTemplate> FilterShapeTemplatePtr;
+
+    /**
+     * Process-wide map from filter shape key to template.  Split into shards, like the plan
+     * cache, so concurrent queries don't all serialize on one mutex.
+     */
+    class FilterShapeCache {
+    public:
+        FilterShapeTemplatePtr get(const std::string& key) {
+            Shard& shard = shardFor(key);
+            boost::lock_guard<boost::mutex> lk(shard.mutex);
+            Map::const_iterator it = shard.templates.find(key);
+            if (shard.templates.end() == it) {
+                return FilterShapeTemplatePtr();
+            }
+            return it->second;
+        }
+
+        void add(const std::string& key, const FilterShapeTemplatePtr& tmpl) {
+            Shard& shard = shardFor(key);
+            boost::lock_guard<boost::mutex> lk(shard.mutex);
+            if (shard.templates.size() >= kMaxShapesPerShard) {
+                shard.templates.clear();
+            }
+            shard.templates[key] = tmpl;
+        }
+
+    private:
+        typedef unordered_map<std::string, FilterShapeTemplatePtr> Map;
+
+        struct Shard {
+            boost::mutex mutex;
+            Map templates;
+        };
+
+        static const size_t kNumShards = 8;
+
+        Shard& shardFor(const std::string& key) {
+            return _shards[boost::hash<std::string>()(key) % kNumShards];
+        }
+
+        Shard _shards[kNumShards];
+    };
+
+    FilterShapeCache filterShapeCache;
+
 } // namespace
 
 namespace mongo {
@@ -552,21 +836,49 @@ namespace mongo {
     Status CanonicalQuery::init(LiteParsedQuery* lpq) {
         _pq.reset(lpq);
 
-        // Build a parse tree from the BSONObj in the parsed query.
-        StatusWithMatchExpression swme = MatchExpressionParser::parse(_pq->getFilter());
-        if (!swme.isOK()) { return swme.getStatus(); }
+        // If we've seen a filter of this shape before, bind our literals into its canonical
+        // tree rather than parsing, normalizing and sorting all over again.
+        FilterShape shape;
+        bool cacheableShape = getFilterShape(_pq->getFilter(), &shape);
+        FilterShapeTemplatePtr shapeTemplate;
+        if (cacheableShape) {
+            shapeTemplate = filterShapeCache.get(shape.key);
+        }
+        if (shapeTemplate) {
+            _root.reset(shapeTemplate->bind(shape));
+        }
 
-        // Normalize, sort and validate tree.
-        MatchExpression* root = swme.getValue();
-        root = normalizeTree(root);
-        sortTree(root);
-        Status validStatus = isValid(root, *_pq);
-        if (!validStatus.isOK()) {
-            return validStatus;
+        if (_root) {
+            mongoutils::str::stream ss;
+            ss << shapeTemplate->treeKey();
+            encodePlanCacheKeySort(_pq->getSort(), &ss);
+            encodePlanCacheKeyProj(_pq->getProj(), &ss);
+            _cacheKey = ss;
         }
-        _root.reset(root);
+        else {
+            // Build a parse tree from the BSONObj in the parsed query.
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(_pq->getFilter());
+            if (!swme.isOK()) { return swme.getStatus(); }
+
+            // Normalize, sort and validate tree.
+            MatchExpression* root = swme.getValue();
+            root = normalizeTree(root);
+            sortTree(root);
+            Status validStatus = isValid(root, *_pq);
+            if (!validStatus.isOK()) {
+                return validStatus;
+            }
+            _root.reset(root);
 
-        this->generateCacheKey();
+            if (cacheableShape && !shapeTemplate) {
+                FilterShapeTemplate* tmpl = FilterShapeTemplate::make(root, shape);
+                if (NULL != tmpl) {
+                    filterShapeCache.add(shape.key, FilterShapeTemplatePtr(tmpl));
+                }
+            }
+
+            this->generateCacheKey();
+        }
 
         // Validate the projection if there is one.
         if (!_pq->getProj().isEmpty()) {
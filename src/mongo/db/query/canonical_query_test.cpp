@@ -431,6 +431,47 @@ namespace {
                            "{$and: [{a: 1}, {b: 1}, {c: 1}]}");
     }
 
+    /**
+     * Canonicalizes 'queryStr' twice so that the second time goes through the filter shape
+     * cache, and checks both results against each other and against 'expectedExprStr'.
+     */
+    void testShapeCachedQuery(const char* queryStr, const char* expectedExprStr) {
+        auto_ptr<CanonicalQuery> first(canonicalize(queryStr));
+        auto_ptr<CanonicalQuery> second(canonicalize(queryStr));
+        BSONObj expectedExprObj = fromjson(expectedExprStr);
+        auto_ptr<MatchExpression> expectedExpr(parseMatchExpression(expectedExprObj));
+        assertEquivalent(queryStr, expectedExpr.get(), first->root());
+        assertEquivalent(queryStr, expectedExpr.get(), second->root());
+        ASSERT_EQUALS(first->getPlanCacheKey(), second->getPlanCacheKey());
+        ASSERT_EQUALS(first->root()->toString(), second->root()->toString());
+    }
+
+    TEST(CanonicalQueryTest, FilterShapeCache) {
+        testShapeCachedQuery("{}", "{}");
+        testShapeCachedQuery("{b: 1, a: 'x'}", "{a: 'x', b: 1}");
+        testShapeCachedQuery("{a: {$lt: 10, $gt: 5}}", "{a: {$lt: 10}, a: {$gt: 5}}");
+        testShapeCachedQuery("{c: null, a: {$gte: 1, $eq: 3}, b: {$lte: 2}}",
+                             "{b: {$lte: 2}, a: {$eq: 3}, c: null, a: {$gte: 1}}");
+        // Not cacheable shapes still canonicalize normally.
+        testShapeCachedQuery("{a: [1, 2], b: {c: 1}}", "{a: [1, 2], b: {c: 1}}");
+        testShapeCachedQuery("{a: {$in: [1, 2]}}", "{a: {$in: [1, 2]}}");
+    }
+
+    TEST(CanonicalQueryTest, FilterShapeCacheRebindsLiterals) {
+        auto_ptr<CanonicalQuery> first(canonicalize("{b: {$gt: 1}, a: 2}", "{b: 1}", "{a: 1}"));
+        auto_ptr<CanonicalQuery> second(canonicalize("{b: {$gt: 7}, a: 'y'}", "{b: 1}",
+                                                     "{a: 1}"));
+        BSONObj expectedExprObj = fromjson("{a: 'y', b: {$gt: 7}}");
+        auto_ptr<MatchExpression> expectedExpr(parseMatchExpression(expectedExprObj));
+        assertEquivalent("{b: {$gt: 7}, a: 'y'}", expectedExpr.get(), second->root());
+        ASSERT_EQUALS(first->getPlanCacheKey(), second->getPlanCacheKey());
+
+        // The literals bound for the second query must point into its own filter.
+        BSONObj doc = BSON("a" << "y" << "b" << 8);
+        ASSERT(second->root()->matchesBSON(doc, NULL));
+        ASSERT(!first->root()->matchesBSON(doc, NULL));
+    }
+
     /**
      * Test functions for getPlanCacheKey.
      * Cache keys are intentionally obfuscated and are meaningful only
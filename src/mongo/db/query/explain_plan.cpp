@@ -439,6 +439,10 @@ namespace mongo {
             for (size_t i = 0; i < spec->mapAfterChild.size(); ++i) {
                 bob->appendNumber(string(stream() << "mapAfterChild_" << i), spec->mapAfterChild[i]);
             }
+            bob->appendNumber("memUsage", spec->memUsage);
+            bob->appendNumber("memLimit", spec->memLimit);
+            bob->appendBool("locsOnly", spec->locsOnly);
+            bob->appendNumber("fetchedResults", spec->fetchedResults);
         }
         else if (STAGE_AND_SORTED == stats.stageType) {
             AndSortedStats* spec = static_cast<AndSortedStats*>(stats.specific.get());
@@ -451,6 +455,9 @@ namespace mongo {
         else if (STAGE_COLLSCAN == stats.stageType) {
             CollectionScanStats* spec = static_cast<CollectionScanStats*>(stats.specific.get());
             bob->appendNumber("docsTested", spec->docsTested);
+            if (spec->workers > 0) {
+                bob->appendNumber("workers", spec->workers);
+            }
         }
         else if (STAGE_FETCH == stats.stageType) {
             FetchStats* spec = static_cast<FetchStats*>(stats.specific.get());
@@ -477,6 +484,7 @@ namespace mongo {
             bob->appendNumber("seenInvalidated", spec->seenInvalidated);
             bob->appendNumber("matchTested", spec->matchTested);
             bob->appendNumber("keysExamined", spec->keysExamined);
+            bob->appendNumber("locsFiltered", spec->locsFiltered);
         }
         else if (STAGE_OR == stats.stageType) {
             OrStats* spec = static_cast<OrStats*>(stats.specific.get());
@@ -494,6 +502,8 @@ namespace mongo {
         else if (STAGE_SORT == stats.stageType) {
             SortStats* spec = static_cast<SortStats*>(stats.specific.get());
             bob->appendNumber("forcedFetches", spec->forcedFetches);
+            bob->appendNumber("spills", spec->spills);
+            bob->appendNumber("spilledBytes", spec->spilledBytes);
         }
         else if (STAGE_SORT_MERGE == stats.stageType) {
             MergeSortStats* spec = static_cast<MergeSortStats*>(stats.specific.get());
@@ -30,8 +30,11 @@
 
 #include <limits>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/base/parse_number.h"
 #include "mongo/client/dbclientinterface.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
+#include "mongo/db/matcher/expression_tree.h"
 #include "mongo/db/query/cached_plan_runner.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/eof_runner.h"
@@ -56,6 +59,10 @@ namespace mongo {
 
     MONGO_EXPORT_SERVER_PARAMETER(enableIndexIntersection, bool, true);
 
+    // Candidate plans that index stats say examine this many times more keys than the cheapest
+    // aren't raced.  0 turns this off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryPlannerPruneRatio, double, 10.0);
+
     static bool canUseIDHack(const CanonicalQuery& query) {
         return !query.getParsed().showDiskLoc()
             && query.getParsed().getHint().isEmpty()
@@ -90,6 +97,188 @@ namespace mongo {
         temp.swap(*indexEntries);
     }
 
+    /**
+     * Fills out the parameters the planner needs for 'canonicalQuery' over 'collection', which
+     * must not be NULL: its indexes, index filters, and the options derived from
+     * 'plannerOptions' and the server settings.
+     */
+    static Status fillOutPlannerParams(Collection* collection,
+                                       const CanonicalQuery& canonicalQuery,
+                                       size_t plannerOptions,
+                                       QueryPlannerParams* plannerParams) {
+        // Access the catalog and fill out IndexEntry(s)
+        IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(false);
+        while (ii.more()) {
+            const IndexDescriptor* desc = ii.next();
+            plannerParams->indices.push_back(IndexEntry(desc->keyPattern(),
+                                                        desc->getAccessMethodName(),
+                                                        desc->isMultikey(),
+                                                        desc->isSparse(),
+                                                        desc->indexName(),
+                                                        desc->infoObj()));
+            plannerParams->indices.back().stats =
+                collection->getIndexCatalog()->getEntry(desc)->getStats();
+        }
+
+        // If query supports index filters, filter params.indices by indices in query settings.
+        QuerySettings* querySettings = collection->infoCache()->getQuerySettings();
+        AllowedIndices* allowedIndicesRaw;
+
+        // Filter index catalog if index filters are specified for query.
+        // Also, signal to planner that application hint should be ignored.
+        if (querySettings->getAllowedIndices(canonicalQuery, &allowedIndicesRaw)) {
+            boost::scoped_ptr<AllowedIndices> allowedIndices(allowedIndicesRaw);
+            filterAllowedIndexEntries(*allowedIndices, &plannerParams->indices);
+            plannerParams->indexFiltersApplied = true;
+        }
+
+        // Tailable: If the query requests tailable the collection must be capped.
+        if (canonicalQuery.getParsed().hasOption(QueryOption_CursorTailable)) {
+            if (!collection->isCapped()) {
+                return Status(ErrorCodes::BadValue,
+                              "error processing query: " + canonicalQuery.toString() +
+                              " tailable cursor requested on non capped collection");
+            }
+
+            // If a sort is specified it must be equal to expectedSort.
+            const BSONObj expectedSort = BSON("$natural" << 1);
+            const BSONObj& actualSort = canonicalQuery.getParsed().getSort();
+            if (!actualSort.isEmpty() && !(actualSort == expectedSort)) {
+                return Status(ErrorCodes::BadValue,
+                              "error processing query: " + canonicalQuery.toString() +
+                              " invalid sort specified for tailable cursor: "
+                              + actualSort.toString());
+            }
+        }
+
+        // Process the planning options.
+        plannerParams->options = plannerOptions;
+        plannerParams->pruneRatio = internalQueryPlannerPruneRatio;
+        if (storageGlobalParams.noTableScan) {
+            const string& ns = canonicalQuery.ns();
+            // There are certain cases where we ignore this restriction:
+            bool ignore = canonicalQuery.getQueryObj().isEmpty()
+                          || (string::npos != ns.find(".system."))
+                          || (0 == ns.find("local."));
+            if (!ignore) {
+                plannerParams->options |= QueryPlannerParams::NO_TABLE_SCAN;
+            }
+        }
+
+        if (!(plannerParams->options & QueryPlannerParams::NO_TABLE_SCAN)) {
+            plannerParams->options |= QueryPlannerParams::INCLUDE_COLLSCAN;
+        }
+
+        // If the caller wants a shard filter, make sure we're actually sharded.
+        if (plannerParams->options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
+            CollectionMetadataPtr collMetadata =
+                shardingState.getCollectionMetadata(canonicalQuery.ns());
+
+            if (collMetadata) {
+                plannerParams->shardKey = collMetadata->getKeyPattern();
+            }
+            else {
+                // If there's no metadata don't bother w/the shard filter since we won't know what
+                // the key pattern is anyway...
+                plannerParams->options &= ~QueryPlannerParams::INCLUDE_SHARD_FILTER;
+            }
+        }
+
+        return Status::OK();
+    }
+
+    namespace {
+
+        /// Returns true if the solution tree rooted at 'node' has a stage of type 'type'.
+        bool hasStage(const QuerySolutionNode* node, StageType type) {
+            if (type == node->getType()) {
+                return true;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (hasStage(node->children[i], type)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Returns true if the solution tree rooted at 'node' reads a multikey index.
+        bool readsMultikeyIndex(const QuerySolutionNode* node) {
+            if (STAGE_IXSCAN == node->getType()
+                && static_cast<const IndexScanNode*>(node)->indexIsMultiKey) {
+                return true;
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (readsMultikeyIndex(node->children[i])) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    }  // namespace
+
+    bool getProvidedSortOnField(Collection* collection,
+                                const CanonicalQuery& canonicalQuery,
+                                const std::string& field,
+                                size_t plannerOptions,
+                                BSONObj* sortOut) {
+        if (NULL == collection || !canonicalQuery.getParsed().getSort().isEmpty()) {
+            return false;
+        }
+
+        QueryPlannerParams plannerParams;
+        if (!fillOutPlannerParams(collection, canonicalQuery, plannerOptions,
+                                  &plannerParams).isOK()) {
+            return false;
+        }
+
+        OwnedPointerVector<QuerySolution> solutions;
+        if (!QueryPlanner::plan(canonicalQuery, plannerParams, &solutions.mutableVector()).isOK()) {
+            return false;
+        }
+
+        // Every indexed plan the runner might pick has to deliver the same order, or the runner
+        // could pick one that doesn't.  The collection scan is offered alongside them as a
+        // fallback; asking for the order drops it.
+        const BSONObj ascending = BSON(field << 1);
+        const BSONObj descending = BSON(field << -1);
+        int direction = 0;
+        for (size_t i = 0; i < solutions.size(); ++i) {
+            const QuerySolutionNode* root = solutions.vector()[i]->root.get();
+            if (hasStage(root, STAGE_COLLSCAN)) {
+                continue;
+            }
+
+            // A multikey index is ordered by array element, not by the document's value.
+            if (readsMultikeyIndex(root)) {
+                return false;
+            }
+
+            const BSONObjSet& sorts = root->getSort();
+            int solnDirection = 0;
+            if (sorts.end() != sorts.find(ascending)) {
+                solnDirection = 1;
+            }
+            else if (sorts.end() != sorts.find(descending)) {
+                solnDirection = -1;
+            }
+
+            if (0 == solnDirection || (0 != direction && solnDirection != direction)) {
+                return false;
+            }
+            direction = solnDirection;
+        }
+
+        if (0 == direction) {
+            // Only the collection scan.
+            return false;
+        }
+
+        *sortOut = (1 == direction) ? ascending : descending;
+        return true;
+    }
+
     /**
      * For a given query, get a runner.  The runner could be a SingleSolutionRunner, a
      * CachedQueryRunner, or a MultiPlanRunner, depending on the cache/query solver/etc.
@@ -136,7 +325,32 @@ namespace mongo {
 
     namespace {
         // The body is below in the "count hack" section but getRunner calls it.
-        bool turnIxscanIntoCount(QuerySolution* soln);
+        bool turnIxscanIntoCount(QuerySolution* soln, bool singleIntervalOnly = false);
+
+        bool hasNaturalOrder(const BSONObj& obj) {
+            return !obj.isEmpty() && !obj.getFieldDotted("$natural").eoo();
+        }
+
+        /**
+         * Lets the collection scans under 'node' be split among worker threads, unless the query
+         * asks for $natural order or uses a scan option the parallel scan doesn't support.  $where
+         * is left out because its JS scope can't be shared by the workers.
+         */
+        void allowParallelCollscan(const CanonicalQuery& query, QuerySolutionNode* node) {
+            if (STAGE_COLLSCAN == node->getType()) {
+                CollectionScanNode* csn = static_cast<CollectionScanNode*>(node);
+                const LiteParsedQuery& pq = query.getParsed();
+                csn->parallel = !csn->tailable
+                                && 0 == csn->maxScan
+                                && !hasNaturalOrder(pq.getSort())
+                                && !hasNaturalOrder(pq.getHint())
+                                && !QueryPlannerCommon::hasNode(query.root(),
+                                                                MatchExpression::WHERE);
+            }
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                allowParallelCollscan(query, node->children[i]);
+            }
+        }
     }  // namespace
 
     /**
@@ -164,82 +378,11 @@ namespace mongo {
             return Status::OK();
         }
 
-        // If it's not NULL, we may have indices.  Access the catalog and fill out IndexEntry(s)
         QueryPlannerParams plannerParams;
-
-        IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(false);
-        while (ii.more()) {
-            const IndexDescriptor* desc = ii.next();
-            plannerParams.indices.push_back(IndexEntry(desc->keyPattern(),
-                                                       desc->getAccessMethodName(),
-                                                       desc->isMultikey(),
-                                                       desc->isSparse(),
-                                                       desc->indexName(),
-                                                       desc->infoObj()));
-        }
-
-        // If query supports index filters, filter params.indices by indices in query settings.
-        QuerySettings* querySettings = collection->infoCache()->getQuerySettings();
-        AllowedIndices* allowedIndicesRaw;
-
-        // Filter index catalog if index filters are specified for query.
-        // Also, signal to planner that application hint should be ignored.
-        if (querySettings->getAllowedIndices(*canonicalQuery, &allowedIndicesRaw)) {
-            boost::scoped_ptr<AllowedIndices> allowedIndices(allowedIndicesRaw);
-            filterAllowedIndexEntries(*allowedIndices, &plannerParams.indices);
-            plannerParams.indexFiltersApplied = true;
-        }
-
-        // Tailable: If the query requests tailable the collection must be capped.
-        if (canonicalQuery->getParsed().hasOption(QueryOption_CursorTailable)) {
-            if (!collection->isCapped()) {
-                return Status(ErrorCodes::BadValue,
-                              "error processing query: " + canonicalQuery->toString() +
-                              " tailable cursor requested on non capped collection");
-            }
-
-            // If a sort is specified it must be equal to expectedSort.
-            const BSONObj expectedSort = BSON("$natural" << 1);
-            const BSONObj& actualSort = canonicalQuery->getParsed().getSort();
-            if (!actualSort.isEmpty() && !(actualSort == expectedSort)) {
-                return Status(ErrorCodes::BadValue,
-                              "error processing query: " + canonicalQuery->toString() +
-                              " invalid sort specified for tailable cursor: "
-                              + actualSort.toString());
-            }
-        }
-
-        // Process the planning options.
-        plannerParams.options = plannerOptions;
-        if (storageGlobalParams.noTableScan) {
-            const string& ns = canonicalQuery->ns();
-            // There are certain cases where we ignore this restriction:
-            bool ignore = canonicalQuery->getQueryObj().isEmpty()
-                          || (string::npos != ns.find(".system."))
-                          || (0 == ns.find("local."));
-            if (!ignore) {
-                plannerParams.options |= QueryPlannerParams::NO_TABLE_SCAN;
-            }
-        }
-
-        if (!(plannerParams.options & QueryPlannerParams::NO_TABLE_SCAN)) {
-            plannerParams.options |= QueryPlannerParams::INCLUDE_COLLSCAN;
-        }
-
-        // If the caller wants a shard filter, make sure we're actually sharded.
-        if (plannerParams.options & QueryPlannerParams::INCLUDE_SHARD_FILTER) {
-            CollectionMetadataPtr collMetadata =
-                shardingState.getCollectionMetadata(canonicalQuery->ns());
-
-            if (collMetadata) {
-                plannerParams.shardKey = collMetadata->getKeyPattern();
-            }
-            else {
-                // If there's no metadata don't bother w/the shard filter since we won't know what
-                // the key pattern is anyway...
-                plannerParams.options &= ~QueryPlannerParams::INCLUDE_SHARD_FILTER;
-            }
-        }
+        Status paramsStatus = fillOutPlannerParams(collection, *canonicalQuery, plannerOptions,
+                                                   &plannerParams);
+        if (!paramsStatus.isOK())
+            return paramsStatus;
 
         // Try to look up a cached solution for the query.
         //
@@ -291,6 +434,11 @@ namespace mongo {
                     }
                 }
 
+                if (NULL == backupQs
+                    && (plannerParams.options & QueryPlannerParams::PARALLEL_COLLSCAN)) {
+                    allowParallelCollscan(*canonicalQuery, qs->root.get());
+                }
+
                 WorkingSet* ws;
                 PlanStage* root;
                 verify(StageBuilder::build(*qs, &root, &ws));
@@ -305,6 +453,8 @@ namespace mongo {
                     cpr->setBackupPlan(backupQs, backupRoot, backupWs);
                 }
 
+                cpr->setReplanBudget(cs->decisionWorks, plannerOptions);
+
                 *out = cpr;
                 return Status::OK();
             }
@@ -337,29 +487,54 @@ namespace mongo {
         // See if one of our solutions is a fast count hack in disguise.
         if (plannerParams.options & QueryPlannerParams::PRIVATE_IS_COUNT) {
             for (size_t i = 0; i < solutions.size(); ++i) {
-                if (turnIxscanIntoCount(solutions[i])) {
-                    // Great, we can use solutions[i].  Clean up the other QuerySolution(s).
-                    for (size_t j = 0; j < solutions.size(); ++j) {
-                        if (j != i) {
-                            delete solutions[j];
-                        }
+                if (!turnIxscanIntoCount(solutions[i], true)) {
+                    continue;
+                }
+
+                // Great, we can use solutions[i].  Clean up the other QuerySolution(s).
+                for (size_t j = 0; j < solutions.size(); ++j) {
+                    if (j != i) {
+                        delete solutions[j];
                     }
+                }
 
-                    // We're not going to cache anything that's fast count.
-                    WorkingSet* ws;
-                    PlanStage* root;
-                    verify(StageBuilder::build(*solutions[i], &root, &ws));
-                    *out = new SingleSolutionRunner(collection,
-                                                    canonicalQuery.release(),
-                                                    solutions[i],
-                                                    root,
-                                                    ws);
-                    return Status::OK();
+                // We're not going to cache anything that's fast count.
+                WorkingSet* ws;
+                PlanStage* root;
+                verify(StageBuilder::build(*solutions[i], &root, &ws));
+                *out = new SingleSolutionRunner(collection,
+                                                canonicalQuery.release(),
+                                                solutions[i],
+                                                root,
+                                                ws);
+                return Status::OK();
+            }
+
+            // Failing that, keep the solutions that can count from the index without fetching.
+            // They are still ranked against each other unless only one is left.
+            vector<QuerySolution*> countingSolutions;
+            for (size_t i = 0; i < solutions.size(); ++i) {
+                if (turnIxscanIntoCount(solutions[i], false)) {
+                    countingSolutions.push_back(solutions[i]);
+                    solutions[i] = NULL;
+                }
+            }
+
+            if (!countingSolutions.empty()) {
+                for (size_t i = 0; i < solutions.size(); ++i) {
+                    delete solutions[i];
                 }
+                solutions.swap(countingSolutions);
             }
         }
 
         if (1 == solutions.size()) {
+            // A collection scan we don't have to race against anything can be split among
+            // threads.
+            if (plannerParams.options & QueryPlannerParams::PARALLEL_COLLSCAN) {
+                allowParallelCollscan(*canonicalQuery, solutions[0]->root.get());
+            }
+
             // Only one possible plan.  Run it.  Build the stages from the solution.
             WorkingSet* ws;
             PlanStage* root;
@@ -427,12 +602,15 @@ namespace mongo {
     namespace {
 
         /**
-         * Returns 'true' if the provided solution 'soln' can be rewritten to use
-         * a fast counting stage.  Mutates the tree in 'soln->root'.
+         * Returns 'true' if the provided solution 'soln' can be rewritten to count from an index
+         * without fetching anything: with the fast counting stage for a single interval, or
+         * otherwise with an index scan that tests any remaining predicates against the keys it
+         * walks.  Mutates the tree in 'soln->root'.  With 'singleIntervalOnly' only the fast
+         * counting stage will do.
          *
          * Otherwise, returns 'false'.
          */
-        bool turnIxscanIntoCount(QuerySolution* soln) {
+        bool turnIxscanIntoCount(QuerySolution* soln, bool singleIntervalOnly) {
             QuerySolutionNode* root = soln->root.get();
 
             // Root should be a fetch w/o any filters.
@@ -451,24 +629,33 @@ namespace mongo {
 
             IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
 
-            // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
-            // isSimpleRange here?  because we could well use it.  I just don't think we ever do see it.
-            if (NULL != isn->filter.get() || isn->bounds.isSimpleRange) {
-                return false;
-            }
-
             // Make sure the bounds are OK.
             BSONObj startKey;
             bool startKeyInclusive;
             BSONObj endKey;
             bool endKeyInclusive;
 
-            if (!IndexBoundsBuilder::isSingleInterval( isn->bounds,
-                                                       &startKey,
-                                                       &startKeyInclusive,
-                                                       &endKey,
-                                                       &endKeyInclusive )) {
-                return false;
+            // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
+            // isSimpleRange here?  because we could well use it.  I just don't think we ever do see it.
+            if (NULL != isn->filter.get()
+                || isn->bounds.isSimpleRange
+                || !IndexBoundsBuilder::isSingleInterval( isn->bounds,
+                                                          &startKey,
+                                                          &startKeyInclusive,
+                                                          &endKey,
+                                                          &endKeyInclusive )) {
+                if (singleIntervalOnly) {
+                    return false;
+                }
+
+                // Everything the fetch would have checked is in the bounds or the ixscan's
+                // filter, both of which only look at the key.  Drop the fetch and have the
+                // ixscan just count.
+                isn->countOnly = true;
+                root->children.clear();
+                // Deletes the old root, which no longer owns 'isn'.
+                soln->root.reset(isn);
+                return true;
             }
 
             // Make the count node that we replace the fetch + ixscan with.
@@ -610,7 +797,8 @@ namespace mongo {
                                                      hintObj,
                                                      &cq)); 
 
-        return getRunner(collection, cq, out, QueryPlannerParams::PRIVATE_IS_COUNT);
+        return getRunner(collection, cq, out, QueryPlannerParams::PRIVATE_IS_COUNT
+                                              | QueryPlannerParams::PARALLEL_COLLSCAN);
     }
 
     //
@@ -631,10 +819,9 @@ namespace mongo {
         if (STAGE_PROJECTION == root->getType() && (STAGE_IXSCAN == root->children[0]->getType())) {
             IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
 
-            // An additional filter must be applied to the data in the key, so we can't just skip
-            // all the keys with a given value; we must examine every one to find the one that (may)
-            // pass the filter.
-            if (NULL != isn->filter.get()) {
+            // An additional filter must be applied to the data in the key.  The distinct scan
+            // can test it, but only if each key holds the document's value for each field.
+            if (NULL != isn->filter.get() && isn->indexIsMultiKey) {
                 return false;
             }
 
@@ -651,6 +838,7 @@ namespace mongo {
             dn->indexKeyPattern = isn->indexKeyPattern;
             dn->direction = isn->direction;
             dn->bounds = isn->bounds;
+            dn->filter.swap(isn->filter);
 
             // Figure out which field we're skipping to the next value of.  TODO: We currently only
             // try to distinct-hack when there is an index prefixed by the field we're distinct-ing
@@ -673,6 +861,131 @@ namespace mongo {
         return false;
     }
 
+    /**
+     * Returns true if 'expr' can be answered from the value of one field of a non-multikey index
+     * key.  $exists and $type are left out because a missing field is indexed as null.
+     */
+    static bool isKeyTestable(const MatchExpression* expr) {
+        switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE:
+        case MatchExpression::MATCH_IN:
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * The planner only uses an index when there are predicates over its first field.  A distinct
+     * over the first field of {a: 1, b: 1} with a query on 'b' can still be answered by skipping
+     * through the 'a' values and looking at the 'b' bounds under each one.
+     *
+     * Builds such a DistinctNode over the smallest suitable index in 'indices' if every predicate
+     * in 'query' is over a field of that index.  Predicates the bounds express exactly become
+     * bounds; the rest become the node's filter.  Returns NULL if there is no such index.  Caller
+     * owns the returned node.
+     */
+    static DistinctNode* buildFilteredDistinctNode(const CanonicalQuery& query,
+                                                   const vector<IndexEntry>& indices) {
+        vector<MatchExpression*> predicates;
+        MatchExpression* root = query.root();
+        if (MatchExpression::AND == root->matchType()) {
+            for (size_t i = 0; i < root->numChildren(); ++i) {
+                predicates.push_back(root->getChild(i));
+            }
+        }
+        else {
+            predicates.push_back(root);
+        }
+
+        for (size_t i = 0; i < predicates.size(); ++i) {
+            if (!isKeyTestable(predicates[i])) {
+                return NULL;
+            }
+        }
+
+        auto_ptr<DistinctNode> best;
+        int minFields = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < indices.size(); ++i) {
+            const IndexEntry& index = indices[i];
+            if (!IndexNames::findPluginName(index.keyPattern).empty() || index.multikey) {
+                continue;
+            }
+
+            int nFields = index.keyPattern.nFields();
+            if (nFields >= minFields) {
+                continue;
+            }
+
+            auto_ptr<DistinctNode> dn(new DistinctNode());
+            dn->indexKeyPattern = index.keyPattern;
+            dn->direction = 1;
+            dn->fieldNo = 0;
+            dn->bounds.fields.resize(nFields);
+            BSONObjIterator kpIt(index.keyPattern);
+            for (int pos = 0; kpIt.more(); ++pos) {
+                dn->bounds.fields[pos].name = kpIt.next().fieldName();
+                dn->bounds.fields[pos].intervals.push_back(IndexBoundsBuilder::allValues());
+            }
+
+            auto_ptr<AndMatchExpression> residual(new AndMatchExpression());
+            bool usable = true;
+            for (size_t j = 0; j < predicates.size() && usable; ++j) {
+                const MatchExpression* pred = predicates[j];
+
+                BSONObjIterator it(index.keyPattern);
+                int pos = 0;
+                BSONElement keyElt;
+                while (it.more()) {
+                    keyElt = it.next();
+                    if (pred->path() == keyElt.fieldName()) {
+                        break;
+                    }
+                    ++pos;
+                }
+                if (pos == nFields) {
+                    usable = false;
+                    break;
+                }
+
+                IndexBoundsBuilder::BoundsTightness tightness;
+                IndexBoundsBuilder::translateAndIntersect(pred, keyElt, index,
+                                                          &dn->bounds.fields[pos], &tightness);
+                if (IndexBoundsBuilder::INEXACT_FETCH == tightness) {
+                    usable = false;
+                }
+                else if (IndexBoundsBuilder::INEXACT_COVERED == tightness) {
+                    residual->add(pred->shallowClone());
+                }
+            }
+
+            if (!usable) {
+                continue;
+            }
+
+            IndexBoundsBuilder::alignBounds(&dn->bounds, index.keyPattern);
+
+            if (1 == residual->numChildren()) {
+                dn->filter.reset(residual->getChild(0));
+                residual->clearAndRelease();
+            }
+            else if (residual->numChildren() > 1) {
+                dn->filter.reset(residual.release());
+            }
+
+            best = dn;
+            minFields = nFields;
+        }
+
+        return best.release();
+    }
+
     Status getRunnerDistinct(Collection* collection,
                              const BSONObj& query,
                              const string& field,
@@ -776,7 +1089,7 @@ namespace mongo {
         vector<QuerySolution*> solutions;
         status = QueryPlanner::plan(*cq, plannerParams, &solutions);
         if (!status.isOK()) {
-            return getRunner(cq, out);
+            solutions.clear();
         }
 
         // We look for a solution that has an ixscan we can turn into a distinctixscan
@@ -798,13 +1111,30 @@ namespace mongo {
             }
         }
 
-        // If we're here, the planner made a soln with the restricted index set but we couldn't
-        // translate any of them into a distinct-compatible soln.  So, delete the solutions and just
-        // go through normal planning.
+        // If we're here, the planner couldn't make a soln with the restricted index set that we
+        // could translate into a distinct-compatible soln.
         for (size_t i = 0; i < solutions.size(); ++i) {
             delete solutions[i];
         }
 
+        // The predicates may still all be over fields of an index prefixed by the distinct field,
+        // just not over its prefix.
+        DistinctNode* dn = buildFilteredDistinctNode(*cq, plannerParams.indices);
+        if (NULL != dn) {
+            QueryPlannerParams params;
+
+            // Takes ownership of 'dn'.
+            QuerySolution* soln = QueryPlannerAnalysis::analyzeDataAccess(*cq, params, dn);
+            verify(soln);
+
+            WorkingSet* ws;
+            PlanStage* root;
+            verify(StageBuilder::build(*soln, &root, &ws));
+            *out = new SingleSolutionRunner(collection, cq, soln, root, ws);
+            return Status::OK();
+        }
+
+        // Go through normal planning.
         return getRunner(cq, out);
     }
 
@@ -44,6 +44,22 @@ namespace mongo {
                                    std::vector<IndexEntry>* indexEntries);
 
 
+    /**
+     * Returns true if every indexed plan the planner considers for 'canonicalQuery' over
+     * 'collection' produces its results ordered on 'field' without a blocking sort, and fills out
+     * '*sortOut' with that order ({field: 1} or {field: -1}).  Plans are not guaranteed to keep an
+     * order they weren't asked for, so callers that depend on it must run the query with
+     * '*sortOut' as its sort, which rules out the collection scan.
+     *
+     * Returns false if 'collection' is NULL, if 'canonicalQuery' already has a sort, if there is
+     * no indexed plan, or if any indexed plan reads a multikey index.
+     */
+    bool getProvidedSortOnField(Collection* collection,
+                                const CanonicalQuery& canonicalQuery,
+                                const std::string& field,
+                                size_t plannerOptions,
+                                BSONObj* sortOut);
+
     /**
      * Get a runner for a query.  Takes ownership of rawCanonicalQuery.
      *
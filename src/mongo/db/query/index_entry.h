@@ -28,6 +28,7 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
 #include <string>
 
 #include "mongo/db/index_names.h"
@@ -35,6 +36,8 @@
 
 namespace mongo {
 
+    struct IndexStats;
+
     /**
      * This name sucks, but every name involving 'index' is used somewhere.
      */
@@ -102,6 +105,10 @@ namespace mongo {
         // by the keyPattern?)
         IndexType type;
 
+        // What the index's keys looked like when they were last sampled.  NULL if they haven't
+        // been yet.
+        boost::shared_ptr<const IndexStats> stats;
+
         std::string toString() const {
             mongoutils::str::stream ss;
             ss << "kp: "  << keyPattern.toString();
@@ -0,0 +1,172 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/index_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+    namespace {
+
+        bool sampleLessThan(const BSONObj& sample, const BSONElement& value) {
+            return sample.firstElement().woCompare(value, false) < 0;
+        }
+
+        bool valueLessThanSample(const BSONElement& value, const BSONObj& sample) {
+            return value.woCompare(sample.firstElement(), false) < 0;
+        }
+
+    }  // namespace
+
+    double IndexStats::estimateKeys(const OrderedIntervalList& oil) const {
+        if (0 == numKeys || samples.empty()) {
+            return 0;
+        }
+
+        const double keysPerSample = static_cast<double>(numKeys) / samples.size();
+        const double keysPerValue =
+            static_cast<double>(numKeys) / std::max(distinctLeadingValues, 1LL);
+
+        double total = 0;
+        for (size_t i = 0; i < oil.intervals.size(); ++i) {
+            const Interval& interval = oil.intervals[i];
+            if (interval.isNull()) {
+                continue;
+            }
+
+            // Intervals are in index order, samples are ascending.
+            BSONElement low = interval.start;
+            BSONElement high = interval.end;
+            bool lowInclusive = interval.startInclusive;
+            bool highInclusive = interval.endInclusive;
+            if (low.woCompare(high, false) > 0) {
+                std::swap(low, high);
+                std::swap(lowInclusive, highInclusive);
+            }
+
+            std::vector<BSONObj>::const_iterator first = lowInclusive
+                ? std::lower_bound(samples.begin(), samples.end(), low, sampleLessThan)
+                : std::upper_bound(samples.begin(), samples.end(), low, valueLessThanSample);
+            std::vector<BSONObj>::const_iterator last = highInclusive
+                ? std::upper_bound(samples.begin(), samples.end(), high, valueLessThanSample)
+                : std::lower_bound(samples.begin(), samples.end(), high, sampleLessThan);
+
+            double estimate = (last > first) ? (last - first) * keysPerSample : 0;
+
+            if (interval.isPoint()) {
+                // A value that isn't common enough to be sampled is assumed to be average.
+                estimate = std::max(estimate, keysPerValue);
+            }
+            else {
+                // The range may fall between two samples.
+                estimate = std::max(estimate, keysPerSample / 2);
+            }
+
+            total += estimate;
+        }
+
+        return std::min(total, static_cast<double>(numKeys));
+    }
+
+    IndexStatsBuilder::IndexStatsBuilder(size_t maxSamples, int direction)
+        : _maxSamples(std::max(maxSamples, static_cast<size_t>(1))),
+          _direction(direction),
+          _numKeys(0),
+          _distinct(0),
+          _singletons(0),
+          _runLength(0),
+          _stride(1) { }
+
+    void IndexStatsBuilder::addKey(const BSONObj& key) {
+        BSONElement value = key.firstElement();
+
+        if (_lastValue.isEmpty() || 0 != _lastValue.firstElement().woCompare(value, false)) {
+            BSONObjBuilder bob;
+            bob.appendAs(value, "");
+            _lastValue = bob.obj();
+            ++_distinct;
+
+            if (1 == _runLength) {
+                ++_singletons;
+            }
+            _runLength = 0;
+        }
+        ++_runLength;
+
+        if (0 == _numKeys % _stride) {
+            _samples.push_back(_lastValue);
+
+            if (_samples.size() >= 2 * _maxSamples) {
+                // Keep every other sample.
+                for (size_t i = 0; 2 * i < _samples.size(); ++i) {
+                    _samples[i] = _samples[2 * i];
+                }
+                _samples.resize((_samples.size() + 1) / 2);
+                _stride *= 2;
+            }
+        }
+
+        ++_numKeys;
+    }
+
+    IndexStats* IndexStatsBuilder::done(long long collectionRecords) {
+        IndexStats* stats = new IndexStats();
+        stats->numKeys = _numKeys;
+        stats->distinctLeadingValues = _distinct;
+        stats->collectionRecords = collectionRecords;
+        stats->samples.swap(_samples);
+        if (_direction < 0) {
+            std::reverse(stats->samples.begin(), stats->samples.end());
+        }
+        return stats;
+    }
+
+    IndexStats* IndexStatsBuilder::doneSampled(long long numKeys, long long collectionRecords) {
+        const long long sampled = _numKeys;
+        const long long singletons = _singletons + (1 == _runLength ? 1 : 0);
+
+        IndexStats* stats = done(collectionRecords);
+        if (0 == sampled) {
+            return stats;
+        }
+        stats->numKeys = std::max(numKeys, sampled);
+
+        // Values seen more than once are likely common ones, and there are few others like
+        // them.  Each value seen once stands for up to sqrt(numKeys / sampled) unseen ones (the
+        // GEE estimator of Charikar et al.).
+        double scale = std::sqrt(static_cast<double>(stats->numKeys) / sampled);
+        double distinct = (stats->distinctLeadingValues - singletons) + singletons * scale;
+        stats->distinctLeadingValues = std::min(static_cast<long long>(distinct), stats->numKeys);
+        return stats;
+    }
+
+}  // namespace mongo
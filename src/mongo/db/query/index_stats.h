@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    struct OrderedIntervalList;
+
+    /**
+     * What an index's keys look like, gathered by walking the whole index or from a random
+     * sample of its keys.  Only the leading field is described: its values are what index bounds narrow first, so they decide most
+     * of how many keys a scan examines.
+     *
+     * The query planner uses these to estimate how many keys a candidate plan examines.  See
+     * QueryPlannerParams::pruneRatio.
+     */
+    struct IndexStats {
+        IndexStats() : numKeys(0), distinctLeadingValues(0), collectionRecords(0) { }
+
+        /**
+         * Estimates how many keys in the index have a leading value within 'oil'.
+         */
+        double estimateKeys(const OrderedIntervalList& oil) const;
+
+        // How many keys the index had.
+        long long numKeys;
+
+        // How many different leading values those keys had.
+        long long distinctLeadingValues;
+
+        // Leading values of evenly spaced keys, ascending, so each one stands for about
+        // numKeys / samples.size() keys.  Each is a one field object with an empty name.
+        std::vector<BSONObj> samples;
+
+        // How many records the collection had, so the stats can tell when they're out of date.
+        long long collectionRecords;
+    };
+
+    /**
+     * Builds IndexStats from an index's keys, fed to it in index order, or from a random sample
+     * of them sorted the same way.
+     */
+    class IndexStatsBuilder {
+    public:
+        /**
+         * Keeps between 'maxSamples' and twice that many samples.  'direction' is the direction
+         * of the index's leading field.
+         */
+        IndexStatsBuilder(size_t maxSamples, int direction);
+
+        void addKey(const BSONObj& key);
+
+        long long numKeys() const { return _numKeys; }
+
+        /**
+         * Caller owns the result.  The builder can't be used afterwards.
+         */
+        IndexStats* done(long long collectionRecords);
+
+        /**
+         * Like done(), for keys that were a random sample of an index of about 'numKeys' keys.
+         * The number of distinct leading values is scaled up from the sample.
+         */
+        IndexStats* doneSampled(long long numKeys, long long collectionRecords);
+
+    private:
+        size_t _maxSamples;
+        int _direction;
+
+        long long _numKeys;
+        long long _distinct;
+
+        // How many values were seen only once, and how many times the last value was seen.
+        long long _singletons;
+        long long _runLength;
+
+        // We keep the leading value of every _stride'th key.  The stride doubles whenever we
+        // have too many samples.
+        long long _stride;
+        std::vector<BSONObj> _samples;
+
+        BSONObj _lastValue;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,180 @@
+/**
+ *    Copyright (C) 2013 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/index_stats.h"
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/unittest/unittest.h"
+
+namespace {
+
+    using boost::scoped_ptr;
+    using mongo::BSONObj;
+    using mongo::IndexStats;
+    using mongo::IndexStatsBuilder;
+    using mongo::Interval;
+    using mongo::OrderedIntervalList;
+
+    // Keys 0, 1, ... numKeys - 1, each repeated 'dups' times, in the index order of 'direction'.
+    IndexStats* buildStats(int numKeys, int dups, int direction, size_t maxSamples = 100) {
+        IndexStatsBuilder builder(maxSamples, direction);
+        for (int i = 0; i < numKeys; ++i) {
+            int value = (direction > 0) ? i : numKeys - 1 - i;
+            for (int j = 0; j < dups; ++j) {
+                builder.addKey(BSON("" << value << "" << j));
+            }
+        }
+        return builder.done(numKeys * dups);
+    }
+
+    OrderedIntervalList oil(const BSONObj& bounds, bool startInclusive, bool endInclusive) {
+        OrderedIntervalList list("a");
+        list.intervals.push_back(Interval(bounds, startInclusive, endInclusive));
+        return list;
+    }
+
+    TEST(IndexStatsBuilder, CountsKeysAndValues) {
+        scoped_ptr<IndexStats> stats(buildStats(1000, 3, 1));
+        ASSERT_EQUALS(3000, stats->numKeys);
+        ASSERT_EQUALS(1000, stats->distinctLeadingValues);
+        ASSERT_EQUALS(3000, stats->collectionRecords);
+    }
+
+    TEST(IndexStatsBuilder, BoundsSamples) {
+        scoped_ptr<IndexStats> stats(buildStats(100000, 1, 1, 50));
+        ASSERT_GREATER_THAN_OR_EQUALS(stats->samples.size(), 50U);
+        ASSERT_LESS_THAN(stats->samples.size(), 100U);
+        ASSERT_EQUALS(0, stats->samples[0].firstElement().numberInt());
+
+        // Evenly spaced.
+        int step = stats->samples[1].firstElement().numberInt();
+        for (size_t i = 1; i < stats->samples.size(); ++i) {
+            ASSERT_EQUALS(static_cast<int>(i) * step, stats->samples[i].firstElement().numberInt());
+        }
+    }
+
+    TEST(IndexStatsBuilder, SmallIndexKeepsEveryKey) {
+        scoped_ptr<IndexStats> stats(buildStats(10, 1, 1));
+        ASSERT_EQUALS(10U, stats->samples.size());
+    }
+
+    TEST(IndexStatsBuilder, DescendingSamplesAreAscending) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 1, -1));
+        for (size_t i = 1; i < stats->samples.size(); ++i) {
+            ASSERT_LESS_THAN(stats->samples[i - 1].firstElement().numberInt(),
+                             stats->samples[i].firstElement().numberInt());
+        }
+    }
+
+    TEST(IndexStatsBuilder, SampledScalesKeys) {
+        // Every thousandth key of an index of a million distinct values.
+        IndexStatsBuilder builder(100, 1);
+        for (int i = 0; i < 1000; ++i) {
+            builder.addKey(BSON("" << i * 1000));
+        }
+        scoped_ptr<IndexStats> stats(builder.doneSampled(1000000, 1000000));
+        ASSERT_EQUALS(1000000, stats->numKeys);
+        ASSERT_GREATER_THAN(stats->distinctLeadingValues, 1000);
+        ASSERT_LESS_THAN_OR_EQUALS(stats->distinctLeadingValues, 1000000);
+
+        double estimate = stats->estimateKeys(oil(BSON("" << 200000 << "" << 400000), true, false));
+        ASSERT_APPROX_EQUAL(200000, estimate, 20000);
+    }
+
+    TEST(IndexStatsBuilder, SampledFewValues) {
+        // Ten values, each seen many times, are probably all there is.
+        IndexStatsBuilder builder(100, 1);
+        for (int i = 0; i < 10; ++i) {
+            for (int j = 0; j < 100; ++j) {
+                builder.addKey(BSON("" << i));
+            }
+        }
+        scoped_ptr<IndexStats> stats(builder.doneSampled(50000, 50000));
+        ASSERT_EQUALS(50000, stats->numKeys);
+        ASSERT_EQUALS(10, stats->distinctLeadingValues);
+    }
+
+    TEST(IndexStatsEstimate, Empty) {
+        IndexStats stats;
+        ASSERT_EQUALS(0, stats.estimateKeys(oil(BSON("" << 1 << "" << 1), true, true)));
+    }
+
+    TEST(IndexStatsEstimate, Point) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 5, 1));
+        double estimate = stats->estimateKeys(oil(BSON("" << 42 << "" << 42), true, true));
+        ASSERT_APPROX_EQUAL(5, estimate, 1);
+    }
+
+    TEST(IndexStatsEstimate, Range) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 1, 1));
+        double estimate = stats->estimateKeys(oil(BSON("" << 2000 << "" << 4000), true, false));
+        ASSERT_APPROX_EQUAL(2000, estimate, 200);
+    }
+
+    TEST(IndexStatsEstimate, DescendingRange) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 1, -1));
+        double estimate = stats->estimateKeys(oil(BSON("" << 4000 << "" << 2000), false, true));
+        ASSERT_APPROX_EQUAL(2000, estimate, 200);
+    }
+
+    TEST(IndexStatsEstimate, RangeOutsideValues) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 1, 1));
+        double estimate = stats->estimateKeys(oil(BSON("" << 20000 << "" << 30000), true, true));
+        ASSERT_LESS_THAN(estimate, 200);
+    }
+
+    TEST(IndexStatsEstimate, CommonValue) {
+        // Half the keys have the value 0.
+        IndexStatsBuilder builder(100, 1);
+        for (int i = 0; i < 5000; ++i) {
+            builder.addKey(BSON("" << 0));
+        }
+        for (int i = 1; i <= 5000; ++i) {
+            builder.addKey(BSON("" << i));
+        }
+        scoped_ptr<IndexStats> stats(builder.done(10000));
+
+        double common = stats->estimateKeys(oil(BSON("" << 0 << "" << 0), true, true));
+        ASSERT_APPROX_EQUAL(5000, common, 500);
+
+        double rare = stats->estimateKeys(oil(BSON("" << 77 << "" << 77), true, true));
+        ASSERT_LESS_THAN(rare, 10);
+    }
+
+    TEST(IndexStatsEstimate, SeveralIntervals) {
+        scoped_ptr<IndexStats> stats(buildStats(10000, 1, 1));
+        OrderedIntervalList list("a");
+        list.intervals.push_back(Interval(BSON("" << 1000 << "" << 2000), true, false));
+        list.intervals.push_back(Interval(BSON("" << 5000 << "" << 6000), true, false));
+        ASSERT_APPROX_EQUAL(2000, stats->estimateKeys(list), 300);
+    }
+
+}  // namespace
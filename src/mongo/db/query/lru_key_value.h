@@ -141,19 +141,47 @@ namespace mongo {
                 return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
             }
             KVListIt found = i->second;
-            V* foundEntry = found->second;
 
             // Promote the kv-store entry to the front of the list.
             // It is now the most recently used.
-            _kvMap.erase(i);
-            _kvList.erase(found);
-            _kvList.push_front(std::make_pair(key, foundEntry));
-            _kvMap[key] = _kvList.begin();
+            _kvList.splice(_kvList.begin(), _kvList, found);
+
+            *entryOut = found->second;
+            return Status::OK();
+        }
 
-            *entryOut = foundEntry;
+        /**
+         * Like get(), but leaves the order of use unchanged. As this doesn't
+         * modify the kv-store, concurrent calls to peek(), hasKey() and size()
+         * are safe as long as no other operation runs at the same time.
+         */
+        Status peek(const K& key, V** entryOut) const {
+            KVMapConstIt i = _kvMap.find(key);
+            if (i == _kvMap.end()) {
+                return Status(ErrorCodes::NoSuchKey, "no such key in LRU key-value store");
+            }
+            *entryOut = i->second->second;
             return Status::OK();
         }
 
+        /**
+         * Makes the entry keyed by 'key' the most recently used, without
+         * returning it.
+         */
+        Status promote(const K& key) {
+            V* unused;
+            return get(key, &unused);
+        }
+
+        /**
+         * Returns the least recently used (K, V*) pair, which is the next one
+         * to be evicted. The kv-store must not be empty.
+         */
+        const KVListEntry& leastRecentlyUsed() const {
+            invariant(!_kvList.empty());
+            return _kvList.back();
+        }
+
         /**
          * Remove the kv-store entry keyed by 'key'.
          */
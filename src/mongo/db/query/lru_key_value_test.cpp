@@ -194,4 +194,31 @@ namespace {
         ASSERT(i == cache.end());
     }
 
+    /**
+     * Test that peek() finds entries without promoting them, and that promote()
+     * and leastRecentlyUsed() change and report the eviction order.
+     */
+    TEST(LRUKeyValueTest, PeekPromoteTest) {
+        LRUKeyValue<int, int> cache(3);
+        cache.add(1, new int(1));
+        cache.add(2, new int(2));
+        cache.add(3, new int(3));
+        ASSERT_EQUALS(cache.leastRecentlyUsed().first, 1);
+
+        int* value = NULL;
+        ASSERT_OK(cache.peek(1, &value));
+        ASSERT_EQUALS(*value, 1);
+        ASSERT_NOT_OK(cache.peek(4, &value));
+        ASSERT_EQUALS(cache.leastRecentlyUsed().first, 1);
+
+        ASSERT_OK(cache.promote(1));
+        ASSERT_NOT_OK(cache.promote(4));
+        ASSERT_EQUALS(cache.leastRecentlyUsed().first, 2);
+
+        std::auto_ptr<int> evicted = cache.add(4, new int(4));
+        ASSERT(NULL != evicted.get());
+        ASSERT_EQUALS(*evicted, 2);
+        assertInKVStore(cache, 1, 1);
+    }
+
 }  // namespace
@@ -141,6 +141,8 @@ namespace mongo {
             _bestPlan->invalidate(dl, type);
             for (list<WorkingSetID>::iterator it = _alreadyProduced.begin();
                  it != _alreadyProduced.end();) {
+                // A counting plan's results carry no member.
+                if (WorkingSet::INVALID_ID == *it) { ++it; continue; }
                 WorkingSetMember* member = _bestPlan->getWorkingSet()->get(*it);
                 if (member->hasLoc() && member->loc == dl) {
                     list<WorkingSetID>::iterator next = it;
@@ -158,6 +160,7 @@ namespace mongo {
                 _backupPlan->invalidate(dl, type);
                 for (list<WorkingSetID>::iterator it = _backupAlreadyProduced.begin();
                         it != _backupAlreadyProduced.end();) {
+                    if (WorkingSet::INVALID_ID == *it) { ++it; continue; }
                     WorkingSetMember* member = _backupPlan->getWorkingSet()->get(*it);
                     if (member->hasLoc() && member->loc == dl) {
                         list<WorkingSetID>::iterator next = it;
@@ -178,6 +181,7 @@ namespace mongo {
                 _candidates[i].root->invalidate(dl, type);
                 for (list<WorkingSetID>::iterator it = _candidates[i].results.begin();
                      it != _candidates[i].results.end();) {
+                    if (WorkingSet::INVALID_ID == *it) { ++it; continue; }
                     WorkingSetMember* member = _candidates[i].ws->get(*it);
                     if (member->hasLoc() && member->loc == dl) {
                         list<WorkingSetID>::iterator next = it;
@@ -231,6 +235,13 @@ namespace mongo {
             WorkingSetID id = _alreadyProduced.front();
             _alreadyProduced.pop_front();
 
+            // Counting plans advance without a result, see PlanExecutor.
+            if (WorkingSet::INVALID_ID == id) {
+                invariant(NULL == objOut);
+                invariant(NULL == dlOut);
+                return Runner::RUNNER_ADVANCED;
+            }
+
             WorkingSetMember* member = _bestPlan->getWorkingSet()->get(id);
 
             // Note that this copies code from PlanExecutor.
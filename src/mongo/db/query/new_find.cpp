@@ -435,7 +435,7 @@ namespace mongo {
         }
         else {
             // Takes ownership of cq.
-            size_t options = QueryPlannerParams::DEFAULT;
+            size_t options = QueryPlannerParams::PARALLEL_COLLSCAN;
             if (shardingState.needCollectionMetadata(pq.ns())) {
                 options |= QueryPlannerParams::INCLUDE_SHARD_FILTER;
             }
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <math.h>
 #include <memory>
+#include "boost/functional/hash.hpp"
 #include "boost/thread/locks.hpp"
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/query/plan_ranker.h"
@@ -44,6 +45,8 @@ namespace mongo {
 
     const int PlanCache::kMaxCacheSize = 200;
 
+    const size_t PlanCache::kMaxShapeStatsPerShard = 4 * (kMaxCacheSize / kNumShards);
+
     //
     // Cache-related functions for CanonicalQuery
     //
@@ -87,6 +90,7 @@ namespace mongo {
         : plannerData(entry.plannerData.size()),
           backupSoln(entry.backupSoln),
           key(key),
+          decisionWorks(0),
           query(entry.query.getOwned()),
           sort(entry.sort.getOwned()),
           projection(entry.projection.getOwned()) {
@@ -96,6 +100,14 @@ namespace mongo {
             verify(entry.plannerData[i]);
             plannerData[i] = entry.plannerData[i]->clone();
         }
+
+        // If the trial ended before the winner got anywhere, we don't know what it costs.
+        if (NULL != entry.decision.get() && !entry.decision->stats.empty()) {
+            const CommonStats& winner = entry.decision->stats.vector()[0]->common;
+            if (winner.advanced > 0 || winner.isEOF) {
+                decisionWorks = winner.works;
+            }
+        }
     }
 
     CachedSolution::~CachedSolution() {
@@ -161,6 +173,7 @@ namespace mongo {
         }
         entry->averageScore = averageScore;
         entry->stddevScore = stddevScore;
+        entry->shapeStats = shapeStats;
         return entry;
     }
 
@@ -273,12 +286,43 @@ namespace mongo {
     // PlanCache
     //
 
-    PlanCache::PlanCache() : _cache(kMaxCacheSize) { }
+    PlanCache::Shard::Shard() : cache(kMaxCacheSize / kNumShards) { }
 
-    PlanCache::PlanCache(const std::string& ns) : _cache(kMaxCacheSize), _ns(ns) { }
+    PlanCache::PlanCache() { }
+
+    PlanCache::PlanCache(const std::string& ns) : _ns(ns) { }
 
     PlanCache::~PlanCache() { }
 
+    PlanCache::Shard& PlanCache::_shardFor(const PlanCacheKey& key) const {
+        return _shards[boost::hash<PlanCacheKey>()(key) % kNumShards];
+    }
+
+    // static
+    boost::shared_ptr<PlanCacheShapeStats> PlanCache::_getShapeStats(Shard* shard,
+                                                                     const PlanCacheKey& key) {
+        boost::shared_ptr<PlanCacheShapeStats>& stats = shard->shapeStats[key];
+        if (stats) {
+            return stats;
+        }
+        stats.reset(new PlanCacheShapeStats());
+
+        // Queries that never get a cached plan still leave counters behind.  Once there are too
+        // many, forget the ones for shapes that have no entry.
+        if (shard->shapeStats.size() > kMaxShapeStatsPerShard) {
+            for (ShapeStatsMap::iterator i = shard->shapeStats.begin();
+                 i != shard->shapeStats.end();) {
+                if (i->first != key && !shard->cache.hasKey(i->first)) {
+                    i = shard->shapeStats.erase(i);
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+        return stats;
+    }
+
     Status PlanCache::add(const CanonicalQuery& query, const std::vector<QuerySolution*>& solns,
                           PlanRankingDecision* why) {
         invariant(why);
@@ -319,10 +363,28 @@ namespace mongo {
             }
         }
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        std::auto_ptr<PlanCacheEntry> evictedEntry = _cache.add(query.getPlanCacheKey(), entry);
+        const PlanCacheKey& key = query.getPlanCacheKey();
+        Shard& shard = _shardFor(key);
+        boost::lock_guard<boost::shared_mutex> cacheLock(shard.mutex);
+        entry->shapeStats = _getShapeStats(&shard, key);
+
+        // Entries that were looked up since they were last passed over get another round
+        // before being evicted.
+        const size_t shardSize = kMaxCacheSize / kNumShards;
+        for (size_t i = 0; shard.cache.size() >= shardSize && i < shard.cache.size(); ++i) {
+            const PlanCacheEntry* lru = shard.cache.leastRecentlyUsed().second;
+            if (!lru->recentlyUsed.load()) {
+                break;
+            }
+            lru->recentlyUsed.store(0);
+            PlanCacheKey lruKey = shard.cache.leastRecentlyUsed().first;
+            shard.cache.promote(lruKey);
+        }
+
+        std::auto_ptr<PlanCacheEntry> evictedEntry = shard.cache.add(key, entry);
 
         if (NULL != evictedEntry.get()) {
+            evictedEntry->shapeStats->evictions.fetchAndAdd(1);
             LOG(1) << _ns << ": plan cache maximum size exceeded - "
                    << "removed least recently used entry "
                    << evictedEntry->toString();
@@ -334,18 +396,35 @@ namespace mongo {
     Status PlanCache::get(const CanonicalQuery& query, CachedSolution** crOut) const {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(crOut);
+        Shard& shard = _shardFor(key);
+
+        Status cacheStatus(Status::OK());
+        {
+            boost::shared_lock<boost::shared_mutex> cacheLock(shard.mutex);
+            PlanCacheEntry* entry;
+            cacheStatus = shard.cache.peek(key, &entry);
+            if (cacheStatus.isOK()) {
+                invariant(entry);
+                // Avoid writing to the entry's cache line when the flag is already set.
+                if (!entry->recentlyUsed.load()) {
+                    entry->recentlyUsed.store(1);
+                }
+                entry->shapeStats->hits.fetchAndAdd(1);
+                *crOut = new CachedSolution(key, *entry);
+                return Status::OK();
+            }
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
-        if (!cacheStatus.isOK()) {
-            return cacheStatus;
+            ShapeStatsMap::const_iterator stats = shard.shapeStats.find(key);
+            if (stats != shard.shapeStats.end()) {
+                stats->second->misses.fetchAndAdd(1);
+                return cacheStatus;
+            }
         }
-        invariant(entry);
-
-        *crOut = new CachedSolution(key, *entry);
 
-        return Status::OK();
+        // First miss for this shape.
+        boost::lock_guard<boost::shared_mutex> cacheLock(shard.mutex);
+        _getShapeStats(&shard, key)->misses.fetchAndAdd(1);
+        return cacheStatus;
     }
 
     // TODO: Figure out what the right policy is here for determining if the cached solution is bad.
@@ -399,10 +478,11 @@ namespace mongo {
         }
         std::auto_ptr<PlanCacheEntryFeedback> autoFeedback(feedback);
         const PlanCacheKey& ck = cq.getPlanCacheKey();
+        Shard& shard = _shardFor(ck);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        boost::lock_guard<boost::shared_mutex> cacheLock(shard.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(ck, &entry);
+        Status cacheStatus = shard.cache.get(ck, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -414,7 +494,7 @@ namespace mongo {
             if (hasCachedPlanPerformanceDegraded(entry, autoFeedback.get())) {
                 LOG(1) << _ns << ": removing plan cache entry " << entry->toString()
                        << " - detected degradation in performance of cached solution.";
-                _cache.remove(ck);
+                shard.cache.remove(ck);
             }
         }
         else {
@@ -426,23 +506,38 @@ namespace mongo {
     }
 
     Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.remove(canonicalQuery.getPlanCacheKey());
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        Shard& shard = _shardFor(key);
+        boost::lock_guard<boost::shared_mutex> cacheLock(shard.mutex);
+        return shard.cache.remove(key);
+    }
+
+    Status PlanCache::removeForReplan(const CanonicalQuery& canonicalQuery) {
+        const PlanCacheKey& key = canonicalQuery.getPlanCacheKey();
+        Shard& shard = _shardFor(key);
+        boost::lock_guard<boost::shared_mutex> cacheLock(shard.mutex);
+        _getShapeStats(&shard, key)->replans.fetchAndAdd(1);
+        return shard.cache.remove(key);
     }
 
     void PlanCache::clear() {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        _cache.clear();
+        // The shape counters outlive the entries, as clear() runs every
+        // kPlanCacheMaxWriteOperations writes.
+        for (size_t i = 0; i < kNumShards; ++i) {
+            boost::lock_guard<boost::shared_mutex> cacheLock(_shards[i].mutex);
+            _shards[i].cache.clear();
+        }
         _writeOperations.store(0);
     }
 
     Status PlanCache::getEntry(const CanonicalQuery& query, PlanCacheEntry** entryOut) const {
         const PlanCacheKey& key = query.getPlanCacheKey();
         verify(entryOut);
+        Shard& shard = _shardFor(key);
 
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
+        boost::shared_lock<boost::shared_mutex> cacheLock(shard.mutex);
         PlanCacheEntry* entry;
-        Status cacheStatus = _cache.get(key, &entry);
+        Status cacheStatus = shard.cache.peek(key, &entry);
         if (!cacheStatus.isOK()) {
             return cacheStatus;
         }
@@ -454,25 +549,34 @@ namespace mongo {
     }
 
     std::vector<PlanCacheEntry*> PlanCache::getAllEntries() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
         std::vector<PlanCacheEntry*> entries;
         typedef std::list< std::pair<PlanCacheKey, PlanCacheEntry*> >::const_iterator ConstIterator;
-        for (ConstIterator i = _cache.begin(); i != _cache.end(); i++) {
-            PlanCacheEntry* entry = i->second;
-            entries.push_back(entry->clone());
+        for (size_t i = 0; i < kNumShards; ++i) {
+            const Shard& shard = _shards[i];
+            boost::shared_lock<boost::shared_mutex> cacheLock(shard.mutex);
+            for (ConstIterator j = shard.cache.begin(); j != shard.cache.end(); j++) {
+                PlanCacheEntry* entry = j->second;
+                entries.push_back(entry->clone());
+            }
         }
 
         return entries;
     }
 
     bool PlanCache::contains(const CanonicalQuery& cq) const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.hasKey(cq.getPlanCacheKey());
+        const PlanCacheKey& key = cq.getPlanCacheKey();
+        Shard& shard = _shardFor(key);
+        boost::shared_lock<boost::shared_mutex> cacheLock(shard.mutex);
+        return shard.cache.hasKey(key);
     }
 
     size_t PlanCache::size() const {
-        boost::lock_guard<boost::mutex> cacheLock(_cacheMutex);
-        return _cache.size();
+        size_t size = 0;
+        for (size_t i = 0; i < kNumShards; ++i) {
+            boost::shared_lock<boost::shared_mutex> cacheLock(_shards[i].mutex);
+            size += _shards[i].cache.size();
+        }
+        return size;
     }
 
     void PlanCache::notifyOfWriteOp() {
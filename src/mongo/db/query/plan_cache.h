@@ -30,7 +30,9 @@
 
 #include <set>
 #include <boost/optional/optional.hpp>
-#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/query/canonical_query.h"
@@ -61,6 +63,25 @@ namespace mongo {
     // TODO: Replace with opaque type.
     typedef std::string PlanID;
 
+    /**
+     * Lookup counters for one query shape.  The cache keeps them while the shape's entry comes
+     * and goes, and planCacheListQueryShapes reports them.
+     */
+    struct PlanCacheShapeStats {
+        // Lookups that found a cached plan.
+        AtomicInt64 hits;
+
+        // Lookups that found no cached plan, so the query was planned from scratch.
+        AtomicInt64 misses;
+
+        // Times the shape's entry was evicted to make room for another shape.
+        AtomicInt64 evictions;
+
+        // Times a query abandoned the cached plan part way through because it was doing far
+        // more work than when it was chosen.
+        AtomicInt64 replans;
+    };
+
     /**
      * A PlanCacheIndexTree is the meaty component of the data
      * stored in SolutionCacheData. It is a tree structure with
@@ -186,6 +207,10 @@ namespace mongo {
         // Key used to provide feedback on the entry.
         PlanCacheKey key;
 
+        // How many times the winning plan was worked while it was being ranked.  0 if unknown,
+        // as when the ranking stopped before the winner produced anything.
+        size_t decisionWorks;
+
         // For debugging.
         std::string toString() const;
 
@@ -272,6 +297,17 @@ namespace mongo {
         // Must be positive. TODO how do we tune this?
         static const double kStdDevThreshold;
 
+        //
+        // Usage
+        //
+
+        // Counters for the query shape.  Shared with the cache, so copies made by clone() read
+        // the current values.  NULL for entries that were never added to a cache.
+        boost::shared_ptr<PlanCacheShapeStats> shapeStats;
+
+        // Set by lookups and cleared when the entry is passed over for eviction.  Lookups only
+        // hold the cache lock shared, so they mark the entry instead of reordering the LRU list.
+        mutable AtomicUInt32 recentlyUsed;
     };
 
     /**
@@ -361,6 +397,12 @@ namespace mongo {
          */
         Status remove(const CanonicalQuery& canonicalQuery);
 
+        /**
+         * Like remove(), for when a query gave up on the cached plan for 'canonicalQuery' and is
+         * planning again.  Counts a replan for the query shape.
+         */
+        Status removeForReplan(const CanonicalQuery& canonicalQuery);
+
         /**
          * Remove *all* entries.
          */
@@ -404,20 +446,45 @@ namespace mongo {
         void notifyOfWriteOp();
 
     private:
+        /**
+         * The entries are split between kNumShards shards by hash of their key.  Each shard has
+         * its own lock and an equal share of kMaxCacheSize, so lookups of different query shapes
+         * don't contend with each other.
+         */
+        static const size_t kNumShards = 8;
 
         /**
-         * Releases resources associated with each cache entry
-         * and clears map.
-         * Invoked by clear() and during destruction.
+         * How many shapes a shard keeps counters for, counting shapes with no entry.
          */
-        void _clear();
+        static const size_t kMaxShapeStatsPerShard;
+
+        typedef boost::unordered_map<PlanCacheKey, boost::shared_ptr<PlanCacheShapeStats> >
+            ShapeStatsMap;
 
-        LRUKeyValue<PlanCacheKey, PlanCacheEntry> _cache;
+        struct Shard {
+            Shard();
+
+            LRUKeyValue<PlanCacheKey, PlanCacheEntry> cache;
+
+            ShapeStatsMap shapeStats;
+
+            /**
+             * Protects 'cache' and 'shapeStats'.  Lookups take it shared, anything that adds,
+             * removes or reorders entries takes it exclusive.
+             */
+            mutable boost::shared_mutex mutex;
+        };
+
+        Shard& _shardFor(const PlanCacheKey& key) const;
 
         /**
-         * Protects _cache.
+         * Returns the counters for 'key', creating them if needed.  Caller must hold the shard's
+         * mutex exclusively.
          */
-        mutable boost::mutex _cacheMutex;
+        static boost::shared_ptr<PlanCacheShapeStats> _getShapeStats(Shard* shard,
+                                                                     const PlanCacheKey& key);
+
+        mutable Shard _shards[kNumShards];
 
         /**
          * Counter for write notifications since initialization or last clear() invocation.
@@ -332,6 +332,31 @@ namespace {
         ASSERT_EQUALS(planCache.size(), 1U);
     }
 
+    TEST(PlanCacheTest, AddEvictsWhenFull) {
+        PlanCache planCache;
+        QuerySolution qs;
+        qs.cacheData.reset(new SolutionCacheData());
+        qs.cacheData->tree.reset(new PlanCacheIndexTree());
+        std::vector<QuerySolution*> solns;
+        solns.push_back(&qs);
+
+        // Keep looking up the first shape, so it is never the entry evicted.
+        auto_ptr<CanonicalQuery> first(canonicalize("{a0: 1}"));
+        ASSERT_OK(planCache.add(*first, solns, createDecision(1U)));
+        for (int i = 1; i < 2 * PlanCache::kMaxCacheSize; ++i) {
+            std::string field = mongoutils::str::stream() << "a" << i;
+            auto_ptr<CanonicalQuery> cq(canonicalize(BSON(field << 1)));
+            ASSERT_OK(planCache.add(*cq, solns, createDecision(1U)));
+            ASSERT_TRUE(planCache.contains(*cq));
+
+            CachedSolution* rawCS;
+            ASSERT_OK(planCache.get(*first, &rawCS));
+            delete rawCS;
+        }
+        ASSERT_LESS_THAN_OR_EQUALS(planCache.size(), size_t(PlanCache::kMaxCacheSize));
+        ASSERT_TRUE(planCache.contains(*first));
+    }
+
     TEST(PlanCacheTest, NotifyOfWriteOp) {
         PlanCache planCache;
         auto_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -28,16 +28,30 @@
 
 #include "mongo/db/query/plan_executor.h"
 
+#include <algorithm>
+
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/pdfile.h"
+#include "mongo/db/server_parameters.h"
 
 namespace mongo {
 
+    // How many units of work getNext(...) asks the plan for at once.  1 or less turns batching
+    // off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryExecBatchSize, int, 64);
+
     PlanExecutor::PlanExecutor(WorkingSet* ws, PlanStage* rt)
-        : _workingSet(ws) , _root(rt) , _killed(false) { }
+        : _workingSet(ws),
+          _root(rt),
+          _killed(false),
+          _batchState(PlanStage::NEED_TIME),
+          _batchOut(WorkingSet::INVALID_ID),
+          _workBudget(0),
+          _worksDone(0),
+          _exceededWorkBudget(false) { }
 
     PlanExecutor::~PlanExecutor() { }
 
@@ -61,7 +75,18 @@ namespace mongo {
     }
 
     void PlanExecutor::invalidate(const DiskLoc& dl, InvalidationType type) {
-        if (!_killed) { _root->invalidate(dl, type); }
+        if (_killed) { return; }
+
+        _root->invalidate(dl, type);
+
+        for (std::deque<WorkingSetID>::const_iterator it = _readAhead.begin();
+             it != _readAhead.end(); ++it) {
+            if (WorkingSet::INVALID_ID == *it) { continue; }
+            WorkingSetMember* member = _workingSet->get(*it);
+            if (member->hasLoc() && (member->loc == dl)) {
+                WorkingSetCommon::fetchAndInvalidateLoc(member);
+            }
+        }
     }
 
     void PlanExecutor::setYieldPolicy(Runner::YieldPolicy policy) {
@@ -77,16 +102,54 @@ namespace mongo {
         if (_killed) { return Runner::RUNNER_DEAD; }
 
         for (;;) {
-            // Yield, if we can yield ourselves.
-            if (NULL != _yieldPolicy.get() && _yieldPolicy->shouldYield()) {
-                saveState();
-                _yieldPolicy->yield();
-                if (_killed) { return Runner::RUNNER_DEAD; }
-                restoreState();
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState code;
+
+            if (!_readAhead.empty()) {
+                id = _readAhead.front();
+                _readAhead.pop_front();
+                code = PlanStage::ADVANCED;
+            }
+            else if (PlanStage::NEED_TIME != _batchState) {
+                id = _batchOut;
+                code = _batchState;
+                _batchState = PlanStage::NEED_TIME;
+                _batchOut = WorkingSet::INVALID_ID;
             }
+            else {
+                // Yield, if we can yield ourselves.
+                if (NULL != _yieldPolicy.get() && _yieldPolicy->shouldYield()) {
+                    saveState();
+                    _yieldPolicy->yield();
+                    if (_killed) { return Runner::RUNNER_DEAD; }
+                    restoreState();
+                }
 
-            WorkingSetID id = WorkingSet::INVALID_ID;
-            PlanStage::StageState code = _root->work(&id);
+                int batchSize = internalQueryExecBatchSize;
+                if (0 != _workBudget) {
+                    if (_worksDone >= _workBudget) {
+                        _exceededWorkBudget = true;
+                        return Runner::RUNNER_EOF;
+                    }
+                    batchSize = std::min(static_cast<size_t>(std::max(batchSize, 1)),
+                                         _workBudget - _worksDone);
+                    _worksDone += (NULL == dlOut && batchSize > 1) ? batchSize : 1;
+                }
+
+                if (NULL == dlOut && batchSize > 1) {
+                    _batch.clear();
+                    code = _root->workBatch(batchSize, &_batch, &id);
+                    if (!_batch.empty()) {
+                        _readAhead.insert(_readAhead.end(), _batch.begin(), _batch.end());
+                        _batchState = code;
+                        _batchOut = id;
+                        continue;
+                    }
+                }
+                else {
+                    code = _root->work(&id);
+                }
+            }
 
             if (PlanStage::ADVANCED == code) {
                 // Fast count.
@@ -186,7 +249,19 @@ namespace mongo {
     }
 
     bool PlanExecutor::isEOF() {
-        return _killed || _root->isEOF();
+        if (_killed) { return true; }
+        if (!_readAhead.empty()) { return false; }
+        if (PlanStage::NEED_TIME != _batchState && PlanStage::IS_EOF != _batchState) {
+            // Still have to report how the last batch ended.
+            return false;
+        }
+        return _root->isEOF();
+    }
+
+    void PlanExecutor::setWorkBudget(size_t works) {
+        _workBudget = works;
+        _worksDone = 0;
+        _exceededWorkBudget = false;
     }
 
     void PlanExecutor::kill() {
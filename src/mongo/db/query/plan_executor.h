@@ -29,8 +29,11 @@
 #pragma once
 
 #include <boost/scoped_ptr.hpp>
+#include <deque>
+#include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/query/runner.h"
 #include "mongo/db/query/runner_yield_policy.h"
 
@@ -38,9 +41,6 @@ namespace mongo {
 
     class BSONObj;
     class DiskLoc;
-    class PlanStage;
-    struct PlanStageStats;
-    class WorkingSet;
 
     /**
      * A PlanExecutor is the abstraction that knows how to crank a tree of stages into execution.
@@ -49,6 +49,10 @@ namespace mongo {
      *
      * Executes a plan.  Used by a runner.  Calls work() on a plan until a result is produced.
      * Stops when the plan is EOF or if the plan errors.
+     *
+     * When the caller doesn't want DiskLocs back, and so won't write to what we return, the
+     * executor asks the plan for results a batch at a time (see PlanStage::workBatch) and hands
+     * them out from there.
      */
     class PlanExecutor {
     public:
@@ -91,6 +95,18 @@ namespace mongo {
         /** TOOD document me */
         bool isEOF();
 
+        /**
+         * Makes getNext() stop with RUNNER_EOF once the plan has been worked about 'works' times,
+         * after which exceededWorkBudget() is true.  A read-ahead batch counts as its full size.
+         * 0, the default, removes the budget.
+         */
+        void setWorkBudget(size_t works);
+
+        bool exceededWorkBudget() const { return _exceededWorkBudget; }
+
+        /** How many times the plan has been worked since the budget was last set. */
+        size_t worksSinceBudgetSet() const { return _worksDone; }
+
         /**
          * During the yield, the database we're operating over or any collection we're relying on
          * may be dropped.  When this happens all cursors and runners on that database and
@@ -106,6 +122,23 @@ namespace mongo {
         // Did somebody drop an index we care about or the namespace we're looking at?  If so,
         // we'll be killed.
         bool _killed;
+
+        // Results of the last batch that getNext(...) hasn't returned yet.  We pass on any
+        // invalidation of them as a stage holding results would.
+        std::deque<WorkingSetID> _readAhead;
+
+        // How the last batch ended, dealt with once _readAhead is empty.  NEED_TIME if there's
+        // nothing to deal with.
+        PlanStage::StageState _batchState;
+        WorkingSetID _batchOut;
+
+        // Reused by each batch.
+        std::vector<WorkingSetID> _batch;
+
+        // See setWorkBudget().
+        size_t _workBudget;
+        size_t _worksDone;
+        bool _exceededWorkBudget;
     };
 
 }  // namespace mongo
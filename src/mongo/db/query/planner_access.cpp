@@ -36,6 +36,7 @@
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
+#include "mongo/db/query/index_stats.h"
 #include "mongo/db/query/index_tag.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_planner.h"
@@ -52,6 +53,59 @@ namespace {
         return STAGE_TEXT == node->getType();
     }
 
+    /**
+     * How many keys the index scan 'node' looks at, going by its index's stats.  Returns false
+     * if it's not an index scan or we can't tell.
+     */
+    bool estimateScanKeys(const QuerySolutionNode* node,
+                          const std::vector<IndexEntry>& indices,
+                          double* out) {
+        if (STAGE_IXSCAN != node->getType()) {
+            return false;
+        }
+
+        const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+        if (isn->bounds.isSimpleRange || isn->bounds.fields.empty()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < indices.size(); ++i) {
+            const IndexEntry& index = indices[i];
+            if (INDEX_BTREE == index.type && NULL != index.stats.get()
+                && 0 == index.keyPattern.woCompare(isn->indexKeyPattern)) {
+                *out = index.stats->estimateKeys(isn->bounds.fields[0]);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    typedef std::pair<double, QuerySolutionNode*> SizedNode;
+
+    bool smallerEstimate(const SizedNode& a, const SizedNode& b) {
+        return a.first < b.first;
+    }
+
+    /**
+     * Puts the children of 'ahn' smallest first.  The hashed AND builds its table from the first
+     * child and only shrinks it after that, so this keeps the table small.  Nothing moves unless
+     * we have an estimate for every child.
+     */
+    void orderBySize(AndHashNode* ahn, const std::vector<IndexEntry>& indices) {
+        std::vector<SizedNode> sized(ahn->children.size());
+        for (size_t i = 0; i < ahn->children.size(); ++i) {
+            if (!estimateScanKeys(ahn->children[i], indices, &sized[i].first)) {
+                return;
+            }
+            sized[i].second = ahn->children[i];
+        }
+
+        std::stable_sort(sized.begin(), sized.end(), smallerEstimate);
+        for (size_t i = 0; i < sized.size(); ++i) {
+            ahn->children[i] = sized[i].second;
+        }
+    }
+
 } // namespace
 
 namespace mongo {
@@ -833,6 +887,7 @@ namespace mongo {
                 AndHashNode* ahn = new AndHashNode();
                 ahn->children.swap(ixscanNodes);
                 andResult = ahn;
+                orderBySize(ahn, indices);
                 // The AndHashNode provides the sort order of its last child.  If any of the
                 // possible subnodes of AndHashNode provides the sort order we care about, we put
                 // that one last.
@@ -1066,6 +1121,7 @@ namespace mongo {
                     }
                     else {
                         // More than one child.
+                        orderBySize(ahn.get(), indices);
                         solution = ahn.release();
                     }
                 }
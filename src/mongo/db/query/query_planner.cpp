@@ -34,6 +34,7 @@
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/index_stats.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/planner_analysis.h"
@@ -86,7 +87,10 @@ namespace mongo {
             ss << "INCLUDE_SHARD_FILTER ";
         }
         if (options & QueryPlannerParams::NO_BLOCKING_SORT) {
-            ss << "NO_BLOCKING_SORT";
+            ss << "NO_BLOCKING_SORT ";
+        }
+        if (options & QueryPlannerParams::PARALLEL_COLLSCAN) {
+            ss << "PARALLEL_COLLSCAN ";
         }
         return ss;
     }
@@ -161,6 +165,109 @@ namespace mongo {
         return !sortIt.more();
     }
 
+    /**
+     * Returns the stats of the btree index with key pattern 'kp', or NULL if there are none.
+     */
+    static const IndexStats* statsFor(const BSONObj& kp, const QueryPlannerParams& params) {
+        for (size_t i = 0; i < params.indices.size(); ++i) {
+            const IndexEntry& index = params.indices[i];
+            if (INDEX_BTREE == index.type && 0 == index.keyPattern.woCompare(kp)) {
+                return index.stats.get();
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * Estimates how many keys or documents the solution rooted at 'node' examines.  Returns
+     * false if some part of it can't be estimated.
+     */
+    static bool estimateExamined(const QuerySolutionNode* node,
+                                 const QueryPlannerParams& params,
+                                 double* out) {
+        if (STAGE_IXSCAN == node->getType()) {
+            const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+            const IndexStats* stats = statsFor(isn->indexKeyPattern, params);
+            if (NULL == stats || isn->bounds.isSimpleRange || isn->bounds.fields.empty()) {
+                return false;
+            }
+            *out = stats->estimateKeys(isn->bounds.fields[0]);
+            return true;
+        }
+
+        if (STAGE_COLLSCAN == node->getType()) {
+            // A non-sparse single key index has a key per document.
+            bool found = false;
+            for (size_t i = 0; i < params.indices.size(); ++i) {
+                const IndexEntry& index = params.indices[i];
+                if (NULL != index.stats.get() && !index.sparse && !index.multikey) {
+                    *out = static_cast<double>(index.stats->numKeys);
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        if (node->children.empty()) {
+            return false;
+        }
+
+        double total = 0;
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            double child;
+            if (!estimateExamined(node->children[i], params, &child)) {
+                return false;
+            }
+            total += child;
+        }
+        *out = total;
+        return true;
+    }
+
+    /**
+     * Drops the solutions in 'out' that examine far more than the cheapest one, going by the
+     * index stats.  See QueryPlannerParams::pruneRatio.
+     */
+    static void pruneByEstimate(const CanonicalQuery& query,
+                                const QueryPlannerParams& params,
+                                vector<QuerySolution*>* out) {
+        // Stops us throwing away plans over a handful of keys.
+        const double kMinKeysAhead = 1000;
+
+        vector<double> estimates(out->size());
+        vector<bool> known(out->size());
+        double cheapest = -1;
+        for (size_t i = 0; i < out->size(); ++i) {
+            known[i] = estimateExamined((*out)[i]->root.get(), params, &estimates[i]);
+            if (known[i] && (cheapest < 0 || estimates[i] < cheapest)) {
+                cheapest = estimates[i];
+            }
+        }
+
+        if (cheapest < 0) {
+            return;
+        }
+
+        // A plan that gets the sort from an index can stop early, which we don't account for.
+        const bool hasSort = !query.getParsed().getSort().isEmpty();
+
+        size_t kept = 0;
+        for (size_t i = 0; i < out->size(); ++i) {
+            QuerySolution* soln = (*out)[i];
+            if (known[i]
+                && !(hasSort && !soln->hasSortStage)
+                && estimates[i] > params.pruneRatio * cheapest
+                && estimates[i] - cheapest > kMinKeysAhead) {
+                QLOG() << "Planner: pruning solution estimated to examine " << estimates[i]
+                       << ", cheapest is " << cheapest << ":\n" << soln->toString() << endl;
+                delete soln;
+                continue;
+            }
+            (*out)[kept++] = soln;
+        }
+        out->resize(kept);
+    }
+
     Status QueryPlanner::cacheDataFromTaggedTree(const MatchExpression* const taggedTree,
                                                  const vector<IndexEntry>& relevantIndices,
                                                  PlanCacheIndexTree** out) {
@@ -836,6 +943,11 @@ namespace mongo {
             }
         }
 
+        if (params.pruneRatio > 0 && out->size() > 1
+            && !(params.options & QueryPlannerParams::PRIVATE_IS_COUNT)) {
+            pruneByEstimate(query, params, out);
+        }
+
         return Status::OK();
     }
 
@@ -42,7 +42,8 @@ namespace mongo {
 
         QueryPlannerParams() : options(DEFAULT),
                                indexFiltersApplied(false),
-                               maxIndexedSolutions(kDefaultMaxIndexedSolutions) { }
+                               maxIndexedSolutions(kDefaultMaxIndexedSolutions),
+                               pruneRatio(0) { }
 
         enum Options {
             // You probably want to set this.
@@ -78,6 +79,11 @@ namespace mongo {
             // Nobody should set this above the getRunner interface.  Internal flag set as a hint to
             // the planner that the caller is actually the count command.
             PRIVATE_IS_COUNT = 1 << 6,
+
+            // Set this if the caller only reads the results and doesn't modify the collection
+            // while it has the runner.  A collection scan may then be split among worker threads,
+            // which returns results out of $natural order.  See internalQueryParallelScanThreads.
+            PARALLEL_COLLSCAN = 1 << 7,
         };
 
         // See Options enum above.
@@ -98,6 +104,11 @@ namespace mongo {
         // plans via the MultiPlanRunner, and the set of possible plans is very large for certain
         // index+query combinations.
         size_t maxIndexedSolutions;
+
+        // If positive, solutions that the indices' stats say examine more than this many times
+        // as many keys as the cheapest solution are dropped, so there are fewer to compare.
+        // Solutions we can't estimate are kept.  See IndexEntry::stats.
+        double pruneRatio;
     };
 
 }  // namespace mongo
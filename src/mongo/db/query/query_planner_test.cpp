@@ -36,6 +36,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/query/index_stats.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/query_solution.h"
@@ -89,6 +90,15 @@ namespace {
             params.indices.push_back(IndexEntry(keyPattern, false, false, "foo", infoObj));
         }
 
+        // Gives the last index added 'numKeys' keys spread evenly over 'numValues' values.
+        void addStats(long long numKeys, long long numValues) {
+            IndexStatsBuilder builder(100, 1);
+            for (long long i = 0; i < numKeys; ++i) {
+                builder.addKey(BSON("" << (i * numValues / numKeys)));
+            }
+            params.indices.back().stats.reset(builder.done(numKeys));
+        }
+
         //
         // Execute planner.
         //
@@ -3054,6 +3064,103 @@ namespace {
                                 "[{ixscan: {pattern: {a: 1, b: 1}}}, {ixscan: {pattern: {a: 1, b: 1}}}]}}}}");
     }
 
+    //
+    // Dropping candidates that index stats say are much worse than the best.
+    //
+
+    TEST_F(QueryPlannerTest, PruneByIndexStats) {
+        params.pruneRatio = 10;
+        addIndex(BSON("a" << 1));
+        addStats(10000, 10000);
+        addIndex(BSON("b" << 1));
+        addStats(10000, 1);
+
+        runQuery(fromjson("{a: 5, b: 0}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, PruneOffByDefault) {
+        addIndex(BSON("a" << 1));
+        addStats(10000, 10000);
+        addIndex(BSON("b" << 1));
+        addStats(10000, 1);
+
+        runQuery(fromjson("{a: 5, b: 0}"));
+
+        assertNumSolutions(3U);
+    }
+
+    TEST_F(QueryPlannerTest, PruneKeepsSimilarPlans) {
+        params.pruneRatio = 10;
+        addIndex(BSON("a" << 1));
+        addStats(10000, 1000);
+        addIndex(BSON("b" << 1));
+        addStats(10000, 500);
+
+        runQuery(fromjson("{a: 5, b: 7}"));
+
+        // Only the collection scan goes.
+        assertNumSolutions(2U);
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1}}}}}");
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {b: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, PruneKeepsPlansWithoutStats) {
+        params.pruneRatio = 10;
+        addIndex(BSON("a" << 1));
+        addStats(10000, 10000);
+        addIndex(BSON("b" << 1));
+
+        runQuery(fromjson("{a: 5, b: 0}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {a: 1}}}}}");
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {b: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, PruneKeepsIndexProvidedSort) {
+        params.pruneRatio = 10;
+        addIndex(BSON("a" << 1));
+        addStats(10000, 10000);
+        addIndex(BSON("b" << 1));
+        addStats(10000, 10000);
+
+        runQuerySortProj(fromjson("{a: 5}"), fromjson("{b: 1}"), BSONObj());
+
+        // The {b: 1} scan examines every key but can stop early.
+        assertNumSolutions(2U);
+        assertSolutionExists("{sort: {pattern: {b: 1}, limit: 0, node: "
+                                "{fetch: {node: {ixscan: {pattern: {a: 1}}}}}}}");
+        assertSolutionExists("{fetch: {node: {ixscan: {pattern: {b: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, IntersectHashesSmallestFirst) {
+        params.options = QueryPlannerParams::NO_TABLE_SCAN | QueryPlannerParams::INDEX_INTERSECTION;
+        addIndex(BSON("a" << 1));
+        addStats(10000, 10000);
+        addIndex(BSON("b" << 1));
+        addStats(10000, 10000);
+
+        // About 9900 keys of a and 10 of b.
+        runQuery(fromjson("{a: {$gt: 100}, b: {$gt: 9990}}"));
+
+        bool found = false;
+        for (size_t i = 0; i < solns.size(); ++i) {
+            const QuerySolutionNode* node = solns[i]->root.get();
+            if (STAGE_FETCH != node->getType() || STAGE_AND_HASH != node->children[0]->getType()) {
+                continue;
+            }
+            const QuerySolutionNode* ahn = node->children[0];
+            ASSERT_EQUALS(2U, ahn->children.size());
+            const IndexScanNode* first = static_cast<const IndexScanNode*>(ahn->children[0]);
+            ASSERT_EQUALS(BSON("b" << 1), first->indexKeyPattern);
+            found = true;
+        }
+        ASSERT(found);
+    }
+
     //
     // Test bad input to query planner helpers.
     //
@@ -83,7 +83,8 @@ namespace mongo {
     // CollectionScanNode
     //
 
-    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) { }
+    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0),
+                                               parallel(false) { }
 
     void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -94,6 +95,10 @@ namespace mongo {
             addIndent(ss, indent + 1);
             *ss << " filter = " << filter->toString();
         }
+        if (parallel) {
+            addIndent(ss, indent + 1);
+            *ss << "parallel\n";
+        }
         addCommon(ss, indent);
     }
 
@@ -314,7 +319,11 @@ namespace mongo {
     //
 
     IndexScanNode::IndexScanNode()
-        : indexIsMultiKey(false), direction(1), maxScan(0), addKeyMetadata(false) { }
+        : indexIsMultiKey(false),
+          direction(1),
+          maxScan(0),
+          addKeyMetadata(false),
+          countOnly(false) { }
 
     void IndexScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -329,6 +338,10 @@ namespace mongo {
         *ss << "direction = " << direction << '\n';
         addIndent(ss, indent + 1);
         *ss << "bounds = " << bounds.toString() << '\n';
+        if (countOnly) {
+            addIndent(ss, indent + 1);
+            *ss << "countOnly\n";
+        }
         addIndent(ss, indent + 1);
         *ss << "fetched = " << fetched() << '\n';
         addCommon(ss, indent);
@@ -634,6 +647,10 @@ namespace mongo {
         *ss << "DISTINCT\n";
         addIndent(ss, indent + 1);
         *ss << "keyPattern = " << indexKeyPattern << '\n';
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << " filter= " << filter->toString() << '\n';
+        }
         addIndent(ss, indent + 1);
         *ss << "direction = " << direction << '\n';
         addIndent(ss, indent + 1);
@@ -243,6 +243,10 @@ namespace mongo {
 
         // maxScan option to .find() limits how many docs we look at.
         int maxScan;
+
+        // May the scan be split among worker threads?  Set by getRunner() for callers that only
+        // read the results and don't care about their order.
+        bool parallel;
     };
 
     struct AndHashNode : public QuerySolutionNode {
@@ -371,6 +375,9 @@ namespace mongo {
         // If there's a 'returnKey' projection we add key metadata.
         bool addKeyMetadata;
 
+        // Set for a count answered from the index alone.  The scan returns no data.
+        bool countOnly;
+
         // BIG NOTE:
         // If you use simple bounds, we'll use whatever index access method the keypattern implies.
         // If you use the complex bounds, we force Btree access.
@@ -41,6 +41,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collscan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/s2near.h"
 #include "mongo/db/exec/shard_filter.h"
@@ -48,11 +49,26 @@
 #include "mongo/db/exec/skip.h"
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage_options.h"
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/catalog/collection.h"
 
 namespace mongo {
 
+    // Sorts that don't fit in memory write sorted runs under dbpath/_tmp rather than failing.
+    MONGO_EXPORT_SERVER_PARAMETER(sortSpillToDisk, bool, true);
+
+    // Collection scans that may run in parallel (see QueryPlannerParams::PARALLEL_COLLSCAN) use
+    // this many threads on collections of at least internalQueryParallelScanMinMB.  1 turns it
+    // off.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelScanThreads, int, 1);
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryParallelScanMinMB, int, 64);
+
+    // How much a hashed AND may buffer.  Past this it keeps only DiskLocs, and fails if those
+    // don't fit either.
+    MONGO_EXPORT_SERVER_PARAMETER(internalQueryAndHashMaxBytes, int, 32 * 1024 * 1024);
+
     PlanStage* buildStages(const QuerySolution& qsol, const QuerySolutionNode* root, WorkingSet* ws) {
         if (STAGE_COLLSCAN == root->getType()) {
             const CollectionScanNode* csn = static_cast<const CollectionScanNode*>(root);
@@ -62,6 +78,19 @@ namespace mongo {
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+
+            const int threads = internalQueryParallelScanThreads;
+            if (csn->parallel && threads > 1) {
+                Database* db = cc().database();
+                Collection* collection = db ? db->getCollection(qsol.ns) : NULL;
+                const int minMB = internalQueryParallelScanMinMB;
+                if (NULL != collection && !collection->isCapped()
+                    && (minMB <= 0
+                        || collection->dataSize() >= (static_cast<uint64_t>(minMB) << 20))) {
+                    return new ParallelCollectionScan(params, threads, ws, csn->filter.get());
+                }
+            }
+
             return new CollectionScan(params, ws, csn->filter.get());
         }
         else if (STAGE_IXSCAN == root->getType()) {
@@ -87,6 +116,7 @@ namespace mongo {
             params.direction = ixn->direction;
             params.maxScan = ixn->maxScan;
             params.addKeyMetadata = ixn->addKeyMetadata;
+            params.countOnly = ixn->countOnly;
             return new IndexScan(params, ws, ixn->filter.get());
         }
         else if (STAGE_FETCH == root->getType()) {
@@ -103,6 +133,9 @@ namespace mongo {
             params.pattern = sn->pattern;
             params.query = sn->query;
             params.limit = sn->limit;
+            if (sortSpillToDisk) {
+                params.tempDir = storageGlobalParams.dbpath + "/_tmp";
+            }
             return new SortStage(params, ws, childStage);
         }
         else if (STAGE_PROJECTION == root->getType()) {
@@ -125,11 +158,17 @@ namespace mongo {
         }
         else if (STAGE_AND_HASH == root->getType()) {
             const AndHashNode* ahn = static_cast<const AndHashNode*>(root);
-            auto_ptr<AndHashStage> ret(new AndHashStage(ws, ahn->filter.get()));
+            auto_ptr<AndHashStage> ret(new AndHashStage(ws, ahn->filter.get(),
+                                                        internalQueryAndHashMaxBytes));
             for (size_t i = 0; i < ahn->children.size(); ++i) {
                 PlanStage* childStage = buildStages(qsol, ahn->children[i], ws);
                 if (NULL == childStage) { return NULL; }
-                ret->addChild(childStage);
+                if (STAGE_IXSCAN == ahn->children[i]->getType()) {
+                    ret->addIndexScanChild(static_cast<IndexScan*>(childStage));
+                }
+                else {
+                    ret->addChild(childStage);
+                }
             }
             return ret.release();
         }
@@ -265,6 +304,7 @@ namespace mongo {
             params.direction = dn->direction;
             params.bounds = dn->bounds;
             params.fieldNo = dn->fieldNo;
+            params.filter = dn->filter.get();
             return new DistinctScan(params, ws);
         }
         else if (STAGE_COUNT == root->getType()) {
@@ -494,6 +494,10 @@ namespace replset {
         _buffer.blockingPeek(op, 1);
     }
 
+    void BackgroundSync::peekMany(std::vector<BSONObj>* ops, size_t max) {
+        _buffer.peekMany(ops, max);
+    }
+
     void BackgroundSync::consume() {
         // this is just to get the op off the queue, it's been peeked at
         // and queued for application already
@@ -58,6 +58,9 @@ namespace replset {
 
         // wait up to 1 second for more ops to appear
         virtual void waitForMore() = 0;
+
+        // Copies up to 'max' ops from the head of the buffer into 'ops', without removing them
+        virtual void peekMany(std::vector<BSONObj>* ops, size_t max) = 0;
     };
 
 
@@ -150,6 +153,8 @@ namespace replset {
         virtual const Member* getSyncTarget();
         virtual void waitForMore();
 
+        virtual void peekMany(std::vector<BSONObj>* ops, size_t max);
+
         // For monitoring
         BSONObj getCounters();
 
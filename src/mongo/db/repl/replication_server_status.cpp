@@ -40,6 +40,7 @@
 #include "mongo/db/repl/master_slave.h"
 #include "mongo/db/repl/oplogreader.h"
 #include "mongo/db/repl/rs.h"
+#include "mongo/db/repl/rs_sync.h"
 #include "mongo/db/storage_options.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/s/write_ops/batched_command_request.h"
@@ -149,6 +150,9 @@ namespace mongo {
             
             BSONObjBuilder result;
             appendReplicationInfo(result, level);
+            if (theReplSet) {
+                replset::appendWriterStats(&result);
+            }
             return result.obj();
         }
     } replicationInfoServerStatus;
@@ -200,6 +200,11 @@ namespace mongo {
                          o["usePowerOf2Sizes"].type() == Bool ) {
                         log() << "replSet not rolling back change of usePowerOf2Sizes: " << o;
                     }
+                    else if ( o.nFields() == 2 &&
+                              o["compressRecords"].type() == Bool ) {
+                        // either way the collection can read what was written
+                        log() << "replSet not rolling back change of compressRecords: " << o;
+                    }
                     else {
                         log() << "replSet error cannot rollback a collMod command: " << o;
                         throw rsfatal();
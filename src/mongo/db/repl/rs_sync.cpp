@@ -30,14 +30,20 @@
 
 #include "mongo/db/repl/rs_sync.h"
 
+#include <map>
 #include <vector>
 
 #include "third_party/murmurhash3/MurmurHash3.h"
 
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/client.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/commands/fsync.h"
 #include "mongo/db/d_concurrency.h"
+#include "mongo/db/hasher.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/prefetch.h"
 #include "mongo/db/repl/bgsync.h"
@@ -78,6 +84,17 @@ namespace replset {
     static ServerStatusMetricField<Counter64> displayOpsApplied( "repl.apply.ops",
                                                                 &opsAppliedStats );
 
+    // Work done by each writer.  Writer i applies the ops put in writerVectors[i], so comparing
+    // busy time across writers shows how evenly batches are split.
+    struct WriterStats {
+        AtomicUInt64 ops;
+        AtomicUInt64 busyMicros;
+    };
+    static const int maxWriters = 16;
+    static WriterStats writerStats[maxWriters];
+    // Time spent applying batches, from the first writer starting to the last one finishing
+    static AtomicUInt64 applyMicros;
+
 
     SyncTail::SyncTail(BackgroundSyncInterface *q) :
         Sync(""), oplogVersion(0), _networkQueue(q)
@@ -132,6 +149,8 @@ namespace replset {
     void initializePrefetchThread() {
         if (!ClientBasic::getCurrent()) {
             Client::initThread("repl prefetch worker");
+            // prefetching for the next batch runs while the current one is being applied
+            Lock::ParallelBatchWriterMode::iAmABatchParticipant();
             replLocalAuth();
         }
     }
@@ -231,24 +250,77 @@ namespace replset {
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
+            // skip the ops prefetchAhead() already handed out while the last batch was applied
+            if ((*it)["ts"]._opTime() <= _lastPrefetched) {
+                continue;
+            }
             prefetcherPool.schedule(&prefetchOp, *it);
         }
         prefetcherPool.join();
     }
-    
+
+    void SyncTail::prefetchAhead() {
+        std::vector<BSONObj> next;
+        _networkQueue->peekMany(&next, replBatchLimitOperations);
+
+        threadpool::ThreadPool& prefetcherPool = theReplSet->getPrefetchPool();
+        for (std::vector<BSONObj>::const_iterator it = next.begin(); it != next.end(); ++it) {
+            OpTime ts = (*it)["ts"]._opTime();
+            if (ts <= _lastPrefetched) {
+                continue;
+            }
+            prefetcherPool.schedule(&prefetchOp, *it);
+            _lastPrefetched = ts;
+        }
+    }
+
+    void SyncTail::applyWriterOps(MultiSyncApplyFunc applyFunc,
+                                  const std::vector<BSONObj>& ops,
+                                  SyncTail* st,
+                                  size_t writer) {
+        Timer timer;
+        applyFunc(ops, st);
+        writerStats[writer].ops.fetchAndAdd(ops.size());
+        writerStats[writer].busyMicros.fetchAndAdd(timer.micros());
+    }
+
     // Doles out all the work to the writer pool threads and waits for them to complete
     void SyncTail::applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                                      MultiSyncApplyFunc applyFunc) {
         ThreadPool& writerPool = theReplSet->getWriterPool();
         TimerHolder timer(&applyBatchStats);
-        for (std::vector< std::vector<BSONObj> >::const_iterator it = writerVectors.begin();
-             it != writerVectors.end();
-             ++it) {
-            if (!it->empty()) {
-                writerPool.schedule(applyFunc, boost::cref(*it), this);
+        Timer applyTimer;
+        invariant(writerVectors.size() <= static_cast<size_t>(maxWriters));
+        for (size_t i = 0; i < writerVectors.size(); ++i) {
+            if (!writerVectors[i].empty()) {
+                writerPool.schedule(&applyWriterOps, applyFunc, boost::cref(writerVectors[i]),
+                                    this, i);
             }
         }
+
+        // Read in the pages the next batch needs while the writers work on this one.
+        prefetchAhead();
+
         writerPool.join();
+        applyMicros.fetchAndAdd(applyTimer.micros());
+    }
+
+    void appendWriterStats(BSONObjBuilder* b) {
+        const unsigned long long totalMicros = applyMicros.load();
+        BSONObjBuilder writers(b->subobjStart("writers"));
+        writers.appendNumber("applyMillis", static_cast<long long>(totalMicros / 1000));
+        BSONArrayBuilder threads(writers.subarrayStart("threads"));
+        for (int i = 0; i < theReplSet->replWriterThreadCount; ++i) {
+            const unsigned long long busyMicros = writerStats[i].busyMicros.load();
+            BSONObjBuilder thread(threads.subobjStart());
+            thread.appendNumber("ops", static_cast<long long>(writerStats[i].ops.load()));
+            thread.appendNumber("busyMillis", static_cast<long long>(busyMicros / 1000));
+            thread.append("utilization",
+                          totalMicros ? static_cast<double>(busyMicros) / totalMicros : 0.0);
+            thread.doneFast();
+        }
+        threads.doneFast();
+        writers.doneFast();
     }
 
     // Doles out all the work to the writer pool threads and waits for them to complete
@@ -272,18 +344,94 @@ namespace replset {
     }
 
 
+    /**
+     * Returns the _id of the document 'op' changes, or EOO if the op isn't an insert, update or
+     * delete of a single document identified by _id.
+     */
+    static BSONElement opDocumentId(const BSONObj& op) {
+        switch (op["op"].valuestrsafe()[0]) {
+        case 'i':
+        case 'd':
+            return op["o"]["_id"];
+        case 'u':
+            return op["o2"]["_id"];
+        default:
+            return BSONElement();
+        }
+    }
+
+    /**
+     * Ops on different documents of 'ns' may be applied in any order unless the collection is
+     * capped, where order is the insertion order, or has a unique index other than _id, where
+     * one document may take a key another one gave up earlier in the batch.
+     */
+    static bool canSplitById(const StringData& ns) {
+        if (NamespaceString(ns).isSystem()) {
+            return false;
+        }
+        Client::ReadContext ctx(ns.toString());
+        Collection* collection = ctx.ctx().db()->getCollection(ns);
+        if (!collection) {
+            // created by the first insert, with just the _id index
+            return true;
+        }
+        if (collection->isCapped()) {
+            return false;
+        }
+        IndexCatalog::IndexIterator ii = collection->getIndexCatalog()->getIndexIterator(true);
+        while (ii.more()) {
+            IndexDescriptor* desc = ii.next();
+            if (desc->unique() && !desc->isIdIndex()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     void SyncTail::fillWriterVectors(const std::deque<BSONObj>& ops, 
                                               std::vector< std::vector<BSONObj> >* writerVectors) {
+        // Find the namespaces whose ops can be split by _id: every op in the batch must name
+        // its document, and the collection must allow reordering.
+        std::map<StringData, bool> splitById;
         for (std::deque<BSONObj>::const_iterator it = ops.begin();
              it != ops.end();
              ++it) {
             const BSONElement e = it->getField("ns");
             verify(e.type() == String);
+            StringData ns(e.valuestr(), e.valuestrsize() - 1);
+            bool hasId = !opDocumentId(*it).eoo();
+            std::map<StringData, bool>::iterator found = splitById.find(ns);
+            if (found == splitById.end()) {
+                splitById[ns] = hasId;
+            }
+            else if (!hasId) {
+                found->second = false;
+            }
+        }
+        for (std::map<StringData, bool>::iterator it = splitById.begin();
+             it != splitById.end();
+             ++it) {
+            if (it->second && !it->first.empty()) {
+                it->second = canSplitById(it->first);
+            }
+        }
+
+        for (std::deque<BSONObj>::const_iterator it = ops.begin();
+             it != ops.end();
+             ++it) {
+            const BSONElement e = it->getField("ns");
             const char* ns = e.valuestr();
             int len = e.valuestrsize();
             uint32_t hash = 0;
             MurmurHash3_x86_32( ns, len, 0, &hash);
 
+            if (splitById[StringData(ns, len - 1)]) {
+                // hash64() maps equal _id values of different numeric types to the same hash
+                long long idHash = BSONElementHasher::hash64(opDocumentId(*it),
+                                                             BSONElementHasher::DEFAULT_HASH_SEED);
+                MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+            }
+
             (*writerVectors)[hash % writerVectors->size()].push_back(*it);
         }
     }
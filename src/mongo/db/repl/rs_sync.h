@@ -123,15 +123,27 @@ namespace replset {
     private:
         BackgroundSyncInterface* _networkQueue;
 
+        // The last op handed to the prefetch pool by prefetchAhead()
+        OpTime _lastPrefetched;
+
         // Doles out all the work to the reader pool threads and waits for them to complete
         void prefetchOps(const std::deque<BSONObj>& ops);
+        // Hands the ops queued for the next batch to the reader pool threads, without waiting
+        void prefetchAhead();
         // Used by the thread pool readers to prefetch an op
         static void prefetchOp(const BSONObj& op);
 
         // Doles out all the work to the writer pool threads and waits for them to complete
         void applyOps(const std::vector< std::vector<BSONObj> >& writerVectors, 
                       MultiSyncApplyFunc applyFunc);
-
+        // Used by the thread pool writers to apply the ops of writerVectors[writer]
+        static void applyWriterOps(MultiSyncApplyFunc applyFunc,
+                                   const std::vector<BSONObj>& ops,
+                                   SyncTail* st,
+                                   size_t writer);
+
+        // Ops on the same document go to the same writer, in oplog order.  Ops on a
+        // namespace that can't be split by _id all go to the same writer.
         void fillWriterVectors(const std::deque<BSONObj>& ops, 
                                std::vector< std::vector<BSONObj> >* writerVectors);
         void handleSlaveDelay(const BSONObj& op);
@@ -156,6 +168,9 @@ namespace replset {
     // TODO: move hbmsg into an error-keeping class (SERVER-4444)
     void sethbmsg(const string& s, const int logLevel=0);
 
+    // Appends how busy each writer was while applying batches, for serverStatus.
+    void appendWriterStats(BSONObjBuilder* b);
+
     // These free functions are used by the thread pool workers to write ops to the db.
     void multiSyncApply(const std::vector<BSONObj>& ops, SyncTail* st);
     void multiInitialSyncApply(const std::vector<BSONObj>& ops, SyncTail* st);
@@ -48,7 +48,13 @@ namespace mongo {
                                   bool directoryPerDB )
         : _dbname( dbname.toString() ),
           _path( path.toString() ),
-          _directoryPerDB( directoryPerDB ) {
+          _directoryPerDB( directoryPerDB ),
+          _allocationMutex( "extentAllocation" ) {
+        if ( Lock::collectionLevelLockingEnabled() ) {
+            // readers index _files while another collection's writer may be adding a file;
+            // never reallocate underneath them
+            _files.reserve( DiskLoc::MaxFiles );
+        }
     }
 
     ExtentManager::~ExtentManager() {
@@ -101,9 +107,20 @@ namespace mongo {
         return Status::OK();
     }
 
+    // with collection level locking a writer may hold the database only in intent mode.  it
+    // reaches the files through its own collection's records, and allocates extents and adds
+    // files under _allocationMutex.
+    static bool filesLocked( const string& dbname ) {
+        return Lock::atLeastReadLocked( dbname ) || Lock::isIntentLocked( dbname );
+    }
+
+    static bool filesWriteLocked( const string& dbname ) {
+        return Lock::isWriteLocked( dbname ) || Lock::isIntentWriteLocked( dbname );
+    }
+
     const DataFile* ExtentManager::_getOpenFile( int n ) const {
         verify(this);
-        DEV Lock::assertAtLeastReadLocked( _dbname );
+        DEV verify( filesLocked( _dbname ) );
         if ( n < 0 || n >= static_cast<int>(_files.size()) )
             log() << "uh oh: " << n;
         verify( n >= 0 && n < static_cast<int>(_files.size()) );
@@ -114,7 +131,7 @@ namespace mongo {
     // todo: this is called a lot. streamline the common case
     DataFile* ExtentManager::getFile( int n, int sizeNeeded , bool preallocateOnly) {
         verify(this);
-        DEV Lock::assertAtLeastReadLocked( _dbname );
+        DEV verify( filesLocked( _dbname ) );
 
         if ( n < 0 || n >= DiskLoc::MaxFiles ) {
             log() << "getFile(): n=" << n << endl;
@@ -130,7 +147,7 @@ namespace mongo {
         if ( !preallocateOnly ) {
             while ( n >= (int) _files.size() ) {
                 verify(this);
-                if( !Lock::isWriteLocked(_dbname) ) {
+                if( !filesWriteLocked(_dbname) ) {
                     log() << "error: getFile() called in a read lock, yet file to return is not yet open" << endl;
                     log() << "       getFile(" << n << ") _files.size:" <<_files.size() << ' ' << fileName(n).string() << endl;
                     log() << "       context ns: " << cc().ns() << endl;
@@ -142,7 +159,7 @@ namespace mongo {
         }
         if ( p == 0 ) {
             if ( n == 0 ) audit::logCreateDatabase( currentClient.get(), _dbname );
-            DEV Lock::assertWriteLocked( _dbname );
+            DEV verify( filesWriteLocked( _dbname ) );
             boost::filesystem::path fullName = fileName( n );
             string fullNameString = fullName.string();
             p = new DataFile(n);
@@ -167,7 +184,7 @@ namespace mongo {
     }
 
     DataFile* ExtentManager::addAFile( int sizeNeeded, bool preallocateNextFile ) {
-        DEV Lock::assertWriteLocked( _dbname );
+        DEV verify( filesWriteLocked( _dbname ) );
         int n = (int) _files.size();
         DataFile *ret = getFile( n, sizeNeeded );
         if ( preallocateNextFile )
@@ -176,7 +193,7 @@ namespace mongo {
     }
 
     size_t ExtentManager::numFiles() const {
-        DEV Lock::assertAtLeastReadLocked( _dbname );
+        DEV verify( filesLocked( _dbname ) );
         return _files.size();
     }
 
@@ -478,10 +495,14 @@ namespace mongo {
                                                 int quotaMax ) {
 
         bool fromFreeList = true;
-        DiskLoc eloc = allocFromFreeList( size, details->isCapped() );
-        if ( eloc.isNull() ) {
-            fromFreeList = false;
-            eloc = createExtent( size, quotaMax );
+        DiskLoc eloc;
+        {
+            SimpleMutex::scoped_lock lk( _allocationMutex );
+            eloc = allocFromFreeList( size, details->isCapped() );
+            if ( eloc.isNull() ) {
+                fromFreeList = false;
+                eloc = createExtent( size, quotaMax );
+            }
         }
 
         verify( !eloc.isNull() );
@@ -526,6 +547,8 @@ namespace mongo {
         if ( firstExt.isNull() && lastExt.isNull() )
             return;
 
+        SimpleMutex::scoped_lock lk( _allocationMutex );
+
         {
             verify( !firstExt.isNull() && !lastExt.isNull() );
             Extent *f = getExtent( firstExt );
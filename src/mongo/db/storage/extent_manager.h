@@ -38,6 +38,7 @@
 #include "mongo/base/status.h"
 #include "mongo/base/string_data.h"
 #include "mongo/db/diskloc.h"
+#include "mongo/util/concurrency/mutex.h"
 
 namespace mongo {
 
@@ -190,6 +191,11 @@ namespace mongo {
         //   to others and we are in the dbholder lock then.
         std::vector<DataFile*> _files;
 
+        // with collection level locking, writers of different collections in this database
+        // run concurrently (the db lock is held in intent mode).  they share the free list and
+        // the files, so taking or returning extents is serialized here.
+        SimpleMutex _allocationMutex;
+
     };
 
 }
@@ -0,0 +1,165 @@
+// record_compression.cpp
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/pch.h"
+
+#include "mongo/db/storage/record_compression.h"
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/concurrency/threadlocal.h"
+
+namespace mongo {
+
+    namespace {
+
+        Counter64 decompressions;
+        ServerStatusMetricField<Counter64> decompressionsDisplay( "record.compressed.decompressions",
+                                                                  &decompressions );
+
+        Counter64 cacheHits;
+        ServerStatusMetricField<Counter64> cacheHitsDisplay( "record.compressed.cacheHits",
+                                                             &cacheHits );
+
+    }
+
+    /**
+     * The last few documents a thread decompressed.  An operation tends to look at a record
+     * more than once (match, fetch, update), and each of those goes through
+     * BSONObj::make(Record*).  An entry is only used while the record still holds the same
+     * compressed bytes, so writes and yields need not invalidate anything.
+     */
+    class DecompressionCache {
+    public:
+        enum { Entries = 4, MaxCachedSize = 64 * 1024 };
+
+        DecompressionCache() : _next( 0 ) {
+            for ( int i = 0; i < Entries; i++ )
+                _entries[i].recordData = NULL;
+        }
+
+        bool get( const char* recordData, int len, BSONObj* out ) const {
+            for ( int i = 0; i < Entries; i++ ) {
+                const Entry& e = _entries[i];
+                if ( e.recordData == recordData &&
+                     e.compressed.size() == static_cast<size_t>( len ) &&
+                     memcmp( e.compressed.data(), recordData, len ) == 0 ) {
+                    *out = e.doc;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void put( const char* recordData, int len, const BSONObj& doc ) {
+            if ( len > MaxCachedSize || doc.objsize() > MaxCachedSize )
+                return;
+            Entry& e = _entries[_next];
+            _next = ( _next + 1 ) % Entries;
+            e.recordData = recordData;
+            e.compressed.assign( recordData, len );
+            e.doc = doc;
+        }
+
+    private:
+        struct Entry {
+            const char* recordData;
+            std::string compressed;
+            BSONObj doc;
+        };
+
+        Entry _entries[Entries];
+        int _next;
+    };
+
+    TSP_DECLARE(DecompressionCache, decompressionCache)
+    TSP_DEFINE(DecompressionCache, decompressionCache)
+
+    bool RecordCompression::compress( const BSONObj& doc, std::string* out ) {
+        const size_t size = doc.objsize();
+        out->resize( HeaderSize + maxCompressedLength( size ) );
+
+        size_t compressedLength;
+        rawCompress( doc.objdata(), size, &(*out)[HeaderSize], &compressedLength );
+        if ( HeaderSize + compressedLength >= size )
+            return false;
+
+        out->resize( HeaderSize + compressedLength );
+        const int header = -static_cast<int>( out->size() );
+        memcpy( &(*out)[0], &header, HeaderSize );
+        return true;
+    }
+
+    BSONObj RecordCompression::uncompress( const char* recordData ) {
+        dassert( isCompressed( recordData ) );
+        const int len = -*reinterpret_cast<const int*>( recordData );
+
+        DecompressionCache* cache = decompressionCache.getMake();
+        BSONObj doc;
+        if ( cache->get( recordData, len, &doc ) ) {
+            cacheHits.increment();
+            return doc;
+        }
+
+        const char* compressed = recordData + HeaderSize;
+        const size_t compressedLength = len - HeaderSize;
+        size_t size = 0;
+        massert( 17414, "compressed record is corrupt",
+                 len > HeaderSize &&
+                 uncompressedLength( compressed, compressedLength, &size ) &&
+                 size >= 5 && size <= static_cast<size_t>( BSONObjMaxInternalSize ) );
+
+        BSONObj::Holder* h = static_cast<BSONObj::Holder*>( malloc( size + sizeof(unsigned) ) );
+        h->zero();
+        if ( !rawUncompress( compressed, compressedLength, h->data ) ||
+             *reinterpret_cast<const int*>( h->data ) != static_cast<int>( size ) ) {
+            free( h );
+            msgasserted( 17415, "compressed record is corrupt" );
+        }
+        doc = BSONObj( h );
+        decompressions.increment();
+
+        cache->put( recordData, len, doc );
+        return doc;
+    }
+
+    RecordData::RecordData( const BSONObj& doc, bool compress ) {
+        if ( compress && RecordCompression::compress( doc, &_compressed ) ) {
+            _data = _compressed.data();
+            _size = _compressed.size();
+        }
+        else {
+            _data = doc.objdata();
+            _size = doc.objsize();
+        }
+    }
+
+}
@@ -0,0 +1,97 @@
+// record_compression.h
+
+/**
+*    Copyright (C) 2014 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    /**
+     * Record level compression, for collections with the compressRecords option.
+     *
+     * A compressed record is a 4 byte header followed by the snappy compressed document.  The
+     * header is the negated length of the stored bytes, header included, so it can't be
+     * mistaken for the leading size of a BSON object.  Documents that don't get smaller are
+     * stored as plain BSON, so a collection can hold both forms; BSONObj::make(Record*) returns
+     * the document either way.
+     */
+    class RecordCompression {
+    public:
+        enum { HeaderSize = 4 };
+
+        static bool isCompressed( const char* recordData ) {
+            return *reinterpret_cast<const int*>( recordData ) < 0;
+        }
+
+        /**
+         * @return true if 'out' was set to the compressed form of 'doc', false if compression
+         *         doesn't make it smaller
+         */
+        static bool compress( const BSONObj& doc, std::string* out );
+
+        /**
+         * @param recordData the data of a record for which isCompressed() is true
+         * @return an owned copy of the document.  a few recently decompressed documents are
+         *         kept per thread, so looking at the same record again is cheap.
+         */
+        static BSONObj uncompress( const char* recordData );
+
+        /**
+         * @return the document in 'recordData', uncompressed if need be.  like
+         *         BSONObj::make(Record*), but for callers that read the record with
+         *         dataNoThrowing() after checking it is in memory themselves.
+         */
+        static BSONObj document( const char* recordData ) {
+            return isCompressed( recordData ) ? uncompress( recordData ) : BSONObj( recordData );
+        }
+    };
+
+    /**
+     * The bytes to store in a record for a document: compressed if 'compress' is set and that
+     * makes them smaller, otherwise the document as is.
+     */
+    class RecordData {
+        MONGO_DISALLOW_COPYING(RecordData);
+    public:
+        RecordData( const BSONObj& doc, bool compress );
+
+        const char* data() const { return _data; }
+        int size() const { return _size; }
+
+    private:
+        std::string _compressed;
+        const char* _data;
+        int _size;
+    };
+
+}
@@ -249,7 +249,8 @@ namespace mongo {
         };
 
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_CompressRecords = 1 << 1 // new documents are stored compressed, see RecordCompression
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
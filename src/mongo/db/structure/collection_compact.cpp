@@ -43,6 +43,7 @@
 #include "mongo/db/structure/catalog/namespace_details.h"
 #include "mongo/db/storage/extent.h"
 #include "mongo/db/storage/extent_manager.h"
+#include "mongo/db/storage/record_compression.h"
 #include "mongo/db/structure/collection_iterator.h"
 #include "mongo/util/touch_pages.h"
 
@@ -53,14 +54,14 @@ namespace mongo {
         /**
          * param allocationSize - allocation size WITH header
          */
-        CompactDocWriter( const BSONObj& doc, size_t allocationSize )
+        CompactDocWriter( const RecordData& doc, size_t allocationSize )
             : _doc( doc ), _allocationSize( allocationSize ) {
         }
 
         virtual ~CompactDocWriter() {}
 
         virtual void writeDocument( char* buf ) const {
-            memcpy( buf, _doc.objdata(), _doc.objsize() );
+            memcpy( buf, _doc.data(), _doc.size() );
         }
 
         virtual size_t documentSize() const {
@@ -72,7 +73,7 @@ namespace mongo {
         }
 
     private:
-        BSONObj _doc;
+        const RecordData& _doc;
         size_t _allocationSize;
     };
 
@@ -121,7 +122,10 @@ namespace mongo {
                         stats->corruptDocuments++;
                     }
                     else {
-                        unsigned docSize = objOld.objsize();
+                        // rewritten in the collection's current form, so compact can
+                        // be used to compress existing documents after a collMod
+                        RecordData stored( objOld, _compressRecords() );
+                        unsigned docSize = stored.size();
 
                         nrecords++;
                         oldObjSize += docSize;
@@ -136,8 +140,10 @@ namespace mongo {
                                 lenWPadding = details()->quantizePowerOf2AllocationSpace(lenWPadding);
                             break;
                         case CompactOptions::PRESERVE:
-                            // if we are preserving the padding, the record should not change size
-                            lenWPadding = recOld->lengthWithHeaders();
+                            // if we are preserving the padding, the record should not change
+                            // size, unless it is no longer stored in the same form
+                            lenWPadding = std::max( lenWHdr,
+                                                    static_cast<unsigned>( recOld->lengthWithHeaders() ) );
                             break;
                         case CompactOptions::MANUAL:
                             lenWPadding = compactOptions->computeRecordSize(lenWPadding);
@@ -147,7 +153,7 @@ namespace mongo {
                             break;
                         }
 
-                        CompactDocWriter writer( objOld, lenWPadding );
+                        CompactDocWriter writer( stored, lenWPadding );
                         StatusWith<DiskLoc> status = _recordStore->insertRecord( &writer, 0 );
                         uassertStatusOK( status.getStatus() );
                         datasize += _recordStore->recordFor( status.getValue() )->netLength();
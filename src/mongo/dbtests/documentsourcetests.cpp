@@ -861,6 +861,102 @@ namespace DocumentSourceTests {
             virtual string expectedResultSetString() { return "[{_id:0, first:null}]"; }
         };
 
+        /** $sum, $avg, $min and $max keep their state in typed arrays. */
+        class TypedAccumulators : public CheckResultsBase {
+            void populateData() {
+                // Numerically equal ids of different types are one group.
+                client.insert( ns, BSON( "id" << 1 << "a" << 1 ) );
+                client.insert( ns, BSON( "id" << 1.0 << "a" << 2LL ) );
+                client.insert( ns, BSON( "id" << 1LL << "a" << 3.0 ) );
+                client.insert( ns, BSON( "id" << 2 << "a" << BSONNULL ) );
+                client.insert( ns, BSON( "id" << 2 << "a" << "x" ) );
+                client.insert( ns, BSON( "id" << 2 << "a" << 4 ) );
+            }
+            virtual BSONObj groupSpec() {
+                return BSON( "_id" << "$id"
+                             << "sum" << BSON( "$sum" << "$a" )
+                             << "avg" << BSON( "$avg" << "$a" )
+                             << "min" << BSON( "$min" << "$a" )
+                             << "max" << BSON( "$max" << "$a" ) );
+            }
+            virtual string expectedResultSetString() {
+                return "[{_id:1,sum:6,avg:2,min:1,max:3},{_id:2,sum:4,avg:4,min:4,max:'x'}]";
+            }
+        };
+
+        /** Enough groups to grow the group index several times. */
+        class ManyGroups : public CheckResultsBase {
+            void populateData() {
+                for( int i = 0; i < 1000; ++i ) {
+                    client.insert( ns, BSON( "id" << i % 500 << "a" << i ) );
+                }
+            }
+            virtual BSONObj groupSpec() {
+                return BSON( "_id" << "$id"
+                             << "sum" << BSON( "$sum" << "$a" )
+                             << "max" << BSON( "$max" << "$a" )
+                             << "list" << BSON( "$push" << "$a" ) );
+            }
+            virtual BSONObj expectedResultSet() {
+                BSONArrayBuilder expected;
+                for( int k = 0; k < 500; ++k ) {
+                    expected << BSON( "_id" << k
+                                      << "sum" << 2 * k + 500
+                                      << "max" << k + 500
+                                      << "list" << BSON_ARRAY( k << k + 500 ) );
+                }
+                return expected.arr();
+            }
+        };
+
+        /** With its input ordered on the _id, a streaming group returns each group as it ends. */
+        class Streaming : public Base {
+        public:
+            void run() {
+                // A missing id sorts and groups with null.
+                client.insert( ns, BSON( "a" << 1 ) );
+                client.insert( ns, BSON( "x" << BSONNULL << "a" << 2 ) );
+                client.insert( ns, BSON( "x" << 1 << "a" << 3 ) );
+                client.insert( ns, BSON( "x" << 1.0 << "a" << 4 ) );
+                client.insert( ns, BSON( "x" << 2 << "a" << 5 ) );
+                createSource();
+                createGroup( BSON( "_id" << "$x"
+                                   << "sum" << BSON( "$sum" << "$a" )
+                                   << "list" << BSON( "$push" << "$a" ) ) );
+
+                DocumentSourceGroup* streaming = static_cast<DocumentSourceGroup*>( group() );
+                ASSERT_EQUALS( "x", streaming->getIdFieldPath() );
+                streaming->setStreaming( true );
+
+                ASSERT_EQUALS( fromjson( "{_id:null,sum:3,list:[1,2]}" ),
+                               streaming->getNext()->toBson() );
+                // The _id is the group's first value.  BSON equality would take 1.0 for 1.
+                BSONObj ones = streaming->getNext()->toBson();
+                ASSERT_EQUALS( fromjson( "{_id:1,sum:7,list:[3,4]}" ), ones );
+                ASSERT_EQUALS( NumberInt, ones[ "_id" ].type() );
+                ASSERT_EQUALS( fromjson( "{_id:2,sum:5,list:[5]}" ),
+                               streaming->getNext()->toBson() );
+                assertExhausted( group() );
+            }
+        };
+
+        /** Only an _id that is a plain field path reports one. */
+        class IdFieldPathForStreaming : public Base {
+        public:
+            void run() {
+                createSource();
+                ASSERT_EQUALS( "x.y", idFieldPath( BSON( "_id" << "$$ROOT.x.y" ) ) );
+                ASSERT_EQUALS( "", idFieldPath( BSON( "_id" << "$$ROOT" ) ) );
+                ASSERT_EQUALS( "", idFieldPath( BSON( "_id" << BSON( "x" << "$x" ) ) ) );
+                ASSERT_EQUALS( "", idFieldPath( fromjson( "{_id:{$add:['$x',1]}}" ) ) );
+            }
+        private:
+            string idFieldPath( const BSONObj& spec ) {
+                createGroup( spec );
+                return static_cast<DocumentSourceGroup*>( group() )->getIdFieldPath();
+            }
+        };
+
         /** Simulate merging sharded results in the router. */ 
         class RouterMerger : public CheckResultsBase {
         public:
@@ -1969,6 +2065,10 @@ namespace DocumentSourceTests {
             add<DocumentSourceGroup::GroupNullUndefinedIds>();
             add<DocumentSourceGroup::ComplexId>();
             add<DocumentSourceGroup::UndefinedAccumulatorValue>();
+            add<DocumentSourceGroup::TypedAccumulators>();
+            add<DocumentSourceGroup::ManyGroups>();
+            add<DocumentSourceGroup::Streaming>();
+            add<DocumentSourceGroup::IdFieldPathForStreaming>();
             add<DocumentSourceGroup::RouterMerger>();
             add<DocumentSourceGroup::Dependencies>();
             add<DocumentSourceGroup::StringConstantIdAndAccumulatorExpressions>();
@@ -344,6 +344,79 @@ namespace DocumentTests {
             }
         };
 
+        /** Fields of a Document built from BSON are read lazily and in order. */
+        class LazyFromBson {
+        public:
+            void run() {
+                BSONObj obj = fromjson( "{a: 1, b: {c: 'x', d: [{e: 2}, 3]}, a: 4, f: 5}" );
+                Document document = fromBson( obj );
+
+                // Reading in any order finds the first of repeated fields.
+                ASSERT_EQUALS( 5, document["f"].getInt() );
+                ASSERT_EQUALS( 1, document["a"].getInt() );
+                ASSERT( document["z"].missing() );
+                ASSERT_EQUALS( Value( 2 ), document.getNestedField( FieldPath( "b.d" ) )[0]["e"] );
+                ASSERT_EQUALS( 4U, document.size() );
+                ASSERT_EQUALS( 4, getNthField( document, 2 ).second.getInt() );
+
+                // An unchanged document is its own BSON.
+                ASSERT_EQUALS( obj.objdata(), document.toBson().objdata() );
+                ASSERT_EQUALS( obj["b"].Obj(), document["b"].getDocument().toBson() );
+
+                // Equal to the same document built field by field.
+                MutableDocument md;
+                md.addField( "a", Value( 1 ) );
+                md.addField( "b", Value( DOC( "c" << "x" <<
+                                              "d" << DOC_ARRAY( DOC( "e" << 2 ) << 3 ) ) ) );
+                md.addField( "a", Value( 4 ) );
+                md.addField( "f", Value( 5 ) );
+                ASSERT_EQUALS( md.freeze(), document );
+            }
+        };
+
+        /** Changing a Document built from BSON leaves the original alone. */
+        class LazyFromBsonModified {
+        public:
+            void run() {
+                BSONObj obj = BSON( "a" << 1 << "b" << BSON( "c" << 2 ) << "d" << 3 );
+                Document document = fromBson( obj );
+                ASSERT_EQUALS( 1, document["a"].getInt() );
+
+                MutableDocument md( document );
+                md.setNestedField( FieldPath( "b.c" ), Value( 20 ) );
+                md.addField( "e", Value( 4 ) );
+                Document modified = md.freeze();
+
+                ASSERT_EQUALS( BSON( "a" << 1 << "b" << BSON( "c" << 20 ) << "d" << 3 <<
+                                     "e" << 4 ),
+                               modified.toBson() );
+                ASSERT_EQUALS( obj, document.toBson() );
+                ASSERT_EQUALS( obj.objdata(), document.toBson().objdata() );
+
+                // Removing a field hides it from the BSON too.
+                MutableDocument removed( document );
+                removed.remove( "a" );
+                ASSERT_EQUALS( BSON( "b" << BSON( "c" << 2 ) << "d" << 3 ),
+                               removed.freeze().toBson() );
+            }
+        };
+
+        /** A Document built from unowned BSON doesn't depend on it afterwards. */
+        class LazyFromUnownedBson {
+        public:
+            void run() {
+                Document document;
+                {
+                    BSONObj owned = BSON( "a" << "hello" << "b" << BSON( "c" << "world" ) );
+                    document = fromBson( BSONObj( owned.objdata() ) );
+                    memset( const_cast<char*>( owned.objdata() ) + 4, 0xff,
+                            owned.objsize() - 5 );
+                }
+                ASSERT_EQUALS( "world", document["b"]["c"].getString() );
+                ASSERT_EQUALS( "hello", document["a"].getString() );
+            }
+        };
+
         class AllTypesDoc {
         public:
             void run() {
@@ -1427,6 +1500,9 @@ namespace DocumentTests {
             add<Document::FieldIteratorEmpty>();
             add<Document::FieldIteratorSingle>();
             add<Document::FieldIteratorMultiple>();
+            add<Document::LazyFromBson>();
+            add<Document::LazyFromBsonModified>();
+            add<Document::LazyFromUnownedBson>();
             add<Document::AllTypesDoc>();
 
             add<Value::BSONArrayTest>();
@@ -40,6 +40,7 @@
 #include <boost/thread/thread.hpp>
 #include <fstream>
 
+#include "mongo/bson/bson_validate.h"
 #include "mongo/db/db.h"
 #include "mongo/db/dur_stats.h"
 #include "mongo/db/instance.h"
@@ -486,6 +487,51 @@ namespace PerfTests {
         }
     };
 
+    /** validateBSON() throughput, as done on every insert.  reports GB/sec validated */
+    class BSONValidate : public NonDurTest {
+    public:
+        unsigned long long bytes;
+        bo b;
+        mongo::Timer t;
+        string name() { return "BSONValidate"; }
+        BSONValidate() {
+            bo sub = bob().appendTimeT("t", time(0)).appendBool("abool", true).appendBinData("somebin", 3, BinDataGeneral, "abc").appendNull("anullone").obj();
+            b = BSON( "_id" << OID() << "x" << 3 << "yaaaaaa" << 3.00009 << "zz" << 1 << "q" << false << "obj" << sub << "zzzzzzz" << "a string a string" << "arr" << BSON_ARRAY( 1 << 2 << "three" ) );
+        }
+        void prep() {
+            bytes = 0;
+            t.reset();
+        }
+        void timed() {
+            ASSERT( validateBSON( b.objdata(), b.objsize() ).isOK() );
+            bytes += b.objsize();
+        }
+        void post() {
+            cout << name() << ' ' << bytes / (1024.0*1024*1024) / (t.micros()/1000000.0) << "GB/sec" << endl;
+        }
+    };
+
+    /** validateBSON() on a document near the max size, mostly many small fields and strings */
+    class BSONValidateBig : public BSONValidate {
+    public:
+        string name() { return "BSONValidateBig"; }
+        virtual unsigned batchSize() { return 1; }
+        BSONValidateBig() {
+            bob x;
+            string str(200, 'x');
+            for( int i = 0; x.len() < 15 * 1024 * 1024; i++ ) {
+                string f = str::stream() << "f" << i;
+                if( i % 10 == 0 )
+                    x.append(f, BSON( "a" << i << "b" << str << "c" << BSON_ARRAY( i << 1.5 << "z" ) ));
+                else if( i % 2 == 0 )
+                    x.append(f, str);
+                else
+                    x.append(f, i);
+            }
+            b = x.obj();
+        }
+    };
+
     class KeyTest : public B {
     public:
         KeyV1Owned a,b,c;
@@ -1429,6 +1475,8 @@ namespace PerfTests {
                 add< BSONIter >();
                 add< BSONGetFields1 >();
                 add< BSONGetFields2 >();
+                add< BSONValidate >();
+                add< BSONValidateBig >();
                 //add< TaskQueueTest >();
                 add< InsertDup >();
                 add< Insert1 >();
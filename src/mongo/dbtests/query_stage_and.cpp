@@ -39,6 +39,7 @@
 #include "mongo/db/exec/and_sorted.h"
 #include "mongo/db/exec/index_scan.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
@@ -490,6 +491,169 @@ namespace QueryStageAnd {
         }
     };
 
+    // An AND that goes over its memory limit drops the index keys it's holding, then fetches
+    // its results instead.
+    class QueryStageAndHashLocsOnly : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                coll = db->createCollection(ns());
+            }
+
+            // Big keys in the first child make the WSMs, not the DiskLocs, the bulk of the AND.
+            string pad(400, 'x');
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("pad" << (pad + BSONObjBuilder::numStr(i)) << "bar" << i));
+            }
+
+            addIndex(BSON("pad" << 1));
+            addIndex(BSON("bar" << 1));
+
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, 16 * 1024));
+
+            // All of pad.
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("pad" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << "");
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            // Bar >= 40
+            params.descriptor = getIndex(BSON("bar" << 1), coll);
+            params.bounds.startKey = BSON("" << 40);
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            int count = 0;
+            while (!ah->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState status = ah->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::FAILURE, status);
+                if (PlanStage::ADVANCED != status) { continue; }
+
+                ++count;
+                WorkingSetMember* member = ws.get(id);
+                ASSERT_TRUE(member->hasObj());
+                BSONElement elt;
+                ASSERT_TRUE(member->getFieldDotted("pad", &elt));
+                ASSERT_TRUE(member->getFieldDotted("bar", &elt));
+                ASSERT_GREATER_THAN_OR_EQUALS(elt.numberInt(), 40);
+            }
+
+            ASSERT_EQUALS(10, count);
+
+            scoped_ptr<PlanStageStats> stats(ah->getStats());
+            const AndHashStats* spec = static_cast<const AndHashStats*>(stats->specific.get());
+            ASSERT_TRUE(spec->locsOnly);
+            ASSERT_EQUALS(size_t(10), spec->fetchedResults);
+        }
+    };
+
+    // An AND that can't even hold the DiskLocs fails.
+    class QueryStageAndHashOverMemLimit : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                coll = db->createCollection(ns());
+            }
+
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL, 1));
+
+            // Foo <= 20
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 20);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = -1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            // Bar >= 10
+            params.descriptor = getIndex(BSON("bar" << 1), coll);
+            params.bounds.startKey = BSON("" << 10);
+            params.direction = 1;
+            ah->addChild(new IndexScan(params, &ws, NULL));
+
+            PlanStage::StageState status = PlanStage::NEED_TIME;
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            while (PlanStage::NEED_TIME == status) {
+                status = ah->work(&id);
+            }
+
+            ASSERT_EQUALS(PlanStage::FAILURE, status);
+            BSONObj statusObj;
+            WorkingSetCommon::getStatusMemberObject(ws, id, &statusObj);
+            ASSERT_TRUE(WorkingSetCommon::isValidStatusMemberObject(statusObj));
+        }
+    };
+
+    // Once the first child is hashed, an index scan probing the table skips the DiskLocs that
+    // can't be in it.
+    class QueryStageAndHashLocFilter : public QueryStageAndBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                coll = db->createCollection(ns());
+            }
+
+            for (int i = 0; i < 50; ++i) {
+                insert(BSON("foo" << i << "bar" << i));
+            }
+
+            addIndex(BSON("foo" << 1));
+            addIndex(BSON("bar" << 1));
+
+            WorkingSet ws;
+            scoped_ptr<AndHashStage> ah(new AndHashStage(&ws, NULL));
+
+            // Foo >= 29
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1), coll);
+            params.bounds.isSimpleRange = true;
+            params.bounds.startKey = BSON("" << 29);
+            params.bounds.endKey = BSONObj();
+            params.bounds.endKeyInclusive = true;
+            params.direction = 1;
+            ah->addIndexScanChild(new IndexScan(params, &ws, NULL));
+
+            // All of bar.
+            params.descriptor = getIndex(BSON("bar" << 1), coll);
+            params.bounds.startKey = BSON("" << 0);
+            ah->addIndexScanChild(new IndexScan(params, &ws, NULL));
+
+            ASSERT_EQUALS(21, countResults(ah.get()));
+
+            // bar == 0 was read before there was a filter, and bars 1 to 28 can't match.  All
+            // but a few of the latter should have been skipped.
+            scoped_ptr<PlanStageStats> stats(ah->getStats());
+            const IndexScanStats* probe =
+                static_cast<const IndexScanStats*>(stats->children[1]->specific.get());
+            ASSERT_GREATER_THAN(probe->locsFiltered, size_t(24));
+            ASSERT_LESS_THAN_OR_EQUALS(probe->locsFiltered, size_t(28));
+        }
+    };
+
     //
     // Sorted AND tests
     //
@@ -870,6 +1034,9 @@ namespace QueryStageAnd {
             add<QueryStageAndHashProducesNothing>();
             add<QueryStageAndHashWithMatcher>();
             add<QueryStageAndHashInvalidateLookahead>();
+            add<QueryStageAndHashLocsOnly>();
+            add<QueryStageAndHashOverMemLimit>();
+            add<QueryStageAndHashLocFilter>();
             add<QueryStageAndSortedInvalidation>();
             add<QueryStageAndSortedThreeLeaf>();
             add<QueryStageAndSortedWithNothing>();
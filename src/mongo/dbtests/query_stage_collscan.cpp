@@ -32,6 +32,7 @@
 
 #include "mongo/client/dbclientcursor.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collscan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
@@ -590,6 +591,250 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // Scanning in batches returns what scanning one document at a time does, filtered the same.
+    //
+
+    class QueryStageCollscanWorkBatch : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::ReadContext ctx(ns());
+
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(3 << 0))));
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet ws;
+            scoped_ptr<CollectionScan> scan(new CollectionScan(params, &ws, filterExpr.get()));
+
+            int expected = 0;
+            PlanStage::StageState state = PlanStage::NEED_TIME;
+            while (PlanStage::IS_EOF != state) {
+                vector<WorkingSetID> results;
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                state = scan->workBatch(7, &results, &id);
+                ASSERT_LESS_THAN_OR_EQUALS(results.size(), 7U);
+                for (size_t i = 0; i < results.size(); ++i) {
+                    ASSERT_EQUALS(expected, ws.get(results[i])->obj["foo"].numberInt());
+                    expected += 3;
+                    ws.free(results[i]);
+                }
+                if (PlanStage::IS_EOF != state) {
+                    ASSERT_EQUALS(PlanStage::NEED_TIME, state);
+                }
+            }
+            ASSERT_EQUALS(51, expected);
+
+            scoped_ptr<PlanStageStats> stats(scan->getStats());
+            const CollectionScanStats* spec =
+                static_cast<const CollectionScanStats*>(stats->specific.get());
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), spec->docsTested);
+            ASSERT_EQUALS(17U, stats->common.advanced);
+        }
+    };
+
+    //
+    // Results the executor read ahead of the caller survive the deletion of their documents,
+    // as results held in a stage would.
+    //
+
+    class QueryStageCollscanInvalidateReadAhead : public QueryStageCollectionScanBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            vector<DiskLoc> locs;
+            getLocs(CollectionScanParams::FORWARD, &locs);
+
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            WorkingSet* ws = new WorkingSet();
+            PlanExecutor runner(ws, new CollectionScan(params, ws, NULL));
+
+            BSONObj obj;
+            int count = 0;
+            while (count < 10) {
+                ASSERT_EQUALS(Runner::RUNNER_ADVANCED, runner.getNext(&obj, NULL));
+                ASSERT_EQUALS(count, obj["foo"].numberInt());
+                ++count;
+            }
+
+            // The rest of the collection was read in the same batch.
+            runner.saveState();
+            runner.invalidate(locs[count], INVALIDATION_DELETION);
+            remove(BSON("foo" << count));
+            runner.restoreState();
+
+            while (Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL)) {
+                ASSERT_EQUALS(count, obj["foo"].numberInt());
+                ++count;
+            }
+            ASSERT_EQUALS(numObj(), count);
+        }
+    };
+
+
+    //
+    // Split a scan of a collection with several extents among worker threads.
+    //
+
+    class QueryStageParallelCollscanBase {
+    public:
+        QueryStageParallelCollscanBase() {
+            Client::WriteContext ctx(ns());
+
+            // Big enough documents that the collection needs several extents.
+            const string pad(1000, 'x');
+            for (int i = 0; i < numObj(); ++i) {
+                _client.insert(ns(), BSON("foo" << i << "skip" << false << "pad" << pad));
+            }
+        }
+
+        virtual ~QueryStageParallelCollscanBase() {
+            Client::WriteContext ctx(ns());
+            _client.dropCollection(ns());
+        }
+
+        ParallelCollectionScan* makeScan(WorkingSet* ws, const MatchExpression* filter) {
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+            return new ParallelCollectionScan(params, 4, ws, filter);
+        }
+
+        void getLocs(vector<DiskLoc>* out) {
+            WorkingSet ws;
+
+            CollectionScanParams params;
+            params.ns = ns();
+            params.direction = CollectionScanParams::FORWARD;
+            params.tailable = false;
+
+            scoped_ptr<CollectionScan> scan(new CollectionScan(params, &ws, NULL));
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == scan->work(&id)) {
+                    out->push_back(ws.get(id)->loc);
+                }
+            }
+        }
+
+        static int numObj() { return 2000; }
+
+        static const char* ns() { return "unittests.QueryStageParallelCollscan"; }
+
+    protected:
+        static DBDirectClient _client;
+    };
+
+    DBDirectClient QueryStageParallelCollscanBase::_client;
+
+    class QueryStageParallelCollscanMatchesEachOnce : public QueryStageParallelCollscanBase {
+    public:
+        void run() {
+            Client::ReadContext ctx(ns());
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(3 << 0))));
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet* ws = new WorkingSet();
+            ParallelCollectionScan* scan = makeScan(ws, filterExpr.get());
+            PlanExecutor runner(ws, scan);
+
+            set<int> seen;
+            BSONObj obj;
+            while (Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL)) {
+                int foo = obj["foo"].numberInt();
+                ASSERT_EQUALS(0, foo % 3);
+                ASSERT(seen.insert(foo).second);
+            }
+            ASSERT_EQUALS(667U, seen.size());
+
+            scoped_ptr<PlanStageStats> stats(scan->getStats());
+            const CollectionScanStats* spec =
+                static_cast<const CollectionScanStats*>(stats->specific.get());
+            ASSERT_GREATER_THAN(spec->workers, 1U);
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), spec->docsTested);
+        }
+    };
+
+    //
+    // Results the workers found before a yield are dropped if their documents are deleted, and
+    // tested again if they are changed.
+    //
+
+    class QueryStageParallelCollscanYield : public QueryStageParallelCollscanBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+
+            vector<DiskLoc> locs;
+            getLocs(&locs);
+            ASSERT_EQUALS(static_cast<size_t>(numObj()), locs.size());
+
+            StatusWithMatchExpression swme =
+                MatchExpressionParser::parse(BSON("skip" << false));
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet* ws = new WorkingSet();
+            PlanExecutor runner(ws, makeScan(ws, filterExpr.get()));
+
+            set<int> seen;
+            BSONObj obj;
+            while (seen.size() < 10) {
+                ASSERT_EQUALS(Runner::RUNNER_ADVANCED, runner.getNext(&obj, NULL));
+                ASSERT(seen.insert(obj["foo"].numberInt()).second);
+            }
+
+            // Delete the first half of the collection and mark the rest of the even documents so
+            // they no longer match.  The update doesn't grow them, so they stay where they are.
+            runner.saveState();
+            for (int i = 0; i < numObj(); ++i) {
+                if (i < numObj() / 2) {
+                    runner.invalidate(locs[i], INVALIDATION_DELETION);
+                }
+                else if (0 == i % 2) {
+                    runner.invalidate(locs[i], INVALIDATION_MUTATION);
+                }
+            }
+            _client.remove(ns(), BSON("foo" << BSON("$lt" << numObj() / 2)));
+            _client.update(ns(),
+                           BSON("foo" << BSON("$mod" << BSON_ARRAY(2 << 0))),
+                           BSON("$set" << BSON("skip" << true)),
+                           false, true);
+            runner.restoreState();
+
+            while (Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL)) {
+                int foo = obj["foo"].numberInt();
+                ASSERT_GREATER_THAN_OR_EQUALS(foo, numObj() / 2);
+                ASSERT_EQUALS(1, foo % 2);
+                ASSERT(seen.insert(foo).second);
+            }
+
+            // Every odd document of the second half came back exactly once.
+            size_t oddSecondHalf = 0;
+            for (set<int>::const_iterator it = seen.begin(); it != seen.end(); ++it) {
+                if (*it >= numObj() / 2 && 1 == *it % 2) {
+                    ++oddSecondHalf;
+                }
+            }
+            ASSERT_EQUALS(static_cast<size_t>(numObj() / 4), oddSecondHalf);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "QueryStageCollectionScan" ) {}
@@ -618,6 +863,10 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+            add<QueryStageCollscanWorkBatch>();
+            add<QueryStageCollscanInvalidateReadAhead>();
+            add<QueryStageParallelCollscanMatchesEachOnce>();
+            add<QueryStageParallelCollscanYield>();
         }
     } all;
 
@@ -424,6 +424,75 @@ namespace QueryStageFetch {
         }
     };
 
+    //
+    // Test that a batch stops at a record that's not in memory and the rest of it, including
+    // invalidations of the rest, is picked up after the fetch.
+    //
+    class FetchStageBatchNotInMemory : public QueryStageFetchBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(ns());
+            Database* db = ctx.ctx().db();
+            Collection* coll = db->getCollection(ns());
+            if (!coll) {
+                coll = db->createCollection(ns());
+            }
+            WorkingSet ws;
+
+            for (int i = 0; i < 3; ++i) {
+                insert(BSON("foo" << i));
+            }
+            vector<DiskLoc> locs;
+            {
+                set<DiskLoc> locSet;
+                getLocs(&locSet, coll);
+                locs.assign(locSet.begin(), locSet.end());
+            }
+            ASSERT_EQUALS(size_t(3), locs.size());
+
+            auto_ptr<MockStage> mockStage(new MockStage(&ws));
+            for (size_t i = 0; i < locs.size(); ++i) {
+                WorkingSetMember mockMember;
+                mockMember.state = WorkingSetMember::LOC_AND_IDX;
+                mockMember.loc = locs[i];
+                mockStage->pushBack(mockMember);
+            }
+
+            auto_ptr<FetchStage> fetchStage(new FetchStage(&ws, mockStage.release(), NULL));
+
+            FailPointRegistry* reg = getGlobalFailPointRegistry();
+            FailPoint* fetchInMemoryFail = reg->getFailPoint("fetchInMemoryFail");
+            fetchInMemoryFail->setMode(FailPoint::alwaysOn);
+
+            // The first record isn't in memory, so the batch ends with a fetch request for it.
+            vector<WorkingSetID> results;
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = fetchStage->workBatch(10, &results, &id);
+            ASSERT_EQUALS(PlanStage::NEED_FETCH, state);
+            ASSERT_EQUALS(size_t(0), results.size());
+            ASSERT_EQUALS(locs[0], ws.get(id)->loc);
+            ASSERT_FALSE(fetchStage->isEOF());
+
+            fetchInMemoryFail->setMode(FailPoint::off);
+
+            // Delete a document that's still waiting.
+            fetchStage->prepareToYield();
+            fetchStage->invalidate(locs[2], INVALIDATION_DELETION);
+            remove(BSON("foo" << 2));
+            fetchStage->recoverFromYield();
+
+            state = fetchStage->workBatch(10, &results, &id);
+            ASSERT_EQUALS(PlanStage::IS_EOF, state);
+            ASSERT_EQUALS(size_t(3), results.size());
+            for (size_t i = 0; i < results.size(); ++i) {
+                WorkingSetMember* member = ws.get(results[i]);
+                ASSERT_EQUALS(static_cast<int>(i), member->obj["foo"].numberInt());
+            }
+            ASSERT_EQUALS(WorkingSetMember::OWNED_OBJ, ws.get(results[2])->state);
+            ASSERT_TRUE(fetchStage->isEOF());
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_fetch" ) { }
@@ -434,6 +503,7 @@ namespace QueryStageFetch {
             add<FetchStageAlreadyFetched>();
             add<FetchStageInvalidation>();
             add<FetchStageFilter>();
+            add<FetchStageBatchNotInMemory>();
         }
     }  queryStageFetchAll;
 
@@ -205,6 +205,49 @@ namespace QueryStageTests {
         }
     };
 
+    class QueryStageIXScanCountOnlyMultiInterval : public IndexScanBase {
+    public:
+        virtual ~QueryStageIXScanCountOnlyMultiInterval() { }
+
+        void run() {
+            // foo in {5} or [10, 20], baz even
+            IndexScanParams params;
+            params.descriptor = getIndex(BSON("foo" << 1 << "baz" << 1));
+            OrderedIntervalList fooList("foo");
+            fooList.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+            fooList.intervals.push_back(Interval(BSON("" << 10 << "" << 20), true, true));
+            OrderedIntervalList bazList("baz");
+            bazList.intervals.push_back(Interval(BSON("" << MINKEY << "" << MAXKEY), true, true));
+            params.bounds.fields.push_back(fooList);
+            params.bounds.fields.push_back(bazList);
+            params.direction = 1;
+
+            BSONObj filterObj = BSON("baz" << BSON("$mod" << BSON_ARRAY(2 << 0)));
+            ASSERT_EQUALS(countResults(params, filterObj), 6);
+
+            // Counting from the keys alone gets the same answer.
+            Client::ReadContext ctx(ns());
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            params.countOnly = true;
+            WorkingSet* ws = new WorkingSet();
+            IndexScan* scan = new IndexScan(params, ws, filterExpr.get());
+            PlanExecutor runner(ws, scan);
+
+            int count = 0;
+            while (Runner::RUNNER_ADVANCED == runner.getNext(NULL, NULL)) {
+                ++count;
+            }
+            ASSERT_EQUALS(6, count);
+
+            // Every key that passed was counted.
+            scoped_ptr<PlanStageStats> stats(runner.getStats());
+            ASSERT_EQUALS(6U, stats->common.advanced);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_stage_tests" ) { }
@@ -215,6 +258,7 @@ namespace QueryStageTests {
             add<QueryStageIXScanLowerUpperIncl>();
             add<QueryStageIXScanLowerUpperInclFilter>();
             add<QueryStageIXScanCantMatch>();
+            add<QueryStageIXScanCountOnlyMultiInterval>();
         }
     }  queryStageTestsAll;
 
@@ -101,7 +101,7 @@ namespace ReplSetTests {
     };
 
     class BackgroundSyncTest : public replset::BackgroundSyncInterface {
-        std::queue<BSONObj> _queue;
+        std::deque<BSONObj> _queue;
     public:
         BackgroundSyncTest() {}
         virtual ~BackgroundSyncTest() {}
@@ -113,17 +113,22 @@ namespace ReplSetTests {
             return true;
         }
         virtual void consume() {
-            _queue.pop();
+            _queue.pop_front();
         }
         virtual Member* getSyncTarget() {
             return 0;
         }
         void addDoc(BSONObj doc) {
-            _queue.push(doc.getOwned());
+            _queue.push_back(doc.getOwned());
         }
         virtual void waitForMore() {
             return;
         }
+        virtual void peekMany(std::vector<BSONObj>* ops, size_t max) {
+            for (size_t i = 0; i < _queue.size() && ops->size() < max; i++) {
+                ops->push_back(_queue[i]);
+            }
+        }
     };
 
 
@@ -35,6 +35,8 @@
 #include <boost/thread.hpp>
 
 #include "mongo/bson/util/atomic_int.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/client.h"
 #include "mongo/db/d_concurrency.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/platform/atomic_word.h"
@@ -279,6 +281,85 @@ namespace ThreadedTests {
         }
     };
 
+    /** writers of different collections in one db, plus readers of the whole db */
+    class CollectionLockTest : public ThreadedTest<20> {
+        enum { N = 1000 };
+        AtomicUInt32 _inA; // writers of foo.a currently holding their lock
+        AtomicUInt32 _conflicts;
+    public:
+        CollectionLockTest() : _inA(0), _conflicts(0) {}
+    private:
+        virtual void setup() {
+            // only collections that exist are locked on their own; creating one takes the db
+            createCollection("foo.a");
+            createCollection("foo.b");
+        }
+        static void createCollection(const string& ns) {
+            Client::WriteContext ctx(ns);
+            Database* db = ctx.ctx().db();
+            if( !db->getCollection(ns) ) {
+                ASSERT( Lock::isWriteLocked("foo") );
+                db->createCollection(ns);
+            }
+        }
+        virtual void subthread(int tnumber) {
+            Client::initThread("collectionlocktest");
+            for( int i = 0; i < N; i++ ) {
+                if( tnumber % 4 == 0 ) {
+                    Lock::DBWrite w("foo.a");
+                    if( _inA.fetchAndAdd(1) != 0 )
+                        _conflicts.fetchAndAdd(1); // two writers of foo.a at once
+                    ASSERT( Lock::isWriteLocked("foo.a") );
+                    ASSERT( Lock::isWriteLocked("foo.a.$x_1") );
+                    // the db itself, its system collections and its other collections are
+                    // only ours when the whole db is locked
+                    ASSERT_EQUALS( !Lock::collectionLevelLockingEnabled(),
+                                   Lock::isWriteLocked("foo") );
+                    ASSERT_EQUALS( !Lock::collectionLevelLockingEnabled(),
+                                   Lock::isWriteLocked("foo.system.indexes") );
+                    ASSERT_EQUALS( !Lock::collectionLevelLockingEnabled(),
+                                   Lock::isWriteLocked("foo.b") );
+                    {
+                        Lock::DBRead nested("foo.a"); // same collection, nested
+                    }
+                    if( i % 50 == 0 ) {
+                        _inA.fetchAndSubtract(1);
+                        Lock::TempRelease t;
+                        _inA.fetchAndAdd(1);
+                    }
+                    _inA.fetchAndSubtract(1);
+                }
+                else if( tnumber % 4 == 1 ) {
+                    Lock::DBWrite w("foo.b");
+                    ASSERT( Lock::isWriteLocked("foo.b") );
+                }
+                else if( tnumber % 4 == 2 ) {
+                    Lock::DBRead r("foo.a");
+                    ASSERT( Lock::atLeastReadLocked("foo.a") );
+                }
+                else {
+                    // the whole database: excludes every collection writer
+                    Lock::DBRead r("foo");
+                    if( _inA.load() != 0 )
+                        _conflicts.fetchAndAdd(1);
+                }
+            }
+            cc().shutdown();
+        }
+        virtual void validate() {
+            ASSERT_EQUALS( 0U, _conflicts.load() );
+            {
+                Lock::DBWrite w("foo.doesnotexist");
+                ASSERT( Lock::isWriteLocked("foo") );
+            }
+            ASSERT( !Lock::isCollectionLockable("foo") );
+            ASSERT( !Lock::isCollectionLockable("foo.system.indexes") );
+            ASSERT( !Lock::isCollectionLockable("local.oplog.rs") );
+            ASSERT_EQUALS( Lock::collectionLevelLockingEnabled(),
+                           Lock::isCollectionLockable("foo.a") );
+        }
+    };
+
     // Tested with up to 30k threads
     class IsAtomicUIntAtomic : public ThreadedTest<> {
         static const int iterations = 1000000;
@@ -1016,6 +1097,7 @@ namespace ThreadedTests {
             add< RWLockTest4 >();
 
             add< MongoMutexTest >();
+            add< CollectionLockTest >();
             add< TicketHolderWaits >();
         }
     } myall;
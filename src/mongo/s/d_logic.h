@@ -296,6 +296,10 @@ namespace mongo {
 
         static ShardedConnectionInfo* get( bool create );
         static void reset();
+
+        /** takes the calling thread's info, if any, so another thread can attach() it */
+        static ShardedConnectionInfo* detach();
+        static void attach( ShardedConnectionInfo* info );
         static void addHook();
 
         bool inForceVersionOkMode() const {
@@ -1661,8 +1661,10 @@ namespace mongo {
 
                 for ( unsigned i=0; i<all.size(); i++ ) {
                     BSONObj idx = all[i];
-                    Client::WriteContext ctx( ns );
-                    Database* db = ctx.ctx().db();
+                    // building an index needs the whole database
+                    Lock::DBWrite lk( nsToDatabaseSubstring( ns ) );
+                    Client::Context ctx( ns );
+                    Database* db = ctx.db();
                     Collection* collection = db->getCollection( ns );
                     if ( !collection ) {
                         errmsg = str::stream() << "collection dropped during migration: " << ns;
@@ -755,6 +755,14 @@ namespace mongo {
         _tl.reset();
     }
 
+    ShardedConnectionInfo* ShardedConnectionInfo::detach() {
+        return _tl.release();
+    }
+
+    void ShardedConnectionInfo::attach( ShardedConnectionInfo* info ) {
+        _tl.reset( info );
+    }
+
     const ChunkVersion ShardedConnectionInfo::getVersion( const string& ns ) const {
         NSVersionMap::const_iterator it = _versions.find( ns );
         if ( it != _versions.end() ) {
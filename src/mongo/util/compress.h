@@ -38,6 +38,12 @@ namespace mongo {
 
     bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
 
+    /** @return false if the input is corrupt */
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result);
+
+    /** 'uncompressed' must have room for uncompressedLength() bytes */
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed);
+
     size_t maxCompressedLength(size_t source_len);
     void rawCompress(const char* input,
         size_t input_length,
@@ -0,0 +1,438 @@
+// connection_reactor.cpp
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "mongo/pch.h"
+
+#include "mongo/util/net/connection_reactor.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#endif
+
+#include "mongo/db/lasterror.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/net/listen.h"
+#include "mongo/util/net/message.h"
+#include "mongo/util/net/message_port.h"
+#include "mongo/util/net/message_server.h"
+#include "mongo/util/net/ssl_manager.h"
+
+namespace mongo {
+
+    // 0 means a thread per connection
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(connectionWorkerThreads, int, 0);
+
+    // how long queued connections may wait with no request finishing before another worker
+    // is started
+    static const unsigned long long stalledMillis = 100;
+
+    struct ReactorConnection {
+        explicit ReactorConnection( MessagingPort* p )
+            : port( p ),
+              lastError( new LastError() ),
+              session( NULL ),
+              connected( false ),
+              closing( false ),
+              headerBytes( 0 ),
+              frame( NULL ),
+              frameBytes( 0 ),
+              bytesIn( 0 ) {
+        }
+
+        ~ReactorConnection() {
+            free( frame );
+        }
+
+        scoped_ptr<MessagingPort> port;
+        scoped_ptr<LastError> lastError;
+        void* session;      // from MessageHandler::detachSession() once connected
+        bool connected;     // MessageHandler::connected() has been called
+        bool closing;       // queued for a worker only to be disconnected
+
+        // the frame being read by the reactor thread
+        MSGHEADER header;
+        int headerBytes;
+        MsgData* frame;     // allocated once the header is in
+        int frameBytes;
+        long long bytesIn;
+
+        Message message;    // a complete request, for a worker
+    };
+
+    int ConnectionReactor::workerThreadsForHandler( const MessageHandler* handler ) {
+#ifdef __linux__
+        if ( connectionWorkerThreads <= 0 || !handler->supportsSessionHandoff() )
+            return 0;
+#ifdef MONGO_SSL
+        if ( getSSLManager() )
+            return 0;
+#endif
+        return connectionWorkerThreads;
+#else
+        return 0;
+#endif
+    }
+
+    ConnectionReactor::ConnectionReactor( MessageHandler* handler, int workerThreads )
+        : _handler( handler ),
+          _workerThreads( workerThreads ),
+          _numWorkers( 0 ),
+          _requestsDone( 0 ),
+          _requestsAtLastCheck( 0 ),
+          _lastCheckMillis( 0 ),
+          _epfd( -1 ) {
+        verify( _workerThreads > 0 );
+    }
+
+#ifdef __linux__
+
+    void ConnectionReactor::start() {
+        _epfd = epoll_create( 1024 );
+        massert( 17411, str::stream() << "epoll_create failed: " << errnoWithDescription(),
+                 _epfd >= 0 );
+
+        log() << "serving connections from " << _workerThreads << " worker threads" << endl;
+
+        _lastCheckMillis = curTimeMillis64();
+        boost::thread reactor( boost::bind( &ConnectionReactor::_reactorThread, this ) );
+        for ( int i = 0; i < _workerThreads; i++ ) {
+            _numWorkers.addAndFetch( 1 );
+            boost::thread worker( boost::bind( &ConnectionReactor::_workerThread, this ) );
+        }
+    }
+
+    void ConnectionReactor::add( MessagingPort* port ) {
+        port->psock->setLogLevel(logger::LogSeverity::Debug(1));
+        ReactorConnection* c = new ReactorConnection( port );
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = c;
+        if ( epoll_ctl( _epfd, EPOLL_CTL_ADD, port->psock->rawFD(), &event ) != 0 ) {
+            log() << "can't watch new connection: " << errnoWithDescription() << endl;
+            port->shutdown();
+            delete c;
+            Listener::globalTicketHolder.release();
+        }
+    }
+
+    void ConnectionReactor::_rearm( ReactorConnection* c ) {
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.ptr = c;
+        if ( epoll_ctl( _epfd, EPOLL_CTL_MOD, c->port->psock->rawFD(), &event ) != 0 ) {
+            log() << "can't watch connection " << c->port->connectionId() << ": "
+                  << errnoWithDescription() << endl;
+            c->closing = true;
+            _ready.push( c );
+        }
+    }
+
+    void ConnectionReactor::_reactorThread() {
+        setThreadName( "connReactor" );
+
+        const int maxEvents = 256;
+        epoll_event events[maxEvents];
+
+        while ( ! inShutdown() ) {
+            // wake up now and then to notice shutdown and stalled workers
+            int n = epoll_wait( _epfd, events, maxEvents, stalledMillis );
+            if ( n < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                error() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                fassertFailed( 17412 );
+            }
+
+            for ( int i = 0; i < n; i++ ) {
+                ReactorConnection* c = static_cast<ReactorConnection*>( events[i].data.ptr );
+                bool ok = false;
+                try {
+                    ok = _readAvailable( c );
+                }
+                catch ( const DBException& e ) {
+                    LOG(1) << "error reading from connection " << c->port->connectionId()
+                           << ": " << e << endl;
+                }
+
+                if ( !ok )
+                    c->closing = true;
+
+                if ( c->closing || !c->message.empty() )
+                    _ready.push( c ); // a worker owns the connection now
+                else
+                    _rearm( c ); // partial frame, wait for the rest
+            }
+
+            _growIfStalled();
+        }
+    }
+
+    /**
+     * Requests can block for a long time: an awaitData getMore, getLastError waiting for
+     * replication, a write behind fsyncLock.  If they hold every worker, the requests that
+     * would unblock them (the secondaries' oplog reads, the fsyncUnlock) sit in the queue
+     * forever.  So when connections are queued and no request has finished for a while,
+     * start another worker.  Workers beyond the configured number exit once idle.
+     */
+    void ConnectionReactor::_growIfStalled() {
+        unsigned long long now = curTimeMillis64();
+        if ( now - _lastCheckMillis < stalledMillis )
+            return;
+        _lastCheckMillis = now;
+
+        unsigned long long done = _requestsDone.load();
+        bool stalled = done == _requestsAtLastCheck && !_ready.empty();
+        _requestsAtLastCheck = done;
+        if ( !stalled )
+            return;
+
+        unsigned workers = _numWorkers.addAndFetch( 1 );
+        try {
+            boost::thread worker( boost::bind( &ConnectionReactor::_workerThread, this ) );
+        }
+        catch ( boost::thread_resource_error& ) {
+            _numWorkers.subtractAndFetch( 1 );
+            warning() << "can't start another connection worker, " << _ready.size()
+                      << " connections waiting" << endl;
+            return;
+        }
+        log() << "all connection workers busy, started another (" << workers << " now)" << endl;
+    }
+
+    bool ConnectionReactor::_retireExtraWorker() {
+        while ( true ) {
+            unsigned workers = _numWorkers.load();
+            if ( workers <= static_cast<unsigned>( _workerThreads ) )
+                return false;
+            if ( _numWorkers.compareAndSwap( workers, workers - 1 ) == workers )
+                return true;
+        }
+    }
+
+    bool ConnectionReactor::_readAvailable( ReactorConnection* c ) {
+        const int fd = c->port->psock->rawFD();
+        while ( true ) {
+            char* dest;
+            int want;
+            if ( c->headerBytes < static_cast<int>(sizeof(MSGHEADER)) ) {
+                dest = reinterpret_cast<char*>( &c->header ) + c->headerBytes;
+                want = sizeof(MSGHEADER) - c->headerBytes;
+            }
+            else {
+                dest = reinterpret_cast<char*>( c->frame ) + c->frameBytes;
+                want = c->header.messageLength - c->frameBytes;
+            }
+
+            int got = ::recv( fd, dest, want, MSG_DONTWAIT );
+            if ( got == 0 )
+                return false; // the other side closed
+            if ( got < 0 ) {
+                if ( errno == EINTR )
+                    continue;
+                if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                    return true;
+                LOG(1) << "recv() failed on connection " << c->port->connectionId() << ": "
+                       << errnoWithDescription() << endl;
+                return false;
+            }
+            c->bytesIn += got;
+
+            if ( c->frame == NULL ) {
+                c->headerBytes += got;
+                if ( c->headerBytes < static_cast<int>(sizeof(MSGHEADER)) )
+                    continue;
+                if ( !_handleHeader( c ) )
+                    return false;
+            }
+            else {
+                c->frameBytes += got;
+            }
+
+            if ( c->frame && c->frameBytes == c->header.messageLength ) {
+                c->message.setData( c->frame, true );
+                c->frame = NULL;
+                c->frameBytes = 0;
+                c->headerBytes = 0;
+                // one request at a time; anything after it stays in the socket until the
+                // worker hands the connection back
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Checks a just-read header the way MessagingPort::recv does and allocates the frame.
+     * @return false if the connection should be closed
+     */
+    bool ConnectionReactor::_handleHeader( ReactorConnection* c ) {
+        Socket& sock = *c->port->psock;
+        int len = c->header.messageLength;
+
+        if ( len == 542393671 ) {
+            // an http GET
+            string msg = "It looks like you are trying to access MongoDB over HTTP on the native driver port.\n";
+            LOG( sock.getLogLevel() ) << msg << endl;
+            stringstream ss;
+            ss << "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-Type: text/plain\r\nContent-Length: " << msg.size() << "\r\n\r\n" << msg;
+            string s = ss.str();
+            c->port->send( s.c_str(), s.size(), "http" );
+            return false;
+        }
+        else if ( len == -1 ) {
+            // Endian check from the client, after connecting, to see what mode server is running in.
+            unsigned foo = 0x10203040;
+            c->port->send( (char *) &foo, 4, "endian" );
+            sock.setHandshakeReceived();
+            c->headerBytes = 0;
+            return true;
+        }
+        else if ( sock.isAwaitingHandshake() &&
+                  c->header.responseTo != 0 && c->header.responseTo != -1 ) {
+            // looks like an SSL hello; SSL connections are never given to the reactor
+            log() << "SSL handshake received but server is started without SSL support" << endl;
+            return false;
+        }
+        else if ( len < static_cast<int>(sizeof(MSGHEADER)) || len > MaxMessageSizeBytes ) {
+            LOG(0) << "recv(): message len " << len << " is invalid. "
+                   << "Min " << sizeof(MSGHEADER) << " Max: " << MaxMessageSizeBytes << endl;
+            return false;
+        }
+
+        sock.setHandshakeReceived();
+        int z = (len+1023)&0xfffffc00;
+        verify(z>=len);
+        c->frame = (MsgData *) malloc(z);
+        verify(c->frame);
+        memcpy(c->frame, &c->header, sizeof(MSGHEADER));
+        c->frameBytes = sizeof(MSGHEADER);
+        return true;
+    }
+
+    void ConnectionReactor::_workerThread() {
+        setThreadName( "connWorker" );
+        while ( ! inShutdown() ) {
+            ReactorConnection* c = NULL;
+            if ( !_ready.blockingPop( c, 1 ) ) {
+                if ( _retireExtraWorker() )
+                    return;
+                continue;
+            }
+            _process( c );
+            _requestsDone.addAndFetch( 1 );
+        }
+    }
+
+    void ConnectionReactor::_process( ReactorConnection* c ) {
+        lastError.reset( c->lastError.get() );
+        if ( c->connected ) {
+            _handler->attachSession( c->session );
+            c->session = NULL;
+        }
+
+        if ( c->closing ) {
+            _close( c );
+            return;
+        }
+
+        try {
+            if ( !c->connected ) {
+                c->connected = true;
+                _handler->connected( c->port.get() );
+            }
+
+            c->port->psock->clearCounters();
+            _handler->process( c->message , c->port.get() , c->lastError.get() );
+            networkCounter.hit( c->bytesIn , c->port->psock->getBytesOut() );
+            c->bytesIn = 0;
+            c->message.reset();
+        }
+        catch ( AssertionException& e ) {
+            log() << "AssertionException handling request, closing client connection: " << e << endl;
+            c->closing = true;
+        }
+        catch ( SocketException& e ) {
+            log() << "SocketException handling request, closing client connection: " << e << endl;
+            c->closing = true;
+        }
+        catch ( const DBException& e ) { // must be right above std::exception to avoid catching subclasses
+            log() << "DBException handling request, closing client connection: " << e << endl;
+            c->closing = true;
+        }
+        catch ( std::exception &e ) {
+            error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+            dbexit( EXIT_UNCAUGHT );
+        }
+        catch ( ... ) {
+            error() << "Uncaught exception, terminating" << endl;
+            dbexit( EXIT_UNCAUGHT );
+        }
+
+        if ( c->closing || inShutdown() ) {
+            _close( c );
+            return;
+        }
+
+        c->session = _handler->detachSession();
+        lastError.release();
+        setThreadName( "connWorker" );
+        _rearm( c );
+    }
+
+    /** called on a worker with the connection's session attached, if it has one */
+    void ConnectionReactor::_close( ReactorConnection* c ) {
+        if ( !serverGlobalParams.quiet ) {
+            int conns = Listener::globalTicketHolder.used()-1;
+            const char* word = (conns == 1 ? " connection" : " connections");
+            log() << "end connection " << c->port->psock->remoteString()
+                  << " (" << conns << word << " now open)" << endl;
+        }
+
+        // removes it from the epoll set too
+        c->port->shutdown();
+
+        if ( c->connected ) {
+            _handler->disconnected( c->port.get() );
+            _handler->destroySession( _handler->detachSession() );
+        }
+        lastError.release();
+        delete c;
+
+        Listener::globalTicketHolder.release();
+        setThreadName( "connWorker" );
+    }
+
+#else
+
+    void ConnectionReactor::start() {
+        msgasserted( 17413, "connectionWorkerThreads is only supported on linux" );
+    }
+
+    void ConnectionReactor::add( MessagingPort* port ) {
+        verify( false );
+    }
+
+#endif // __linux__
+
+}
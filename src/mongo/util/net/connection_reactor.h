@@ -0,0 +1,93 @@
+// connection_reactor.h
+
+/*    Copyright 2014 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/queue.h"
+
+namespace mongo {
+
+    class MessageHandler;
+    class MessagingPort;
+    struct ReactorConnection;
+
+    /**
+     * Serves client connections from a fixed pool of worker threads instead of a thread per
+     * connection.  Linux only (epoll).
+     *
+     * One reactor thread waits for readable sockets and reads message frames without
+     * blocking, keeping partial frames per connection.  A connection with a complete message
+     * is queued for a worker, which attaches the connection's session (see
+     * MessageHandler::supportsSessionHandoff), processes the message and sends the reply, then
+     * gives the socket back to the reactor.  A connection is owned by at most one thread at a
+     * time (the epoll registration is one-shot), so its messages are handled in order.  Idle
+     * connections cost a descriptor and a small struct - no thread or stack.
+     *
+     * A request that blocks (awaitData, getLastError with w, fsyncLock) keeps its worker.  If
+     * queued connections see no request finish for a short while the reactor starts another
+     * worker, so the pool grows past its configured size while requests are blocked and
+     * shrinks back as the extra workers go idle.
+     *
+     * Enabled by the connectionWorkerThreads startup parameter.  SSL connections still get a
+     * thread each, as the handshake and record layer need blocking reads.
+     */
+    class ConnectionReactor {
+        MONGO_DISALLOW_COPYING(ConnectionReactor);
+    public:
+        /** @return number of workers to use, 0 if connections should get their own thread */
+        static int workerThreadsForHandler( const MessageHandler* handler );
+
+        ConnectionReactor( MessageHandler* handler, int workerThreads );
+
+        /** starts the reactor and worker threads, which run until shutdown */
+        void start();
+
+        /**
+         * Takes ownership of 'port'.  The caller must hold a Listener::globalTicketHolder
+         * ticket for it, which is released when the connection closes.
+         */
+        void add( MessagingPort* port );
+
+    private:
+        void _reactorThread();
+        void _workerThread();
+        void _growIfStalled();
+
+        /** @return true if the calling worker is beyond the configured number and should exit */
+        bool _retireExtraWorker();
+
+        /** @return false if the connection should be closed */
+        bool _readAvailable( ReactorConnection* c );
+        bool _handleHeader( ReactorConnection* c );
+        void _process( ReactorConnection* c );
+        void _rearm( ReactorConnection* c );
+        void _close( ReactorConnection* c );
+
+        MessageHandler* const _handler;
+        const int _workerThreads;               // workers always running
+        AtomicUInt32 _numWorkers;               // including extra ones while requests block
+        AtomicUInt64 _requestsDone;
+        unsigned long long _requestsAtLastCheck; // these two only used by the reactor thread
+        unsigned long long _lastCheckMillis;
+        int _epfd;
+        BlockingQueue<ReactorConnection*> _ready;
+    };
+
+}
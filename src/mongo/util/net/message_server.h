@@ -47,6 +47,31 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * Servers that serve many connections from a pool of threads move a connection's
+         * state between threads with these: after each process() the state that connected()
+         * set up on the calling thread is detached, and it is attached again on whichever
+         * thread handles the connection's next message (or its disconnected()).
+         *
+         * @return false if the handler needs a thread per connection
+         */
+        virtual bool supportsSessionHandoff() const { return false; }
+
+        /**
+         * @return all of the calling thread's per connection state (thread locals), no longer
+         * attached to the thread
+         */
+        virtual void* detachSession() { return NULL; }
+
+        /**
+         * makes 'session', from detachSession(), the calling thread's connection state.
+         * 'session' is used up; detach again to get it back.
+         */
+        virtual void attachSession( void* session ) {}
+
+        /** frees a detached session once disconnected() has been called for it */
+        virtual void destroySession( void* session ) {}
     };
 
     class MessageServer {
@@ -26,6 +26,7 @@
 #include "mongo/db/stats/counters.h"
 #include "mongo/util/concurrency/ticketholder.h"
 #include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/net/connection_reactor.h"
 #include "mongo/util/net/listen.h"
 #include "mongo/util/net/message.h"
 #include "mongo/util/net/message_port.h"
@@ -64,6 +65,11 @@ namespace mongo {
                 return;
             }
 
+            if ( _reactor ) {
+                _reactor->add( p );
+                return;
+            }
+
             try {
 #ifndef __linux__  // TODO: consider making this ifdef _WIN32
                 {
@@ -130,6 +136,11 @@ namespace mongo {
         }
 
         void run() {
+            int workerThreads = ConnectionReactor::workerThreadsForHandler( _handler );
+            if ( workerThreads > 0 ) {
+                _reactor.reset( new ConnectionReactor( _handler, workerThreads ) );
+                _reactor->start();
+            }
             initAndListen();
         }
 
@@ -138,6 +149,9 @@ namespace mongo {
     private:
         MessageHandler* _handler;
 
+        // when set, connections are served by its worker threads rather than a thread each
+        scoped_ptr<ConnectionReactor> _reactor;
+
         /**
          * Simple holder for threadRun parameters. Should not destroy the objects it holds -
          * it is the responsibility of the caller to take care of them.
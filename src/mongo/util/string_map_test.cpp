@@ -120,6 +120,22 @@ namespace {
         ASSERT_EQUALS( before, m.capacity() );
     }
 
+    TEST( StringMapTest, EraseSize ) {
+        StringMap<int> m;
+        m["eliot"] = 5;
+        m["andy"] = 6;
+        ASSERT_EQUALS( 2U, m.size() );
+
+        m.erase( "eliot" );
+        ASSERT_EQUALS( 1U, m.size() );
+        m.erase( "eliot" );
+        ASSERT_EQUALS( 1U, m.size() );
+
+        m.erase( m.find( "andy" ) );
+        ASSERT_EQUALS( 0U, m.size() );
+        ASSERT( m.empty() );
+    }
+
     TEST( StringMapTest, Iterator1 ) {
         StringMap<int> m;
         ASSERT( m.begin() == m.end() );
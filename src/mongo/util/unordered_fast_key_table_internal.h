@@ -165,6 +165,7 @@ namespace mongo {
         if ( pos < 0 )
             return 0;
 
+        --_size;
         _area._entries[pos].used = false;
         _area._entries[pos].data.second = V();
         return 1;
@@ -175,6 +176,7 @@ namespace mongo {
         dassert(it._position >= 0);
         dassert(it._area == &_area);
 
+        --_size;
         _area._entries[it._position].used = false;
         _area._entries[it._position].data.second = V();
     }